@@ -292,12 +292,16 @@ void CSVExportWizard::on_apply()
 		fprintf(fp, ",%s", s.GetName().c_str());
 	fprintf(fp, "\n");
 
-	//Prepare to generate output waveform
+	//Prepare to generate output waveform.
+	//Render all protocol text up front so the main loop only has to look up cached strings.
 	vector<WaveformBase*> waveforms;
 	vector<size_t> indexes;
 	for(auto s : streams)
 	{
-		waveforms.push_back(s.GetData());
+		auto w = s.GetData();
+		if(s.GetType() == Stream::STREAM_TYPE_PROTOCOL)
+			w->RenderTextRange(0, w->size());
+		waveforms.push_back(w);
 		indexes.push_back(0);
 	}
 	auto timebaseWaveform = waveforms[0];
@@ -337,7 +341,7 @@ void CSVExportWizard::on_apply()
 				break;
 
 			case Stream::STREAM_TYPE_PROTOCOL:
-				fprintf(fp, ",%s", timebaseWaveform->GetText(i).c_str());
+				fprintf(fp, ",%s", timebaseWaveform->GetCachedText(i).c_str());
 				break;
 
 			default:
@@ -416,7 +420,7 @@ void CSVExportWizard::on_apply()
 				case Stream::STREAM_TYPE_PROTOCOL:
 					{
 						if(firstHit)
-							fprintf(fp, ",%s", w->GetText(k).c_str());
+							fprintf(fp, ",%s", w->GetCachedText(k).c_str());
 						else
 							fprintf(fp, ",");
 					}
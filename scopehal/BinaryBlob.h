@@ -0,0 +1,187 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of BinaryBlobWriter and BinaryBlobReader
+ */
+#ifndef BinaryBlob_h
+#define BinaryBlob_h
+
+#include <string.h>
+
+/**
+	@brief Helper for serializing plain-old-data structures to a compact binary blob
+
+	Data is written in host byte order with no padding or versioning; callers are expected to include a format
+	version of their own if the blob is persisted.
+ */
+class BinaryBlobWriter
+{
+public:
+	BinaryBlobWriter(std::vector<uint8_t>& buf)
+	: m_buf(buf)
+	{}
+
+	template<class T>
+	void Write(const T& value)
+	{ WriteRaw(&value, sizeof(T)); }
+
+	void WriteRaw(const void* data, size_t len)
+	{
+		size_t off = m_buf.size();
+		m_buf.resize(off + len);
+		if(len)
+			memcpy(&m_buf[off], data, len);
+	}
+
+	void WriteString(const std::string& str)
+	{
+		Write<uint32_t>(str.length());
+		WriteRaw(str.c_str(), str.length());
+	}
+
+	///@brief Writes a length-prefixed array of POD elements
+	template<class T>
+	void WriteArray(const T* data, size_t len)
+	{
+		Write<uint64_t>(len);
+		WriteRaw(data, len * sizeof(T));
+	}
+
+	template<class T>
+	void WriteVector(const std::vector<T>& vec)
+	{ WriteArray(vec.data(), vec.size()); }
+
+protected:
+	std::vector<uint8_t>& m_buf;
+};
+
+/**
+	@brief Helper for reading back a blob written by BinaryBlobWriter
+
+	All reads are bounds checked. Once any read fails, the reader is marked bad and all subsequent reads fail too,
+	so callers can do a batch of reads and check IsOK() once at the end.
+ */
+class BinaryBlobReader
+{
+public:
+	BinaryBlobReader(const std::vector<uint8_t>& buf)
+	: m_buf(buf)
+	, m_pos(0)
+	, m_ok(true)
+	{}
+
+	bool IsOK() const
+	{ return m_ok; }
+
+	bool AtEnd() const
+	{ return m_pos == m_buf.size(); }
+
+	template<class T>
+	T Read()
+	{
+		T ret;
+		if(!ReadRaw(&ret, sizeof(T)))
+			memset(&ret, 0, sizeof(T));
+		return ret;
+	}
+
+	bool ReadRaw(void* data, size_t len)
+	{
+		if(!m_ok || (len > m_buf.size() - m_pos) )
+		{
+			m_ok = false;
+			return false;
+		}
+		if(len)
+			memcpy(data, &m_buf[m_pos], len);
+		m_pos += len;
+		return true;
+	}
+
+	std::string ReadString()
+	{
+		auto len = Read<uint32_t>();
+		if(!m_ok || (len > m_buf.size() - m_pos) )
+		{
+			m_ok = false;
+			return "";
+		}
+		std::string ret(reinterpret_cast<const char*>(&m_buf[m_pos]), len);
+		m_pos += len;
+		return ret;
+	}
+
+	/**
+		@brief Reads a 32-bit element count and sanity checks it against the remaining data
+
+		@param minSize	Minimum serialized size of a single element
+	 */
+	size_t ReadCount(size_t minSize)
+	{
+		size_t count = Read<uint32_t>();
+		if(!m_ok || (count > (m_buf.size() - m_pos) / minSize) )
+		{
+			m_ok = false;
+			return 0;
+		}
+		return count;
+	}
+
+	/**
+		@brief Reads the length of an array written by WriteArray() and sanity checks it against the remaining data
+	 */
+	template<class T>
+	size_t ReadArrayLength()
+	{
+		auto len = Read<uint64_t>();
+		if(!m_ok || (len > (m_buf.size() - m_pos) / sizeof(T)) )
+		{
+			m_ok = false;
+			return 0;
+		}
+		return len;
+	}
+
+	template<class T>
+	void ReadVector(std::vector<T>& vec)
+	{
+		vec.resize(ReadArrayLength<T>());
+		ReadRaw(vec.data(), vec.size() * sizeof(T));
+	}
+
+protected:
+	const std::vector<uint8_t>& m_buf;
+	size_t m_pos;
+	bool m_ok;
+};
+
+#endif
@@ -218,6 +218,9 @@ void DSLabsOscilloscope::IdentifyHardware()
 
 DSLabsOscilloscope::~DSLabsOscilloscope()
 {
+	//Make sure the streaming thread isn't still calling ReadChunk() as we go away
+	StopStreamThread();
+
 	delete m_dataSocket;
 }
 
@@ -282,134 +285,169 @@ Oscilloscope::TriggerMode DSLabsOscilloscope::PollTrigger()
 	return TRIGGER_MODE_TRIGGERED;
 }
 
-bool DSLabsOscilloscope::AcquireData()
+/**
+	@brief Requests one acquisition from the bridge and reads its headers and sample data into a chunk
+ */
+bool DSLabsOscilloscope::ReadChunk(RemoteBridgeChunk& chunk)
 {
+	chunk.Clear();
+
 	const uint8_t r = 'K';
 	m_transport->SendRawData(1, &r);
 
-	//Read the sequence number of the current waveform
-	uint32_t seqnum;
-	if(!m_transport->ReadRawData(sizeof(seqnum), (uint8_t*)&seqnum))
+	if(!WaitForChunkData())
 		return false;
 
-	//Read the number of channels in the current waveform
-	uint16_t numChannels;
-	if(!m_transport->ReadRawData(sizeof(numChannels), (uint8_t*)&numChannels))
-		return false;
+	#pragma pack(push, 1)
+	struct
+	{
+		//Sequence number of the current waveform
+		uint32_t seqnum;
 
-	//Get the sample interval.
-	//May be different from m_srate if we changed the rate after the trigger was armed
-	int64_t fs_per_sample;
-	if(!m_transport->ReadRawData(sizeof(fs_per_sample), (uint8_t*)&fs_per_sample))
-		return false;
+		//Number of channels in the current waveform
+		uint16_t numChannels;
+
+		//Sample interval.
+		//May be different from m_srate if we changed the rate after the trigger was armed
+		int64_t fs_per_sample;
 
-	//Get the de-facto trigger position.
-	int64_t trigger_fs;
-	if(!m_transport->ReadRawData(sizeof(trigger_fs), (uint8_t*)&trigger_fs))
+		//De-facto trigger position
+		int64_t trigger_fs;
+
+		//De-facto hardware capture rate
+		double wfms_s;
+	} header;
+	#pragma pack(pop)
+	if(!m_transport->ReadRawData(sizeof(header), (uint8_t*)&header))
 		return false;
 
 	{
 		lock_guard<recursive_mutex> lock(m_mutex);
-		if (m_triggerOffset != trigger_fs)
+		if (m_triggerOffset != header.trigger_fs)
 		{
-			AddDiagnosticLog("Correcting trigger offset by " + to_string(m_triggerOffset - trigger_fs));
-			m_triggerOffset = trigger_fs;
+			AddDiagnosticLog("Correcting trigger offset by " + to_string(m_triggerOffset - header.trigger_fs));
+			m_triggerOffset = header.trigger_fs;
 		}
 	}
 
-	//Get the de-facto hardware capture rate.
-	double wfms_s;
-	if(!m_transport->ReadRawData(sizeof(wfms_s), (uint8_t*)&wfms_s))
-		return false;
+	m_diag_hardwareWFMHz.SetFloatVal(header.wfms_s);
 
-	m_diag_hardwareWFMHz.SetFloatVal(wfms_s);
+	// LogDebug("Receive header: SEQ#%u, %d channels\n", header.seqnum, header.numChannels);
 
-	// AddDiagnosticLog("Something... " + to_string(GetTime()));
-
-	// LogDebug("Receive header: SEQ#%u, %d channels\n", seqnum, numChannels);
-
-	//Acquire data for each channel
-	size_t chnum;
-	size_t memdepth;
-	float config[3];
-	SequenceSet s;
+	chunk.m_fsPerSample = header.fs_per_sample;
 	double t = GetTime();
-	int64_t fs = (t - floor(t)) * FS_PER_SECOND;
-
-	//Analog channels get processed separately
-	vector<uint8_t*> abufs;
-	vector<UniformAnalogWaveform*> awfms;
-	vector<float> scales;
-	vector<float> offsets;
+	chunk.m_startTimestamp = time(NULL);
+	chunk.m_startFemtoseconds = (t - floor(t)) * FS_PER_SECOND;
 
-	for(size_t i=0; i<numChannels; i++)
+	for(size_t i=0; i<header.numChannels; i++)
 	{
 		//Get channel ID and memory depth (samples, not bytes)
-		if(!m_transport->ReadRawData(sizeof(chnum), (uint8_t*)&chnum))
-			return false;
-		if(!m_transport->ReadRawData(sizeof(memdepth), (uint8_t*)&memdepth))
+		size_t chanhdr[2];
+		if(!m_transport->ReadRawData(sizeof(chanhdr), (uint8_t*)chanhdr))
 			return false;
+		size_t chnum = chanhdr[0];
+		size_t memdepth = chanhdr[1];
 
 		// LogDebug("ch%ld: Receive %ld samples\n", chnum, memdepth);
 
-		uint8_t* buf = new uint8_t[memdepth];
-
 		//Analog channels
 		if(chnum < m_analogChannelCount)
 		{
-			abufs.push_back(buf);
-
 			//Scale and offset are sent in the header since they might have changed since the capture began
-			if(!m_transport->ReadRawData(sizeof(config), (uint8_t*)&config))
-				return false;
-			float scale = config[0];
-			float offset = config[1];
-			float trigphase = -config[2] * fs_per_sample;
-			scale *= GetChannelAttenuation(chnum);
-			offset *= GetChannelAttenuation(chnum);
-
-			bool clipping;
-			if(!m_transport->ReadRawData(sizeof(clipping), (uint8_t*)&clipping))
+			#pragma pack(push, 1)
+			struct
+			{
+				float config[3];
+				bool clipping;
+			} chancfg;
+			#pragma pack(pop)
+			if(!m_transport->ReadRawData(sizeof(chancfg), (uint8_t*)&chancfg))
 				return false;
 
+			auto buf = chunk.AppendBlock(chnum, memdepth, sizeof(uint8_t));
+			auto& block = chunk.m_blocks.back();
+			block.m_scale = chancfg.config[0];
+			block.m_offset = chancfg.config[1];
+			block.m_trigphase = -chancfg.config[2] * header.fs_per_sample;
+			block.m_clipping = chancfg.clipping;
+
 			//TODO: stream timestamp from the server
 
-			if(!m_transport->ReadRawData(memdepth * sizeof(int8_t), (uint8_t*)buf))
+			if(!m_transport->ReadRawData(memdepth * sizeof(int8_t), buf))
 				return false;
+		}
+		else
+		{
+			int32_t first_sample;
+			if(!m_transport->ReadRawData(sizeof(first_sample), (uint8_t*)&first_sample))
+				return false;
+
+			auto buf = chunk.AppendBlock(chnum, memdepth, sizeof(uint8_t));
+			chunk.m_blocks.back().m_firstSample = first_sample;
+			if(!m_transport->ReadRawData(memdepth * sizeof(uint8_t), buf))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+	@brief Converts a chunk read by ReadChunk() into waveforms
+ */
+bool DSLabsOscilloscope::ProcessChunk(RemoteBridgeChunk& chunk)
+{
+	SequenceSet s;
+	int64_t fs_per_sample = chunk.m_fsPerSample;
+
+	//Analog channels get processed separately
+	vector<uint8_t*> abufs;
+	vector<size_t> achans;
+	vector<UniformAnalogWaveform*> awfms;
+	vector<float> scales;
+	vector<float> offsets;
+
+	for(auto& block : chunk.m_blocks)
+	{
+		size_t chnum = block.m_chnum;
+		size_t memdepth = block.m_depth;
+		uint8_t* buf = chunk.GetSamples<uint8_t>(block);
+
+		//Analog channels
+		if(chnum < m_analogChannelCount)
+		{
+			abufs.push_back(buf);
+			achans.push_back(chnum);
 
 			//Create our waveform
-			auto cap = new UniformAnalogWaveform;
+			auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(chnum)->GetHwname());
 			cap->m_timescale = fs_per_sample;
-			cap->m_triggerPhase = trigphase;
-			cap->m_startTimestamp = time(NULL);
-			cap->m_startFemtoseconds = fs;
-			if (clipping)
+			cap->m_triggerPhase = block.m_trigphase;
+			cap->m_startTimestamp = chunk.m_startTimestamp;
+			cap->m_startFemtoseconds = chunk.m_startFemtoseconds;
+			if (block.m_clipping)
 				cap->m_flags |= WaveformBase::WAVEFORM_CLIPPING;
+			else
+				cap->m_flags &= ~WaveformBase::WAVEFORM_CLIPPING;
 
 			cap->Resize(memdepth);
 			awfms.push_back(cap);
-			scales.push_back(scale);
-			offsets.push_back(offset);
+			scales.push_back(block.m_scale * GetChannelAttenuation(chnum));
+			offsets.push_back(block.m_offset * GetChannelAttenuation(chnum));
 
 			s[m_channels[chnum]] = cap;
 		}
 		else
 		{
-			int32_t first_sample;
-
-			if(!m_transport->ReadRawData(sizeof(first_sample), (uint8_t*)&first_sample))
-				return false;
-
-			if(!m_transport->ReadRawData(memdepth * sizeof(uint8_t), (uint8_t*)buf))
-				return false;
+			int64_t first_sample = block.m_firstSample;
 
 			//Create buffers for output waveforms
 			auto cap = new SparseDigitalWaveform;
 			s[m_channels[chnum]] = cap;
 			cap->m_timescale = fs_per_sample;
 			cap->m_triggerPhase = 0;
-			cap->m_startTimestamp = time(NULL);
-			cap->m_startFemtoseconds = fs;
+			cap->m_startTimestamp = chunk.m_startTimestamp;
+			cap->m_startFemtoseconds = chunk.m_startFemtoseconds;
 			cap->PrepareForCpuAccess();
 
 			//Preallocate memory assuming no deduplication possible
@@ -455,26 +493,31 @@ bool DSLabsOscilloscope::AcquireData()
 			cap->m_samples.shrink_to_fit();
 			cap->MarkSamplesModifiedFromCpu();
 			cap->MarkTimestampsModifiedFromCpu();
-
-			delete[] buf;
 		}
 	}
 
-	//Process analog captures in parallel
-	#pragma omp parallel for
+	//Convert all analog channels in one batch
+	vector<SampleConversionJob> jobs;
 	for(size_t i=0; i<awfms.size(); i++)
 	{
 		auto cap = awfms[i];
 		cap->PrepareForCpuAccess();
-		ConvertUnsigned8BitSamples(
+		jobs.push_back(SampleConversionJob(
 			cap->m_samples.GetCpuPointer(),
 			abufs[i],
 			scales[i],
 			offsets[i],
-			cap->size());
-		cap->MarkSamplesModifiedFromCpu();
-		delete[] abufs[i];
+			cap->size()));
+
+		//Codes at either rail also count as clipping, on top of what the hardware reported
+		auto& job = jobs.back();
+		job.m_invert = IsInverted(achans[i]);
+		job.DetectClipping(cap, 0, UINT8_MAX);
+		ApplyDeskew(achans[i], job, cap);
 	}
+	ConvertSamples(jobs);
+	for(auto cap : awfms)
+		cap->MarkSamplesModifiedFromCpu();
 
 	FilterParameter* param = &m_diag_totalWFMs;
 	int total = param->GetIntVal() + 1;
@@ -514,6 +557,19 @@ bool DSLabsOscilloscope::AcquireData()
 	return true;
 }
 
+/**
+	@brief Analog channels can be inverted in software during sample conversion
+ */
+bool DSLabsOscilloscope::CanInvert(size_t i)
+{
+	return (i < m_analogChannelCount);
+}
+
+bool DSLabsOscilloscope::IsStreamingModeSupported()
+{
+	return true;
+}
+
 void DSLabsOscilloscope::Start()
 {
 	RemoteBridgeOscilloscope::Start();
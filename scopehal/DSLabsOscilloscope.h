@@ -60,10 +60,13 @@ public:
 	virtual void SetChannelBandwidthLimit(size_t i, unsigned int limit_mhz);
 	virtual OscilloscopeChannel* GetExternalTrigger();
 	virtual bool CanEnableChannel(size_t i);
+	virtual bool CanInvert(size_t i);
 
 	//Triggering
 	virtual Oscilloscope::TriggerMode PollTrigger();
-	virtual bool AcquireData();
+
+	//Streaming
+	virtual bool IsStreamingModeSupported();
 
 	// Captures
 	virtual void Start();
@@ -111,6 +114,9 @@ protected:
 	void IdentifyHardware();
 	void ResetPerCaptureDiagnostics();
 
+	virtual bool ReadChunk(RemoteBridgeChunk& chunk);
+	virtual bool ProcessChunk(RemoteBridgeChunk& chunk);
+
 	std::string GetChannelColor(size_t i);
 
 	size_t m_analogChannelCount;
@@ -35,6 +35,7 @@
 
 #include "scopehal.h"
 #include "Filter.h"
+#include <omp.h>
 #ifdef __x86_64__
 #include <immintrin.h>
 #endif
@@ -46,6 +47,8 @@ set<Filter*> Filter::m_filters;
 
 mutex Filter::m_cacheMutex;
 map<pair<WaveformBase*, float>, vector<int64_t> > Filter::m_zeroCrossingCache;
+map<WaveformBase*, shared_ptr<WaveformSummary> > Filter::m_summaryCache;
+map<pair<WaveformBase*, WaveformBase*>, Filter::SampledDataCacheEntry> Filter::m_sampledDataCache;
 
 map<string, unsigned int> Filter::m_instanceCount;
 
@@ -93,6 +96,65 @@ void Filter::Release()
 		delete this;
 }
 
+/**
+	@brief Discards cached symbol text of all outputs
+
+	Filters whose symbol text depends on a parameter (display format etc) should connect the parameter's change
+	signal to this, since changing it doesn't modify the waveform data.
+ */
+void Filter::InvalidateOutputText()
+{
+	for(size_t i=0; i<GetStreamCount(); i++)
+	{
+		auto w = GetData(i);
+		if(w)
+			w->InvalidateTextCache();
+	}
+}
+
+/**
+	@brief Forces the next GetFirstNewSample() call on each input to request a full re-decode
+
+	Incremental decoders should call this when a parameter that affects decoding changes, and when their output is
+	discarded.
+ */
+void Filter::ResetIncrementalState()
+{
+	m_incrementalInputs.clear();
+}
+
+/**
+	@brief Determines how much of an input has already been seen, for filters which decode incrementally
+
+	Filters opt in to incremental decoding by calling this once per refresh for each input. If the input is the same
+	waveform as last time and its source has only appended samples to it since (see
+	WaveformBase::MarkSamplesAppended()), the filter may keep its decoder state and process only the new samples,
+	appending to its existing output.
+
+	@param i	Input index
+
+	@return	Index of the first sample not seen by the previous call, or 0 if the input must be processed from scratch
+ */
+size_t Filter::GetFirstNewSample(size_t i)
+{
+	auto wfm = GetInputWaveform(i);
+	if(m_incrementalInputs.size() <= i)
+		m_incrementalInputs.resize(i+1, {WaveformCacheKey(), 0});
+	auto& state = m_incrementalInputs[i];
+
+	size_t first = 0;
+	size_t len = wfm ? wfm->size() : 0;
+	if(wfm && (state.m_key.m_wfm == wfm) && wfm->IsAppendOf(state.m_key.m_rev) && (len >= state.m_len) )
+		first = state.m_len;
+
+	if(wfm)
+		state.m_key = WaveformCacheKey(wfm);
+	else
+		state.m_key = WaveformCacheKey();
+	state.m_len = len;
+	return first;
+}
+
 /**
 	@brief Returns true if this filter outputs a waveform consisting of a single sample.
 
@@ -314,6 +376,139 @@ void Filter::FillDurationsAVX2(SparseWaveformBase& wfm)
 }
 #endif /* __x86_64__ */
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Clock sampling helpers
+
+/**
+	@brief Finds edges of a digital clock
+
+	An edge at index i is a change between samples i-1 and i.
+
+	@param clk		Clock samples
+	@param start	First sample to check (must be at least 1)
+	@param end		One past the last sample to check
+	@param type		Edges to look for
+	@param edges	Output buffer for indexes of the edges, or NULL to only count them
+
+	@return	Number of edges found
+ */
+size_t Filter::FindClockEdges(const bool* clk, size_t start, size_t end, ClockEdgeType type, int64_t* edges)
+{
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		return FindClockEdgesAVX2(clk, start, end, type, edges);
+	else
+	#endif
+		return FindClockEdgesGeneric(clk, start, end, type, edges);
+}
+
+size_t Filter::FindClockEdgesGeneric(const bool* clk, size_t start, size_t end, ClockEdgeType type, int64_t* edges)
+{
+	//An edge of the requested type is any toggle for CLOCK_EDGE_ANY, otherwise a toggle to the right level
+	bool any = (type == CLOCK_EDGE_ANY);
+	bool level = (type == CLOCK_EDGE_RISING);
+
+	size_t count = 0;
+	for(size_t i=start; i<end; i++)
+	{
+		if( (clk[i] == clk[i-1]) || (!any && (clk[i] != level)) )
+			continue;
+
+		if(edges)
+			edges[count] = i;
+		count ++;
+	}
+	return count;
+}
+
+#ifdef __x86_64__
+/**
+	@brief AVX2 optimized version of FindClockEdgesGeneric()
+
+	Compares 32 clock samples at a time against the previous ones, then pulls edges out of the resulting bitmask.
+ */
+__attribute__((target("avx2")))
+size_t Filter::FindClockEdgesAVX2(const bool* clk, size_t start, size_t end, ClockEdgeType type, int64_t* edges)
+{
+	size_t count = 0;
+	size_t i = start;
+	__m256i zero = _mm256_setzero_si256();
+	for(; i+32 <= end; i += 32)
+	{
+		__m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(clk + i));
+		__m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(clk + i - 1));
+
+		//Bools are 0 or 1, so this leaves 1 in each byte with an edge
+		__m256i edge;
+		switch(type)
+		{
+			case CLOCK_EDGE_RISING:
+				edge = _mm256_andnot_si256(prev, cur);
+				break;
+
+			case CLOCK_EDGE_FALLING:
+				edge = _mm256_andnot_si256(cur, prev);
+				break;
+
+			case CLOCK_EDGE_ANY:
+			default:
+				edge = _mm256_xor_si256(cur, prev);
+				break;
+		}
+		uint32_t mask = _mm256_movemask_epi8(_mm256_sub_epi8(zero, edge));
+
+		if(!edges)
+			count += __builtin_popcount(mask);
+		else
+		{
+			while(mask)
+			{
+				edges[count ++] = i + __builtin_ctz(mask);
+				mask &= mask - 1;
+			}
+		}
+	}
+
+	return count + FindClockEdgesGeneric(clk, i, end, type, edges ? edges + count : NULL);
+}
+#endif /* __x86_64__ */
+
+/**
+	@brief Copies in[index[i]] to out[i] for each i
+ */
+void Filter::GatherSamples(const float* in, const int64_t* index, float* out, size_t len)
+{
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+	{
+		GatherSamplesAVX2(in, index, out, len);
+		return;
+	}
+	#endif
+
+	for(size_t i=0; i<len; i++)
+		out[i] = in[index[i]];
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+void Filter::GatherSamplesAVX2(const float* in, const int64_t* index, float* out, size_t len)
+{
+	size_t end = len - (len % 8);
+	for(size_t i=0; i<end; i += 8)
+	{
+		__m256i ilo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index + i));
+		__m256i ihi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index + i + 4));
+		__m128 lo = _mm256_i64gather_ps(in, ilo, 4);
+		__m128 hi = _mm256_i64gather_ps(in, ihi, 4);
+		_mm256_storeu_ps(out + i, _mm256_set_m128(hi, lo));
+	}
+
+	for(size_t i=end; i<len; i++)
+		out[i] = in[index[i]];
+}
+#endif /* __x86_64__ */
+
 /**
 	@brief Find rising edges in a waveform, interpolating to sub-sample resolution as necessary
  */
@@ -881,11 +1076,603 @@ void Filter::ClearAnalysisCache()
 {
 	lock_guard<mutex> lock(m_cacheMutex);
 	m_zeroCrossingCache.clear();
+	m_summaryCache.clear();
+	m_sampledDataCache.clear();
+}
+
+/**
+	@brief Looks up a memoized SampleOnAnyEdgesBase() result
+
+	@return The cached samples, or null if there are none for the current revision of both inputs
+ */
+shared_ptr<const SparseWaveformBase> Filter::LookupSampledData(WaveformBase* data, WaveformBase* clock)
+{
+	lock_guard<mutex> lock(m_cacheMutex);
+	auto it = m_sampledDataCache.find(pair<WaveformBase*, WaveformBase*>(data, clock));
+	if(it == m_sampledDataCache.end())
+		return nullptr;
+
+	auto& entry = it->second;
+	if( (entry.m_data != data) || (entry.m_clock != clock) )
+		return nullptr;
+	return entry.m_samples;
+}
+
+void Filter::StoreSampledData(WaveformBase* data, WaveformBase* clock, shared_ptr<const SparseWaveformBase> samples)
+{
+	lock_guard<mutex> lock(m_cacheMutex);
+	auto& entry = m_sampledDataCache[pair<WaveformBase*, WaveformBase*>(data, clock)];
+	entry.m_data = WaveformCacheKey(data);
+	entry.m_clock = WaveformCacheKey(clock);
+	entry.m_samples = samples;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Waveform summary statistics
+
+WaveformSummary::WaveformSummary()
+	: m_count(0)
+	, m_min(FLT_MAX)
+	, m_max(-FLT_MAX)
+	, m_sum(0)
+	, m_sumSquares(0)
+	, m_m2(0)
+{
+}
+
+/**
+	@brief Re-bins the fine histogram into a coarser one
+
+	@param bins	Number of output bins. Must divide HISTOGRAM_BINS evenly.
+ */
+vector<size_t> WaveformSummary::GetCoarseHistogram(size_t bins) const
+{
+	vector<size_t> ret(bins, 0);
+	if(m_histogram.empty() || (bins == 0))
+		return ret;
+
+	size_t ratio = HISTOGRAM_BINS / bins;
+	for(size_t i=0; i<HISTOGRAM_BINS; i++)
+		ret[i / ratio] += m_histogram[i];
+	return ret;
+}
+
+/**
+	@brief Gets the most probable "0" level, from the highest peak in the first quarter of a 100-bin histogram
+ */
+float WaveformSummary::GetBaseVoltage() const
+{
+	const size_t nbins = 100;
+	return FindMostProbableLevel(GetCoarseHistogram(nbins), 0, nbins/4);
+}
+
+/**
+	@brief Gets the most probable "1" level, from the highest peak in the last quarter of a 100-bin histogram
+ */
+float WaveformSummary::GetTopVoltage() const
+{
+	const size_t nbins = 100;
+	return FindMostProbableLevel(GetCoarseHistogram(nbins), (nbins*3)/4, nbins);
+}
+
+float WaveformSummary::FindMostProbableLevel(const vector<size_t>& hist, size_t startBin, size_t endBin) const
+{
+	size_t binval = 0;
+	size_t idx = 0;
+	for(size_t i=startBin; i<endBin; i++)
+	{
+		if(hist[i] > binval)
+		{
+			binval = hist[i];
+			idx = i;
+		}
+	}
+
+	float fbin = (idx + 0.5f)/hist.size();
+	return fbin*(m_max - m_min) + m_min;
+}
+
+/**
+	@brief Gets (and memoizes) summary statistics for an analog waveform
+
+	The summary is cached by waveform and revision until the next ClearAnalysisCache(), so every measurement on a
+	given waveform shares a single pass over the samples. The histogram needs a second pass (since it spans the
+	min/max range) and is only computed the first time it's asked for.
+
+	The caller is responsible for calling PrepareForCpuAccess() on the waveform first.
+
+	@param wfm			Analog waveform (sparse or uniform)
+	@param histogram	True if m_histogram is needed
+ */
+shared_ptr<const WaveformSummary> Filter::GetWaveformSummary(WaveformBase* wfm, bool histogram)
+{
+	//Check the cache first
+	shared_ptr<WaveformSummary> cached;
+	{
+		lock_guard<mutex> lock(m_cacheMutex);
+		auto it = m_summaryCache.find(wfm);
+		if(it != m_summaryCache.end())
+		{
+			if( (it->second->m_key == wfm) && (it->second->m_count == wfm->size()) )
+				cached = it->second;
+		}
+	}
+	if(cached && (!histogram || !cached->m_histogram.empty() || (cached->m_count == 0)) )
+		return cached;
+
+	const float* samples = nullptr;
+	auto swfm = dynamic_cast<SparseAnalogWaveform*>(wfm);
+	auto uwfm = dynamic_cast<UniformAnalogWaveform*>(wfm);
+	if(swfm)
+		samples = swfm->m_samples.GetCpuPointer();
+	else if(uwfm)
+		samples = uwfm->m_samples.GetCpuPointer();
+	else
+	{
+		LogError("Filter::GetWaveformSummary called on a non-analog waveform\n");
+		return make_shared<WaveformSummary>();
+	}
+
+	//Summaries are immutable once published, so adding the histogram makes a new one
+	auto summary = make_shared<WaveformSummary>();
+	if(cached)
+		*summary = *cached;
+	else
+	{
+		summary->m_key = WaveformCacheKey(wfm);
+		ComputeWaveformStats(samples, wfm->size(), *summary);
+	}
+	if(histogram)
+		ComputeWaveformHistogram(samples, wfm->size(), *summary);
+
+	lock_guard<mutex> lock(m_cacheMutex);
+	m_summaryCache[wfm] = summary;
+	return summary;
+}
+
+/**
+	@brief Computes min, max, sum and sum of squares in a single pass
+ */
+void Filter::ComputeWaveformStats(const float* samples, size_t count, WaveformSummary& summary)
+{
+	summary.m_count = count;
+
+	//Divide large waveforms into blocks and multithread them
+	//TODO: tune split
+	size_t numblocks = 1;
+	if(count > 1000000)
+		numblocks = omp_get_max_threads();
+
+	//Round blocks to multiples of 32 samples for clean vectorization
+	size_t blocksize = count / numblocks;
+	blocksize = blocksize - (blocksize % 32);
+	size_t lastblock = numblocks - 1;
+
+	vector<float> mins(numblocks);
+	vector<float> maxes(numblocks);
+	vector<double> sums(numblocks);
+	vector<double> sumSquares(numblocks);
+
+	#pragma omp parallel for if(numblocks > 1)
+	for(size_t i=0; i<numblocks; i++)
+	{
+		//Last block gets any extra that didn't divide evenly
+		size_t off = i*blocksize;
+		size_t nsamp = blocksize;
+		if(i == lastblock)
+			nsamp = count - off;
+
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			ComputeWaveformStatsAVX2(samples + off, nsamp, mins[i], maxes[i], sums[i], sumSquares[i]);
+		else
+		#endif
+			ComputeWaveformStatsGeneric(samples + off, nsamp, mins[i], maxes[i], sums[i], sumSquares[i]);
+	}
+
+	size_t nmerged = 0;
+	for(size_t i=0; i<numblocks; i++)
+	{
+		summary.m_min = min(summary.m_min, mins[i]);
+		summary.m_max = max(summary.m_max, maxes[i]);
+
+		//Merge the per-block deviations (Chan et al.) so large DC offsets don't cancel out the variance
+		size_t nblock = (i == lastblock) ? (count - i*blocksize) : blocksize;
+		if(nblock)
+		{
+			double blockMean = sums[i] / nblock;
+			double blockM2 = max(0.0, sumSquares[i] - sums[i]*blockMean);
+			if(nmerged == 0)
+				summary.m_m2 = blockM2;
+			else
+			{
+				double delta = blockMean - summary.m_sum / nmerged;
+				summary.m_m2 += blockM2 + delta*delta * nmerged * nblock / (nmerged + nblock);
+			}
+			nmerged += nblock;
+		}
+
+		summary.m_sum += sums[i];
+		summary.m_sumSquares += sumSquares[i];
+	}
+}
+
+void Filter::ComputeWaveformStatsGeneric(
+	const float* samples, size_t count, float& vmin, float& vmax, double& sum, double& sumSquares)
+{
+	vmin = FLT_MAX;
+	vmax = -FLT_MAX;
+	sum = 0;
+	sumSquares = 0;
+	for(size_t i=0; i<count; i++)
+	{
+		float f = samples[i];
+		vmin = min(vmin, f);
+		vmax = max(vmax, f);
+		sum += f;
+		sumSquares += (double)f * f;
+	}
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+void Filter::ComputeWaveformStatsAVX2(
+	const float* samples, size_t count, float& vmin, float& vmax, double& sum, double& sumSquares)
+{
+	size_t end = count - (count % 8);
+
+	__m256 vmins = _mm256_set1_ps(FLT_MAX);
+	__m256 vmaxes = _mm256_set1_ps(-FLT_MAX);
+
+	//Accumulate in double precision to avoid losing precision on deep captures
+	__m256d sums = _mm256_setzero_pd();
+	__m256d squares = _mm256_setzero_pd();
+
+	for(size_t i=0; i<end; i += 8)
+	{
+		__m256 v = _mm256_loadu_ps(samples + i);
+		vmins = _mm256_min_ps(vmins, v);
+		vmaxes = _mm256_max_ps(vmaxes, v);
+
+		__m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+		__m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+		sums = _mm256_add_pd(sums, _mm256_add_pd(lo, hi));
+		squares = _mm256_add_pd(squares, _mm256_add_pd(_mm256_mul_pd(lo, lo), _mm256_mul_pd(hi, hi)));
+	}
+
+	//Horizontal reduction
+	float fmins[8];
+	float fmaxes[8];
+	double dsums[4];
+	double dsquares[4];
+	_mm256_storeu_ps(fmins, vmins);
+	_mm256_storeu_ps(fmaxes, vmaxes);
+	_mm256_storeu_pd(dsums, sums);
+	_mm256_storeu_pd(dsquares, squares);
+
+	vmin = FLT_MAX;
+	vmax = -FLT_MAX;
+	for(int i=0; i<8; i++)
+	{
+		vmin = min(vmin, fmins[i]);
+		vmax = max(vmax, fmaxes[i]);
+	}
+	sum = dsums[0] + dsums[1] + dsums[2] + dsums[3];
+	sumSquares = dsquares[0] + dsquares[1] + dsquares[2] + dsquares[3];
+
+	//Get any extras we didn't get in the SIMD loop
+	for(size_t i=end; i<count; i++)
+	{
+		float f = samples[i];
+		vmin = min(vmin, f);
+		vmax = max(vmax, f);
+		sum += f;
+		sumSquares += (double)f * f;
+	}
+}
+#endif /* __x86_64__ */
+
+/**
+	@brief Fills the summary's histogram, spanning [m_min, m_max]
+
+	Out of range values are clamped the same way as MakeHistogram().
+ */
+void Filter::ComputeWaveformHistogram(const float* samples, size_t count, WaveformSummary& summary)
+{
+	const size_t bins = WaveformSummary::HISTOGRAM_BINS;
+
+	//Zero span, everything lands in the first bin
+	float low = summary.m_min;
+	float delta = summary.m_max - low;
+	if(!(delta > 0))
+	{
+		summary.m_histogram.assign(bins, 0);
+		summary.m_histogram[0] = count;
+		return;
+	}
+
+	FillHistogram(samples, count, low, summary.m_max, bins, summary.m_histogram, false);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Histograms
+
+///@brief Number of samples binned at a time, small enough that the bin indexes stay in L1
+static const size_t g_histogramChunkSize = 1024;
+
+/**
+	@brief Runs a histogram kernel over blocks of samples in parallel, then sums the per-block histograms
+
+	Each block gets its own private copy of the bins so threads never contend on a bin. Block 0 accumulates directly
+	into the output; the rest use scratch space that's kept per calling thread and reused from call to call.
+
+	Every histogram has one extra bin at the end for discarded (clipped) samples, which is removed at the end.
+
+	@param count	Number of samples
+	@param bins		Number of bins, not counting the discard bin
+	@param hist		Output histogram
+	@param kernel	Functor called as kernel(start, end, bins) to add samples [start, end) to the bins
+ */
+template<class T, class F>
+static void ParallelHistogram(size_t count, size_t bins, vector<T>& hist, F kernel)
+{
+	//Reuses the caller's capacity if it's big enough
+	hist.assign(bins + 1, 0);
+
+	//Divide large waveforms into blocks and multithread them
+	size_t numblocks = 1;
+	if(count > 1000000)
+		numblocks = omp_get_max_threads();
+	size_t blocksize = count / numblocks;
+	size_t lastblock = numblocks - 1;
+
+	//Look up the scratch space on the calling thread, since worker threads each have their own thread_local copy
+	size_t stride = bins + 1;
+	static thread_local vector<T> scratch;
+	if(numblocks > 1)
+		scratch.resize(lastblock * stride);
+	T* pscratch = scratch.data();
+	T* phist = hist.data();
+
+	#pragma omp parallel for if(numblocks > 1)
+	for(size_t i=0; i<numblocks; i++)
+	{
+		size_t off = i*blocksize;
+		size_t end = (i == lastblock) ? count : off + blocksize;
+
+		T* blockbins = phist;
+		if(i > 0)
+		{
+			blockbins = pscratch + (i-1)*stride;
+			memset(blockbins, 0, stride * sizeof(T));
+		}
+
+		kernel(off, end, blockbins);
+	}
+
+	//Merge the per-block histograms
+	if(numblocks > 1)
+	{
+		#pragma omp parallel for if(bins > 100000)
+		for(size_t j=0; j<bins; j++)
+		{
+			T total = phist[j];
+			for(size_t i=0; i<lastblock; i++)
+				total += pscratch[i*stride + j];
+			phist[j] = total;
+		}
+	}
+
+	hist.pop_back();
+}
+
+/**
+	@brief Makes a histogram of an array of samples, reusing the caller's storage
+
+	The bin indexes are calculated with SIMD, then each thread counts a block of samples into its own private bins.
+
+	@param samples	Input samples
+	@param count	Number of samples
+	@param low		Low endpoint of the histogram
+	@param high		High endpoint of the histogram
+	@param bins		Number of histogram bins
+	@param hist		Output histogram (resized to bins)
+	@param clip		If true, out of range values are discarded. If false, they're clamped to bin 0 or bins-1.
+ */
+void Filter::FillHistogram(
+	const float* samples,
+	size_t count,
+	float low,
+	float high,
+	size_t bins,
+	vector<size_t>& hist,
+	bool clip)
+{
+	//Early out if we have zero span
+	if(bins == 0)
+	{
+		hist.clear();
+		return;
+	}
+
+	float scale = bins / (high - low);
+	ParallelHistogram(count, bins, hist,
+		[&](size_t start, size_t end, size_t* data)
+		{
+			int32_t indexes[g_histogramChunkSize];
+			for(size_t base=start; base<end; base += g_histogramChunkSize)
+			{
+				size_t n = min(g_histogramChunkSize, end - base);
+				ComputeHistogramBins(samples + base, n, low, scale, bins, clip, indexes);
+				for(size_t i=0; i<n; i++)
+					data[indexes[i]] ++;
+			}
+		});
+}
+
+/**
+	@brief Calculates the histogram bin of each sample
+
+	Clamped values go to bin 0 or bins-1. Clipped values (and NaNs) go to bin "bins", which the caller discards.
+ */
+void Filter::ComputeHistogramBins(
+	const float* samples, size_t count, float low, float scale, size_t bins, bool clip, int32_t* indexes)
+{
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		ComputeHistogramBinsAVX2(samples, count, low, scale, bins, clip, indexes);
+	else
+	#endif
+		ComputeHistogramBinsGeneric(samples, count, low, scale, bins, clip, indexes);
+}
+
+void Filter::ComputeHistogramBinsGeneric(
+	const float* samples, size_t count, float low, float scale, size_t bins, bool clip, int32_t* indexes)
+{
+	float fbins = bins;
+	float maxbin = bins - 1;
+	for(size_t i=0; i<count; i++)
+	{
+		float fbin = (samples[i] - low) * scale;
+		if(clip)
+		{
+			if( (fbin >= 0) && (fbin < fbins) )
+				indexes[i] = fbin;
+			else
+				indexes[i] = bins;
+		}
+		else
+		{
+			if(!(fbin >= 0))
+				fbin = 0;
+			else if(fbin > maxbin)
+				fbin = maxbin;
+			indexes[i] = fbin;
+		}
+	}
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+void Filter::ComputeHistogramBinsAVX2(
+	const float* samples, size_t count, float low, float scale, size_t bins, bool clip, int32_t* indexes)
+{
+	size_t end = count - (count % 8);
+
+	__m256 vlow = _mm256_set1_ps(low);
+	__m256 vscale = _mm256_set1_ps(scale);
+	__m256 vzero = _mm256_setzero_ps();
+	__m256 vbins = _mm256_set1_ps(bins);
+	__m256 vmaxbin = _mm256_set1_ps(bins - 1);
+	__m256i vdiscard = _mm256_set1_epi32(bins);
+
+	if(clip)
+	{
+		for(size_t i=0; i<end; i += 8)
+		{
+			__m256 fbin = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(samples + i), vlow), vscale);
+
+			//Ordered compares, so NaNs are out of range too
+			__m256 valid = _mm256_and_ps(
+				_mm256_cmp_ps(fbin, vzero, _CMP_GE_OQ),
+				_mm256_cmp_ps(fbin, vbins, _CMP_LT_OQ));
+			__m256i bin = _mm256_blendv_epi8(vdiscard, _mm256_cvttps_epi32(fbin), _mm256_castps_si256(valid));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(indexes + i), bin);
+		}
+	}
+	else
+	{
+		for(size_t i=0; i<end; i += 8)
+		{
+			__m256 fbin = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(samples + i), vlow), vscale);
+
+			//max_ps returns the second operand if either is NaN, so NaNs land in bin 0
+			fbin = _mm256_min_ps(_mm256_max_ps(fbin, vzero), vmaxbin);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(indexes + i), _mm256_cvttps_epi32(fbin));
+		}
+	}
+
+	//Get any extras we didn't get in the SIMD loop
+	ComputeHistogramBinsGeneric(samples + end, count - end, low, scale, bins, clip, indexes + end);
+}
+#endif /* __x86_64__ */
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Helpers for various common boilerplate operations
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Segmented acquisitions
+
+/**
+	@brief Creates an empty, CPU-side waveform for each segment's results in RefreshSegmentBatch()
+
+	The results only live until FinishSegmentBatch(), so nothing proportional to the batch size is kept between
+	refreshes.
+
+	@return Start time of the batch, for performance logging
+ */
+double Filter::BeginSegmentBatch(SegmentedAnalogWaveform* batch, vector<SparseAnalogWaveform*>& results)
+{
+	size_t nseg = batch->GetSegmentCount();
+	results.resize(nseg);
+	for(size_t i=0; i<nseg; i++)
+	{
+		auto out = new SparseAnalogWaveform;
+		out->SetGpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);
+		out->m_timescale = 1;
+		out->m_triggerPhase = 0;
+		results[i] = out;
+	}
+
+	return GetTime();
+}
+
+/**
+	@brief Generates the per-segment trend output from the results of each segment, then frees the results
+ */
+void Filter::FinishSegmentBatch(SegmentedAnalogWaveform* batch, vector<SparseAnalogWaveform*>& results, double start)
+{
+	auto cap = SetupEmptySparseAnalogOutputWaveform(batch, 0, true);
+	cap->m_timescale = 1;
+	cap->m_triggerPhase = 0;
+	cap->PrepareForCpuAccess();
+
+	size_t nseg = batch->GetSegmentCount();
+	for(size_t i=0; i<nseg; i++)
+	{
+		auto out = results[i];
+		size_t len = out->size();
+		if(len == 0)
+		{
+			delete out;
+			continue;
+		}
+
+		double sum = 0;
+		for(size_t j=0; j<len; j++)
+			sum += out->m_samples[j];
+
+		//Each point lasts until the next segment's trigger
+		int64_t offset = batch->GetSegmentOffset(i);
+		int64_t duration;
+		if(i+1 < nseg)
+			duration = batch->GetSegmentOffset(i+1) - offset;
+		else
+			duration = batch->GetSegment(i)->size() * batch->m_timescale;
+
+		cap->m_offsets.push_back(offset);
+		cap->m_durations.push_back(duration);
+		cap->m_samples.push_back(sum / len);
+		delete out;
+	}
+	results.clear();
+
+	cap->MarkModifiedFromCpu();
+
+	LogTrace("%s: measured %zu segments in %.3f ms\n",
+		GetHwname().c_str(), nseg, (GetTime() - start) * 1000);
+}
+
 /**
 	@brief Sets up an analog output waveform and copies basic metadata from the input.
 
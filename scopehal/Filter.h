@@ -73,6 +73,51 @@ public:
 	uint64_t m_rev;
 };
 
+/**
+	@brief Summary statistics for one revision of an analog waveform
+
+	Computed once by Filter::GetWaveformSummary() and shared by every measurement and statistic that needs any of
+	these values, so a probe with several measurements attached only walks its samples once or twice.
+ */
+class WaveformSummary
+{
+public:
+	WaveformSummary();
+
+	float GetBaseVoltage() const;
+	float GetTopVoltage() const;
+	std::vector<size_t> GetCoarseHistogram(size_t bins) const;
+
+	///@brief Arithmetic mean of all samples
+	float GetAverage() const
+	{ return m_sum / m_count; }
+
+	///@brief Waveform revision this summary was computed from
+	WaveformCacheKey m_key;
+
+	///@brief Population variance of all samples
+	double GetVariance() const
+	{ return m_count ? (m_m2 / m_count) : 0; }
+
+	size_t m_count;
+	float m_min;
+	float m_max;
+	double m_sum;
+	double m_sumSquares;
+
+	///@brief Sum of squared deviations from the mean (merged per block, so it doesn't suffer from cancellation)
+	double m_m2;
+
+	///@brief Number of bins in m_histogram (a multiple of every bin count GetCoarseHistogram() is used with)
+	static const size_t HISTOGRAM_BINS = 1600;
+
+	///@brief Histogram spanning [m_min, m_max], or empty if not requested
+	std::vector<size_t> m_histogram;
+
+protected:
+	float FindMostProbableLevel(const std::vector<size_t>& hist, size_t startBin, size_t endBin) const;
+};
+
 /**
 	@brief Abstract base class for all filters and protocol decoders
  */
@@ -279,6 +324,48 @@ public:
 			return GetNextEventTimestampScaled(uwfm, i, len, timestamp);
 	}
 
+protected:
+	/**
+		@brief Runs a measurement on every segment of a sequence acquisition, if the input is one
+
+		Segments are measured in place and in parallel, each as its own waveform. The output (stream 0) has one point
+		per segment, at its trigger time, holding the mean of that segment's results. Statistics on the output then
+		give aggregates over the whole acquisition.
+
+		@param din		Input waveform, already prepared for CPU access
+		@param measure	Called as measure(segment, cap) with an empty CPU-side output. Must be thread safe, and
+						return false if there was nothing to measure in the segment.
+
+		@return	True if din was a SegmentedAnalogWaveform and the output has been set up, false if the caller
+				should measure it normally
+	 */
+	template<class F>
+	bool RefreshSegmentBatch(WaveformBase* din, F measure)
+	{
+		auto batch = dynamic_cast<SegmentedAnalogWaveform*>(din);
+		if(!batch)
+			return false;
+
+		std::vector<SparseAnalogWaveform*> results;
+		double start = BeginSegmentBatch(batch, results);
+
+		size_t nseg = batch->GetSegmentCount();
+		#pragma omp parallel for if(nseg > 1)
+		for(size_t i=0; i<nseg; i++)
+		{
+			auto seg = batch->GetSegment(i);
+			seg->PrepareForCpuAccess();
+			if(!measure(seg, results[i]))
+				results[i]->clear();
+		}
+
+		FinishSegmentBatch(batch, results, start);
+		return true;
+	}
+
+	double BeginSegmentBatch(SegmentedAnalogWaveform* batch, std::vector<SparseAnalogWaveform*>& results);
+	void FinishSegmentBatch(SegmentedAnalogWaveform* batch, std::vector<SparseAnalogWaveform*>& results, double start);
+
 protected:
 	UniformAnalogWaveform* SetupEmptyUniformAnalogOutputWaveform(WaveformBase* din, size_t stream, bool clear=true);
 	SparseAnalogWaveform* SetupEmptySparseAnalogOutputWaveform(WaveformBase* din, size_t stream, bool clear=true);
@@ -287,6 +374,37 @@ protected:
 	SparseAnalogWaveform* SetupSparseOutputWaveform(SparseWaveformBase* din, size_t stream, size_t skipstart, size_t skipend);
 	SparseDigitalWaveform* SetupSparseDigitalOutputWaveform(SparseWaveformBase* din, size_t stream, size_t skipstart, size_t skipend);
 
+	/**
+		@brief Sets up an empty output waveform of any type and copies basic metadata from the input.
+
+		The existing output is reused (keeping its allocations, e.g. the SymbolArena of an ArenaSparseWaveform) if it
+		is already of the requested type.
+
+		@param din			Input waveform
+		@param stream		Stream index
+
+		@return	The ready-to-use output waveform
+	 */
+	template<class W>
+	W* SetupEmptyOutputWaveform(WaveformBase* din, size_t stream)
+	{
+		auto cap = dynamic_cast<W*>(GetData(stream));
+		if(cap == NULL)
+		{
+			cap = new W;
+			SetData(cap, stream);
+		}
+
+		cap->m_startTimestamp 		= din->m_startTimestamp;
+		cap->m_startFemtoseconds	= din->m_startFemtoseconds;
+		cap->m_triggerPhase			= din->m_triggerPhase;
+		cap->m_timescale			= din->m_timescale;
+		cap->m_revision ++;
+		cap->clear();
+
+		return cap;
+	}
+
 public:
 	//Helpers for sub-sample interpolation
 
@@ -347,25 +465,16 @@ public:
 	static float InterpolateValue(UniformAnalogWaveform* cap, size_t index, float frac_ticks);
 
 	//Helpers for more complex measurements
-	//TODO: create some process for caching this so we don't waste CPU time
+	//These are all backed by the memoized WaveformSummary, so calling several of them on one waveform is cheap
 
 	/**
 		@brief Gets the lowest voltage of a waveform
 	 */
 	template<class T>
-	__attribute__((noinline))
 	static float GetMinVoltage(T* cap)
 	{
 		AssertTypeIsAnalogWaveform(cap);
-
-		//Loop over samples and find the minimum
-		float tmp = FLT_MAX;
-		for(float f : cap->m_samples)
-		{
-			if(f < tmp)
-				tmp = f;
-		}
-		return tmp;
+		return GetWaveformSummary(cap, false)->m_min;
 	}
 
 	/**
@@ -383,19 +492,10 @@ public:
 		@brief Gets the highest voltage of a waveform
 	 */
 	template<class T>
-	__attribute__((noinline))
 	static float GetMaxVoltage(T* cap)
 	{
 		AssertTypeIsAnalogWaveform(cap);
-
-		//Loop over samples and find the maximum
-		float tmp = -FLT_MAX;
-		for(float f : cap->m_samples)
-		{
-			if(f > tmp)
-				tmp = f;
-		}
-		return tmp;
+		return GetWaveformSummary(cap, false)->m_max;
 	}
 
 	/**
@@ -413,31 +513,10 @@ public:
 		@brief Gets the most probable "0" level for a digital waveform
 	 */
 	template<class T>
-	__attribute__((noinline))
 	static float GetBaseVoltage(T* cap)
 	{
 		AssertTypeIsAnalogWaveform(cap);
-
-		float vmin = GetMinVoltage(cap);
-		float vmax = GetMaxVoltage(cap);
-		float delta = vmax - vmin;
-		const int nbins = 100;
-		auto hist = MakeHistogram(cap, vmin, vmax, nbins);
-
-		//Find the highest peak in the first quarter of the histogram
-		size_t binval = 0;
-		int idx = 0;
-		for(int i=0; i<(nbins/4); i++)
-		{
-			if(hist[i] > binval)
-			{
-				binval = hist[i];
-				idx = i;
-			}
-		}
-
-		float fbin = (idx + 0.5f)/nbins;
-		return fbin*delta + vmin;
+		return GetWaveformSummary(cap)->GetBaseVoltage();
 	}
 
 	/**
@@ -455,31 +534,10 @@ public:
 		@brief Gets the most probable "1" level for a digital waveform
 	 */
 	template<class T>
-	__attribute__((noinline))
 	static float GetTopVoltage(T* cap)
 	{
 		AssertTypeIsAnalogWaveform(cap);
-
-		float vmin = GetMinVoltage(cap);
-		float vmax = GetMaxVoltage(cap);
-		float delta = vmax - vmin;
-		const int nbins = 100;
-		auto hist = MakeHistogram(cap, vmin, vmax, nbins);
-
-		//Find the highest peak in the third quarter of the histogram
-		size_t binval = 0;
-		int idx = 0;
-		for(int i=(nbins*3)/4; i<nbins; i++)
-		{
-			if(hist[i] > binval)
-			{
-				binval = hist[i];
-				idx = i;
-			}
-		}
-
-		float fbin = (idx + 0.5f)/nbins;
-		return fbin*delta + vmin;
+		return GetWaveformSummary(cap)->GetTopVoltage();
 	}
 
 	/**
@@ -497,17 +555,10 @@ public:
 		@brief Gets the average voltage of a waveform
 	 */
 	template<class T>
-	__attribute__((noinline))
 	static float GetAvgVoltage(T* cap)
 	{
 		AssertTypeIsAnalogWaveform(cap);
-
-		//Loop over samples and find the average
-		//TODO: more numerically stable summation algorithm for deep captures
-		double sum = 0;
-		for(float f : cap->m_samples)
-			sum += f;
-		return sum / cap->m_samples.size();
+		return GetWaveformSummary(cap, false)->GetAverage();
 	}
 
 	/**
@@ -521,43 +572,66 @@ public:
 			return GetAvgVoltage(uwfm);
 	}
 
+	static void FillHistogram(
+		const float* samples,
+		size_t count,
+		float low,
+		float high,
+		size_t bins,
+		std::vector<size_t>& hist,
+		bool clip = false);
+
 	/**
-		@brief Makes a histogram from a waveform with the specified number of bins.
+		@brief Makes a histogram from a waveform with the specified number of bins, reusing the caller's storage
 
 		Any values outside the range are clamped (put in bin 0 or bins-1 as appropriate).
 
 		@param low	Low endpoint of the histogram (volts)
 		@param high High endpoint of the histogram (volts)
 		@param bins	Number of histogram bins
+		@param hist	Output histogram (resized to bins)
 	 */
 	template<class T>
-	__attribute__((noinline))
-	static std::vector<size_t> MakeHistogram(T* cap, float low, float high, size_t bins)
+	static void MakeHistogram(T* cap, float low, float high, size_t bins, std::vector<size_t>& hist)
 	{
 		AssertTypeIsAnalogWaveform(cap);
+		FillHistogram(cap->m_samples.GetCpuPointer(), cap->size(), low, high, bins, hist, false);
+	}
 
-		std::vector<size_t> ret;
-		for(size_t i=0; i<bins; i++)
-			ret.push_back(0);
+	/**
+		@brief Makes a histogram from a waveform with the specified number of bins.
 
-		//Early out if we have zero span
-		if(bins == 0)
-			return ret;
+		Any values outside the range are clamped (put in bin 0 or bins-1 as appropriate).
 
-		float delta = high-low;
+		@param low	Low endpoint of the histogram (volts)
+		@param high High endpoint of the histogram (volts)
+		@param bins	Number of histogram bins
+	 */
+	template<class T>
+	static std::vector<size_t> MakeHistogram(T* cap, float low, float high, size_t bins)
+	{
+		std::vector<size_t> ret;
+		MakeHistogram(cap, low, high, bins, ret);
+		return ret;
+	}
 
-		for(float v : cap->m_samples)
-		{
-			float fbin = (v-low) / delta;
-			size_t bin = floor(fbin * bins);
-			if(fbin < 0)
-				bin = 0;
-			else
-				bin = std::min(bin, bins-1);
-			ret[bin] ++;
-		}
+	/**
+		@brief Makes a histogram from a waveform with the specified number of bins, reusing the caller's storage
 
-		return ret;
+		Any values outside the range are clamped (put in bin 0 or bins-1 as appropriate).
+
+		@param low	Low endpoint of the histogram (volts)
+		@param high High endpoint of the histogram (volts)
+		@param bins	Number of histogram bins
+		@param hist	Output histogram (resized to bins)
+	 */
+	static void MakeHistogram(
+		SparseAnalogWaveform* s, UniformAnalogWaveform* u, float low, float high, size_t bins, std::vector<size_t>& hist)
+	{
+		if(s)
+			MakeHistogram(s, low, high, bins, hist);
+		else
+			MakeHistogram(u, low, high, bins, hist);
 	}
 
 	/**
@@ -572,10 +646,9 @@ public:
 	static std::vector<size_t> MakeHistogram(
 		SparseAnalogWaveform* s, UniformAnalogWaveform* u, float low, float high, size_t bins)
 	{
-		if(s)
-			return MakeHistogram(s, low, high, bins);
-		else
-			return MakeHistogram(u, low, high, bins);
+		std::vector<size_t> ret;
+		MakeHistogram(s, u, low, high, bins, ret);
+		return ret;
 	}
 
 	/**
@@ -588,35 +661,162 @@ public:
 		@param bins	Number of histogram bins
 	 */
 	template<class T>
-	__attribute__((noinline))
 	static std::vector<size_t> MakeHistogramClipped(T* cap, float low, float high, size_t bins)
 	{
 		AssertTypeIsAnalogWaveform(cap);
 
 		std::vector<size_t> ret;
-		for(size_t i=0; i<bins; i++)
-			ret.push_back(0);
+		FillHistogram(cap->m_samples.GetCpuPointer(), cap->size(), low, high, bins, ret, true);
+		return ret;
+	}
+
+	///@brief Clock edges to sample on
+	enum ClockEdgeType
+	{
+		CLOCK_EDGE_RISING,
+		CLOCK_EDGE_FALLING,
+		CLOCK_EDGE_ANY
+	};
+
+	///@brief Number of clock samples processed as one block by SampleOnEdges()
+	static const size_t SAMPLE_EDGE_BLOCK = 262144;
+
+	static size_t FindClockEdges(const bool* clk, size_t start, size_t end, ClockEdgeType type, int64_t* edges);
 
-		//Early out if we have zero span
-		if(bins == 0)
-			return ret;
+	/**
+		@brief Finds the sample of a uniform waveform in effect at a given time
+
+		@param data		The waveform
+		@param dlen		Number of samples in the waveform (must be nonzero)
+		@param t		Timestamp, in femtoseconds
+		@param hint		Ignored (the index is computed directly)
+
+		@return	Index of the last sample starting before t, or 0 if there is none
+	 */
+	static size_t FindSampleBefore(UniformWaveformBase* data, size_t dlen, int64_t t, size_t /*hint*/)
+	{
+		int64_t delta = t - data->m_triggerPhase;
+		if(delta <= 0)
+			return 0;
+		return std::min( (size_t)( (delta - 1) / data->m_timescale ), dlen - 1);
+	}
+
+	/**
+		@brief Finds the sample of a sparse waveform in effect at a given time
 
-		float delta = high-low;
+		Gallops forward from the previous result, then binary searches, so both dense and widely spaced lookups are
+		cheap.
 
-		for(float v : cap->m_samples)
+		@param data		The waveform
+		@param dlen		Number of samples in the waveform (must be nonzero)
+		@param t		Timestamp, in femtoseconds
+		@param hint		Index of a sample known to start before t (or 0)
+
+		@return	Index of the last sample starting before t, or hint if there is none after it
+	 */
+	static size_t FindSampleBefore(SparseWaveformBase* data, size_t dlen, int64_t t, size_t hint)
+	{
+		const int64_t* offs = data->m_offsets.GetCpuPointer();
+		int64_t target = t - data->m_triggerPhase;
+		int64_t ts = data->m_timescale;
+
+		//Gallop until we overshoot
+		size_t lo = hint;
+		size_t step = 1;
+		while( (lo + step < dlen) && (offs[lo + step] * ts < target) )
 		{
-			float fbin = (v-low) / delta;
-			size_t bin = floor(fbin * bins);
-			if(bin >= bins)	//negative values wrap to huge positive and get caught here
-				continue;
-			ret[bin] ++;
+			lo += step;
+			step <<= 1;
 		}
 
-		return ret;
+		//The answer is now in [lo, hi)
+		size_t hi = std::min(lo + step, dlen);
+		while(hi - lo > 1)
+		{
+			size_t mid = lo + (hi - lo)/2;
+			if(offs[mid] * ts < target)
+				lo = mid;
+			else
+				hi = mid;
+		}
+		return lo;
 	}
 
 	/**
-		@brief Samples a waveform on all edges of a clock
+		@brief Copies in[index[i]] to out[i] for each i
+	 */
+	template<class S>
+	static void GatherSamples(const S* in, const int64_t* index, S* out, size_t len)
+	{
+		for(size_t i=0; i<len; i++)
+			out[i] = in[index[i]];
+	}
+
+	static void GatherSamples(const float* in, const int64_t* index, float* out, size_t len);
+
+	/**
+		@brief Finds the clock edges to sample on, and the data sample in effect at each one
+
+		The output is sized up front: the clock is scanned once to count edges in each block, then again to fill in
+		the edges, with blocks processed in parallel.
+
+		On return, samples.m_offsets holds the edge timestamps (in femtoseconds) and samples.m_durations holds the
+		index of the data sample at each edge. The caller is expected to fill in samples.m_samples, then the durations.
+
+		@param data		The data signal to sample. Can be be sparse or uniform of any type.
+		@param clock	The clock signal to use. Must be sparse or uniform digital.
+		@param samples	Output waveform
+		@param type		Edges to sample on
+	 */
+	template<class T, class R, class S>
+	static void FindSampleEdges(T* data, R* clock, SparseWaveform<S>& samples, ClockEdgeType type)
+	{
+		samples.clear();
+		samples.SetGpuAccessHint(AcceleratorBuffer<S>::HINT_NEVER);	//assume we're being used as part of a CPU-side filter
+		samples.PrepareForCpuAccess();
+
+		size_t len = clock->size();
+		size_t dlen = data->size();
+		if( (len < 2) || (dlen == 0) )
+			return;
+
+		//Count edges in each block
+		const bool* clk = clock->m_samples.GetCpuPointer();
+		size_t nblocks = (len + SAMPLE_EDGE_BLOCK - 1) / SAMPLE_EDGE_BLOCK;
+		std::vector<size_t> base(nblocks + 1, 0);
+		#pragma omp parallel for if(nblocks > 1)
+		for(size_t i=0; i<nblocks; i++)
+		{
+			size_t start = std::max(i * SAMPLE_EDGE_BLOCK, (size_t)1);
+			size_t end = std::min((i+1) * SAMPLE_EDGE_BLOCK, len);
+			base[i+1] = FindClockEdges(clk, start, end, type, NULL);
+		}
+		for(size_t i=0; i<nblocks; i++)
+			base[i+1] += base[i];
+		samples.Resize(base[nblocks]);
+
+		//Find the edges again, this time saving them, and look up the data sample at each
+		int64_t* offs = samples.m_offsets.GetCpuPointer();
+		int64_t* index = samples.m_durations.GetCpuPointer();
+		#pragma omp parallel for if(nblocks > 1)
+		for(size_t i=0; i<nblocks; i++)
+		{
+			size_t start = std::max(i * SAMPLE_EDGE_BLOCK, (size_t)1);
+			size_t end = std::min((i+1) * SAMPLE_EDGE_BLOCK, len);
+			FindClockEdges(clk, start, end, type, offs + base[i]);
+
+			size_t ndata = 0;
+			for(size_t j=base[i]; j<base[i+1]; j++)
+			{
+				offs[j] = GetOffsetScaled(clock, offs[j]);
+				ndata = FindSampleBefore(data, dlen, offs[j], ndata);
+				index[j] = ndata;
+			}
+		}
+	}
+
+	/**
+		@brief Samples a waveform on edges of a clock
 
 		The sampling rate of the data and clock signals need not be equal or uniform.
 
@@ -626,55 +826,63 @@ public:
 		@param data		The data signal to sample. Can be be sparse or uniform of any type.
 		@param clock	The clock signal to use. Must be sparse or uniform digital.
 		@param samples	Output waveform. Must be sparse and same data type as data.
+		@param type		Edges to sample on
 	 */
 	template<class T, class R, class S>
 	__attribute__((noinline))
-	static void SampleOnAnyEdges(T* data, R* clock, SparseWaveform<S>& samples)
+	static void SampleOnEdges(T* data, R* clock, SparseWaveform<S>& samples, ClockEdgeType type)
 	{
 		//Compile-time check to make sure inputs are correct types
 		AssertTypeIsDigitalWaveform(clock);
+		AssertTypeIsSparseWaveform(&samples);
 		AssertSampleTypesAreSame(data, &samples);
 
-		samples.clear();
-		samples.SetGpuAccessHint(AcceleratorBuffer<S>::HINT_NEVER);	//assume we're being used as part of a CPU-side filter
-		samples.PrepareForCpuAccess();
+		FindSampleEdges(data, clock, samples, type);
 
-		//TODO: split up into blocks and multithread?
-		//TODO: AVX vcompress?
-
-		size_t len = clock->size();
-		size_t dlen = data->size();
-
-		size_t ndata = 0;
-		for(size_t i=1; i<len; i++)
+		//Gather the data samples
+		size_t len = samples.size();
+		size_t nblocks = (len + SAMPLE_EDGE_BLOCK - 1) / SAMPLE_EDGE_BLOCK;
+		const S* din = data->m_samples.GetCpuPointer();
+		const int64_t* index = samples.m_durations.GetCpuPointer();
+		S* dout = samples.m_samples.GetCpuPointer();
+		#pragma omp parallel for if(nblocks > 1)
+		for(size_t i=0; i<nblocks; i++)
 		{
-			//Throw away clock samples until we find an edge
-			if(clock->m_samples[i] == clock->m_samples[i-1])
-				continue;
-
-			//Throw away data samples until the data is synced with us
-			int64_t clkstart = GetOffsetScaled(clock, i);
-			while( (ndata+1 < dlen) && (GetOffsetScaled(data, ndata+1) < clkstart) )
-				ndata ++;
-			if(ndata >= dlen)
-				break;
-
-			//Add the new sample
-			samples.m_offsets.push_back(clkstart);
-			samples.m_samples.push_back(data->m_samples[ndata]);
+			size_t start = i * SAMPLE_EDGE_BLOCK;
+			size_t end = std::min(start + SAMPLE_EDGE_BLOCK, len);
+			GatherSamples(din, index + start, dout + start, end - start);
 		}
 
 		//Compute sample durations
-		#ifdef __x86_64__
-		if(g_hasAvx2)
-			FillDurationsAVX2(samples);
-		else
-		#endif
-			FillDurationsGeneric(samples);
+		if(len)
+		{
+			#ifdef __x86_64__
+			if(g_hasAvx2)
+				FillDurationsAVX2(samples);
+			else
+			#endif
+				FillDurationsGeneric(samples);
+		}
 
 		samples.MarkModifiedFromCpu();
 	}
 
+	/**
+		@brief Samples a waveform on all edges of a clock
+
+		The sampling rate of the data and clock signals need not be equal or uniform.
+
+		The sampled waveform is sparse and has a time scale in femtoseconds,
+		regardless of the incoming waveform's time scale and sampling uniformity.
+
+		@param data		The data signal to sample. Can be be sparse or uniform of any type.
+		@param clock	The clock signal to use. Must be sparse or uniform digital.
+		@param samples	Output waveform. Must be sparse and same data type as data.
+	 */
+	template<class T, class R, class S>
+	static void SampleOnAnyEdges(T* data, R* clock, SparseWaveform<S>& samples)
+	{ SampleOnEdges(data, clock, samples, CLOCK_EDGE_ANY); }
+
 	/**
 		@brief Samples a waveform on all edges of a clock
 
@@ -724,52 +932,8 @@ public:
 		@param samples	Output waveform. Must be sparse and same data type as data.
 	 */
 	template<class T, class R, class S>
-	__attribute__((noinline))
 	static void SampleOnRisingEdges(T* data, R* clock, SparseWaveform<S>& samples)
-	{
-		//Compile-time check to make sure inputs are correct types
-		AssertTypeIsDigitalWaveform(clock);
-		AssertTypeIsSparseWaveform(&samples);
-		AssertSampleTypesAreSame(data, &samples);
-
-		samples.clear();
-		samples.SetGpuAccessHint(AcceleratorBuffer<S>::HINT_NEVER);	//assume we're being used as part of a CPU-side filter
-
-		//TODO: split up into blocks and multithread?
-		//TODO: AVX vcompress?
-
-		size_t len = clock->size();
-		size_t dlen = data->size();
-
-		size_t ndata = 0;
-		for(size_t i=1; i<len; i++)
-		{
-			//Throw away clock samples until we find a rising edge
-			if(!(clock->m_samples[i] && !clock->m_samples[i-1]))
-				continue;
-
-			//Throw away data samples until the data is synced with us
-			int64_t clkstart = GetOffsetScaled(clock, i);
-			while( (ndata+1 < dlen) && (GetOffsetScaled(data, ndata+1) < clkstart) )
-				ndata ++;
-			if(ndata >= dlen)
-				break;
-
-			//Add the new sample
-			samples.m_offsets.push_back(clkstart);
-			samples.m_samples.push_back(data->m_samples[ndata]);
-		}
-
-		//Compute sample durations
-		#ifdef __x86_64__
-		if(g_hasAvx2)
-			FillDurationsAVX2(samples);
-		else
-		#endif
-			FillDurationsGeneric(samples);
-
-		samples.MarkModifiedFromCpu();
-	}
+	{ SampleOnEdges(data, clock, samples, CLOCK_EDGE_RISING); }
 
 	/**
 		@brief Samples a waveform on rising edges of a clock
@@ -798,13 +962,13 @@ public:
 		auto sclock = dynamic_cast<SparseDigitalWaveform*>(clock);
 
 		if(udata && uclock)
-			SampleOnAnyEdges(udata, uclock, samples);
+			SampleOnRisingEdges(udata, uclock, samples);
 		else if(udata && sclock)
-			SampleOnAnyEdges(udata, sclock, samples);
+			SampleOnRisingEdges(udata, sclock, samples);
 		else if(sdata && sclock)
-			SampleOnAnyEdges(sdata, sclock, samples);
+			SampleOnRisingEdges(sdata, sclock, samples);
 		else if(sdata && uclock)
-			SampleOnAnyEdges(sdata, uclock, samples);
+			SampleOnRisingEdges(sdata, uclock, samples);
 	}
 
 	/**
@@ -820,52 +984,8 @@ public:
 		@param samples	Output waveform. Must be sparse and same data type as data.
 	 */
 	template<class T, class R, class S>
-	__attribute__((noinline))
 	static void SampleOnFallingEdges(T* data, R* clock, SparseWaveform<S>& samples)
-	{
-		//Compile-time check to make sure inputs are correct types
-		AssertTypeIsDigitalWaveform(clock);
-		AssertTypeIsSparseWaveform(&samples);
-		AssertSampleTypesAreSame(data, &samples);
-
-		samples.clear();
-		samples.SetGpuAccessHint(AcceleratorBuffer<S>::HINT_NEVER);	//assume we're being used as part of a CPU-side filter
-
-		//TODO: split up into blocks and multithread?
-		//TODO: AVX vcompress?
-
-		size_t len = clock->size();
-		size_t dlen = data->size();
-
-		size_t ndata = 0;
-		for(size_t i=1; i<len; i++)
-		{
-			//Throw away clock samples until we find a falling edge
-			if(!(!clock->m_samples[i] && clock->m_samples[i-1]))
-				continue;
-
-			//Throw away data samples until the data is synced with us
-			int64_t clkstart = GetOffsetScaled(clock, i);
-			while( (ndata+1 < dlen) && (GetOffsetScaled(data, ndata+1) < clkstart) )
-				ndata ++;
-			if(ndata >= dlen)
-				break;
-
-			//Add the new sample
-			samples.m_offsets.push_back(clkstart);
-			samples.m_samples.push_back(data->m_samples[ndata]);
-		}
-
-		//Compute sample durations
-		#ifdef __x86_64__
-		if(g_hasAvx2)
-			FillDurationsAVX2(samples);
-		else
-		#endif
-			FillDurationsGeneric(samples);
-
-		samples.MarkModifiedFromCpu();
-	}
+	{ SampleOnEdges(data, clock, samples, CLOCK_EDGE_FALLING); }
 
 	/**
 		@brief Samples an analog waveform on all edges of a clock, interpolating linearly to get sub-sample accuracy.
@@ -886,46 +1006,33 @@ public:
 		AssertTypeIsAnalogWaveform(data);
 		AssertTypeIsDigitalWaveform(clock);
 
-		samples.clear();
-		samples.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_NEVER);	//assume we're being used as part of a CPU-side filter
-
-		//TODO: split up into blocks and multithread?
-		//TODO: AVX vcompress
-
-		size_t len = clock->size();
-		size_t dlen = data->size();
+		FindSampleEdges(data, clock, samples, CLOCK_EDGE_ANY);
 
-		size_t ndata = 0;
-		for(size_t i=1; i<len; i++)
+		size_t len = samples.size();
+		const int64_t* offs = samples.m_offsets.GetCpuPointer();
+		const int64_t* index = samples.m_durations.GetCpuPointer();
+		float* dout = samples.m_samples.GetCpuPointer();
+		#pragma omp parallel for if(len > SAMPLE_EDGE_BLOCK)
+		for(size_t i=0; i<len; i++)
 		{
-			//Throw away clock samples until we find an edge
-			if(clock->m_samples[i] == clock->m_samples[i-1])
-				continue;
-
-			//Throw away data samples until the data is synced with us
-			int64_t clkstart = GetOffsetScaled(clock, i);
-			while( (ndata+1 < dlen) && (GetOffsetScaled(data, ndata+1) < clkstart) )
-				ndata ++;
-			if(ndata >= dlen)
-				break;
-
 			//Find the fractional position of the clock edge
-			int64_t tsample = GetOffsetScaled(data, ndata);
-			int64_t delta = clkstart - tsample;
+			size_t ndata = index[i];
+			int64_t delta = offs[i] - GetOffsetScaled(data, ndata);
 			float frac = delta * 1.0 / data->m_timescale;
 
-			//Add the new sample
-			samples.m_offsets.push_back(clkstart);
-			samples.m_samples.push_back(InterpolateValue(data, ndata, frac));
+			dout[i] = InterpolateValue(data, ndata, frac);
 		}
 
 		//Compute sample durations
-		#ifdef __x86_64__
-		if(g_hasAvx2)
-			FillDurationsAVX2(samples);
-		else
-		#endif
-			FillDurationsGeneric(samples);
+		if(len)
+		{
+			#ifdef __x86_64__
+			if(g_hasAvx2)
+				FillDurationsAVX2(samples);
+			else
+			#endif
+				FillDurationsGeneric(samples);
+		}
 
 		samples.MarkModifiedFromCpu();
 	}
@@ -1050,18 +1157,91 @@ public:
 
 	static void ClearAnalysisCache();
 
+	static std::shared_ptr<const WaveformSummary> GetWaveformSummary(WaveformBase* wfm, bool histogram = true);
+
+	/**
+		@brief Samples a waveform on all edges of a clock, sharing the result with other filters
+
+		Same as SampleOnAnyEdgesBase(), but the output is memoized by (data, clock) pointer and revision until the
+		next ClearAnalysisCache(). Several decoders and jitter measurements fed by the same CDR clock therefore only
+		do the merge walk once per trigger.
+
+		The returned waveform is shared and must not be modified. It is CPU-only, so no PrepareForCpuAccess() call
+		is needed before reading it.
+
+		@param data		The data signal to sample. Can be be sparse or uniform of any type.
+		@param clock	The clock signal to use. Must be sparse or uniform digital.
+	 */
+	template<class T>
+	static std::shared_ptr<const SparseWaveform<T> > GetSampledOnAnyEdges(WaveformBase* data, WaveformBase* clock)
+	{
+		auto cached = std::dynamic_pointer_cast<const SparseWaveform<T> >(LookupSampledData(data, clock));
+		if(cached)
+			return cached;
+
+		auto samples = std::make_shared<SparseWaveform<T> >();
+		SampleOnAnyEdgesBase(data, clock, *samples);
+		StoreSampledData(data, clock, samples);
+		return samples;
+	}
+
 protected:
+	static std::shared_ptr<const SparseWaveformBase> LookupSampledData(WaveformBase* data, WaveformBase* clock);
+	static void StoreSampledData(
+		WaveformBase* data, WaveformBase* clock, std::shared_ptr<const SparseWaveformBase> samples);
+
+	static void ComputeWaveformStats(const float* samples, size_t count, WaveformSummary& summary);
+	static void ComputeWaveformHistogram(const float* samples, size_t count, WaveformSummary& summary);
+	static void ComputeWaveformStatsGeneric(
+		const float* samples, size_t count, float& vmin, float& vmax, double& sum, double& sumSquares);
+#ifdef __x86_64__
+	static void ComputeWaveformStatsAVX2(
+		const float* samples, size_t count, float& vmin, float& vmax, double& sum, double& sumSquares);
+#endif
+
+	static void ComputeHistogramBins(
+		const float* samples, size_t count, float low, float scale, size_t bins, bool clip, int32_t* indexes);
+	static void ComputeHistogramBinsGeneric(
+		const float* samples, size_t count, float low, float scale, size_t bins, bool clip, int32_t* indexes);
+#ifdef __x86_64__
+	static void ComputeHistogramBinsAVX2(
+		const float* samples, size_t count, float low, float scale, size_t bins, bool clip, int32_t* indexes);
+#endif
+
 	//Helpers for sparse waveforms
 	static void FillDurationsGeneric(SparseWaveformBase& wfm);
 #ifdef __x86_64__
 	static void FillDurationsAVX2(SparseWaveformBase& wfm);
 #endif
 
+	//Helpers for clock sampling
+	static size_t FindClockEdgesGeneric(const bool* clk, size_t start, size_t end, ClockEdgeType type, int64_t* edges);
+#ifdef __x86_64__
+	static size_t FindClockEdgesAVX2(const bool* clk, size_t start, size_t end, ClockEdgeType type, int64_t* edges);
+	static void GatherSamplesAVX2(const float* in, const int64_t* index, float* out, size_t len);
+#endif
+
 public:
 	sigc::signal<void> signal_outputsChanged()
 	{ return m_outputsChangedSignal; }
 
+	void InvalidateOutputText();
+	void ResetIncrementalState();
+
 protected:
+	size_t GetFirstNewSample(size_t i);
+
+	///@brief State of one input as of the previous GetFirstNewSample() call
+	struct IncrementalInputState
+	{
+		WaveformCacheKey m_key;
+		size_t m_len;
+	};
+
+	///@brief Input states for incremental decoding, indexed by input number (empty until first used)
+	std::vector<IncrementalInputState> m_incrementalInputs;
+
+
 	///@brief Signal emitted when the set of output streams changes
 	sigc::signal<void> m_outputsChangedSignal;
 
@@ -1093,6 +1273,16 @@ protected:
 	//Caching
 	static std::mutex m_cacheMutex;
 	static std::map<std::pair<WaveformBase*, float>, std::vector<int64_t> > m_zeroCrossingCache;
+	static std::map<WaveformBase*, std::shared_ptr<WaveformSummary> > m_summaryCache;
+
+	///@brief A memoized SampleOnAnyEdgesBase() result, valid for one revision of each input
+	struct SampledDataCacheEntry
+	{
+		WaveformCacheKey m_data;
+		WaveformCacheKey m_clock;
+		std::shared_ptr<const SparseWaveformBase> m_samples;
+	};
+	static std::map<std::pair<WaveformBase*, WaveformBase*>, SampledDataCacheEntry> m_sampledDataCache;
 };
 
 #define PROTOCOL_DECODER_INITPROC(T) \
@@ -33,9 +33,13 @@
 	@brief Implementation of IBISParser and related classes
  */
 #include "scopehal.h"
+#include "PipelineCacheManager.h"
 
 using namespace std;
 
+///@brief Version number of the IBIS binary format stored in the parsed file cache
+static const uint32_t g_ibisCacheVersion = 1;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // IVCurve
 
@@ -248,6 +252,20 @@ void IBISParser::Clear()
 
 bool IBISParser::Load(string fname)
 {
+	//If we've parsed this exact file before, use the cached copy
+	if(g_pipelineCacheMgr)
+	{
+		auto blob = g_pipelineCacheMgr->LookupParsedFile(fname, "ibis", g_ibisCacheVersion);
+		if(blob && DeserializeBinary(*blob))
+		{
+			LogTrace("Loaded IBIS file %s from cache\n", fname.c_str());
+			return true;
+		}
+	}
+
+	//Only cache the parsed result if it contains nothing but this file's models
+	bool cacheable = m_models.empty();
+
 	FILE* fp = fopen(fname.c_str(), "r");
 	if(!fp)
 	{
@@ -645,6 +663,136 @@ bool IBISParser::Load(string fname)
 	}
 
 	fclose(fp);
+
+	//Save the parsed data so we don't have to do this again
+	if(cacheable && g_pipelineCacheMgr)
+	{
+		auto blob = make_shared< vector<uint8_t> >();
+		SerializeBinary(*blob);
+		g_pipelineCacheMgr->StoreParsedFile(fname, "ibis", g_ibisCacheVersion, blob);
+	}
+
+	return true;
+}
+
+/**
+	@brief Serializes all loaded models to a compact binary blob (for caching parsed files)
+ */
+void IBISParser::SerializeBinary(vector<uint8_t>& blob)
+{
+	BinaryBlobWriter writer(blob);
+	writer.WriteString(m_component);
+	writer.WriteString(m_manufacturer);
+	writer.Write<uint32_t>(m_models.size());
+
+	for(auto it : m_models)
+	{
+		auto model = it.second;
+		writer.WriteString(it.first);
+		writer.WriteString(model->m_name);
+		writer.Write<uint32_t>(model->m_type);
+
+		for(int i=0; i<3; i++)
+		{
+			writer.WriteVector(model->m_pulldown[i].m_curve);
+			writer.WriteVector(model->m_pullup[i].m_curve);
+		}
+
+		SerializeVTCurves(writer, model->m_rising);
+		SerializeVTCurves(writer, model->m_falling);
+
+		writer.WriteRaw(model->m_vil, sizeof(model->m_vil));
+		writer.WriteRaw(model->m_vih, sizeof(model->m_vih));
+		writer.WriteRaw(model->m_temps, sizeof(model->m_temps));
+		writer.WriteRaw(model->m_voltages, sizeof(model->m_voltages));
+		writer.WriteRaw(model->m_dieCapacitance, sizeof(model->m_dieCapacitance));
+	}
+}
+
+void IBISParser::SerializeVTCurves(BinaryBlobWriter& writer, const vector<VTCurves>& curves)
+{
+	writer.Write<uint32_t>(curves.size());
+	for(auto& c : curves)
+	{
+		writer.Write(c.m_fixtureResistance);
+		writer.Write(c.m_fixtureVoltage);
+		for(int i=0; i<3; i++)
+			writer.WriteVector(c.m_curves[i]);
+	}
+}
+
+void IBISParser::DeserializeVTCurves(BinaryBlobReader& reader, vector<VTCurves>& curves)
+{
+	//Each VTCurves is at least 8 bytes of fixture data plus three array lengths
+	curves.resize(reader.ReadCount(32));
+	for(auto& c : curves)
+	{
+		c.m_fixtureResistance = reader.Read<float>();
+		c.m_fixtureVoltage = reader.Read<float>();
+		for(int i=0; i<3; i++)
+			reader.ReadVector(c.m_curves[i]);
+	}
+}
+
+/**
+	@brief Loads models from a blob created by SerializeBinary()
+
+	Models are added to any already loaded, as with parsing a text file.
+
+	@return True on success, false if the blob was malformed (in which case nothing is loaded)
+ */
+bool IBISParser::DeserializeBinary(const vector<uint8_t>& blob)
+{
+	BinaryBlobReader reader(blob);
+	auto component = reader.ReadString();
+	auto manufacturer = reader.ReadString();
+	size_t nmodels = reader.ReadCount(1);
+	if(!reader.IsOK())
+		return false;
+
+	map<string, IBISModel*> models;
+	for(size_t n=0; (n < nmodels) && reader.IsOK(); n++)
+	{
+		auto key = reader.ReadString();
+		auto model = new IBISModel(reader.ReadString());
+		models[key] = model;
+		model->m_type = static_cast<IBISModel::type_t>(reader.Read<uint32_t>());
+
+		for(int i=0; i<3; i++)
+		{
+			reader.ReadVector(model->m_pulldown[i].m_curve);
+			reader.ReadVector(model->m_pullup[i].m_curve);
+		}
+
+		DeserializeVTCurves(reader, model->m_rising);
+		DeserializeVTCurves(reader, model->m_falling);
+
+		reader.ReadRaw(model->m_vil, sizeof(model->m_vil));
+		reader.ReadRaw(model->m_vih, sizeof(model->m_vih));
+		reader.ReadRaw(model->m_temps, sizeof(model->m_temps));
+		reader.ReadRaw(model->m_voltages, sizeof(model->m_voltages));
+		reader.ReadRaw(model->m_dieCapacitance, sizeof(model->m_dieCapacitance));
+	}
+
+	//Discard everything if the blob was bad
+	if(!reader.IsOK() || !reader.AtEnd())
+	{
+		for(auto it : models)
+			delete it.second;
+		return false;
+	}
+
+	//All good, merge into our model list
+	if(!component.empty())
+		m_component = component;
+	if(!manufacturer.empty())
+		m_manufacturer = manufacturer;
+	for(auto it : models)
+	{
+		if(m_models.find(it.first) != m_models.end())
+			delete m_models[it.first];
+		m_models[it.first] = it.second;
+	}
 	return true;
 }
 
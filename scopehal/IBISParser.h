@@ -193,6 +193,12 @@ public:
 
 protected:
 	float ParseNumber(const char* str);
+
+	void SerializeBinary(std::vector<uint8_t>& blob);
+	bool DeserializeBinary(const std::vector<uint8_t>& blob);
+
+	static void SerializeVTCurves(BinaryBlobWriter& writer, const std::vector<VTCurves>& curves);
+	static void DeserializeVTCurves(BinaryBlobReader& reader, std::vector<VTCurves>& curves);
 };
 
 #endif
@@ -2427,6 +2427,7 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 	int16_t* wdata = (int16_t*)&data[0];
 	int8_t* bdata = (int8_t*)&data[0];
 
+	vector<SampleConversionJob> jobs;
 	for(size_t j=0; j<num_sequences; j++)
 	{
 		//Set up the capture we're going to store our data into
@@ -2444,30 +2445,29 @@ vector<WaveformBase*> LeCroyOscilloscope::ProcessAnalogWaveform(
 
 		cap->Resize(num_per_segment);
 
-		//Convert raw ADC samples to volts
+		//Queue conversion of raw ADC samples to volts, all segments are converted in one batch at the end
 		if(m_highDefinition)
-		{
-			Convert16BitSamples(
+			jobs.push_back(SampleConversionJob(
 				cap->m_samples.GetCpuPointer(),
 				wdata + j*num_per_segment,
 				v_gain,
 				v_off,
-				num_per_segment);
-		}
+				num_per_segment));
 		else
-		{
-			Convert8BitSamples(
+			jobs.push_back(SampleConversionJob(
 				cap->m_samples.GetCpuPointer(),
 				bdata + j*num_per_segment,
 				v_gain,
 				v_off,
-				num_per_segment);
-		}
+				num_per_segment));
 
-		cap->MarkSamplesModifiedFromCpu();
 		ret.push_back(cap);
 	}
 
+	ConvertSamples(jobs);
+	for(auto cap : ret)
+		cap->MarkSamplesModifiedFromCpu();
+
 	return ret;
 }
 
@@ -2794,18 +2794,16 @@ bool LeCroyOscilloscope::AcquireData()
 	}
 
 	//Now that we have all of the pending waveforms, save them in sets across all channels
-	m_pendingWaveformsMutex.lock();
+	vector<SequenceSet> sets(num_sequences);
 	for(size_t i=0; i<num_sequences; i++)
 	{
-		SequenceSet s;
 		for(size_t j=0; j<m_channels.size(); j++)
 		{
 			if(pending_waveforms.find(j) != pending_waveforms.end())
-				s[m_channels[j]] = pending_waveforms[j][i];
+				sets[i][m_channels[j]] = pending_waveforms[j][i];
 		}
-		m_pendingWaveforms.push_back(s);
 	}
-	m_pendingWaveformsMutex.unlock();
+	PushPendingSegments(sets);
 
 	double dt = GetTime() - start;
 	LogTrace("Waveform download and processing took %.3f ms\n", dt * 1000);
@@ -0,0 +1,546 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PackedBitstream and LineCoding
+ */
+
+#include "scopehal.h"
+#include "LineCoding.h"
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PackedBitstream
+
+/**
+	@brief Packs an array of sampled bits (one bool per bit)
+ */
+void PackedBitstream::Pack(const bool* samples, size_t len)
+{
+	resize(len);
+
+#ifdef __x86_64__
+	if(g_hasAvx2)
+	{
+		PackAVX2(samples, len);
+		return;
+	}
+#endif
+
+	PackGeneric(samples, 0, len);
+}
+
+/**
+	@brief Packs samples [start, len)
+ */
+void PackedBitstream::PackGeneric(const bool* samples, size_t start, size_t len)
+{
+	//Gather eight bools at a time: byte k of x is 0 or 1, and the multiply moves it to bit 56+k
+	size_t end = len - ((len - start) % 8);
+	for(size_t i=start; i<end; i += 8)
+	{
+		uint64_t x;
+		memcpy(&x, samples + i, sizeof(x));
+		m_words[i >> 6] |= ((x * 0x0102040810204080ULL) >> 56) << (i & 63);
+	}
+
+	for(size_t i=end; i<len; i++)
+	{
+		if(samples[i])
+			m_words[i >> 6] |= (1ULL << (i & 63));
+	}
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+void PackedBitstream::PackAVX2(const bool* samples, size_t len)
+{
+	size_t end = len - (len % 64);
+	for(size_t i=0; i<end; i += 64)
+	{
+		//Move each bool into the sign bit of its byte and grab all of them at once
+		__m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i));
+		__m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(samples + i + 32));
+		uint32_t blo = _mm256_movemask_epi8(_mm256_slli_epi16(lo, 7));
+		uint32_t bhi = _mm256_movemask_epi8(_mm256_slli_epi16(hi, 7));
+		m_words[i >> 6] = blo | (static_cast<uint64_t>(bhi) << 32);
+	}
+
+	PackGeneric(samples, end, len);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Alignment searches
+
+/**
+	@brief Finds possible 64b/66b or 128b/130b sync headers
+
+	Bit i of the mask is set if bits i and i+1 of the stream differ (header 01 or 10).
+ */
+void LineCoding::FindSyncHeaders(const PackedBitstream& bits, PackedBitstream& mask)
+{
+	mask.resize(bits.size());
+	auto pmask = mask.GetWords();
+	auto pbits = bits.GetWords();
+	size_t nw = bits.GetWordCount();
+	for(size_t w=0; w<nw; w++)
+		pmask[w] = pbits[w] ^ bits.GetWindow(w*64 + 1);
+}
+
+/**
+	@brief Finds possible 8b/10b comma characters
+
+	Bit i of the mask is set if a code group starting at bit i has a comma (exactly five identical bits) in
+	bits 2 through 6.
+ */
+void LineCoding::FindCommas(const PackedBitstream& bits, PackedBitstream& mask)
+{
+	mask.resize(bits.size());
+	auto pmask = mask.GetWords();
+	size_t nw = bits.GetWordCount();
+	for(size_t w=0; w<nw; w++)
+	{
+		size_t base = w*64;
+		uint64_t s1 = bits.GetWindow(base + 1);
+		uint64_t s2 = bits.GetWindow(base + 2);
+		uint64_t s3 = bits.GetWindow(base + 3);
+		uint64_t s4 = bits.GetWindow(base + 4);
+		uint64_t s5 = bits.GetWindow(base + 5);
+		uint64_t s6 = bits.GetWindow(base + 6);
+		uint64_t s7 = bits.GetWindow(base + 7);
+
+		uint64_t same = ~( (s2 ^ s3) | (s2 ^ s4) | (s2 ^ s5) | (s2 ^ s6) );
+		pmask[w] = same & (s1 ^ s2) & (s7 ^ s2);
+	}
+}
+
+/**
+	@brief Finds 10-bit windows that can't be a valid 8b/10b code group
+
+	Bit i of the mask is set if the ten bits starting at bit i do not contain four, five, or six ones.
+ */
+void LineCoding::FindDisparityErrors(const PackedBitstream& bits, PackedBitstream& mask)
+{
+	mask.resize(bits.size());
+	auto pmask = mask.GetWords();
+	auto pbits = bits.GetWords();
+	size_t nw = bits.GetWordCount();
+	for(size_t w=0; w<nw; w++)
+	{
+		uint64_t lo = pbits[w];
+		uint64_t hi = pbits[w+1];
+
+		//Bit-sliced count of the ones in all 64 windows at once (at most 10, so four planes is plenty)
+		uint64_t c0 = lo;
+		uint64_t c1 = 0;
+		uint64_t c2 = 0;
+		uint64_t c3 = 0;
+		for(size_t k=1; k<10; k++)
+		{
+			uint64_t x = (lo >> k) | (hi << (64 - k));
+			uint64_t t0 = c0 & x;
+			c0 ^= x;
+			uint64_t t1 = c1 & t0;
+			c1 ^= t0;
+			uint64_t t2 = c2 & t1;
+			c2 ^= t1;
+			c3 ^= t2;
+		}
+
+		//Valid counts are 4 (0100), 5 (0101), and 6 (0110)
+		uint64_t ok = ~c3 & c2 & ~(c1 & c0);
+		pmask[w] = ~ok;
+	}
+}
+
+/**
+	@brief Finds occurrences of any of a set of fixed code groups
+
+	Bit i of the mask is set if the len bits starting at bit i equal any of the patterns.
+ */
+void LineCoding::FindPatterns(
+	const PackedBitstream& bits,
+	const uint64_t* patterns,
+	size_t npatterns,
+	size_t len,
+	PackedBitstream& mask)
+{
+	mask.resize(bits.size());
+	auto pmask = mask.GetWords();
+	size_t nw = bits.GetWordCount();
+
+	uint64_t windows[64];
+	for(size_t w=0; w<nw; w++)
+	{
+		for(size_t k=0; k<len; k++)
+			windows[k] = bits.GetWindow(w*64 + k);
+
+		uint64_t hits = 0;
+		for(size_t j=0; j<npatterns; j++)
+		{
+			uint64_t match = ~0ULL;
+			for(size_t k=0; k<len; k++)
+			{
+				if( (patterns[j] >> k) & 1)
+					match &= windows[k];
+				else
+					match &= ~windows[k];
+			}
+			hits |= match;
+		}
+		pmask[w] = hits;
+	}
+}
+
+/**
+	@brief Counts the set bits of a mask at each phase of a block period
+
+	On return, counts[phase] is the number of blocks k < nblocks with bit (k*period + phase) of the mask set.
+
+	The phase of each bit within a word repeats every period / gcd(period, 64) words, so we keep one set of
+	bit-sliced counters per word in that cycle and add each mask word to its set. This counts all 64 bit positions
+	of the word in a few logic operations, and the counters are only sorted out into phases once at the end.
+ */
+void LineCoding::CountPerPhase(
+	const PackedBitstream& mask,
+	size_t period,
+	size_t nblocks,
+	vector<size_t>& counts)
+{
+	size_t a = period;
+	size_t b = 64;
+	while(b)
+	{
+		size_t t = a % b;
+		a = b;
+		b = t;
+	}
+	size_t cycle = period / a;
+
+	const size_t nplanes = 64;
+	vector<uint64_t> planes(cycle * nplanes, 0);
+
+	size_t nbits = nblocks * period;
+	size_t nw = (nbits + 63) / 64;
+	auto pmask = mask.GetWords();
+	size_t r = 0;
+	for(size_t w=0; w<nw; w++)
+	{
+		uint64_t carry = pmask[w];
+		if( (w+1)*64 > nbits)
+			carry &= (1ULL << (nbits & 63)) - 1;
+
+		uint64_t* pplanes = &planes[r * nplanes];
+		for(size_t p=0; (p<nplanes) && carry; p++)
+		{
+			uint64_t t = pplanes[p] & carry;
+			pplanes[p] ^= carry;
+			carry = t;
+		}
+
+		r ++;
+		if(r == cycle)
+			r = 0;
+	}
+
+	counts.clear();
+	counts.resize(period, 0);
+	for(size_t pos=0; pos < cycle*64; pos++)
+	{
+		const uint64_t* pplanes = &planes[(pos / 64) * nplanes];
+		size_t bit = pos & 63;
+		size_t count = 0;
+		for(size_t p=0; p<nplanes; p++)
+			count |= ((pplanes[p] >> bit) & 1) << p;
+		counts[pos % period] += count;
+	}
+}
+
+/**
+	@brief Finds the alignment of a 64b/66b or 128b/130b stream
+
+	@return Offset of the first sync header, in the range [0, period)
+ */
+size_t LineCoding::FindBlockAlignment(const PackedBitstream& bits, size_t period)
+{
+	if(bits.size() < 2*period)
+		return 0;
+
+	PackedBitstream mask;
+	FindSyncHeaders(bits, mask);
+
+	vector<size_t> counts;
+	CountPerPhase(mask, period, bits.size() / period - 1, counts);
+
+	size_t best_offset = 0;
+	for(size_t offset=1; offset<period; offset++)
+	{
+		if(counts[offset] > counts[best_offset])
+			best_offset = offset;
+	}
+	LogTrace("Found %zu valid sync headers at offset %zu\n", counts[best_offset], best_offset);
+	return best_offset;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Decode tables
+
+/**
+	@brief Returns the 8b/10b decode table, indexed by code group in wire order (bit a is the LSB)
+ */
+const IBM8b10bCode* LineCoding::Get8b10bTable()
+{
+	static IBM8b10bCode table[1024];
+	static bool built = false;
+	static mutex buildMutex;
+
+	lock_guard<mutex> lock(buildMutex);
+	if(built)
+		return table;
+
+	static const int code5_table[64] =
+	{
+		 0,  0,  0,  0,  0, 23,  8,  7,	//00-07
+		 0, 27,  4, 20, 24, 12, 28, 28, //08-0f
+		 0, 29,  2, 18, 31, 10, 26, 15, //10-17
+		 0,  6, 22, 16, 14,  1, 30,  0,	//18-1f
+		 0, 30, 1,  17, 16,  9, 25,  0,	//20-27
+		15,  5, 21, 31, 13,  2, 29,  0,	//28-2f
+		28,  3, 19, 24, 11,  4, 27,  0,	//30-37
+		 7,  8, 23,  0,  0,  0,  0,  0  //38-3f
+	};
+
+	static const int disp5_table[64] =
+	{
+		 0,  0,  0, 0,  0, -2, -2, 0,	//00-07
+		 0, -2, -2, 0, -2,  0,  0, 2,	//08-0f
+		 0, -2, -2, 0, -2,  0,  0, 2,	//10-17
+		-2,  0,  0, 2,  0,  2,  2, 0,	//18-1f
+		 0, -2, -2, 0, -2,  0,  0, 2,	//20-27
+		-2,  0,  0, 2,  0,  2,  2, 0,	//28-2f
+		-2,  0,  0, 2,  0,  2,  2, 0,	//30-37
+		 0,  2,  2, 0,  0,  0,  0, 0 	//38-3f
+	};
+
+	static const bool err5_table[64] =
+	{
+		 true,  true,  true,  true,  true, false, false, false,	//00-07
+		 true, false, false, false, false, false, false, false, //08-0f
+		 true, false, false, false, false, false, false, false, //10-17
+		false, false, false, false, false, false, false,  true,	//18-1f
+		 true, false, false, false, false, false, false, false,	//20-27
+		false, false, false, false, false, false, false,  true,	//28-2f
+		false, false, false, false, false, false, false,  true,	//30-37
+		false, false, false,  true,  true,  true,  true,  true  //38-3f
+	};
+
+	static const bool ctl5_table[64] =
+	{
+		false, false, false, false, false, false, false, false,	//00-07
+		false, false, false, false, false, false, false, true,  //08-0f
+		false, false, false, false, false, false, false, false, //10-17
+		false, false, false, false, false, false, false, false,	//18-1f
+		false, false, false, false, false, false, false, false,	//20-27
+		false, false, false, false, false, false, false, false,	//28-2f
+		true,  false, false, false, false, false, false, false,	//30-37
+		false, false, false, false, false, false, false, false  //38-3f
+	};
+
+	static const bool err3_ctl_table[16] =
+	{
+		 true,  true, false, false, false, false, false, false,
+		false, false, false, false, false, false,  true,  true
+	};
+
+	static const int code3_pos_ctl_table[16] =	//if disp5 positive
+	{
+		0, 0, 4, 3, 0, 2, 6, 7,
+		7, 1, 5, 0, 3, 4, 0, 0,
+	};
+
+	static const int code3_neg_ctl_table[16] =	//if disp5 negative
+	{
+		0, 0, 4, 3, 0, 5, 1, 7,
+		7, 6, 2, 0, 3, 4, 0, 0
+	};
+
+	static const bool err3_table[16] =
+	{
+		 true,  false, false, false, false, false, false, false,
+		false, false, false, false, false, false, false,  true
+	};
+
+	static const int code3_table[16] =
+	{
+		0, 7, 4, 3, 0, 2, 6, 7,
+		7, 1, 5, 0, 3, 4, 7, 0
+	};
+
+	static const int disp3_table[16] =
+	{
+		 0, -2, -2, 0, -2, 0, 0, 2,
+		-2, 0,  0, 2,  0, 2, 2, 0
+	};
+
+	//true only for Dx.A7
+	static const bool alt3_table[16] =
+	{
+		0, 0, 0, 0, 0, 0, 0, 1,
+		1, 0, 0, 0, 0, 0, 0, 0
+	};
+
+	for(unsigned int code=0; code<1024; code++)
+	{
+		//The sub-block tables are indexed with the first bit on the wire (a or f) as the MSB
+		unsigned int code6 = 0;
+		for(unsigned int k=0; k<6; k++)
+			code6 |= ((code >> k) & 1) << (5-k);
+		unsigned int code4 = 0;
+		for(unsigned int k=0; k<4; k++)
+			code4 |= ((code >> (6+k)) & 1) << (3-k);
+
+		//5b/6b decode
+		int code5 = code5_table[code6];
+		int disp5 = disp5_table[code6];
+		bool err5 = err5_table[code6];
+		bool ctl5 = ctl5_table[code6];
+
+		//3b/4b decode
+		int code3;
+		bool err3;
+		if(ctl5)
+		{
+			if(disp5 >= 0)
+				code3 = code3_pos_ctl_table[code4];
+			else
+				code3 = code3_neg_ctl_table[code4];
+			err3 = err3_ctl_table[code4];
+		}
+		else
+		{
+			code3 = code3_table[code4];
+			err3 = err3_table[code4];
+		}
+
+		//Special processing for a few control codes that use the .A7 format
+		if(alt3_table[code4])
+		{
+			if( (code5 == 23) || (code5 == 27) || (code5 == 29) || (code5 == 30) )
+				ctl5 = true;
+		}
+
+		auto& entry = table[code];
+		entry.m_data = (code3 << 5) | code5;
+		entry.m_control = ctl5;
+		entry.m_error = err5 || err3;
+		entry.m_disparity = disp5 + disp3_table[code4];
+	}
+
+	built = true;
+	return table;
+}
+
+/**
+	@brief Returns the TMDS decode table, indexed by character in wire order (bit 0 is the LSB)
+ */
+const TMDSCode* LineCoding::GetTMDSTable()
+{
+	static TMDSCode table[1024];
+	static bool built = false;
+	static mutex buildMutex;
+
+	lock_guard<mutex> lock(buildMutex);
+	if(built)
+		return table;
+
+	//Control period characters, indexed by C1:C0 (HDMI 1.4 spec section 5.4.2)
+	static const uint16_t control_codes[4] = { 0x354, 0x0ab, 0x154, 0x2ab };
+
+	for(unsigned int code=0; code<1024; code++)
+	{
+		//Video data (DVI 1.0 spec section 3.3.3)
+		uint8_t d = code & 0xff;
+		if(code & 0x200)
+			d ^= 0xff;
+		if(code & 0x100)
+			d ^= (d << 1);
+		else
+			d ^= (d << 1) ^ 0xfe;
+
+		auto& entry = table[code];
+		entry.m_data = d;
+		entry.m_control = -1;
+		for(int j=0; j<4; j++)
+		{
+			if(code == control_codes[j])
+				entry.m_control = j;
+		}
+	}
+
+	built = true;
+	return table;
+}
+
+LineCoding::ScramblerTable::ScramblerTable()
+{
+	//Run eight LFSR steps (PCIe 3.0 spec section 4.2.2.4) from each single-byte state
+	for(size_t slice=0; slice<3; slice++)
+	{
+		for(uint32_t v=0; v<256; v++)
+		{
+			uint32_t state = (v << (slice*8)) & 0x7fffff;
+			uint32_t out = 0;
+			for(int j=0; j<8; j++)
+			{
+				bool b22 = (state & 0x400000);
+				state = (state << 1) & 0x7fffff;
+				if(b22)
+				{
+					state ^= 0x210125;
+					out |= (1 << j);
+				}
+			}
+			m_slices[slice][v] = state | (out << 24);
+		}
+	}
+}
+
+const LineCoding::ScramblerTable& LineCoding::GetPCIeGen3ScramblerTable()
+{
+	static ScramblerTable table;
+	return table;
+}
@@ -0,0 +1,213 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PackedBitstream and LineCoding
+ */
+
+#ifndef LineCoding_h
+#define LineCoding_h
+
+/**
+	@brief A stream of sampled line bits, packed 64 to a word
+
+	Bit i of the stream is stored in bit (i & 63) of word (i >> 6), so the first bit on the wire is the LSB of any
+	value extracted from the stream. The word array is padded with zeroes so windows may run off the end.
+ */
+class PackedBitstream
+{
+public:
+	PackedBitstream(size_t len = 0)
+	{ resize(len); }
+
+	void Pack(const bool* samples, size_t len);
+
+	void resize(size_t len)
+	{
+		m_len = len;
+		m_words.resize((len + 63) / 64 + 2);
+		for(auto& w : m_words)
+			w = 0;
+	}
+
+	size_t size() const
+	{ return m_len; }
+
+	///@brief Number of words containing stream data (not including padding)
+	size_t GetWordCount() const
+	{ return (m_len + 63) / 64; }
+
+	uint64_t* GetWords()
+	{ return &m_words[0]; }
+
+	const uint64_t* GetWords() const
+	{ return &m_words[0]; }
+
+	/**
+		@brief Returns the 64 bits starting at bit position pos
+	 */
+	uint64_t GetWindow(size_t pos) const
+	{
+		size_t j = pos >> 6;
+		size_t s = pos & 63;
+		if(s == 0)
+			return m_words[j];
+		return (m_words[j] >> s) | (m_words[j+1] << (64 - s));
+	}
+
+	/**
+		@brief Returns nbits (at most 64) bits starting at bit position pos
+	 */
+	uint64_t Extract(size_t pos, size_t nbits) const
+	{
+		uint64_t w = GetWindow(pos);
+		if(nbits < 64)
+			w &= (1ULL << nbits) - 1;
+		return w;
+	}
+
+protected:
+	void PackGeneric(const bool* samples, size_t start, size_t len);
+#ifdef __x86_64__
+	void PackAVX2(const bool* samples, size_t len);
+#endif
+
+	std::vector<uint64_t> m_words;
+	size_t m_len;
+};
+
+/**
+	@brief One 10-bit 8b/10b code group, decoded without regard to running disparity
+ */
+class IBM8b10bCode
+{
+public:
+	///@brief Decoded byte, in HGF EDCBA order
+	uint8_t m_data;
+
+	///@brief True for K (control) characters
+	bool m_control;
+
+	///@brief True if either sub-block is not a valid code
+	bool m_error;
+
+	///@brief Disparity of the code group (-2, 0, or +2)
+	int8_t m_disparity;
+};
+
+/**
+	@brief One 10-bit TMDS character, decoded as both video data and a control period character
+ */
+class TMDSCode
+{
+public:
+	///@brief Decoded video data byte
+	uint8_t m_data;
+
+	///@brief Index of the control code (C1:C0), or -1 if not a control period character
+	int8_t m_control;
+};
+
+/**
+	@brief Helpers shared by the 8b/10b, TMDS, 64b/66b and 128b/130b decoders
+
+	Everything here works on PackedBitstreams. Alignment searches produce a packed mask with bit i set if a
+	candidate symbol boundary starts at bit i, which is then folded into per-phase hit counts with CountPerPhase().
+	All code group values are in wire order (first bit on the wire is the LSB).
+ */
+class LineCoding
+{
+public:
+	static void FindSyncHeaders(const PackedBitstream& bits, PackedBitstream& mask);
+	static void FindCommas(const PackedBitstream& bits, PackedBitstream& mask);
+	static void FindDisparityErrors(const PackedBitstream& bits, PackedBitstream& mask);
+	static void FindPatterns(
+		const PackedBitstream& bits,
+		const uint64_t* patterns,
+		size_t npatterns,
+		size_t len,
+		PackedBitstream& mask);
+
+	static void CountPerPhase(
+		const PackedBitstream& mask,
+		size_t period,
+		size_t nblocks,
+		std::vector<size_t>& counts);
+
+	static size_t FindBlockAlignment(const PackedBitstream& bits, size_t period);
+
+	static const IBM8b10bCode* Get8b10bTable();
+	static const TMDSCode* GetTMDSTable();
+
+	/**
+		@brief Descrambles one 64b/66b block payload (x^58 + x^39 + 1 self-synchronizing scrambler)
+
+		@param scrambled	Scrambled payload of this block
+		@param prev			Scrambled payload of the previous block
+	 */
+	static uint64_t Descramble64b66b(uint64_t scrambled, uint64_t prev)
+	{
+		return scrambled ^
+			(scrambled << 39) ^ (prev >> 25) ^
+			(scrambled << 58) ^ (prev >> 6);
+	}
+
+	/**
+		@brief Advances the 128b/130b scrambler LFSR by one byte and returns the keystream byte
+	 */
+	static uint8_t RunPCIeGen3Scrambler(uint32_t& state)
+	{
+		auto& t = GetPCIeGen3ScramblerTable();
+		uint32_t r = t.m_slices[0][state & 0xff] ^ t.m_slices[1][(state >> 8) & 0xff] ^ t.m_slices[2][(state >> 16) & 0x7f];
+		state = r & 0x7fffff;
+		return r >> 24;
+	}
+
+protected:
+	/**
+		@brief Byte-sliced form of eight LFSR steps
+
+		Each entry holds the next state in the low 23 bits and the keystream byte in the high 8 bits. Since the
+		LFSR is linear, the result for a full state is the XOR of the entries for each of its bytes.
+	 */
+	class ScramblerTable
+	{
+	public:
+		ScramblerTable();
+
+		uint32_t m_slices[3][256];
+	};
+
+	static const ScramblerTable& GetPCIeGen3ScramblerTable();
+};
+
+#endif
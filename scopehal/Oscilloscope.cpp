@@ -46,6 +46,7 @@
 #include <immintrin.h>
 #endif
 #include <omp.h>
+#include <utility>
 
 #include "EdgeTrigger.h"
 
@@ -57,6 +58,7 @@ Oscilloscope::CreateMapType Oscilloscope::m_createprocs;
 // Construction / destruction
 
 Oscilloscope::Oscilloscope()
+	: m_segmentBatching(false)
 {
 	m_trigger = NULL;
 }
@@ -218,6 +220,105 @@ bool Oscilloscope::PopPendingWaveform()
 	return false;
 }
 
+/**
+	@brief Adds all segments of a sequence acquisition to the pending waveform queue
+
+	Drivers supporting sequenced triggering call this with one SequenceSet per segment. If segment batching is
+	enabled, the segments are merged (see MergeSegments()) and queued as one set, otherwise each is queued separately.
+ */
+void Oscilloscope::PushPendingSegments(vector<SequenceSet>& segments)
+{
+	if(m_segmentBatching && (segments.size() > 1) )
+	{
+		//Merge before taking the lock so the consumer isn't held up
+		auto set = MergeSegments(segments);
+
+		lock_guard<mutex> lock(m_pendingWaveformsMutex);
+		m_pendingWaveforms.push_back(set);
+	}
+
+	else
+	{
+		lock_guard<mutex> lock(m_pendingWaveformsMutex);
+		for(auto& set : segments)
+			m_pendingWaveforms.push_back(set);
+	}
+
+	segments.clear();
+}
+
+/**
+	@brief Combines the segments of a sequence acquisition into a single SequenceSet
+
+	Each uniform analog stream becomes a SegmentedAnalogWaveform, whose first segment is the stream's waveform from
+	the first set. Segments which are empty or have a different timescale from the first are discarded. Any other
+	stream type just gets its waveform from the first set.
+ */
+Oscilloscope::SequenceSet Oscilloscope::MergeSegments(vector<SequenceSet>& segments)
+{
+	SequenceSet ret;
+	for(auto it : segments[0])
+	{
+		auto stream = it.first;
+		auto first = it.second;
+		auto ufirst = dynamic_cast<UniformAnalogWaveform*>(first);
+
+		//Not something we can batch, keep the first segment only
+		if(!ufirst || (first->size() == 0) )
+		{
+			ret[stream] = first;
+			for(size_t i=1; i<segments.size(); i++)
+			{
+				auto jt = segments[i].find(stream);
+				if(jt != segments[i].end())
+					delete jt->second;
+			}
+			continue;
+		}
+
+		auto batch = new SegmentedAnalogWaveform;
+		batch->m_timescale = first->m_timescale;
+		batch->m_startTimestamp = first->m_startTimestamp;
+		batch->m_startFemtoseconds = first->m_startFemtoseconds;
+		batch->m_triggerPhase = first->m_triggerPhase;
+		batch->m_flags = first->m_flags;
+		batch->m_samples.CopyFrom(ufirst->m_samples);
+		AddWaveformToAnalogPool(first);
+
+		for(size_t i=1; i<segments.size(); i++)
+		{
+			auto jt = segments[i].find(stream);
+			if(jt == segments[i].end())
+				continue;
+
+			auto seg = dynamic_cast<UniformAnalogWaveform*>(jt->second);
+			if(!seg || (seg->size() == 0) || (seg->m_timescale != batch->m_timescale) )
+			{
+				LogWarning("Dropping segment %zu of %s: empty or inconsistent timebase\n",
+					i, stream.GetName().c_str());
+				delete jt->second;
+				continue;
+			}
+
+			batch->AddSegment(seg);
+			batch->m_flags |= seg->m_flags;
+		}
+
+		ret[stream] = batch;
+	}
+
+	//Clean up any streams that only showed up in later segments
+	for(size_t i=1; i<segments.size(); i++)
+	{
+		for(auto it : segments[i])
+		{
+			if(segments[0].find(it.first) == segments[0].end())
+				delete it.second;
+		}
+	}
+
+	return ret;
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Serialization
@@ -797,65 +898,345 @@ bool Oscilloscope::HasTimebaseControls()
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// Helpers for converting raw 8-bit ADC samples to fp32 waveforms
+// Multi-channel sample conversion
 
 /**
-	@brief Converts 8-bit ADC samples to floating point
+	@brief Converts raw ADC samples for any number of channels (or segments) to floating point
+
+	Every job is split into fixed size blocks and all blocks of all jobs are spread over the OpenMP worker pool
+	together, so a single deep channel and many shallow ones parallelize equally well. Drivers should submit every
+	channel of an acquisition in one call rather than converting them one at a time.
  */
-void Oscilloscope::Convert8BitSamples(float* pout, int8_t* pin, float gain, float offset, size_t count)
+void Oscilloscope::ConvertSamples(const SampleConversionJob* jobs, size_t njobs)
 {
-	//Divide large waveforms (>1M points) into blocks and multithread them
+	//Blocks are a multiple of 64 samples for clean vectorization in every kernel, and small enough that
+	//the input and 128 kB of fp32 output for a block stay resident in L2 while it's being converted
+	const size_t blocksize = 32768;
+
+	//Small acquisitions get done single threaded to avoid overhead
 	//TODO: tune split
-	if(count > 1000000)
+	size_t total = 0;
+	for(size_t i=0; i<njobs; i++)
+		total += jobs[i].m_count;
+	if(total <= 1000000)
+	{
+		for(size_t i=0; i<njobs; i++)
+		{
+			if(ConvertSampleBlock(jobs[i], 0, jobs[i].m_count))
+				jobs[i].m_clipTarget->m_flags |= WaveformBase::WAVEFORM_CLIPPING;
+		}
+		return;
+	}
+
+	//Flatten (job, block) pairs into a single work list
+	vector<pair<size_t, size_t> > blocks;
+	blocks.reserve(total / blocksize + njobs);
+	for(size_t i=0; i<njobs; i++)
+	{
+		for(size_t off=0; off<jobs[i].m_count; off += blocksize)
+			blocks.push_back(pair<size_t, size_t>(i, off));
+	}
+
+	//Clip detection results for each block, merged per job once all blocks are done
+	vector<uint8_t> blockClipped(blocks.size());
+
+	#pragma omp parallel for schedule(dynamic, 4)
+	for(size_t i=0; i<blocks.size(); i++)
+	{
+		auto& job = jobs[blocks[i].first];
+		size_t off = blocks[i].second;
+		blockClipped[i] = ConvertSampleBlock(job, off, min(blocksize, job.m_count - off));
+	}
+
+	for(size_t i=0; i<blocks.size(); i++)
+	{
+		if(blockClipped[i])
+			jobs[blocks[i].first].m_clipTarget->m_flags |= WaveformBase::WAVEFORM_CLIPPING;
+	}
+}
+
+/**
+	@brief Gets the set of transforms (a bitmask of ConversionTransform values) a job needs
+
+	Unity gain, zero offset and zero skew are left out so the selected kernel doesn't spend any time on them.
+ */
+unsigned int Oscilloscope::GetConversionTransforms(const SampleConversionJob& job)
+{
+	unsigned int transforms = 0;
+	if(job.m_gain != 1)
+		transforms |= CONVERT_GAIN;
+	if(job.m_offset != 0)
+		transforms |= CONVERT_OFFSET;
+	if(job.m_invert)
+		transforms |= CONVERT_INVERT;
+	if(job.m_skew != 0)
+		transforms |= CONVERT_SKEW;
+	if(job.m_clipTarget)
+		transforms |= CONVERT_CLIP;
+	return transforms;
+}
+
+///@brief A fused conversion kernel. Returns true if clip detection is enabled and the block was clipped.
+typedef bool (*FusedConversionKernel)(const Oscilloscope::SampleConversionJob& job, size_t off, size_t count);
+
+/**
+	@brief Gets the gain and offset a fused kernel multiplies and subtracts by
+
+	-(x*gain - offset) == x*(-gain) - (-offset), so inversion is folded in for free.
+ */
+template<unsigned int transforms>
+static inline void GetFusedCoefficients(const Oscilloscope::SampleConversionJob& job, float& gain, float& offset)
+{
+	gain = (transforms & Oscilloscope::CONVERT_GAIN) ? job.m_gain : 1;
+	offset = (transforms & Oscilloscope::CONVERT_OFFSET) ? job.m_offset : 0;
+	if(transforms & Oscilloscope::CONVERT_INVERT)
+	{
+		gain = -gain;
+		offset = -offset;
+	}
+}
+
+/**
+	@brief Generic fused conversion kernel, for CPUs without AVX2
+
+	@param job		The job to convert
+	@param off		Offset of the first output sample to convert
+	@param count	Number of samples to convert
+ */
+template<class T, unsigned int transforms>
+static bool ConvertSamplesFusedGeneric(const Oscilloscope::SampleConversionJob& job, size_t off, size_t count)
+{
+	const bool scale = (transforms & (Oscilloscope::CONVERT_GAIN | Oscilloscope::CONVERT_INVERT)) != 0;
+	const bool shift = (transforms & Oscilloscope::CONVERT_OFFSET) != 0;
+	const bool detectClip = (transforms & Oscilloscope::CONVERT_CLIP) != 0;
+
+	float gain;
+	float offset;
+	GetFusedCoefficients<transforms>(job, gain, offset);
+
+	float* pout = job.m_pout + off;
+	const T* pin = reinterpret_cast<const T*>(job.m_pin) + off;
+	if(transforms & Oscilloscope::CONVERT_SKEW)
+		pin += job.m_skew;
+
+	int32_t vmin = INT32_MAX;
+	int32_t vmax = INT32_MIN;
+	for(size_t i=0; i<count; i++)
+	{
+		int32_t v = pin[i];
+		if(detectClip)
+		{
+			vmin = min(vmin, v);
+			vmax = max(vmax, v);
+		}
+
+		float f = v;
+		if(scale)
+			f *= gain;
+		if(shift)
+			f -= offset;
+		pout[i] = f;
+	}
+
+	if(detectClip)
+		return (vmin <= job.m_clipLow) || (vmax >= job.m_clipHigh);
+	return false;
+}
+
+#ifdef __x86_64__
+///@brief Loads 16 raw samples, widened to 16 bits
+__attribute__((target("avx2")))
+static inline __m256i LoadFusedSamples(const int8_t* p)
+{ return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }
+
+__attribute__((target("avx2")))
+static inline __m256i LoadFusedSamples(const uint8_t* p)
+{ return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }
+
+__attribute__((target("avx2")))
+static inline __m256i LoadFusedSamples(const int16_t* p)
+{ return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+
+/**
+	@brief AVX2 fused conversion kernel
+
+	Every input format is widened to 16 bits first, so clip detection is a pair of packed 16-bit min/max per 16
+	samples no matter the format.
+ */
+template<class T, unsigned int transforms>
+__attribute__((target("avx2")))
+static bool ConvertSamplesFusedAVX2(const Oscilloscope::SampleConversionJob& job, size_t off, size_t count)
+{
+	const bool scale = (transforms & (Oscilloscope::CONVERT_GAIN | Oscilloscope::CONVERT_INVERT)) != 0;
+	const bool shift = (transforms & Oscilloscope::CONVERT_OFFSET) != 0;
+	const bool detectClip = (transforms & Oscilloscope::CONVERT_CLIP) != 0;
+
+	float gain;
+	float offset;
+	GetFusedCoefficients<transforms>(job, gain, offset);
+
+	float* pout = job.m_pout + off;
+	const T* pin = reinterpret_cast<const T*>(job.m_pin) + off;
+	if(transforms & Oscilloscope::CONVERT_SKEW)
+		pin += job.m_skew;
+
+	size_t end = count - (count % 16);
+
+	__m256 gains = _mm256_set1_ps(gain);
+	__m256 offsets = _mm256_set1_ps(offset);
+	__m256i vmin = _mm256_set1_epi16(INT16_MAX);
+	__m256i vmax = _mm256_set1_epi16(INT16_MIN);
+
+	for(size_t k=0; k<end; k += 16)
+	{
+		__m256i raw = LoadFusedSamples(pin + k);
+		if(detectClip)
+		{
+			vmin = _mm256_min_epi16(vmin, raw);
+			vmax = _mm256_max_epi16(vmax, raw);
+		}
+
+		//Sign extend each half to 32 bits and convert to float
+		__m256 flo = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(raw)));
+		__m256 fhi = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(raw, 1)));
+
+		if(scale)
+		{
+			flo = _mm256_mul_ps(flo, gains);
+			fhi = _mm256_mul_ps(fhi, gains);
+		}
+		if(shift)
+		{
+			flo = _mm256_sub_ps(flo, offsets);
+			fhi = _mm256_sub_ps(fhi, offsets);
+		}
+
+		_mm256_storeu_ps(pout + k, flo);
+		_mm256_storeu_ps(pout + k + 8, fhi);
+	}
+
+	//Reduce the SIMD extrema, then get any extras we didn't get in the SIMD loop
+	int32_t smin = INT32_MAX;
+	int32_t smax = INT32_MIN;
+	if(detectClip)
 	{
-		//Round blocks to multiples of 32 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 32);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
+		int16_t mins[16];
+		int16_t maxes[16];
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(mins), vmin);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(maxes), vmax);
+		for(int i=0; i<16; i++)
 		{
-			//Last block gets any extra that didn't divide evenly
-			size_t nsamp = blocksize;
-			if(i == lastblock)
-				nsamp = count - i*blocksize;
+			smin = min(smin, (int32_t)mins[i]);
+			smax = max(smax, (int32_t)maxes[i]);
+		}
+	}
+
+	for(size_t k=end; k<count; k++)
+	{
+		int32_t v = pin[k];
+		if(detectClip)
+		{
+			smin = min(smin, v);
+			smax = max(smax, v);
+		}
 
-			size_t off = i*blocksize;
+		float f = v;
+		if(scale)
+			f *= gain;
+		if(shift)
+			f -= offset;
+		pout[k] = f;
+	}
+
+	if(detectClip)
+		return (smin <= job.m_clipLow) || (smax >= job.m_clipHigh);
+	return false;
+}
+#endif /* __x86_64__ */
+
+/**
+	@brief Table of fused kernels for one sample format, indexed by transform mask
+ */
+template<class T, size_t... transforms>
+static const FusedConversionKernel* GetFusedKernels(index_sequence<transforms...>)
+{
+	static const FusedConversionKernel generic[] = { &ConvertSamplesFusedGeneric<T, transforms>... };
+
+	#ifdef __x86_64__
+	static const FusedConversionKernel avx2[] = { &ConvertSamplesFusedAVX2<T, transforms>... };
+	if(g_hasAvx2)
+		return avx2;
+	#endif /* __x86_64__ */
+
+	return generic;
+}
+
+template<class T>
+static const FusedConversionKernel* GetFusedKernels()
+{ return GetFusedKernels<T>(make_index_sequence<Oscilloscope::CONVERT_ALL + 1>()); }
+
+/**
+	@brief Converts a single block of one job using the best kernel for this CPU
+
+	The kernel is the fused instantiation for exactly the transforms the job needs (see GetConversionTransforms()).
+	The one exception is plain 16-bit gain/offset/invert jobs on CPUs with AVX-512F or FMA, which keep using the
+	dedicated kernels for those instruction sets.
+
+	@param job		The job to convert
+	@param off		Offset of the first output sample to convert. Must be a multiple of 64 samples.
+	@param count	Number of samples to convert
+
+	@return True if clip detection is enabled for the job and the block contained clipped samples
+ */
+bool Oscilloscope::ConvertSampleBlock(const SampleConversionJob& job, size_t off, size_t count)
+{
+	unsigned int transforms = GetConversionTransforms(job);
+
+	switch(job.m_format)
+	{
+		case RAW_FORMAT_INT8:
+			return GetFusedKernels<int8_t>()[transforms](job, off, count);
+
+		case RAW_FORMAT_UINT8:
+			return GetFusedKernels<uint8_t>()[transforms](job, off, count);
+
+		case RAW_FORMAT_INT16:
 			#ifdef __x86_64__
-			if(g_hasAvx2)
+			if( (g_hasAvx512F || g_hasFMA) && !(transforms & (CONVERT_SKEW | CONVERT_CLIP)) )
 			{
-				Convert8BitSamplesAVX2(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
+				float gain = job.m_gain;
+				float offset = job.m_offset;
+				if(job.m_invert)
+				{
+					gain = -gain;
+					offset = -offset;
+				}
+
+				float* pout = job.m_pout + off;
+				auto pin = reinterpret_cast<int16_t*>(job.m_pin) + off;
+				if(g_hasAvx512F)
+					Convert16BitSamplesAVX512F(pout, pin, gain, offset, count);
+				else
+					Convert16BitSamplesFMA(pout, pin, gain, offset, count);
+				return false;
 			}
-			else
 			#endif /* __x86_64__ */
-			{
-				Convert8BitSamplesGeneric(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-		}
+			return GetFusedKernels<int16_t>()[transforms](job, off, count);
 	}
 
-	//Small waveforms get done single threaded to avoid overhead
-	else
-	{
-		#ifdef __x86_64__
-		if(g_hasAvx2)
-			Convert8BitSamplesAVX2(pout, pin, gain, offset, count);
-		else
-		#endif
-			Convert8BitSamplesGeneric(pout, pin, gain, offset, count);
-	}
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers for converting raw 8-bit ADC samples to fp32 waveforms
+
+/**
+	@brief Converts 8-bit ADC samples to floating point
+ */
+void Oscilloscope::Convert8BitSamples(float* pout, int8_t* pin, float gain, float offset, size_t count)
+{
+	SampleConversionJob job(pout, pin, gain, offset, count);
+	ConvertSamples(&job, 1);
 }
 
 /**
@@ -936,58 +1317,8 @@ void Oscilloscope::Convert8BitSamplesAVX2(float* pout, int8_t* pin, float gain,
  */
 void Oscilloscope::ConvertUnsigned8BitSamples(float* pout, uint8_t* pin, float gain, float offset, size_t count)
 {
-	//Divide large waveforms (>1M points) into blocks and multithread them
-	//TODO: tune split
-	if(count > 1000000)
-	{
-		//Round blocks to multiples of 32 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 32);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
-		{
-			//Last block gets any extra that didn't divide evenly
-			size_t nsamp = blocksize;
-			if(i == lastblock)
-				nsamp = count - i*blocksize;
-
-			size_t off = i*blocksize;
-			#ifdef __x86_64__
-			if(g_hasAvx2)
-			{
-				ConvertUnsigned8BitSamplesAVX2(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-			else
-			#endif
-			{
-				ConvertUnsigned8BitSamplesGeneric(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-		}
-	}
-
-	//Small waveforms get done single threaded to avoid overhead
-	else
-	{
-		#ifdef __x86_64__
-		if(g_hasAvx2)
-			ConvertUnsigned8BitSamplesAVX2(pout, pin, gain, offset, count);
-		else
-		#endif
-			ConvertUnsigned8BitSamplesGeneric(pout, pin, gain, offset, count);
-	}
+	SampleConversionJob job(pout, pin, gain, offset, count);
+	ConvertSamples(&job, 1);
 }
 
 /**
@@ -1071,84 +1402,8 @@ void Oscilloscope::ConvertUnsigned8BitSamplesAVX2(float* pout, uint8_t* pin, flo
  */
 void Oscilloscope::Convert16BitSamples(float* pout, int16_t* pin, float gain, float offset, size_t count)
 {
-	//Divide large waveforms (>1M points) into blocks and multithread them
-	//TODO: tune split
-	if(count > 1000000)
-	{
-		//Round blocks to multiples of 64 samples for clean vectorization
-		size_t numblocks = omp_get_max_threads();
-		size_t lastblock = numblocks - 1;
-		size_t blocksize = count / numblocks;
-		blocksize = blocksize - (blocksize % 64);
-
-		#pragma omp parallel for
-		for(size_t i=0; i<numblocks; i++)
-		{
-			//Last block gets any extra that didn't divide evenly
-			size_t nsamp = blocksize;
-			if(i == lastblock)
-				nsamp = count - i*blocksize;
-
-			size_t off = i*blocksize;
-			#ifdef __x86_64__
-			if(g_hasAvx512F)
-			{
-				Convert16BitSamplesAVX512F(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-			else if(g_hasAvx2)
-			{
-				if(g_hasFMA)
-				{
-					Convert16BitSamplesFMA(
-						pout + off,
-						pin + off,
-						gain,
-						offset,
-						nsamp);
-				}
-				else
-				{
-					Convert16BitSamplesAVX2(
-						pout + off,
-						pin + off,
-						gain,
-						offset,
-						nsamp);
-				}
-			}
-			else
-			#endif /* __x86_64__ */
-			{
-				Convert16BitSamplesGeneric(
-					pout + off,
-					pin + off,
-					gain,
-					offset,
-					nsamp);
-			}
-		}
-	}
-
-	//Small waveforms get done single threaded to avoid overhead
-	else
-	{
-		#ifdef __x86_64__
-		if(g_hasAvx2)
-		{
-			if(g_hasFMA)
-				Convert16BitSamplesFMA(pout, pin, gain, offset, count);
-			else
-				Convert16BitSamplesAVX2(pout, pin, gain, offset, count);
-		}
-		else
-		#endif /* __x86_64__ */
-			Convert16BitSamplesGeneric(pout, pin, gain, offset, count);
-	}
+	SampleConversionJob job(pout, pin, gain, offset, count);
+	ConvertSamples(&job, 1);
 }
 
 /**
@@ -663,6 +663,18 @@ public:
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Sequenced triggering
 
+	/**
+		@brief Enables or disables handing each sequence acquisition to the filter graph as a single batch
+
+		When enabled, drivers queue all segments of a sequence acquisition as one SequenceSet, with each uniform analog
+		stream combined into a SegmentedAnalogWaveform, rather than one SequenceSet per segment.
+	 */
+	void SetSegmentBatchingEnabled(bool enable)
+	{ m_segmentBatching = enable; }
+
+	bool IsSegmentBatchingEnabled()
+	{ return m_segmentBatching; }
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// ADC bit depth configuration
 
@@ -825,6 +837,100 @@ public:
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Sample format conversion
+public:
+
+	///@brief Raw ADC sample formats accepted by ConvertSamples()
+	enum RawSampleFormat
+	{
+		RAW_FORMAT_INT8,
+		RAW_FORMAT_UINT8,
+		RAW_FORMAT_INT16
+	};
+
+	/**
+		@brief One channel (or segment) worth of raw ADC samples to be converted to fp32 by ConvertSamples()
+
+		Output is pout[i] = pin[i + skew]*gain - offset, negated if inverted. Inversion, integer-sample deskew and clip
+		detection are all applied in the same pass as the conversion, by a kernel specialized at compile time for the
+		set of transforms the job actually needs.
+	 */
+	class SampleConversionJob
+	{
+	public:
+		SampleConversionJob(float* pout, int8_t* pin, float gain, float offset, size_t count)
+		: m_pout(pout), m_pin(pin), m_format(RAW_FORMAT_INT8), m_gain(gain), m_offset(offset), m_count(count)
+		, m_invert(false), m_skew(0), m_clipLow(INT8_MIN), m_clipHigh(INT8_MAX), m_clipTarget(nullptr)
+		{}
+
+		SampleConversionJob(float* pout, uint8_t* pin, float gain, float offset, size_t count)
+		: m_pout(pout), m_pin(pin), m_format(RAW_FORMAT_UINT8), m_gain(gain), m_offset(offset), m_count(count)
+		, m_invert(false), m_skew(0), m_clipLow(0), m_clipHigh(UINT8_MAX), m_clipTarget(nullptr)
+		{}
+
+		SampleConversionJob(float* pout, int16_t* pin, float gain, float offset, size_t count)
+		: m_pout(pout), m_pin(pin), m_format(RAW_FORMAT_INT16), m_gain(gain), m_offset(offset), m_count(count)
+		, m_invert(false), m_skew(0), m_clipLow(INT16_MIN), m_clipHigh(INT16_MAX), m_clipTarget(nullptr)
+		{}
+
+		/**
+			@brief Requests clip detection for this job
+
+			If any raw code is <= low or >= high, WAVEFORM_CLIPPING is set on the target waveform. The flag is never
+			cleared, so drivers can combine this with clipping reported by the instrument.
+		 */
+		void DetectClipping(WaveformBase* target, int32_t low, int32_t high)
+		{
+			m_clipTarget = target;
+			m_clipLow = low;
+			m_clipHigh = high;
+		}
+
+		float* m_pout;
+		void* m_pin;
+		RawSampleFormat m_format;
+		float m_gain;
+		float m_offset;
+
+		///@brief Number of output samples. The input must have m_count + m_skew samples.
+		size_t m_count;
+
+		///@brief Negate the output
+		bool m_invert;
+
+		///@brief Number of input samples to skip, for integer-sample deskew
+		size_t m_skew;
+
+		int32_t m_clipLow;
+		int32_t m_clipHigh;
+
+		///@brief Waveform to flag if clipping is detected, or null to skip clip detection
+		WaveformBase* m_clipTarget;
+	};
+
+	/**
+		@brief Transforms applied by a fused conversion kernel, as a bitmask selecting the template instantiation
+	 */
+	enum ConversionTransform
+	{
+		CONVERT_GAIN	= 0x01,
+		CONVERT_OFFSET	= 0x02,
+		CONVERT_INVERT	= 0x04,
+		CONVERT_SKEW	= 0x08,
+		CONVERT_CLIP	= 0x10,
+
+		CONVERT_ALL		= 0x1f
+	};
+
+	static unsigned int GetConversionTransforms(const SampleConversionJob& job);
+
+	static void ConvertSamples(const SampleConversionJob* jobs, size_t njobs);
+
+	static void ConvertSamples(const std::vector<SampleConversionJob>& jobs)
+	{ ConvertSamples(jobs.data(), jobs.size()); }
+
+protected:
+	static bool ConvertSampleBlock(const SampleConversionJob& job, size_t off, size_t count);
+
 public:
 	static void Convert8BitSamples(float* pout, int8_t* pin, float gain, float offset, size_t count);
 	static void Convert8BitSamplesGeneric(float* pout, int8_t* pin, float gain, float offset, size_t count);
@@ -858,6 +964,11 @@ public:
 protected:
 	typedef std::map<StreamDescriptor, WaveformBase*> SequenceSet;
 	std::list<SequenceSet> m_pendingWaveforms;
+	void PushPendingSegments(std::vector<SequenceSet>& segments);
+	SequenceSet MergeSegments(std::vector<SequenceSet>& segments);
+
+	///@brief True if sequence acquisitions should be queued as a single batch
+	bool m_segmentBatching;
 	std::mutex m_pendingWaveformsMutex;
 	std::recursive_mutex m_mutex;
 
@@ -912,7 +1023,7 @@ protected:
 	{
 		auto p = m_analogWaveformPool.Get();
 		auto ret = dynamic_cast<UniformAnalogWaveform*>(p);
-		if(ret)
+		if(ret && !dynamic_cast<SegmentedAnalogWaveform*>(p))
 		{
 			ret->Rename(name);
 			return ret;
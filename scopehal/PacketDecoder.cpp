@@ -30,6 +30,8 @@
 #include "scopehal.h"
 #include "PacketDecoder.h"
 
+using namespace std;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Color schemes
 
@@ -64,13 +66,39 @@ Packet::~Packet()
 
 PacketDecoder::PacketDecoder(const std::string& color, Category cat)
 	: Filter(color, cat, Unit(Unit::UNIT_FS))
+	, m_storeViewCount(0)
+	, m_index(this)
+	, m_exportname("PCAPNG Output")
+	, m_exporter(NULL)
+	, m_exportInterface(0)
+	, m_exportCount(0)
+	, m_lastPacketOpen(false)
 {
 	AddProtocolStream("data");
+
+	m_parameters[m_exportname] = FilterParameter(FilterParameter::TYPE_FILENAME, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_exportname].m_fileFilterMask = "*.pcapng";
+	m_parameters[m_exportname].m_fileFilterName = "PCAPNG files (*.pcapng)";
+	m_parameters[m_exportname].m_fileIsOutput = true;
+
+	m_store.SetDefaultColors(Gdk::Color("#ffffff"), m_backgroundColors[PROTO_COLOR_DEFAULT]);
 }
 
 PacketDecoder::~PacketDecoder()
 {
 	ClearPackets();
+
+	PacketExporter::Close(m_exporter);
+	m_exporter = NULL;
+}
+
+/**
+	@brief Evaluates the decoder, then streams the new packets to the export file (if any)
+ */
+void PacketDecoder::Refresh(vk::raii::CommandBuffer& cmdBuf, vk::raii::Queue& queue)
+{
+	Filter::Refresh(cmdBuf, queue);
+	ExportPackets();
 }
 
 void PacketDecoder::ClearPackets()
@@ -78,6 +106,190 @@ void PacketDecoder::ClearPackets()
 	for(auto p : m_packets)
 		delete p;
 	m_packets.clear();
+
+	m_store.clear();
+	m_storeViewCount = 0;
+
+	m_index.Clear();
+
+	m_exportCount = 0;
+	m_lastPacketOpen = false;
+}
+
+/**
+	@brief Adds a row to the packet store, setting up the column schema from GetHeaders() on first use
+
+	@param offset	Start time of the packet (femtoseconds)
+
+	@return Index of the new row
+ */
+size_t PacketDecoder::AddPacket(int64_t offset)
+{
+	if(!m_store.HasSchema())
+		m_store.SetSchema(GetHeaders());
+	return m_store.AddPacket(offset);
+}
+
+/**
+	@brief Returns all packets as Packet objects
+
+	Rows of the packet store are converted to Packet objects the first time this is called after they're added, so
+	decoders using the store only pay for string formatting if something actually wants the packets in this form.
+ */
+const vector<Packet*>& PacketDecoder::GetPackets()
+{
+	size_t nrows = m_store.size();
+	size_t ncols = m_store.GetColumnCount();
+	for(size_t i=m_storeViewCount; i<nrows; i++)
+	{
+		auto pack = CreatePacketView(i);
+		pack->m_offset = m_store.GetOffset(i);
+		pack->m_len = m_store.GetLength(i);
+		pack->m_displayForegroundColor = m_store.GetForegroundColor(i);
+		pack->m_displayBackgroundColor = m_store.GetBackgroundColor(i);
+
+		auto data = m_store.GetData(i);
+		pack->m_data.assign(data, data + m_store.GetDataLength(i));
+
+		for(size_t j=0; j<ncols; j++)
+		{
+			if(m_store.HasValue(i, j))
+				pack->m_headers[m_store.GetColumnName(j)] = GetHeaderText(i, j);
+		}
+
+		m_packets.push_back(pack);
+	}
+	m_storeViewCount = nrows;
+
+	return m_packets;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Export
+
+/**
+	@brief Returns the PCAPNG export sink, opening or closing it if the file name parameter has changed
+
+	Decoders exporting to the same file share one exporter, each with its own interface in the file.
+
+	@return The sink, or NULL if export is disabled or the file couldn't be opened
+ */
+PacketExporter* PacketDecoder::GetExporter()
+{
+	auto fname = m_parameters[m_exportname].GetFileName();
+	if(fname == m_exportFileName)
+		return m_exporter;
+
+	PacketExporter::Close(m_exporter);
+	m_exporter = NULL;
+	m_exportFileName = fname;
+	m_exportCount = 0;
+	if(fname.empty())
+		return NULL;
+
+	m_exporter = PacketExporter::Open(fname, PacketExporter::FORMAT_PCAPNG);
+	if(m_exporter)
+		m_exportInterface = m_exporter->AddInterface(GetExportLinkType(), GetDisplayName());
+	return m_exporter;
+}
+
+/**
+	@brief Writes the packets added since the last export to the export file
+
+	The default implementation writes the data bytes of each packet. Decoders with a standard link-layer framing
+	(e.g. Ethernet) may override this to export complete frames.
+
+	If m_lastPacketOpen is set, the last packet is still being appended to by an incremental decoder and is held back
+	until it's complete.
+ */
+void PacketDecoder::ExportPackets()
+{
+	auto exporter = GetExporter();
+	if(!exporter)
+		return;
+	auto data = GetData(0);
+	if(!data)
+	{
+		//Still get the file header out
+		exporter->Commit();
+		return;
+	}
+
+	size_t end = GetPacketCount();
+	if(m_lastPacketOpen && (end > 0) )
+		end --;
+
+	time_t timestamp = data->m_startTimestamp;
+	int64_t fs = data->m_startFemtoseconds;
+	if(m_store.size())
+	{
+		for(size_t i=m_exportCount; i<end; i++)
+		{
+			exporter->WritePacket(
+				m_exportInterface, timestamp, fs + m_store.GetOffset(i), m_store.GetData(i), m_store.GetDataLength(i));
+		}
+	}
+	else
+	{
+		for(size_t i=m_exportCount; i<end; i++)
+		{
+			auto p = m_packets[i];
+			exporter->WritePacket(m_exportInterface, timestamp, fs + p->m_offset, p->m_data.data(), p->m_data.size());
+		}
+	}
+	m_exportCount = max(m_exportCount, end);
+
+	exporter->Commit();
+}
+
+/**
+	@brief Returns the PCAPNG link type for this decoder's packets
+
+	The default is LINKTYPE_USER0, since most decoders' packet data has no registered link type.
+ */
+uint16_t PacketDecoder::GetExportLinkType()
+{
+	return PacketExporter::LINKTYPE_USER0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Packet views and formatting
+
+/**
+	@brief Creates the (empty) Packet object used as the compatibility view of one row of the packet store
+
+	Decoders which need a Packet subclass (e.g. for the image column) override this.
+ */
+Packet* PacketDecoder::CreatePacketView(size_t /*row*/)
+{
+	return new Packet;
+}
+
+/**
+	@brief Formats one header of a packet in the packet store
+
+	@param row		Index of the packet
+	@param col		Index of the column, in GetHeaders() order
+ */
+string PacketDecoder::GetHeaderText(size_t row, size_t col)
+{
+	if( (m_store.GetColumnType(col) == PacketStore::COLUMN_CUSTOM) && m_store.HasValue(row, col) && !m_store.IsText(row, col) )
+		return FormatHeader(row, col, m_store.GetValue(row, col));
+	return m_store.GetText(row, col);
+}
+
+/**
+	@brief Formats a COLUMN_CUSTOM header
+
+	The default implementation displays the value in decimal.
+
+	@param row		Index of the packet
+	@param col		Index of the column
+	@param value	Value stored in the cell
+ */
+string PacketDecoder::FormatHeader(size_t /*row*/, size_t /*col*/, uint64_t value)
+{
+	return to_string(value);
 }
 
 bool PacketDecoder::GetShowDataColumn()
@@ -31,6 +31,9 @@
 #define PacketDecoder_h
 
 #include "Filter.h"
+#include "PacketStore.h"
+#include "PacketIndex.h"
+#include "PacketExporter.h"
 
 /**
 	@class
@@ -71,11 +74,26 @@ public:
 	PacketDecoder(const std::string& color, Filter::Category cat);
 	virtual ~PacketDecoder();
 
-	const std::vector<Packet*>& GetPackets()
-	{ return m_packets; }
+	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, vk::raii::Queue& queue);
+
+	const std::vector<Packet*>& GetPackets();
 
 	virtual std::vector<std::string> GetHeaders() =0;
 
+	///@brief Columnar storage for decoders which don't create Packet objects directly
+	const PacketStore& GetPacketStore() const
+	{ return m_store; }
+
+	std::string GetHeaderText(size_t row, size_t col);
+
+	///@brief Number of packets, whether stored as Packet objects or in the packet store
+	size_t GetPacketCount()
+	{ return m_store.size() ? m_store.size() : m_packets.size(); }
+
+	///@brief Search indexes over the packets
+	PacketIndex& GetIndex()
+	{ return m_index; }
+
 	virtual bool GetShowDataColumn();
 	virtual bool GetShowImageColumn();
 
@@ -105,7 +123,47 @@ public:
 protected:
 	void ClearPackets();
 
+	size_t AddPacket(int64_t offset);
+	virtual std::string FormatHeader(size_t row, size_t col, uint64_t value);
+	virtual Packet* CreatePacketView(size_t row);
+
+	PacketExporter* GetExporter();
+	virtual void ExportPackets();
+	virtual uint16_t GetExportLinkType();
+
+	/**
+		@brief Packets created directly by the decoder, plus compatibility views of the rows of m_store
+
+		A decoder should either push Packet objects here or add rows to m_store, not both.
+	 */
 	std::vector<Packet*> m_packets;
+
+	///@brief Columnar packet storage
+	PacketStore m_store;
+
+	///@brief Number of rows of m_store which have a view in m_packets
+	size_t m_storeViewCount;
+
+	///@brief Search indexes, built lazily on first query
+	PacketIndex m_index;
+
+	///@brief Name of the PCAPNG export file parameter
+	std::string m_exportname;
+
+	///@brief PCAPNG export sink, if a file is selected (shared with any other decoder exporting to the same file)
+	PacketExporter* m_exporter;
+
+	///@brief File name m_exporter was last opened for, so a rejected name isn't retried every refresh
+	std::string m_exportFileName;
+
+	///@brief Interface ID of this decoder's packets in the export file
+	uint32_t m_exportInterface;
+
+	///@brief Number of packets already written to the export file
+	size_t m_exportCount;
+
+	///@brief True if an incremental decoder may still append data to the last packet
+	bool m_lastPacketOpen;
 };
 
 #endif
@@ -0,0 +1,417 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PacketExporter
+ */
+
+#include "scopehal.h"
+#include "PacketExporter.h"
+
+using namespace std;
+
+mutex PacketExporter::m_exportersMutex;
+map<string, PacketExporter*> PacketExporter::m_exporters;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+/**
+	@brief Opens the output file and writes the file header
+
+	@param fname		Path to the file
+	@param format		File format
+	@param linktype		Link type of every packet (FORMAT_PCAP only; PCAPNG link types are set per interface)
+ */
+PacketExporter::PacketExporter(const string& fname, Format format, uint16_t linktype)
+	: m_fname(fname)
+	, m_format(format)
+	, m_linktype(linktype)
+	, m_refcount(0)
+	, m_interfaceCount(0)
+	, m_current(new vector<uint8_t>)
+	, m_terminating(false)
+{
+	m_fp = fopen(fname.c_str(), "wb");
+	if(!m_fp)
+	{
+		LogError("PacketExporter: couldn't open %s\n", fname.c_str());
+		return;
+	}
+
+	m_current->reserve(BUFFER_SIZE + 65536);
+
+	if(m_format == FORMAT_PCAP)
+	{
+		//Nanosecond-resolution magic number
+		uint32_t magic = 0xa1b23c4d;
+		uint16_t major = 2;
+		uint16_t minor = 4;
+		int32_t reserved = 0;
+		uint32_t snaplen = 0x40000;
+		uint32_t network = linktype;
+		Append(&magic, sizeof(magic));
+		Append(&major, sizeof(major));
+		Append(&minor, sizeof(minor));
+		Append(&reserved, sizeof(reserved));
+		Append(&reserved, sizeof(reserved));
+		Append(&snaplen, sizeof(snaplen));
+		Append(&network, sizeof(network));
+	}
+
+	else
+	{
+		//Section header block, no options
+		uint32_t type = 0x0a0d0d0a;
+		uint32_t len = 28;
+		uint32_t magic = 0x1a2b3c4d;
+		uint16_t major = 1;
+		uint16_t minor = 0;
+		int64_t sectionlen = -1;
+		Append(&type, sizeof(type));
+		Append(&len, sizeof(len));
+		Append(&magic, sizeof(magic));
+		Append(&major, sizeof(major));
+		Append(&minor, sizeof(minor));
+		Append(&sectionlen, sizeof(sectionlen));
+		Append(&len, sizeof(len));
+	}
+
+	m_thread = thread(&PacketExporter::WriterThread, this);
+}
+
+PacketExporter::~PacketExporter()
+{
+	if(m_fp)
+	{
+		HandOff();
+
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_terminating = true;
+		}
+		m_writerCvar.notify_one();
+		m_thread.join();
+
+		fclose(m_fp);
+		m_fp = NULL;
+	}
+
+	delete m_current;
+	for(auto p : m_free)
+		delete p;
+}
+
+/**
+	@brief Gets the exporter for a file, opening it if nobody has it open yet
+
+	Every successful call must be matched by a Close().
+
+	@param fname		Path to the file
+	@param format		File format
+	@param linktype		Link type of every packet (FORMAT_PCAP only; PCAPNG link types are set per interface)
+
+	@return The exporter, or NULL if the file couldn't be opened or is already open with an incompatible format
+ */
+PacketExporter* PacketExporter::Open(const string& fname, Format format, uint16_t linktype)
+{
+	lock_guard<mutex> lock(m_exportersMutex);
+
+	auto it = m_exporters.find(fname);
+	if(it != m_exporters.end())
+	{
+		auto exporter = it->second;
+		if( (exporter->m_format != format) || ( (format == FORMAT_PCAP) && (exporter->m_linktype != linktype) ) )
+		{
+			LogError("PacketExporter: %s is already open in a different format or link type\n", fname.c_str());
+			return NULL;
+		}
+
+		exporter->m_refcount ++;
+		return exporter;
+	}
+
+	auto exporter = new PacketExporter(fname, format, linktype);
+	if(!exporter->IsOpen())
+	{
+		delete exporter;
+		return NULL;
+	}
+
+	exporter->m_refcount = 1;
+	m_exporters[fname] = exporter;
+	return exporter;
+}
+
+/**
+	@brief Releases a reference obtained from Open(), closing the file when the last user is done with it
+
+	The file is flushed and closed with the registry locked, so a subsequent Open() of the same name can't truncate
+	it while the old writer is still draining.
+
+	@param exporter		The exporter to release (may be NULL)
+ */
+void PacketExporter::Close(PacketExporter* exporter)
+{
+	if(!exporter)
+		return;
+
+	lock_guard<mutex> lock(m_exportersMutex);
+	exporter->m_refcount --;
+	if(exporter->m_refcount == 0)
+	{
+		m_exporters.erase(exporter->m_fname);
+		delete exporter;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Serialization
+
+void PacketExporter::Append(const void* data, size_t len)
+{
+	auto p = reinterpret_cast<const uint8_t*>(data);
+	m_current->insert(m_current->end(), p, p + len);
+}
+
+///@brief Pads the current buffer to a 32-bit boundary (PCAPNG blocks are 32-bit aligned)
+void PacketExporter::Pad()
+{
+	while(m_current->size() & 3)
+		m_current->push_back(0);
+}
+
+/**
+	@brief Adds an interface description block
+
+	@param linktype		Link type of packets on this interface
+	@param name			Name of the interface (typically the decoder's display name)
+
+	@return Interface ID to pass to WritePacket()
+ */
+uint32_t PacketExporter::AddInterface(uint16_t linktype, const string& name)
+{
+	if( (m_format != FORMAT_PCAPNG) || !m_fp)
+		return 0;
+
+	lock_guard<mutex> lock(m_bufferMutex);
+
+	size_t namelen = name.length();
+	size_t namepad = (namelen + 3) & ~3;
+
+	//Header, if_name, if_tsresol, opt_endofopt, trailer
+	uint32_t type = 1;
+	uint32_t len = 16 + (4 + namepad) + 8 + 4 + 4;
+	uint16_t reserved = 0;
+	uint32_t snaplen = 0;
+	Append(&type, sizeof(type));
+	Append(&len, sizeof(len));
+	Append(&linktype, sizeof(linktype));
+	Append(&reserved, sizeof(reserved));
+	Append(&snaplen, sizeof(snaplen));
+
+	uint16_t code = 2;
+	uint16_t olen = namelen;
+	Append(&code, sizeof(code));
+	Append(&olen, sizeof(olen));
+	Append(name.c_str(), namelen);
+	Pad();
+
+	//Timestamps in ns
+	code = 9;
+	olen = 1;
+	uint8_t tsresol = 9;
+	Append(&code, sizeof(code));
+	Append(&olen, sizeof(olen));
+	Append(&tsresol, sizeof(tsresol));
+	Pad();
+
+	uint32_t endofopt = 0;
+	Append(&endofopt, sizeof(endofopt));
+	Append(&len, sizeof(len));
+
+	return m_interfaceCount ++;
+}
+
+/**
+	@brief Adds one packet to the file
+
+	Call Commit() after each batch of packets to send them to the file.
+
+	@param iface		Interface ID from AddInterface() (ignored for FORMAT_PCAP)
+	@param timestamp	Start time of the waveform the packet came from
+	@param fs			Time of the packet, in femtoseconds after the timestamp (may exceed one second)
+	@param data			Packet bytes
+	@param len			Length of the packet
+ */
+void PacketExporter::WritePacket(
+	uint32_t iface,
+	time_t timestamp,
+	int64_t fs,
+	const uint8_t* data,
+	size_t len)
+{
+	if(!m_fp)
+		return;
+
+	lock_guard<mutex> lock(m_bufferMutex);
+
+	int64_t sec = timestamp + (fs / FS_PER_SECOND);
+	int64_t ns = (fs % (int64_t)FS_PER_SECOND) / 1000000;
+
+	uint32_t len32 = len;
+	if(m_format == FORMAT_PCAP)
+	{
+		uint32_t tsec = sec;
+		uint32_t tns = ns;
+		Append(&tsec, sizeof(tsec));
+		Append(&tns, sizeof(tns));
+		Append(&len32, sizeof(len32));
+		Append(&len32, sizeof(len32));
+		Append(data, len);
+	}
+
+	else
+	{
+		//Enhanced packet block
+		uint64_t ts = sec * 1000000000LL + ns;
+		uint32_t type = 6;
+		uint32_t blocklen = 32 + ((len + 3) & ~3);
+		uint32_t tshi = ts >> 32;
+		uint32_t tslo = ts & 0xffffffff;
+		Append(&type, sizeof(type));
+		Append(&blocklen, sizeof(blocklen));
+		Append(&iface, sizeof(iface));
+		Append(&tshi, sizeof(tshi));
+		Append(&tslo, sizeof(tslo));
+		Append(&len32, sizeof(len32));
+		Append(&len32, sizeof(len32));
+		Append(data, len);
+		Pad();
+		Append(&blocklen, sizeof(blocklen));
+	}
+
+	if(m_current->size() >= BUFFER_SIZE)
+		HandOff();
+}
+
+/**
+	@brief Ends a batch of packets, and hands everything written since the last batch to the writer thread
+
+	Callers generally commit once per refresh, so each acquisition's packets are in the file (flushed to the OS) as
+	soon as the writer thread gets to them, even for a single-shot capture.
+ */
+void PacketExporter::Commit()
+{
+	lock_guard<mutex> lock(m_bufferMutex);
+	HandOff();
+}
+
+/**
+	@brief Queues the current buffer for writing and starts a new one
+
+	Called with m_bufferMutex held, or from the destructor once nobody else can be writing.
+ */
+void PacketExporter::HandOff()
+{
+	if(m_current->empty())
+		return;
+
+	{
+		unique_lock<mutex> lock(m_mutex);
+
+		//If the disk can't keep up, wait rather than buffering without bound
+		m_doneCvar.wait(lock, [this]{ return m_pending.size() < MAX_QUEUED_BUFFERS; });
+
+		m_pending.push_back(m_current);
+		if(m_free.empty())
+		{
+			m_current = new vector<uint8_t>;
+			m_current->reserve(BUFFER_SIZE + 65536);
+		}
+		else
+		{
+			m_current = m_free.back();
+			m_free.pop_back();
+		}
+	}
+	m_writerCvar.notify_one();
+
+	m_current->clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Writer thread
+
+void PacketExporter::WriterThread(PacketExporter* pThis)
+{
+	#ifdef __linux__
+	pthread_setname_np(pthread_self(), "PacketExporter");
+	#endif
+
+	pThis->DoWriterThread();
+}
+
+void PacketExporter::DoWriterThread()
+{
+	while(true)
+	{
+		vector<uint8_t>* buf;
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_writerCvar.wait(lock, [this]{ return m_terminating || !m_pending.empty(); });
+
+			//Drain the queue before exiting
+			if(m_pending.empty())
+				break;
+
+			buf = m_pending.front();
+			m_pending.pop_front();
+		}
+
+		if(fwrite(buf->data(), 1, buf->size(), m_fp) != buf->size())
+			LogError("PacketExporter: write to %s failed\n", m_fname.c_str());
+
+		bool idle;
+		{
+			lock_guard<mutex> lock(m_mutex);
+			buf->clear();
+			m_free.push_back(buf);
+			idle = m_pending.empty();
+		}
+
+		//Caught up, make sure everything so far is visible to other readers of the file
+		if(idle)
+			fflush(m_fp);
+		m_doneCvar.notify_all();
+	}
+}
@@ -0,0 +1,162 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PacketExporter
+ */
+
+#ifndef PacketExporter_h
+#define PacketExporter_h
+
+#include <condition_variable>
+#include <deque>
+
+/**
+	@brief Streams packets to a PCAP or PCAPNG file
+
+	Packets are serialized into a large in-memory buffer by the caller and handed to a background thread, which does
+	all of the file I/O in big sequential writes. A filter refreshing on a graph executor thread never waits on the
+	disk unless the writer falls more than MAX_QUEUED_BUFFERS behind.
+
+	Exporters are opened with Open() and released with Close(). Opening a file name that is already open returns the
+	existing exporter (with its reference count bumped) rather than truncating the file under it, and the file is
+	closed once the last user releases it. PCAPNG files get one interface description block per AddInterface() call,
+	so several decoders (or several streams of one decoder) can share a file; AddInterface(), WritePacket() and
+	Commit() are serialized internally since sharing decoders may refresh on different threads. A PCAP file has a
+	single link type for the whole file and can only be shared by users asking for that same link type. Timestamps are written with nanosecond resolution in both formats,
+	the finest that fits in 64 bits for present-day dates given our femtosecond timebase.
+ */
+class PacketExporter
+{
+public:
+
+	enum Format
+	{
+		FORMAT_PCAP,
+		FORMAT_PCAPNG
+	};
+
+	///@brief Link types from the tcpdump.org registry
+	enum LinkType
+	{
+		LINKTYPE_ETHERNET	= 1,
+		LINKTYPE_USER0		= 147
+	};
+
+	static PacketExporter* Open(const std::string& fname, Format format, uint16_t linktype = LINKTYPE_USER0);
+	static void Close(PacketExporter* exporter);
+
+	//not copyable or assignable
+	PacketExporter(const PacketExporter& rhs) =delete;
+	PacketExporter& operator=(const PacketExporter& rhs) =delete;
+
+	///@brief Returns true if the file was opened successfully
+	bool IsOpen() const
+	{ return m_fp != NULL; }
+
+	///@brief Name of the output file
+	const std::string& GetFileName() const
+	{ return m_fname; }
+
+	uint32_t AddInterface(uint16_t linktype, const std::string& name);
+
+	void WritePacket(
+		uint32_t iface,
+		time_t timestamp,
+		int64_t fs,
+		const uint8_t* data,
+		size_t len);
+
+	void Commit();
+
+protected:
+	PacketExporter(const std::string& fname, Format format, uint16_t linktype);
+	~PacketExporter();
+
+	void Append(const void* data, size_t len);
+	void Pad();
+	void HandOff();
+
+	static void WriterThread(PacketExporter* pThis);
+	void DoWriterThread();
+
+	///@brief Maximum number of full buffers waiting to be written before WritePacket() blocks
+	static const size_t MAX_QUEUED_BUFFERS = 64;
+
+	///@brief Size at which the current buffer is handed to the writer thread
+	static const size_t BUFFER_SIZE = 4 * 1024 * 1024;
+
+	std::string m_fname;
+	Format m_format;
+	uint16_t m_linktype;
+	FILE* m_fp;
+
+	///@brief Number of Open() calls not yet matched by Close() (guarded by m_exportersMutex)
+	size_t m_refcount;
+
+	///@brief Mutex serializing writers to m_current, since several decoders may share one exporter
+	std::mutex m_bufferMutex;
+
+	///@brief Number of interfaces created so far
+	uint32_t m_interfaceCount;
+
+	///@brief Buffer being filled by the caller
+	std::vector<uint8_t>* m_current;
+
+	//Mutex for access to the queues and m_terminating
+	std::mutex m_mutex;
+
+	//Buffers waiting to be written
+	std::deque<std::vector<uint8_t>*> m_pending;
+
+	//Buffers which have been written and can be reused
+	std::vector<std::vector<uint8_t>*> m_free;
+
+	//Condition variable for waking up the writer thread when a buffer is queued
+	std::condition_variable m_writerCvar;
+
+	//Condition variable for waking up the caller when a buffer has been written
+	std::condition_variable m_doneCvar;
+
+	//Shutdown flag
+	bool m_terminating;
+
+	std::thread m_thread;
+
+	///@brief Mutex for access to m_exporters and the reference counts
+	static std::mutex m_exportersMutex;
+
+	///@brief Map of file names to open exporters
+	static std::map<std::string, PacketExporter*> m_exporters;
+};
+
+#endif
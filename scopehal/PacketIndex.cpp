@@ -0,0 +1,355 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PacketBitmap and PacketIndex
+ */
+
+#include "scopehal.h"
+#include "PacketDecoder.h"
+#include <algorithm>
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PacketBitmap
+
+PacketBitmap::PacketBitmap(size_t size, bool value)
+	: m_size(size)
+	, m_words((size + 63) / 64, value ? ~0ULL : 0)
+{
+	//Keep the unused bits of the last word clear so Count() and FindNext() don't need to mask them
+	if(value && (size & 63))
+		m_words.back() = (1ULL << (size & 63)) - 1;
+}
+
+/**
+	@brief Returns the number of packets in the set
+ */
+size_t PacketBitmap::Count() const
+{
+	size_t count = 0;
+	for(auto w : m_words)
+		count += __builtin_popcountll(w);
+	return count;
+}
+
+/**
+	@brief Returns the first packet in the set at or after i, or size() if there is none
+ */
+size_t PacketBitmap::FindNext(size_t i) const
+{
+	if(i >= m_size)
+		return m_size;
+
+	size_t nword = i >> 6;
+	uint64_t w = m_words[nword] & (~0ULL << (i & 63));
+	while(true)
+	{
+		if(w)
+			return (nword << 6) + __builtin_ctzll(w);
+
+		nword ++;
+		if(nword >= m_words.size())
+			return m_size;
+		w = m_words[nword];
+	}
+}
+
+/**
+	@brief Returns the last packet in the set at or before i, or size() if there is none
+ */
+size_t PacketBitmap::FindPrevious(size_t i) const
+{
+	if(m_size == 0)
+		return m_size;
+	if(i >= m_size)
+		i = m_size - 1;
+
+	size_t nword = i >> 6;
+	uint64_t w = m_words[nword];
+	if( (i & 63) != 63)
+		w &= (2ULL << (i & 63)) - 1;
+	while(true)
+	{
+		if(w)
+			return (nword << 6) + 63 - __builtin_clzll(w);
+
+		if(nword == 0)
+			return m_size;
+		nword --;
+		w = m_words[nword];
+	}
+}
+
+/**
+	@brief Returns the packet numbers in the set, in increasing order
+ */
+vector<size_t> PacketBitmap::ToVector() const
+{
+	vector<size_t> ret;
+	ret.reserve(Count());
+	for(size_t i=FindNext(0); i<m_size; i=FindNext(i+1))
+		ret.push_back(i);
+	return ret;
+}
+
+PacketBitmap& PacketBitmap::operator&=(const PacketBitmap& rhs)
+{
+	size_t len = min(m_words.size(), rhs.m_words.size());
+	for(size_t i=0; i<len; i++)
+		m_words[i] &= rhs.m_words[i];
+	for(size_t i=len; i<m_words.size(); i++)
+		m_words[i] = 0;
+	return *this;
+}
+
+PacketBitmap& PacketBitmap::operator|=(const PacketBitmap& rhs)
+{
+	size_t len = min(m_words.size(), rhs.m_words.size());
+	for(size_t i=0; i<len; i++)
+		m_words[i] |= rhs.m_words[i];
+	return *this;
+}
+
+PacketBitmap PacketBitmap::operator~() const
+{
+	PacketBitmap ret(m_size, true);
+	for(size_t i=0; i<m_words.size(); i++)
+		ret.m_words[i] &= ~m_words[i];
+	return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PacketIndex construction / invalidation
+
+PacketIndex::PacketIndex(PacketDecoder* decoder)
+	: m_decoder(decoder)
+	, m_packetCount(0)
+	, m_timeIndexValid(false)
+{
+}
+
+/**
+	@brief Discards all indexes (called when the decoder's packets are cleared)
+ */
+void PacketIndex::Clear()
+{
+	m_columns.clear();
+	m_timeIndexValid = false;
+	m_timeOrder.clear();
+	m_startTimes.clear();
+	m_packetCount = 0;
+}
+
+/**
+	@brief Discards the indexes if the set of packets has changed since they were built
+
+	@return Number of packets
+ */
+size_t PacketIndex::Sync()
+{
+	size_t count = m_decoder->GetPacketCount();
+	if(count != m_packetCount)
+	{
+		Clear();
+		m_packetCount = count;
+	}
+	return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Queries
+
+/**
+	@brief Finds all packets with a header equal to the given value
+
+	@param column	Name of the header, as returned by GetHeaders()
+	@param value	Header text to look for
+ */
+PacketBitmap PacketIndex::Find(const string& column, const string& value)
+{
+	PacketBitmap ret(Sync());
+	auto& index = GetColumnIndex(column);
+	auto it = index.find(value);
+	if(it != index.end())
+	{
+		for(auto row : it->second)
+			ret.Set(row);
+	}
+	return ret;
+}
+
+/**
+	@brief Finds all packets starting in the interval [start, end)
+
+	@param start	Start of the interval (femtoseconds from the start of the capture)
+	@param end		End of the interval
+ */
+PacketBitmap PacketIndex::FindInTimeRange(int64_t start, int64_t end)
+{
+	PacketBitmap ret(Sync());
+	if(!m_timeIndexValid)
+		BuildTimeIndex();
+
+	size_t first = lower_bound(m_startTimes.begin(), m_startTimes.end(), start) - m_startTimes.begin();
+	size_t last = lower_bound(m_startTimes.begin(), m_startTimes.end(), end) - m_startTimes.begin();
+	for(size_t i=first; i<last; i++)
+	{
+		if(m_timeOrder.empty())
+			ret.Set(i);
+		else
+			ret.Set(m_timeOrder[i]);
+	}
+	return ret;
+}
+
+/**
+	@brief Returns the distinct values of a header, sorted
+ */
+vector<string> PacketIndex::GetValues(const string& column)
+{
+	Sync();
+
+	vector<string> ret;
+	for(auto& it : GetColumnIndex(column))
+		ret.push_back(it.first);
+	return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Index building
+
+PacketIndex::ColumnIndex& PacketIndex::GetColumnIndex(const string& column)
+{
+	auto it = m_columns.find(column);
+	if(it != m_columns.end())
+		return it->second;
+
+	auto& index = m_columns[column];
+	BuildColumnIndex(column, index);
+	return index;
+}
+
+void PacketIndex::BuildColumnIndex(const string& column, ColumnIndex& index)
+{
+	auto& store = m_decoder->GetPacketStore();
+
+	//Legacy decoder: read the headers of each Packet object
+	if(store.size() == 0)
+	{
+		auto& packets = m_decoder->GetPackets();
+		for(size_t i=0; i<packets.size(); i++)
+		{
+			auto& headers = packets[i]->m_headers;
+			auto it = headers.find(column);
+			if(it != headers.end())
+				index[it->second].push_back(i);
+		}
+		return;
+	}
+
+	size_t col = 0;
+	for(; col<store.GetColumnCount(); col++)
+	{
+		if(store.GetColumnName(col) == column)
+			break;
+	}
+	if(col >= store.GetColumnCount())
+		return;
+
+	//Custom columns may depend on more than the raw value (e.g. payload bytes), so format every cell
+	size_t nrows = store.size();
+	bool custom = (store.GetColumnType(col) == PacketStore::COLUMN_CUSTOM);
+	map<uint64_t, vector<uint32_t> > raw;
+	for(size_t i=0; i<nrows; i++)
+	{
+		if(!store.HasValue(i, col))
+			continue;
+
+		if(custom && !store.IsText(i, col))
+			index[m_decoder->GetHeaderText(i, col)].push_back(i);
+		else
+			raw[store.GetValue(i, col)].push_back(i);
+	}
+
+	//Everything else: format each distinct value once
+	for(auto& it : raw)
+	{
+		auto& rows = index[store.GetText(it.second[0], col)];
+		if(rows.empty())
+			rows.swap(it.second);
+		else
+		{
+			rows.insert(rows.end(), it.second.begin(), it.second.end());
+			sort(rows.begin(), rows.end());
+		}
+	}
+}
+
+void PacketIndex::BuildTimeIndex()
+{
+	auto& store = m_decoder->GetPacketStore();
+	size_t count = m_packetCount;
+
+	m_startTimes.resize(count);
+	if(store.size() != 0)
+	{
+		for(size_t i=0; i<count; i++)
+			m_startTimes[i] = store.GetOffset(i);
+	}
+	else
+	{
+		auto& packets = m_decoder->GetPackets();
+		for(size_t i=0; i<count; i++)
+			m_startTimes[i] = packets[i]->m_offset;
+	}
+
+	//Packets out of order? Sort a permutation and search that instead
+	m_timeOrder.clear();
+	if(!is_sorted(m_startTimes.begin(), m_startTimes.end()))
+	{
+		m_timeOrder.resize(count);
+		for(size_t i=0; i<count; i++)
+			m_timeOrder[i] = i;
+		auto& times = m_startTimes;
+		stable_sort(m_timeOrder.begin(), m_timeOrder.end(),
+			[&times](uint32_t a, uint32_t b) { return times[a] < times[b]; });
+
+		vector<int64_t> sorted(count);
+		for(size_t i=0; i<count; i++)
+			sorted[i] = times[m_timeOrder[i]];
+		m_startTimes.swap(sorted);
+	}
+
+	m_timeIndexValid = true;
+}
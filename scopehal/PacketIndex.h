@@ -0,0 +1,162 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PacketBitmap and PacketIndex
+ */
+
+#ifndef PacketIndex_h
+#define PacketIndex_h
+
+class PacketDecoder;
+
+/**
+	@brief A set of packets, stored as one bit per packet
+
+	Compound queries are built by combining the results of PacketIndex lookups with &, | and ~.
+ */
+class PacketBitmap
+{
+public:
+	PacketBitmap(size_t size = 0, bool value = false);
+
+	///@brief Number of packets covered by the bitmap (not the number of packets in the set)
+	size_t size() const
+	{ return m_size; }
+
+	bool Get(size_t i) const
+	{ return (m_words[i >> 6] >> (i & 63)) & 1; }
+
+	void Set(size_t i)
+	{ m_words[i >> 6] |= (1ULL << (i & 63)); }
+
+	size_t Count() const;
+	size_t FindNext(size_t i) const;
+	size_t FindPrevious(size_t i) const;
+	std::vector<size_t> ToVector() const;
+
+	PacketBitmap& operator&=(const PacketBitmap& rhs);
+	PacketBitmap& operator|=(const PacketBitmap& rhs);
+	PacketBitmap operator~() const;
+
+	PacketBitmap operator&(const PacketBitmap& rhs) const
+	{
+		PacketBitmap ret(*this);
+		ret &= rhs;
+		return ret;
+	}
+
+	PacketBitmap operator|(const PacketBitmap& rhs) const
+	{
+		PacketBitmap ret(*this);
+		ret |= rhs;
+		return ret;
+	}
+
+protected:
+	size_t m_size;
+	std::vector<uint64_t> m_words;
+};
+
+/**
+	@brief Secondary indexes over the packets of one PacketDecoder
+
+	Packets are numbered in GetPackets() order. The index for a column is built the first time that column is queried,
+	as a sorted list of packets for each distinct header value, and is reused until the decoder's packets change.
+	For decoders using a PacketStore, cells are grouped by their raw value first so each distinct value is only
+	formatted once.
+
+	Time queries binary search the packet start times. Decoders almost always emit packets in time order, but if not,
+	a sorted copy of the start times is made.
+ */
+class PacketIndex
+{
+public:
+	PacketIndex(PacketDecoder* decoder);
+
+	void Clear();
+
+	PacketBitmap Find(const std::string& column, const std::string& value);
+	PacketBitmap FindInTimeRange(int64_t start, int64_t end);
+	std::vector<std::string> GetValues(const std::string& column);
+
+	/**
+		@brief Finds all packets whose header matches an arbitrary predicate
+
+		The predicate is evaluated once per distinct value of the column, not once per packet.
+
+		@param column	Name of the header
+		@param pred		Functor taking a const std::string& and returning bool
+	 */
+	template<class P>
+	PacketBitmap FindMatching(const std::string& column, P pred)
+	{
+		PacketBitmap ret(Sync());
+		for(auto& it : GetColumnIndex(column))
+		{
+			if(pred(it.first))
+			{
+				for(auto row : it.second)
+					ret.Set(row);
+			}
+		}
+		return ret;
+	}
+
+protected:
+	size_t Sync();
+
+	typedef std::map<std::string, std::vector<uint32_t> > ColumnIndex;
+	ColumnIndex& GetColumnIndex(const std::string& column);
+	void BuildColumnIndex(const std::string& column, ColumnIndex& index);
+	void BuildTimeIndex();
+
+	///@brief The decoder whose packets are indexed
+	PacketDecoder* m_decoder;
+
+	///@brief Number of packets the indexes were built from
+	size_t m_packetCount;
+
+	///@brief Packets grouped by header value, for each column queried so far
+	std::map<std::string, ColumnIndex> m_columns;
+
+	///@brief True if m_timeOrder and m_startTimes are up to date
+	bool m_timeIndexValid;
+
+	///@brief Packet numbers sorted by start time (empty if packets are already in order)
+	std::vector<uint32_t> m_timeOrder;
+
+	///@brief Packet start times, sorted
+	std::vector<int64_t> m_startTimes;
+};
+
+#endif
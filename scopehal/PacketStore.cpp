@@ -0,0 +1,279 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of PacketStore
+ */
+
+#include "scopehal.h"
+#include "PacketStore.h"
+
+using namespace std;
+
+//Definition for ODR-uses (push_back takes a reference)
+const uint64_t PacketStore::NO_VALUE;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+PacketStore::PacketStore()
+	: m_hasSchema(false)
+{
+	m_colors.push_back(Gdk::Color("#ffffff"));
+	m_colors.push_back(Gdk::Color("#101010"));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Schema
+
+/**
+	@brief Sets the type of a column
+
+	May be called before the schema is known (typically from the decoder's constructor). Columns which are never
+	declared default to COLUMN_TEXT.
+
+	@param name		Column name, as returned by GetHeaders()
+	@param type		Type of the column
+	@param width	Number of digits for COLUMN_HEX
+ */
+void PacketStore::DeclareColumn(const string& name, ColumnType type, size_t width)
+{
+	auto& col = m_declaredColumns[name];
+	col.m_name = name;
+	col.m_type = type;
+	col.m_width = width;
+
+	if(m_hasSchema)
+	{
+		for(auto& c : m_columns)
+		{
+			if(c.m_name == name)
+			{
+				c.m_type = type;
+				c.m_width = width;
+			}
+		}
+	}
+}
+
+/**
+	@brief Declares a COLUMN_ENUM column and the names of its values
+ */
+void PacketStore::DeclareEnum(const string& name, const vector<string>& names)
+{
+	DeclareColumn(name, COLUMN_ENUM);
+	m_declaredColumns[name].m_enumNames = names;
+
+	if(m_hasSchema)
+	{
+		for(auto& c : m_columns)
+		{
+			if(c.m_name == name)
+				c.m_enumNames = names;
+		}
+	}
+}
+
+/**
+	@brief Creates the columns, in the order given by PacketDecoder::GetHeaders()
+
+	Discards any existing packets.
+ */
+void PacketStore::SetSchema(const vector<string>& names)
+{
+	m_rows.clear();
+	m_data.clear();
+	m_columns.clear();
+	m_columns.resize(names.size());
+	for(size_t i=0; i<names.size(); i++)
+	{
+		auto& col = m_columns[i];
+		auto it = m_declaredColumns.find(names[i]);
+		if(it != m_declaredColumns.end())
+			col = it->second;
+		else
+		{
+			col.m_type = COLUMN_TEXT;
+			col.m_width = 0;
+		}
+		col.m_name = names[i];
+	}
+	m_hasSchema = true;
+}
+
+/**
+	@brief Sets the colors new packets start out with
+ */
+void PacketStore::SetDefaultColors(const Gdk::Color& fg, const Gdk::Color& bg)
+{
+	m_colors[0] = fg;
+	m_colors[1] = bg;
+}
+
+/**
+	@brief Removes all packets, keeping the schema and all allocated memory
+ */
+void PacketStore::clear()
+{
+	m_rows.clear();
+	m_data.clear();
+	for(auto& c : m_columns)
+		c.m_values.clear();
+
+	//Strings are only dropped once they pile up, since most decoders reuse the same few every refresh
+	if(m_strings.size() > 4096)
+	{
+		m_strings.clear();
+		m_stringIndexes.clear();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Packet creation
+
+/**
+	@brief Adds a new packet with no headers, no payload, and the default colors
+
+	@return Index of the packet
+ */
+size_t PacketStore::AddPacket(int64_t offset)
+{
+	Row row;
+	row.m_offset = offset;
+	row.m_len = 0;
+	row.m_dataStart = m_data.size();
+	row.m_dataLen = 0;
+	row.m_fg = 0;
+	row.m_bg = 1;
+	m_rows.push_back(row);
+
+	for(auto& c : m_columns)
+		c.m_values.push_back(NO_VALUE);
+
+	return m_rows.size() - 1;
+}
+
+/**
+	@brief Discards the most recently added packet, e.g. if it turned out to be truncated
+ */
+void PacketStore::RemoveLastPacket()
+{
+	if(m_rows.empty())
+		return;
+
+	m_data.resize(m_rows.back().m_dataStart);
+	m_rows.pop_back();
+	for(auto& c : m_columns)
+		c.m_values.pop_back();
+}
+
+uint32_t PacketStore::Intern(const string& text)
+{
+	auto it = m_stringIndexes.find(text);
+	if(it != m_stringIndexes.end())
+		return it->second;
+
+	uint32_t index = m_strings.size();
+	m_strings.push_back(text);
+	m_stringIndexes[text] = index;
+	return index;
+}
+
+uint16_t PacketStore::GetColorIndex(const Gdk::Color& color)
+{
+	//Decoders only ever use a handful of colors, so a linear search is fine
+	for(size_t i=0; i<m_colors.size(); i++)
+	{
+		auto& c = m_colors[i];
+		if( (c.get_red() == color.get_red()) &&
+			(c.get_green() == color.get_green()) &&
+			(c.get_blue() == color.get_blue()) )
+		{
+			return i;
+		}
+	}
+
+	m_colors.push_back(color);
+	return m_colors.size() - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Formatting
+
+/**
+	@brief Formats one cell for display
+
+	COLUMN_CUSTOM cells are shown in decimal here; PacketDecoder::GetHeaderText() passes them to the decoder instead.
+
+	@return The cell text, or an empty string if the cell was never set
+ */
+string PacketStore::GetText(size_t row, size_t col) const
+{
+	auto& c = m_columns[col];
+	uint64_t value = c.m_values[row];
+	if(value == NO_VALUE)
+		return "";
+	if(value & TEXT_FLAG)
+		return m_strings[value & ~TEXT_FLAG];
+
+	char tmp[64];
+	switch(c.m_type)
+	{
+		case COLUMN_TEXT:
+			return m_strings[value];
+
+		case COLUMN_HEX:
+			snprintf(tmp, sizeof(tmp), "%0*llx", (int)c.m_width, (unsigned long long)value);
+			return tmp;
+
+		case COLUMN_MAC:
+			snprintf(tmp, sizeof(tmp), "%02x:%02x:%02x:%02x:%02x:%02x",
+				(int)(value >> 40) & 0xff,
+				(int)(value >> 32) & 0xff,
+				(int)(value >> 24) & 0xff,
+				(int)(value >> 16) & 0xff,
+				(int)(value >> 8) & 0xff,
+				(int)value & 0xff);
+			return tmp;
+
+		case COLUMN_ENUM:
+			if(value < c.m_enumNames.size())
+				return c.m_enumNames[value];
+			//fall through
+
+		case COLUMN_DECIMAL:
+		case COLUMN_CUSTOM:
+		default:
+			snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long)value);
+			return tmp;
+	}
+}
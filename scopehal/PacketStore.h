@@ -0,0 +1,214 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PacketStore
+ */
+
+#ifndef PacketStore_h
+#define PacketStore_h
+
+/**
+	@brief Columnar storage for the packets produced by a PacketDecoder
+
+	The column schema is the list of names returned by PacketDecoder::GetHeaders(). Each column holds one 64-bit value
+	per packet and a type saying how to turn it into text, so decoders store raw fields (a MAC address, a length, an
+	index into a table of names) and nothing is formatted until the protocol analyzer actually asks for a cell.
+	Payload bytes for every packet live in a single shared arena rather than one vector per packet.
+
+	Any cell may also hold a literal string (see SetText()). Strings are interned, so repeated values such as "--" or
+	"NAK" cost one copy per store rather than one per packet.
+
+	Clearing the store keeps all allocations, so a decoder refreshing every trigger reaches a steady state with no
+	heap traffic at all.
+ */
+class PacketStore
+{
+public:
+	PacketStore();
+
+	enum ColumnType
+	{
+		COLUMN_TEXT,		//Value is an interned string
+		COLUMN_DECIMAL,		//Unsigned integer, displayed in decimal
+		COLUMN_HEX,			//Unsigned integer, displayed as hex zero-padded to the column width
+		COLUMN_MAC,			//48-bit MAC address
+		COLUMN_ENUM,		//Index into a table of names
+		COLUMN_CUSTOM		//Formatted by the decoder (see PacketDecoder::FormatHeader())
+	};
+
+	void DeclareColumn(const std::string& name, ColumnType type, size_t width = 0);
+	void DeclareEnum(const std::string& name, const std::vector<std::string>& names);
+
+	///@brief Returns true if the schema has been set up
+	bool HasSchema() const
+	{ return m_hasSchema; }
+
+	void SetSchema(const std::vector<std::string>& names);
+	void SetDefaultColors(const Gdk::Color& fg, const Gdk::Color& bg);
+
+	void clear();
+
+	///@brief Number of packets in the store
+	size_t size() const
+	{ return m_rows.size(); }
+
+	///@brief Number of columns in the schema
+	size_t GetColumnCount() const
+	{ return m_columns.size(); }
+
+	const std::string& GetColumnName(size_t col) const
+	{ return m_columns[col].m_name; }
+
+	ColumnType GetColumnType(size_t col) const
+	{ return m_columns[col].m_type; }
+
+	//Creating packets
+	size_t AddPacket(int64_t offset);
+	void RemoveLastPacket();
+
+	void SetOffset(size_t row, int64_t offset)
+	{ m_rows[row].m_offset = offset; }
+
+	void SetLength(size_t row, int64_t len)
+	{ m_rows[row].m_len = len; }
+
+	void SetForegroundColor(size_t row, const Gdk::Color& color)
+	{ m_rows[row].m_fg = GetColorIndex(color); }
+
+	void SetBackgroundColor(size_t row, const Gdk::Color& color)
+	{ m_rows[row].m_bg = GetColorIndex(color); }
+
+	void SetValue(size_t row, size_t col, uint64_t value)
+	{ m_columns[col].m_values[row] = value; }
+
+	void SetText(size_t row, size_t col, const std::string& text)
+	{ m_columns[col].m_values[row] = TEXT_FLAG | Intern(text); }
+
+	/**
+		@brief Appends payload bytes to the most recently added packet
+	 */
+	void AppendData(const uint8_t* data, size_t len)
+	{
+		m_data.insert(m_data.end(), data, data + len);
+		m_rows.back().m_dataLen += len;
+	}
+
+	void AppendData(uint8_t b)
+	{
+		m_data.push_back(b);
+		m_rows.back().m_dataLen ++;
+	}
+
+	//Reading packets
+	int64_t GetOffset(size_t row) const
+	{ return m_rows[row].m_offset; }
+
+	int64_t GetLength(size_t row) const
+	{ return m_rows[row].m_len; }
+
+	const Gdk::Color& GetForegroundColor(size_t row) const
+	{ return m_colors[m_rows[row].m_fg]; }
+
+	const Gdk::Color& GetBackgroundColor(size_t row) const
+	{ return m_colors[m_rows[row].m_bg]; }
+
+	///@brief Returns true if the cell has been set
+	bool HasValue(size_t row, size_t col) const
+	{ return m_columns[col].m_values[row] != NO_VALUE; }
+
+	///@brief Returns true if the cell holds a literal string rather than a typed value
+	bool IsText(size_t row, size_t col) const
+	{ return HasValue(row, col) && (m_columns[col].m_values[row] & TEXT_FLAG); }
+
+	uint64_t GetValue(size_t row, size_t col) const
+	{ return m_columns[col].m_values[row]; }
+
+	std::string GetText(size_t row, size_t col) const;
+
+	///@brief Returns a pointer to the payload of a packet (only valid until the next packet is added)
+	const uint8_t* GetData(size_t row) const
+	{ return m_data.data() + m_rows[row].m_dataStart; }
+
+	size_t GetDataLength(size_t row) const
+	{ return m_rows[row].m_dataLen; }
+
+protected:
+	uint32_t Intern(const std::string& text);
+	uint16_t GetColorIndex(const Gdk::Color& color);
+
+	///@brief Marker for a cell that was never set
+	static const uint64_t NO_VALUE = 0xffffffffffffffffULL;
+
+	///@brief Marker for a cell holding an index into m_strings rather than a typed value
+	static const uint64_t TEXT_FLAG = 0x8000000000000000ULL;
+
+	class Row
+	{
+	public:
+		int64_t m_offset;
+		int64_t m_len;
+		size_t m_dataStart;
+		size_t m_dataLen;
+		uint16_t m_fg;
+		uint16_t m_bg;
+	};
+
+	class Column
+	{
+	public:
+		std::string m_name;
+		ColumnType m_type;
+		size_t m_width;
+		std::vector<std::string> m_enumNames;
+		std::vector<uint64_t> m_values;
+	};
+
+	bool m_hasSchema;
+	std::vector<Column> m_columns;
+	std::vector<Row> m_rows;
+
+	///@brief Payload bytes of all packets, back to back
+	std::vector<uint8_t> m_data;
+
+	///@brief Column types declared before the schema was known
+	std::map<std::string, Column> m_declaredColumns;
+
+	///@brief Interned strings
+	std::vector<std::string> m_strings;
+	std::map<std::string, uint32_t> m_stringIndexes;
+
+	///@brief Distinct packet colors; the first two are the defaults for new packets
+	std::vector<Gdk::Color> m_colors;
+};
+
+#endif
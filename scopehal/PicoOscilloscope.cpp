@@ -169,15 +169,6 @@ PicoOscilloscope::PicoOscilloscope(SCPITransport* transport)
 	SetTrigger(trig);
 	PushTrigger();
 	SetTriggerOffset(10 * 1000L * 1000L);
-
-	//Initialize waveform buffers
-	//Plain old garden-variety CPU-side RAM here
-	for(size_t i=0; i<m_analogChannelCount; i++)
-	{
-		m_analogRawWaveformBuffers.push_back(std::make_unique<AcceleratorBuffer<int16_t> >());
-		m_analogRawWaveformBuffers[i]->SetCpuAccessHint(AcceleratorBuffer<int16_t>::HINT_LIKELY);
-		m_analogRawWaveformBuffers[i]->SetGpuAccessHint(AcceleratorBuffer<int16_t>::HINT_NEVER);
-	}
 }
 
 /**
@@ -277,6 +268,8 @@ void PicoOscilloscope::IdentifyHardware()
 
 PicoOscilloscope::~PicoOscilloscope()
 {
+	//Make sure the streaming thread isn't still calling ReadChunk() as we go away
+	StopStreamThread();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -431,74 +424,124 @@ Oscilloscope::TriggerMode PicoOscilloscope::PollTrigger()
 	return TRIGGER_MODE_TRIGGERED;
 }
 
-bool PicoOscilloscope::AcquireData()
+/**
+	@brief Reads one acquisition's headers and sample data from the bridge into a chunk
+
+	Raw samples for all channels go straight into the chunk's sample buffer, so no per-acquisition allocations are
+	needed once the buffer has grown to the current memory depth.
+ */
+bool PicoOscilloscope::ReadChunk(RemoteBridgeChunk& chunk)
 {
-	//Read the number of channels in the current waveform
-	uint16_t numChannels;
-	if(!m_transport->ReadRawData(sizeof(numChannels), (uint8_t*)&numChannels))
+	chunk.Clear();
+
+	if(!WaitForChunkData())
 		return false;
 
-	//Get the sample interval.
-	//May be different from m_srate if we changed the rate after the trigger was armed
-	int64_t fs_per_sample;
-	if(!m_transport->ReadRawData(sizeof(fs_per_sample), (uint8_t*)&fs_per_sample))
+	//Read the number of channels in the current waveform, and the sample interval.
+	//Interval may be different from m_srate if we changed the rate after the trigger was armed
+	#pragma pack(push, 1)
+	struct
+	{
+		uint16_t numChannels;
+		int64_t fs_per_sample;
+	} header;
+	#pragma pack(pop)
+	if(!m_transport->ReadRawData(sizeof(header), (uint8_t*)&header))
 		return false;
 
-	//Acquire data for each channel
-	size_t chnum;
-	size_t memdepth;
-	float config[3];
-	SequenceSet s;
+	chunk.m_fsPerSample = header.fs_per_sample;
 	double t = GetTime();
-	int64_t fs = (t - floor(t)) * FS_PER_SECOND;
-
-	//Analog channels get processed separately
-	vector<UniformAnalogWaveform*> awfms;
-	vector<size_t> achans;
-	vector<float> scales;
-	vector<float> offsets;
+	chunk.m_startTimestamp = time(NULL);
+	chunk.m_startFemtoseconds = (t - floor(t)) * FS_PER_SECOND;
 
-	for(size_t i=0; i<numChannels; i++)
+	for(size_t i=0; i<header.numChannels; i++)
 	{
 		//Get channel ID and memory depth (samples, not bytes)
-		if(!m_transport->ReadRawData(sizeof(chnum), (uint8_t*)&chnum))
-			return false;
-		if(!m_transport->ReadRawData(sizeof(memdepth), (uint8_t*)&memdepth))
+		size_t chanhdr[2];
+		if(!m_transport->ReadRawData(sizeof(chanhdr), (uint8_t*)chanhdr))
 			return false;
+		size_t chnum = chanhdr[0];
+		size_t memdepth = chanhdr[1];
 
 		//Analog channels
 		if(chnum < m_analogChannelCount)
 		{
-			auto& abuf = m_analogRawWaveformBuffers[chnum];
-			abuf->resize(memdepth);
-			abuf->PrepareForCpuAccess();
-			achans.push_back(chnum);
-
 			//Scale and offset are sent in the header since they might have changed since the capture began
+			float config[3];
 			if(!m_transport->ReadRawData(sizeof(config), (uint8_t*)&config))
 				return false;
-			float scale = config[0];
-			float offset = config[1];
-			float trigphase = -config[2] * fs_per_sample;
-			scale *= GetChannelAttenuation(chnum);
-			offset *= GetChannelAttenuation(chnum);
+
+			auto buf = chunk.AppendBlock(chnum, memdepth, sizeof(int16_t));
+			auto& block = chunk.m_blocks.back();
+			block.m_scale = config[0];
+			block.m_offset = config[1];
+			block.m_trigphase = -config[2] * header.fs_per_sample;
 
 			//TODO: stream timestamp from the server
-			if(!m_transport->ReadRawData(memdepth * sizeof(int16_t), reinterpret_cast<uint8_t*>(abuf->GetCpuPointer())))
+			if(!m_transport->ReadRawData(memdepth * sizeof(int16_t), buf))
+				return false;
+		}
+
+		//Digital pod
+		else
+		{
+			size_t podnum = chnum - m_analogChannelCount;
+			if(podnum > 2)
+			{
+				LogError("Digital pod number was >2 (chnum = %zu). Possible protocol desync or data corruption?\n",
+						 chnum);
+				return false;
+			}
+
+			float trigphase;
+			if(!m_transport->ReadRawData(sizeof(trigphase), (uint8_t*)&trigphase))
 				return false;
 
-			abuf->MarkModifiedFromCpu();
+			auto buf = chunk.AppendBlock(chnum, memdepth, sizeof(int16_t));
+			chunk.m_blocks.back().m_trigphase = -trigphase * header.fs_per_sample;
+			if(!m_transport->ReadRawData(memdepth * sizeof(int16_t), buf))
+				return false;
+		}
+	}
+
+	return true;
+}
 
+/**
+	@brief Converts a chunk read by ReadChunk() into waveforms
+ */
+bool PicoOscilloscope::ProcessChunk(RemoteBridgeChunk& chunk)
+{
+	SequenceSet s;
+	int64_t fs_per_sample = chunk.m_fsPerSample;
+
+	//Analog channels get processed separately
+	vector<UniformAnalogWaveform*> awfms;
+	vector<size_t> achans;
+	vector<int16_t*> abufs;
+	vector<float> scales;
+	vector<float> offsets;
+
+	for(auto& block : chunk.m_blocks)
+	{
+		size_t chnum = block.m_chnum;
+		size_t memdepth = block.m_depth;
+
+		//Analog channels
+		if(chnum < m_analogChannelCount)
+		{
 			//Create our waveform
-			auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(i)->GetHwname());
+			auto cap = AllocateAnalogWaveform(m_nickname + "." + GetChannel(chnum)->GetHwname());
 			cap->m_timescale = fs_per_sample;
-			cap->m_triggerPhase = trigphase;
-			cap->m_startTimestamp = time(NULL);
-			cap->m_startFemtoseconds = fs;
+			cap->m_triggerPhase = block.m_trigphase;
+			cap->m_startTimestamp = chunk.m_startTimestamp;
+			cap->m_startFemtoseconds = chunk.m_startFemtoseconds;
 			cap->Resize(memdepth);
 			awfms.push_back(cap);
-			scales.push_back(scale);
-			offsets.push_back(offset);
+			achans.push_back(chnum);
+			abufs.push_back(chunk.GetSamples<int16_t>(block));
+			scales.push_back(block.m_scale * GetChannelAttenuation(chnum));
+			offsets.push_back(block.m_offset * GetChannelAttenuation(chnum));
 
 			s[m_channels[chnum]] = cap;
 		}
@@ -506,22 +549,8 @@ bool PicoOscilloscope::AcquireData()
 		//Digital pod
 		else
 		{
-			int16_t* buf = new int16_t[memdepth];
-
-			float trigphase;
-			if(!m_transport->ReadRawData(sizeof(trigphase), (uint8_t*)&trigphase))
-				return false;
-			trigphase = -trigphase * fs_per_sample;
-			if(!m_transport->ReadRawData(memdepth * sizeof(int16_t), (uint8_t*)buf))
-				return false;
-
+			int16_t* buf = chunk.GetSamples<int16_t>(block);
 			size_t podnum = chnum - m_analogChannelCount;
-			if(podnum > 2)
-			{
-				LogError("Digital pod number was >2 (chnum = %zu). Possible protocol desync or data corruption?\n",
-						 chnum);
-				return false;
-			}
 
 			//Create buffers for output waveforms
 			SparseDigitalWaveform* caps[8];
@@ -542,9 +571,9 @@ bool PicoOscilloscope::AcquireData()
 				//Create the waveform
 				auto cap = caps[j];
 				cap->m_timescale = fs_per_sample;
-				cap->m_triggerPhase = trigphase;
-				cap->m_startTimestamp = time(NULL);
-				cap->m_startFemtoseconds = fs;
+				cap->m_triggerPhase = block.m_trigphase;
+				cap->m_startTimestamp = chunk.m_startTimestamp;
+				cap->m_startFemtoseconds = chunk.m_startFemtoseconds;
 
 				//Preallocate memory assuming no deduplication possible
 				cap->Resize(memdepth);
@@ -588,27 +617,48 @@ bool PicoOscilloscope::AcquireData()
 				cap->MarkSamplesModifiedFromCpu();
 				cap->MarkTimestampsModifiedFromCpu();
 			}
-
-			delete[] buf;
 		}
 	}
 
-	//Fallback path
-	//Process analog captures in parallel
-	#pragma omp parallel for
+	//Samples are left justified in 16 bits, so full scale depends on the ADC resolution
+	int32_t cliplimit;
+	switch(m_adcMode)
+	{
+		case ADC_MODE_10BIT:
+			cliplimit = 0x1ff << 6;
+			break;
+
+		case ADC_MODE_12BIT:
+			cliplimit = 0x7ff << 4;
+			break;
+
+		case ADC_MODE_8BIT:
+		default:
+			cliplimit = 0x7f << 8;
+			break;
+	}
+
+	//Convert all analog channels in one batch
+	vector<SampleConversionJob> jobs;
 	for(size_t i=0; i<awfms.size(); i++)
 	{
 		auto cap = awfms[i];
 		cap->PrepareForCpuAccess();
-		Convert16BitSamples(
+		jobs.push_back(SampleConversionJob(
 			cap->m_samples.GetCpuPointer(),
-			m_analogRawWaveformBuffers[achans[i]]->GetCpuPointer(),
+			abufs[i],
 			scales[i],
 			-offsets[i],
-			cap->size());
+			cap->size()));
 
-		cap->MarkSamplesModifiedFromCpu();
+		auto& job = jobs.back();
+		job.m_invert = IsInverted(achans[i]);
+		job.DetectClipping(cap, -cliplimit, cliplimit);
+		ApplyDeskew(achans[i], job, cap);
 	}
+	ConvertSamples(jobs);
+	for(auto cap : awfms)
+		cap->MarkSamplesModifiedFromCpu();
 
 	//Save the waveforms to our queue
 	m_pendingWaveformsMutex.lock();
@@ -622,6 +672,19 @@ bool PicoOscilloscope::AcquireData()
 	return true;
 }
 
+/**
+	@brief Analog channels can be inverted in software during sample conversion
+ */
+bool PicoOscilloscope::CanInvert(size_t i)
+{
+	return (i < m_analogChannelCount);
+}
+
+bool PicoOscilloscope::IsStreamingModeSupported()
+{
+	return true;
+}
+
 bool PicoOscilloscope::IsTriggerArmed()
 {
 	return m_triggerArmed;
@@ -66,10 +66,10 @@ public:
 	virtual void SetChannelBandwidthLimit(size_t i, unsigned int limit_mhz);
 	virtual OscilloscopeChannel* GetExternalTrigger();
 	virtual bool CanEnableChannel(size_t i);
+	virtual bool CanInvert(size_t i);
 
 	//Triggering
 	virtual Oscilloscope::TriggerMode PollTrigger();
-	virtual bool AcquireData();
 	virtual bool IsTriggerArmed();
 	virtual void PushTrigger();
 
@@ -97,6 +97,9 @@ public:
 	virtual size_t GetADCMode(size_t channel);
 	virtual void SetADCMode(size_t channel, size_t mode);
 
+	//Streaming
+	virtual bool IsStreamingModeSupported();
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Function generator
 
@@ -171,6 +174,9 @@ public:
 protected:
 	void IdentifyHardware();
 
+	virtual bool ReadChunk(RemoteBridgeChunk& chunk);
+	virtual bool ProcessChunk(RemoteBridgeChunk& chunk);
+
 	//Helpers for determining legal configurations
 	bool Is10BitModeAvailable();
 	bool Is12BitModeAvailable();
@@ -224,9 +230,6 @@ protected:
 
 	Series m_series;
 
-	///@brief Buffers for storing raw ADC samples before converting to fp32
-	std::vector<std::unique_ptr<AcceleratorBuffer<int16_t> > > m_analogRawWaveformBuffers;
-
 public:
 
 	static std::string GetDriverNameInternal();
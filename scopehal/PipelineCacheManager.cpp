@@ -31,13 +31,13 @@
 #include "PipelineCacheManager.h"
 #include "FileSystem.h"
 #include "VulkanFFTPlan.h"
+#include <sys/stat.h>
 
 #ifdef _WIN32
 #include <windows.h>
 #include <shlwapi.h>
 #include <shlobj.h>
 #else
-#include <sys/stat.h>
 #include <wordexp.h>
 #endif
 
@@ -187,6 +187,166 @@ shared_ptr<vk::raii::PipelineCache> PipelineCacheManager::Lookup(const string& k
 	return ret;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Parsed file cache
+
+/**
+	@brief Gets the modification time and size of a source file
+
+	@return False if the file could not be found
+ */
+bool PipelineCacheManager::GetSourceFileIdentity(const string& path, int64_t& mtime, int64_t& size)
+{
+	struct stat st;
+	if(0 != stat(path.c_str(), &st))
+		return false;
+
+	#ifdef _WIN32
+		mtime = static_cast<int64_t>(st.st_mtime) * 1000000000LL;
+	#else
+		mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+	#endif
+	size = st.st_size;
+	return true;
+}
+
+/**
+	@brief Gets the path to the on-disk cache file for a given source file
+ */
+string PipelineCacheManager::GetParsedFileCachePath(const string& path, const string& type)
+{
+	auto crc = CRC32(reinterpret_cast<const uint8_t*>(path.c_str()), 0, path.length()-1);
+	return m_cacheRootDir + "parsed_" + type + "_" + to_string_hex(crc, true, 8) + ".bin";
+}
+
+/**
+	@brief Looks up previously parsed content of a data file (S-parameters, IBIS models, etc)
+
+	Returns null if there is no cache entry, or if the source file has been modified since the entry was created.
+
+	@param path				Path to the source file
+	@param type				Short identifier for the kind of data (must be a legal file name component)
+	@param formatVersion	Version number of the parsed blob format (entries with other versions are ignored)
+ */
+shared_ptr< vector<uint8_t> > PipelineCacheManager::LookupParsedFile(
+	const string& path, const string& type, uint32_t formatVersion)
+{
+	if(path.empty())
+		return nullptr;
+
+	int64_t mtime;
+	int64_t size;
+	if(!GetSourceFileIdentity(path, mtime, size))
+		return nullptr;
+
+	lock_guard<mutex> lock(m_mutex);
+
+	auto fname = GetParsedFileCachePath(path, type);
+	FILE* fp = fopen(fname.c_str(), "rb");
+	if(!fp)
+	{
+		LogTrace("Miss for parsed %s\n", path.c_str());
+		return nullptr;
+	}
+
+	//Make sure the entry is for this version of this file
+	ParsedFileCacheHeader header;
+	if( (1 != fread(&header, sizeof(header), 1, fp)) ||
+		(header.format_ver != formatVersion) ||
+		(header.file_mtime != mtime) ||
+		(header.file_size != size) ||
+		(header.pathlen != path.length()) ||
+		(header.len == 0) )
+	{
+		LogTrace("Ignoring out of date cache entry for %s\n", path.c_str());
+		fclose(fp);
+		return nullptr;
+	}
+
+	//Verify the path (in case of a CRC collision on the name)
+	string cachedPath;
+	cachedPath.resize(header.pathlen);
+	if( (header.pathlen != fread(&cachedPath[0], 1, header.pathlen, fp)) || (cachedPath != path) )
+	{
+		LogTrace("Ignoring cache entry for %s (path mismatch)\n", path.c_str());
+		fclose(fp);
+		return nullptr;
+	}
+
+	//Read the content in one go
+	auto p = make_shared< vector<uint8_t> >();
+	p->resize(header.len);
+	if(header.len != fread(&((*p)[0]), 1, header.len, fp))
+	{
+		LogWarning("Read cache content failed (%s)\n", fname.c_str());
+		fclose(fp);
+		return nullptr;
+	}
+	fclose(fp);
+
+	if(header.crc != CRC32(*p))
+	{
+		LogWarning("Rejecting cache file (%s) due to bad CRC\n", fname.c_str());
+		return nullptr;
+	}
+
+	LogTrace("Hit for parsed %s\n", path.c_str());
+	return p;
+}
+
+/**
+	@brief Writes parsed content of a data file to the cache
+
+	Unlike the shader caches, this is written to disk immediately since parsed files are looked up on demand.
+
+	@param path				Path to the source file
+	@param type				Short identifier for the kind of data (must be a legal file name component)
+	@param formatVersion	Version number of the parsed blob format
+	@param value			The blob to store
+ */
+void PipelineCacheManager::StoreParsedFile(
+	const string& path,
+	const string& type,
+	uint32_t formatVersion,
+	shared_ptr< vector<uint8_t> > value)
+{
+	if(path.empty() || value->empty())
+		return;
+
+	ParsedFileCacheHeader header;
+	if(!GetSourceFileIdentity(path, header.file_mtime, header.file_size))
+		return;
+	header.format_ver = formatVersion;
+	header.pathlen = path.length();
+	header.len = value->size();
+	header.crc = CRC32(*value);
+
+	lock_guard<mutex> lock(m_mutex);
+
+	auto fname = GetParsedFileCachePath(path, type);
+	LogTrace("Saving parsed %s to %s (%zu bytes)\n", path.c_str(), fname.c_str(), value->size());
+	FILE* fp = fopen(fname.c_str(), "wb");
+	if(!fp)
+	{
+		LogWarning("Couldn't open cache file %s for writing\n", fname.c_str());
+		return;
+	}
+
+	if( (1 != fwrite(&header, sizeof(header), 1, fp)) ||
+		(header.pathlen != fwrite(path.c_str(), 1, header.pathlen, fp)) ||
+		(header.len != fwrite(&((*value)[0]), 1, header.len, fp)) )
+	{
+		LogWarning("Write cache data failed (%s)\n", fname.c_str());
+		fclose(fp);
+
+		//Don't leave a truncated file around
+		remove(fname.c_str());
+		return;
+	}
+
+	fclose(fp);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Serialization
 
@@ -46,6 +46,16 @@ struct PipelineCacheFileHeader
 	uint32_t	len;
 	uint32_t	crc;
 };
+
+struct ParsedFileCacheHeader
+{
+	uint32_t	format_ver;
+	int64_t		file_mtime;
+	int64_t		file_size;
+	uint32_t	pathlen;
+	uint32_t	len;
+	uint32_t	crc;
+};
 #pragma pack(pop)
 
 /**
@@ -55,6 +65,10 @@ struct PipelineCacheFileHeader
 
 	Raw data: $cachedir/shader_raw_[key].bin
 	Vulkan shader data: $cachedir/shader_pipeline_[key].bin
+	Parsed data files (Touchstone, IBIS, etc): $cachedir/parsed_[type]_[path crc].bin
+
+	Parsed data files are not loaded at startup. They are read on demand and validated against the path,
+	modification time, and size of the source file.
  */
 class PipelineCacheManager
 {
@@ -67,6 +81,14 @@ public:
 
 	std::shared_ptr<vk::raii::PipelineCache> Lookup(const std::string& key, time_t target);
 
+	std::shared_ptr< std::vector<uint8_t> > LookupParsedFile(
+		const std::string& path, const std::string& type, uint32_t formatVersion);
+	void StoreParsedFile(
+		const std::string& path,
+		const std::string& type,
+		uint32_t formatVersion,
+		std::shared_ptr< std::vector<uint8_t> > value);
+
 	void LoadFromDisk();
 	void SaveToDisk();
 	void Clear();
@@ -74,6 +96,9 @@ public:
 protected:
 	void FindPath();
 
+	bool GetSourceFileIdentity(const std::string& path, int64_t& mtime, int64_t& size);
+	std::string GetParsedFileCachePath(const std::string& path, const std::string& type);
+
 	///@brief Mutex to interlock access to the STL containers
 	std::mutex m_mutex;
 
@@ -39,13 +39,89 @@ RemoteBridgeOscilloscope::RemoteBridgeOscilloscope(SCPITransport* transport, boo
 	: SCPIDevice(transport, identify)
 	, SCPIOscilloscope()
 	, m_triggerArmed(false)
+	, m_streamingMode(false)
+	, m_streamTerminating(false)
+	, m_streamChunksReceived(0)
+	, m_streamChunksDropped(0)
+	, m_diag_streamChunksReceived(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS))
+	, m_diag_streamChunksDropped(FilterParameter::TYPE_INT, Unit(Unit::UNIT_COUNTS))
 {
-
+	m_diag_streamChunksReceived.SetIntVal(0);
+	m_diag_streamChunksDropped.SetIntVal(0);
 }
 
 RemoteBridgeOscilloscope::~RemoteBridgeOscilloscope()
 {
+	StopStreamThread();
+}
+
+/**
+	@brief Sets software inversion for a channel
+
+	The bridges have no hardware inversion, so drivers that support it apply the inversion during sample conversion
+ */
+void RemoteBridgeOscilloscope::Invert(size_t i, bool invert)
+{
+	lock_guard<recursive_mutex> lock(m_cacheMutex);
+	m_channelsInverted[i] = invert;
+}
+
+bool RemoteBridgeOscilloscope::IsInverted(size_t i)
+{
+	lock_guard<recursive_mutex> lock(m_cacheMutex);
+	return m_channelsInverted[i];
+}
+
+/**
+	@brief Sets software deskew for a channel
 
+	The bridges have no hardware deskew, so drivers apply it during sample conversion (see ApplyDeskew())
+ */
+void RemoteBridgeOscilloscope::SetDeskewForChannel(size_t channel, int64_t skew)
+{
+	lock_guard<recursive_mutex> lock(m_cacheMutex);
+	m_channelDeskew[channel] = skew;
+}
+
+int64_t RemoteBridgeOscilloscope::GetDeskewForChannel(size_t channel)
+{
+	lock_guard<recursive_mutex> lock(m_cacheMutex);
+	return m_channelDeskew[channel];
+}
+
+/**
+	@brief Applies a channel's deskew setting to a conversion job and the waveform it writes to
+
+	Moving a channel earlier drops whole samples from the start of the record via the job's sample shift, so the
+	channel stays on the same sample grid as the others, and only the sub-sample remainder goes in the trigger phase.
+	Moving a channel later would need samples from before the start of the record, so it only shifts the trigger
+	phase.
+
+	Must be called before the job is converted. The waveform is shortened by the number of samples skipped.
+ */
+void RemoteBridgeOscilloscope::ApplyDeskew(size_t chnum, SampleConversionJob& job, UniformAnalogWaveform* cap)
+{
+	int64_t skew = GetDeskewForChannel(chnum);
+	if( (skew >= 0) || (cap->m_timescale <= 0) )
+	{
+		cap->m_triggerPhase += skew;
+		return;
+	}
+
+	int64_t advance = -skew;
+	size_t nskip = advance / cap->m_timescale;
+	if(nskip >= job.m_count)
+	{
+		job.m_skew = job.m_count;
+		job.m_count = 0;
+		cap->Resize(0);
+		return;
+	}
+
+	job.m_skew = nskip;
+	job.m_count -= nskip;
+	cap->Resize(job.m_count);
+	cap->m_triggerPhase -= advance - (int64_t)nskip * cap->m_timescale;
 }
 
 void RemoteBridgeOscilloscope::Start()
@@ -55,6 +131,9 @@ void RemoteBridgeOscilloscope::Start()
 
 	m_triggerArmed = true;
 	m_triggerOneShot = false;
+
+	if(m_streamingMode)
+		StartStreamThread();
 }
 
 void RemoteBridgeOscilloscope::StartSingleTrigger()
@@ -64,14 +143,22 @@ void RemoteBridgeOscilloscope::StartSingleTrigger()
 
 	m_triggerArmed = true;
 	m_triggerOneShot = true;
+
+	if(m_streamingMode)
+		StartStreamThread();
 }
 
 void RemoteBridgeOscilloscope::Stop()
 {
-	lock_guard<recursive_mutex> lock(m_mutex);
-	m_transport->SendCommand("STOP");
+	{
+		lock_guard<recursive_mutex> lock(m_mutex);
+		m_transport->SendCommand("STOP");
+
+		m_triggerArmed = false;
+	}
 
-	m_triggerArmed = false;
+	//No more acquisitions are coming, so shut down the streaming thread (if any)
+	StopStreamThread();
 }
 
 void RemoteBridgeOscilloscope::ForceTrigger()
@@ -80,6 +167,9 @@ void RemoteBridgeOscilloscope::ForceTrigger()
 	m_transport->SendCommand("FORCE");
 	m_triggerArmed = true;
 	m_triggerOneShot = true;
+
+	if(m_streamingMode)
+		StartStreamThread();
 }
 
 void RemoteBridgeOscilloscope::PullTrigger()
@@ -306,3 +396,305 @@ void RemoteBridgeOscilloscope::SetChannelOffset(size_t i, size_t /*stream*/, flo
 	snprintf(buf, sizeof(buf), ":%s:OFFS %f", m_channels[i]->GetHwname().c_str(), -offset / GetChannelAttenuation(i));
 	m_transport->SendCommand(buf);
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// RemoteBridgeChunk
+
+RemoteBridgeChunk::RemoteBridgeChunk()
+	: m_fsPerSample(0)
+	, m_startTimestamp(0)
+	, m_startFemtoseconds(0)
+{
+}
+
+/**
+	@brief Removes all blocks from the chunk, but keeps the sample buffer allocated for reuse
+ */
+void RemoteBridgeChunk::Clear()
+{
+	m_blocks.clear();
+	m_data.clear();
+}
+
+/**
+	@brief Adds a new block to the chunk and returns a pointer to space for its samples
+
+	The returned pointer is only valid until the next call to AppendBlock(), since the sample buffer may be moved.
+	Each block starts on a 32-byte boundary so the vectorized sample conversion sees aligned input.
+ */
+uint8_t* RemoteBridgeChunk::AppendBlock(size_t chnum, size_t depth, size_t bytesPerSample)
+{
+	Block block;
+	block.m_chnum = chnum;
+	block.m_depth = depth;
+	block.m_start = (m_data.size() + 31) & ~31;
+	block.m_scale = 1;
+	block.m_offset = 0;
+	block.m_trigphase = 0;
+	block.m_firstSample = 0;
+	block.m_clipping = false;
+	m_blocks.push_back(block);
+
+	m_data.resize(block.m_start + depth*bytesPerSample);
+	return m_data.GetCpuPointer() + block.m_start;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Acquisition
+
+/**
+	@brief Reads and converts one acquisition from the bridge
+
+	In streaming mode the socket is drained by a background thread, so this only converts the oldest pending chunk.
+ */
+bool RemoteBridgeOscilloscope::AcquireData()
+{
+	if(!m_streamingMode)
+	{
+		if(!ReadChunk(m_blockChunk))
+			return false;
+		return ProcessChunk(m_blockChunk);
+	}
+
+	//Wait for the producer to hand us a chunk, but don't block forever so the caller can shut down cleanly
+	RemoteBridgeChunk* chunk = nullptr;
+	{
+		unique_lock<mutex> lock(m_streamMutex);
+		if(!m_streamReadyCvar.wait_for(
+			lock, chrono::milliseconds(100), [&]{ return !m_streamReadyChunks.empty(); }))
+		{
+			return false;
+		}
+
+		chunk = m_streamReadyChunks.front();
+		m_streamReadyChunks.pop_front();
+	}
+
+	bool ok = ProcessChunk(*chunk);
+
+	//Hand the buffer back to the producer
+	{
+		lock_guard<mutex> lock(m_streamMutex);
+		m_streamFreeChunks.push_back(chunk);
+	}
+
+	m_diag_streamChunksReceived.SetIntVal(m_streamChunksReceived);
+	m_diag_streamChunksDropped.SetIntVal(m_streamChunksDropped);
+
+	return ok;
+}
+
+/**
+	@brief Reads one acquisition's worth of headers and sample data from the bridge into a chunk
+
+	Called from the streaming thread in streaming mode, so implementations must not touch any state shared with
+	ProcessChunk() other than the chunk itself.
+ */
+bool RemoteBridgeOscilloscope::ReadChunk(RemoteBridgeChunk& /*chunk*/)
+{
+	LogError("RemoteBridgeOscilloscope::ReadChunk not implemented for this driver\n");
+	return false;
+}
+
+/**
+	@brief Waits for the bridge to start sending a chunk
+
+	In streaming mode, ReadChunk() implementations call this before reading the chunk header so that the streaming
+	thread can be shut down while it's idle, rather than blocking in ReadRawData() until the next acquisition that
+	may never come. Once a chunk has started arriving it's read to completion.
+
+	@return False if the streaming thread is being shut down
+ */
+bool RemoteBridgeOscilloscope::WaitForChunkData()
+{
+	if(!m_streamingMode)
+		return true;
+
+	while(!m_streamTerminating)
+	{
+		if(m_transport->WaitForRawData(50))
+			return true;
+	}
+	return false;
+}
+
+/**
+	@brief Converts a chunk into waveforms and adds them to the pending waveform queue
+ */
+bool RemoteBridgeOscilloscope::ProcessChunk(RemoteBridgeChunk& /*chunk*/)
+{
+	LogError("RemoteBridgeOscilloscope::ProcessChunk not implemented for this driver\n");
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Streaming acquisition
+
+/**
+	@brief Returns true if the driver can read acquisitions on a background thread
+ */
+bool RemoteBridgeOscilloscope::IsStreamingModeSupported()
+{
+	return false;
+}
+
+/**
+	@brief Enables or disables streaming acquisition
+
+	In streaming mode a background thread reads acquisitions from the bridge into a ring of preallocated buffers as
+	fast as they arrive, and AcquireData() only performs the conversion. If conversion falls behind, the oldest
+	unconverted chunk is discarded and counted in GetStreamingChunksDropped() rather than stalling the bridge.
+
+	Should only be called while the trigger is stopped.
+ */
+void RemoteBridgeOscilloscope::SetStreamingMode(bool enable)
+{
+	if(enable == m_streamingMode)
+		return;
+
+	if(enable)
+	{
+		if(!IsStreamingModeSupported())
+		{
+			LogError("Streaming mode is not supported by this driver\n");
+			return;
+		}
+
+		if(m_streamChunks.empty())
+			SetStreamingBufferCount(4);
+
+		m_diagnosticValues["Streamed Chunks Received"] = &m_diag_streamChunksReceived;
+		m_diagnosticValues["Streamed Chunks Dropped"] = &m_diag_streamChunksDropped;
+
+		m_streamChunksReceived = 0;
+		m_streamChunksDropped = 0;
+		m_streamingMode = true;
+
+		if(m_triggerArmed)
+			StartStreamThread();
+	}
+
+	else
+	{
+		StopStreamThread();
+		m_streamingMode = false;
+	}
+}
+
+/**
+	@brief Sets the number of chunks in the streaming ring buffer
+
+	Must be at least two (one being filled and one being converted). Cannot be changed while streaming.
+ */
+void RemoteBridgeOscilloscope::SetStreamingBufferCount(size_t count)
+{
+	if(m_streamThread)
+	{
+		LogError("Cannot change streaming buffer count while streaming\n");
+		return;
+	}
+
+	count = max(count, (size_t)2);
+
+	lock_guard<mutex> lock(m_streamMutex);
+	m_streamFreeChunks.clear();
+	m_streamReadyChunks.clear();
+	m_streamChunks.resize(count);
+	for(auto& c : m_streamChunks)
+	{
+		if(!c)
+			c = make_unique<RemoteBridgeChunk>();
+		m_streamFreeChunks.push_back(c.get());
+	}
+}
+
+/**
+	@brief Starts the streaming thread, if it isn't already running
+ */
+void RemoteBridgeOscilloscope::StartStreamThread()
+{
+	if(m_streamThread)
+		return;
+
+	m_streamTerminating = false;
+	m_streamThread = make_unique<thread>(&RemoteBridgeOscilloscope::StreamThreadProc, this);
+}
+
+/**
+	@brief Stops the streaming thread and discards any unconverted chunks
+
+	Blocks until a chunk being read completes, but not while waiting for the next one (see WaitForChunkData()).
+	Derived classes must call this from their destructor, since the thread calls their ReadChunk() implementation.
+ */
+void RemoteBridgeOscilloscope::StopStreamThread()
+{
+	if(!m_streamThread)
+		return;
+
+	m_streamTerminating = true;
+	m_streamThread->join();
+	m_streamThread = nullptr;
+
+	lock_guard<mutex> lock(m_streamMutex);
+	for(auto c : m_streamReadyChunks)
+		m_streamFreeChunks.push_back(c);
+	m_streamReadyChunks.clear();
+}
+
+void RemoteBridgeOscilloscope::StreamThreadProc(RemoteBridgeOscilloscope* pThis)
+{
+	#ifdef __linux__
+	pthread_setname_np(pthread_self(), "BridgeStream");
+	#endif
+
+	pThis->DoStreamThread();
+}
+
+void RemoteBridgeOscilloscope::DoStreamThread()
+{
+	while(!m_streamTerminating)
+	{
+		//Grab a free buffer. If the consumer has fallen behind, recycle the oldest unconverted chunk
+		//rather than stalling the socket.
+		RemoteBridgeChunk* chunk = nullptr;
+		{
+			lock_guard<mutex> lock(m_streamMutex);
+			if(!m_streamFreeChunks.empty())
+			{
+				chunk = m_streamFreeChunks.front();
+				m_streamFreeChunks.pop_front();
+			}
+			else if(!m_streamReadyChunks.empty())
+			{
+				chunk = m_streamReadyChunks.front();
+				m_streamReadyChunks.pop_front();
+				m_streamChunksDropped ++;
+			}
+		}
+
+		//Every buffer is checked out by the consumer, wait for one to come back
+		if(!chunk)
+		{
+			this_thread::sleep_for(chrono::milliseconds(1));
+			continue;
+		}
+
+		if(!ReadChunk(*chunk))
+		{
+			lock_guard<mutex> lock(m_streamMutex);
+			m_streamFreeChunks.push_back(chunk);
+
+			if(!m_streamTerminating)
+				LogError("Failed to read chunk from bridge, streaming stopped\n");
+			break;
+		}
+
+		//Hand it off to the consumer
+		{
+			lock_guard<mutex> lock(m_streamMutex);
+			m_streamReadyChunks.push_back(chunk);
+		}
+		m_streamChunksReceived ++;
+		m_streamReadyCvar.notify_one();
+	}
+}
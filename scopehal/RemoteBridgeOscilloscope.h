@@ -32,6 +32,68 @@
 
 #include "EdgeTrigger.h"
 
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+
+/**
+	@brief Raw sample data for one acquisition read from a bridge server, before conversion to waveforms
+
+	All channels share a single sample buffer so a chunk can be recycled without any further allocations once it has
+	grown to the size of a typical acquisition.
+ */
+class RemoteBridgeChunk
+{
+public:
+	RemoteBridgeChunk();
+
+	//not copyable or assignable
+	RemoteBridgeChunk(const RemoteBridgeChunk& rhs) =delete;
+	RemoteBridgeChunk& operator=(const RemoteBridgeChunk& rhs) =delete;
+
+	///@brief Descriptor for one channel's samples within the chunk
+	struct Block
+	{
+		///@brief Hardware channel index as reported by the bridge
+		size_t m_chnum;
+
+		///@brief Number of samples (not bytes)
+		size_t m_depth;
+
+		///@brief Byte offset of the first sample within m_data
+		size_t m_start;
+
+		float m_scale;
+		float m_offset;
+		float m_trigphase;
+		int64_t m_firstSample;
+		bool m_clipping;
+	};
+
+	void Clear();
+	uint8_t* AppendBlock(size_t chnum, size_t depth, size_t bytesPerSample);
+
+	/**
+		@brief Gets a pointer to the samples for a given block
+	 */
+	template<class T>
+	T* GetSamples(const Block& block)
+	{ return reinterpret_cast<T*>(m_data.GetCpuPointer() + block.m_start); }
+
+	///@brief Sample interval, in femtoseconds
+	int64_t m_fsPerSample;
+
+	///@brief Time the chunk was received
+	time_t m_startTimestamp;
+	int64_t m_startFemtoseconds;
+
+	///@brief Per-channel descriptors, in the order the bridge sent them
+	std::vector<Block> m_blocks;
+
+	///@brief Sample data for all channels, back to back
+	AcceleratorBuffer<uint8_t> m_data;
+};
+
 /**
 	@brief An oscilloscope connected over a SDK-to-SCPI bridge that follows our pattern
 	       (i.e. uses scpi-server-tools)
@@ -56,6 +118,12 @@ public:
 	virtual float GetChannelOffset(size_t i, size_t stream);
 	virtual void SetChannelOffset(size_t i, size_t stream, float offset);
 
+	virtual void Invert(size_t i, bool invert);
+	virtual bool IsInverted(size_t i);
+
+	virtual void SetDeskewForChannel(size_t channel, int64_t skew);
+	virtual int64_t GetDeskewForChannel(size_t channel);
+
 	// Triggering
 	virtual void Start();
 	virtual void StartSingleTrigger();
@@ -74,7 +142,39 @@ public:
 	virtual void SetSampleDepth(uint64_t depth);
 	virtual void SetSampleRate(uint64_t rate);
 
+	virtual bool AcquireData();
+
+	// Streaming acquisition
+	virtual bool IsStreamingModeSupported();
+	void SetStreamingMode(bool enable);
+	bool IsStreamingMode()
+	{ return m_streamingMode; }
+
+	void SetStreamingBufferCount(size_t count);
+	size_t GetStreamingBufferCount()
+	{ return m_streamChunks.size(); }
+
+	///@brief Number of chunks read from the bridge since streaming mode was enabled
+	uint64_t GetStreamingChunksReceived()
+	{ return m_streamChunksReceived; }
+
+	///@brief Number of chunks discarded because the consumer could not keep up
+	uint64_t GetStreamingChunksDropped()
+	{ return m_streamChunksDropped; }
+
 protected:
+	virtual bool ReadChunk(RemoteBridgeChunk& chunk);
+	virtual bool ProcessChunk(RemoteBridgeChunk& chunk);
+	bool WaitForChunkData();
+
+	void ApplyDeskew(size_t chnum, SampleConversionJob& job, UniformAnalogWaveform* cap);
+
+	void StartStreamThread();
+	void StopStreamThread();
+	static void StreamThreadProc(RemoteBridgeOscilloscope* pThis);
+	void DoStreamThread();
+
+
 	bool m_triggerArmed;
 	bool m_triggerOneShot;
 	int64_t m_triggerOffset;
@@ -90,7 +190,46 @@ protected:
 	std::map<size_t, float> m_channelOffsets;
 	std::map<size_t, float> m_channelVoltageRanges;
 
+	///@brief Channels inverted in software during sample conversion (for drivers that return true from CanInvert)
+	std::map<size_t, bool> m_channelsInverted;
+
+	///@brief Per-channel deskew in femtoseconds, applied in software during sample conversion
+	std::map<size_t, int64_t> m_channelDeskew;
+
 	void PushEdgeTrigger(EdgeTrigger* trig);
+
+	///@brief Chunk used for conventional (non-streaming) acquisitions
+	RemoteBridgeChunk m_blockChunk;
+
+	///@brief True if acquisitions are read by a background thread into m_streamChunks
+	bool m_streamingMode;
+
+	///@brief Ring of preallocated chunks used in streaming mode
+	std::vector<std::unique_ptr<RemoteBridgeChunk> > m_streamChunks;
+
+	///@brief Chunks available for the producer thread to fill
+	std::deque<RemoteBridgeChunk*> m_streamFreeChunks;
+
+	///@brief Chunks filled by the producer thread and waiting to be converted, oldest first
+	std::deque<RemoteBridgeChunk*> m_streamReadyChunks;
+
+	///@brief Mutex for access to the streaming queues
+	std::mutex m_streamMutex;
+
+	///@brief Condition variable for waking up the consumer when a chunk is ready
+	std::condition_variable m_streamReadyCvar;
+
+	///@brief Thread reading chunks from the bridge in streaming mode
+	std::unique_ptr<std::thread> m_streamThread;
+
+	///@brief Shutdown flag for m_streamThread
+	std::atomic<bool> m_streamTerminating;
+
+	std::atomic<uint64_t> m_streamChunksReceived;
+	std::atomic<uint64_t> m_streamChunksDropped;
+
+	FilterParameter m_diag_streamChunksReceived;
+	FilterParameter m_diag_streamChunksDropped;
 };
 
 #endif
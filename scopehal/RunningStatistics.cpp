@@ -0,0 +1,212 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of RunningStatistics
+ */
+
+#include "scopehal.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+RunningStatistics::RunningStatistics()
+{
+	Clear();
+}
+
+void RunningStatistics::Clear()
+{
+	m_lastWaveform = WaveformCacheKey();
+	m_lastHadHistogram = false;
+
+	m_count = 0;
+	m_mean = 0;
+	m_m2 = 0;
+	m_min = FLT_MAX;
+	m_max = -FLT_MAX;
+
+	m_histogram.clear();
+	m_histogramCount = 0;
+	m_histogramMin = 0;
+	m_histogramBinWidth = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Integration
+
+/**
+	@brief Adds a new waveform to the statistics
+
+	Does nothing if the waveform (at its current revision) was already integrated.
+
+	@param w			Analog waveform (sparse or uniform)
+	@param histogram	True if the waveform should be added to the percentile histogram too
+
+	@return False if the waveform isn't analog
+ */
+bool RunningStatistics::Integrate(WaveformBase* w, bool histogram)
+{
+	if(!dynamic_cast<UniformAnalogWaveform*>(w) && !dynamic_cast<SparseAnalogWaveform*>(w))
+		return false;
+
+	bool alreadyIntegrated = (m_lastWaveform == w);
+	if(alreadyIntegrated && (!histogram || m_lastHadHistogram) )
+		return true;
+
+	w->PrepareForCpuAccess();
+	auto summary = Filter::GetWaveformSummary(w, histogram);
+	if(summary->m_count == 0)
+		return true;
+
+	if(!alreadyIntegrated)
+	{
+		m_lastWaveform = WaveformCacheKey(w);
+		m_lastHadHistogram = false;
+
+		//Merge mean and deviations (Chan et al.)
+		double n = summary->m_count;
+		double mean = summary->m_sum / n;
+		if(m_count == 0)
+		{
+			m_mean = mean;
+			m_m2 = summary->m_m2;
+		}
+		else
+		{
+			double total = m_count + n;
+			double delta = mean - m_mean;
+			m_mean += delta * n / total;
+			m_m2 += summary->m_m2 + delta*delta * m_count * n / total;
+		}
+		m_count += summary->m_count;
+
+		m_min = min(m_min, summary->m_min);
+		m_max = max(m_max, summary->m_max);
+	}
+
+	if(histogram)
+	{
+		m_lastHadHistogram = true;
+		ExtendHistogram(summary->m_min, summary->m_max);
+
+		//Re-bin the waveform's fine histogram into ours
+		double finewidth = (summary->m_max - summary->m_min) * 1.0 / WaveformSummary::HISTOGRAM_BINS;
+		for(size_t i=0; i<WaveformSummary::HISTOGRAM_BINS; i++)
+		{
+			size_t count = summary->m_histogram[i];
+			if(count == 0)
+				continue;
+
+			double center = summary->m_min + (i + 0.5) * finewidth;
+			int64_t bin = floor( (center - m_histogramMin) / m_histogramBinWidth );
+			bin = max(bin, (int64_t)0);
+			bin = min(bin, (int64_t)HISTOGRAM_BINS - 1);
+			m_histogram[bin] += count;
+			m_histogramCount += count;
+		}
+	}
+
+	return true;
+}
+
+/**
+	@brief Makes sure the histogram covers [vmin, vmax], doubling its bin width as many times as needed
+ */
+void RunningStatistics::ExtendHistogram(float vmin, float vmax)
+{
+	//First waveform sets the initial range
+	if(m_histogram.empty())
+	{
+		m_histogram.resize(HISTOGRAM_BINS, 0);
+		m_histogramMin = vmin;
+		m_histogramBinWidth = (vmax - vmin) * 1.0 / HISTOGRAM_BINS;
+
+		//Flat waveforms still need a nonzero range
+		if(m_histogramBinWidth <= 0)
+			m_histogramBinWidth = max(fabs(vmin) * 1e-6, 1e-12);
+		return;
+	}
+
+	while(true)
+	{
+		double hmax = m_histogramMin + m_histogramBinWidth * HISTOGRAM_BINS;
+
+		bool grow_down = (vmin < m_histogramMin);
+		bool grow_up = (vmax > hmax);
+		if(!grow_down && !grow_up)
+			break;
+
+		//Merge pairs of bins into the upper or lower half, then double the bin width
+		size_t half = HISTOGRAM_BINS / 2;
+		vector<uint64_t> merged(HISTOGRAM_BINS, 0);
+		size_t base = grow_down ? half : 0;
+		for(size_t i=0; i<HISTOGRAM_BINS; i++)
+			merged[base + i/2] += m_histogram[i];
+		m_histogram.swap(merged);
+
+		if(grow_down)
+			m_histogramMin -= m_histogramBinWidth * HISTOGRAM_BINS;
+		m_histogramBinWidth *= 2;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+/**
+	@brief Estimates a percentile from the histogram, interpolating linearly within a bin
+
+	@param percent	Percentile to look up, from 0 to 100
+ */
+double RunningStatistics::GetPercentile(double percent) const
+{
+	if(m_histogramCount == 0)
+		return 0;
+
+	double target = m_histogramCount * min(max(percent, 0.0), 100.0) / 100;
+	uint64_t cumulative = 0;
+	for(size_t i=0; i<HISTOGRAM_BINS; i++)
+	{
+		uint64_t next = cumulative + m_histogram[i];
+		if( (next >= target) && (m_histogram[i] != 0) )
+		{
+			double frac = (target - cumulative) / m_histogram[i];
+			return m_histogramMin + (i + frac) * m_histogramBinWidth;
+		}
+		cumulative = next;
+	}
+
+	return m_histogramMin + m_histogramBinWidth * HISTOGRAM_BINS;
+}
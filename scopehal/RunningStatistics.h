@@ -0,0 +1,118 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of RunningStatistics
+ */
+
+#ifndef RunningStatistics_h
+#define RunningStatistics_h
+
+/**
+	@brief Statistics for one stream, integrated over every waveform since the last Clear()
+
+	One instance is shared by every Statistic attached to a given stream (see Statistic::GetRunningStatistics()), so
+	each new waveform is only integrated once no matter how many statistics are displayed for it. The per-waveform
+	pass is Filter::GetWaveformSummary(), which is vectorized, multithreaded and itself shared with measurements.
+
+	Mean and variance are merged across waveforms with the parallel form of Welford's algorithm, so precision holds
+	up after billions of samples. Percentiles come from a fixed-size histogram whose range doubles as needed.
+
+	Statistics are calculated from the UI thread only, so there is no locking.
+ */
+class RunningStatistics
+{
+public:
+	RunningStatistics();
+
+	void Clear();
+	bool Integrate(WaveformBase* w, bool histogram);
+
+	///@brief Total number of samples integrated
+	uint64_t GetCount() const
+	{ return m_count; }
+
+	///@brief Arithmetic mean of all samples
+	double GetMean() const
+	{ return m_mean; }
+
+	///@brief Population variance of all samples
+	double GetVariance() const
+	{ return m_count ? (m_m2 / m_count) : 0; }
+
+	double GetStdDev() const
+	{ return sqrt(GetVariance()); }
+
+	float GetMinimum() const
+	{ return m_min; }
+
+	float GetMaximum() const
+	{ return m_max; }
+
+	double GetPercentile(double percent) const;
+
+	///@brief Hit counts for each bin of the percentile histogram (empty if no histogram was integrated)
+	const std::vector<uint64_t>& GetHistogram() const
+	{ return m_histogram; }
+
+	///@brief Lower edge of the first histogram bin
+	double GetHistogramMin() const
+	{ return m_histogramMin; }
+
+	double GetHistogramBinWidth() const
+	{ return m_histogramBinWidth; }
+
+	///@brief Number of bins in the percentile histogram
+	static const size_t HISTOGRAM_BINS = 4096;
+
+protected:
+	void ExtendHistogram(float vmin, float vmax);
+
+	///@brief The last waveform integrated, so statistics sharing this object don't integrate it twice
+	WaveformCacheKey m_lastWaveform;
+
+	///@brief True if the last waveform was added to the histogram too
+	bool m_lastHadHistogram;
+
+	uint64_t m_count;
+	double m_mean;
+	double m_m2;
+	float m_min;
+	float m_max;
+
+	std::vector<uint64_t> m_histogram;
+	uint64_t m_histogramCount;
+	double m_histogramMin;
+	double m_histogramBinWidth;
+};
+
+#endif
@@ -35,6 +35,10 @@
 
 #include "scopehal.h"
 
+#ifndef _WIN32
+#include <poll.h>
+#endif
+
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -167,6 +171,33 @@ size_t SCPISocketTransport::ReadRawData(size_t len, unsigned char* buf)
 	return len;
 }
 
+bool SCPISocketTransport::WaitForRawData(unsigned int timeout_ms)
+{
+	return WaitForSocketData(m_socket, timeout_ms);
+}
+
+/**
+	@brief Waits up to timeout_ms for a socket to become readable
+
+	@return True if data (or a disconnect, which the next read will report) is pending
+ */
+bool SCPISocketTransport::WaitForSocketData(Socket& sock, unsigned int timeout_ms)
+{
+#ifdef _WIN32
+	WSAPOLLFD pfd;
+	pfd.fd = sock;
+	pfd.events = POLLRDNORM;
+	pfd.revents = 0;
+	return WSAPoll(&pfd, 1, timeout_ms) > 0;
+#else
+	pollfd pfd;
+	pfd.fd = sock;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return poll(&pfd, 1, timeout_ms) > 0;
+#endif
+}
+
 bool SCPISocketTransport::IsCommandBatchingSupported()
 {
 	return true;
@@ -56,6 +56,7 @@ public:
 	virtual std::string ReadReply(bool endOnSemicolon = true);
 	virtual size_t ReadRawData(size_t len, unsigned char* buf);
 	virtual void SendRawData(size_t len, const unsigned char* buf);
+	virtual bool WaitForRawData(unsigned int timeout_ms);
 
 	virtual bool IsCommandBatchingSupported();
 	virtual bool IsConnected();
@@ -72,6 +73,8 @@ protected:
 
 	void SharedCtorInit();
 
+	static bool WaitForSocketData(Socket& sock, unsigned int timeout_ms);
+
 	Socket m_socket;
 
 	std::string m_hostname;
@@ -271,6 +271,21 @@ void* SCPITransport::SendCommandImmediateWithRawBlockReply(string cmd, size_t& l
 	return buf;
 }
 
+/**
+	@brief Waits for data to arrive on the raw data stream
+
+	Lets a caller which is about to block in ReadRawData() check periodically whether it should give up instead.
+	The default implementation can't tell, so it returns immediately and the caller's read blocks as usual.
+
+	@param timeout_ms	Maximum time to wait, in milliseconds
+
+	@return True if data is (or may be) available, false if the timeout expired
+ */
+bool SCPITransport::WaitForRawData(unsigned int /*timeout_ms*/)
+{
+	return true;
+}
+
 void SCPITransport::FlushRXBuffer(void)
 {
 	LogError("SCPITransport::FlushRXBuffer is unimplemented");
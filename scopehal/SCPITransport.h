@@ -77,6 +77,7 @@ public:
 	virtual std::string ReadReply(bool endOnSemicolon = true) =0;
 	virtual size_t ReadRawData(size_t len, unsigned char* buf) =0;
 	virtual void SendRawData(size_t len, const unsigned char* buf) =0;
+	virtual bool WaitForRawData(unsigned int timeout_ms);
 
 	virtual bool IsCommandBatchingSupported() =0;
 	virtual bool IsConnected() =0;
@@ -84,6 +84,11 @@ size_t SCPITwinLanTransport::ReadRawData(size_t len, unsigned char* buf)
 		return 0;
 }
 
+bool SCPITwinLanTransport::WaitForRawData(unsigned int timeout_ms)
+{
+	return WaitForSocketData(m_secondarysocket, timeout_ms);
+}
+
 void SCPITwinLanTransport::SendRawData(size_t len, const unsigned char* buf)
 {
 	m_secondarysocket.SendLooped(buf, len);
@@ -55,6 +55,7 @@ public:
 
 	virtual size_t ReadRawData(size_t len, unsigned char* buf);
 	virtual void SendRawData(size_t len, const unsigned char* buf);
+	virtual bool WaitForRawData(unsigned int timeout_ms);
 
 	TRANSPORT_INITPROC(SCPITwinLanTransport)
 
@@ -44,6 +44,9 @@ SParameterFilter::SParameterFilter(const string& color, Category cat)
 
 SParameterFilter::~SParameterFilter()
 {
+	for(auto v : m_inputVectors)
+		delete v;
+	m_inputVectors.clear();
 }
 
 
@@ -109,3 +112,33 @@ void SParameterFilter::RefreshPorts()
 
 	m_inputsChangedSignal.emit();
 }
+
+/**
+	@brief Makes sure m_inputVectors reflects the current contents of our inputs
+
+	Inputs are assumed to be mag/angle pairs in order. Vectors whose inputs have not changed since the last call are
+	left untouched, so any resampled copies of them stay valid.
+
+	@param npairs	Number of mag/angle input pairs to load
+ */
+void SParameterFilter::LoadInputVectors(size_t npairs)
+{
+	while(m_inputVectors.size() < npairs)
+		m_inputVectors.push_back(new SParameterVector);
+	m_inputVectorKeys.resize(npairs*2);
+
+	for(size_t i=0; i<npairs; i++)
+	{
+		auto wmag = GetInputWaveform(i*2);
+		auto wang = GetInputWaveform(i*2 + 1);
+		if( (m_inputVectorKeys[i*2] == wmag) && (m_inputVectorKeys[i*2 + 1] == wang) )
+			continue;
+
+		wmag->PrepareForCpuAccess();
+		wang->PrepareForCpuAccess();
+		m_inputVectors[i]->LoadFromWaveforms(wmag, wang);
+
+		m_inputVectorKeys[i*2] = wmag;
+		m_inputVectorKeys[i*2 + 1] = wang;
+	}
+}
@@ -48,8 +48,15 @@ public:
 
 protected:
 	virtual void RefreshPorts();
+	void LoadInputVectors(size_t npairs);
 
 	std::string m_portCountName;
+
+	///@brief Input S-parameters, one vector per mag/angle input pair (only reloaded when the input changes)
+	std::vector<SParameterVector*> m_inputVectors;
+
+	///@brief Identity of the waveforms each of our input vectors was loaded from
+	std::vector<WaveformCacheKey> m_inputVectorKeys;
 };
 
 #endif
@@ -34,12 +34,17 @@
  */
 #include "scopehal.h"
 #include <math.h>
+#ifdef __x86_64__
+#include "avx_mathfun.h"
+#endif
 
 using namespace std;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // SParameterVector
 
+atomic<uint64_t> SParameterVector::m_nextSerial(0);
+
 /**
 	@brief Copy our state to analog mag/angle waveforms
  */
@@ -200,6 +205,198 @@ float SParameterVector::InterpolateAngle(float frequency) const
 	return InterpolatePoint(frequency).m_phase;
 }
 
+/**
+	@brief Resamples this vector to the frequency points of another vector
+
+	Equivalent to calling InterpolatePoint() on every point of the grid, but uses a single monotonic walk over both
+	vectors rather than a binary search per point, and outputs rectangular form directly.
+
+	If neither this vector nor the grid has been modified since the last call with the same output object,
+	the previous results are reused.
+
+	@param grid		Vector whose frequency points we want to sample at (must be sorted by ascending frequency)
+	@param out		Output vector
+ */
+void SParameterVector::Resample(const SParameterVector& grid, SParameterResampledVector& out) const
+{
+	if( (out.m_srcSerial == m_serial) && (out.m_gridSerial == grid.m_serial) )
+		return;
+
+	DoResample([&](size_t i) { return grid.m_points[i].m_frequency; }, grid.size(), out);
+
+	out.m_srcSerial = m_serial;
+	out.m_gridSerial = grid.m_serial;
+}
+
+/**
+	@brief Resamples this vector to a uniformly spaced grid of frequencies (typically FFT bins)
+
+	If this vector has not been modified since the last call with the same grid and output object,
+	the previous results are reused.
+
+	@param start	Frequency of the first output point, in Hz
+	@param step		Spacing between output points, in Hz
+	@param npoints	Number of output points
+	@param out		Output vector
+ */
+void SParameterVector::ResampleUniform(float start, float step, size_t npoints, SParameterResampledVector& out) const
+{
+	if( (out.m_srcSerial == m_serial) &&
+		(out.m_gridSerial == 0) &&
+		(out.m_gridStart == start) &&
+		(out.m_gridStep == step) &&
+		(out.size() == npoints) )
+	{
+		return;
+	}
+
+	DoResample([&](size_t i) { return start + step*i; }, npoints, out);
+
+	out.m_srcSerial = m_serial;
+	out.m_gridSerial = 0;
+	out.m_gridStart = start;
+	out.m_gridStep = step;
+}
+
+/**
+	@brief Does the actual resampling for Resample() and ResampleUniform()
+
+	Output frequencies must be monotonically increasing. Out-of-range behavior matches InterpolatePoint().
+
+	@param freqAt	Functor returning the frequency of the i'th output point
+	@param npoints	Number of output points
+	@param out		Output vector
+ */
+template<class F>
+void SParameterVector::DoResample(F freqAt, size_t npoints, SParameterResampledVector& out) const
+{
+	out.m_real.resize(npoints);
+	out.m_imag.resize(npoints);
+	out.m_real.PrepareForCpuAccess();
+	out.m_imag.PrepareForCpuAccess();
+
+	//Empty input? Output is all zeroes
+	size_t len = m_points.size();
+	if(len == 0)
+	{
+		for(size_t i=0; i<npoints; i++)
+		{
+			out.m_real[i] = 0;
+			out.m_imag[i] = 0;
+		}
+		out.m_real.MarkModifiedFromCpu();
+		out.m_imag.MarkModifiedFromCpu();
+		return;
+	}
+
+	//First pass: merge walk to interpolate magnitude and phase.
+	//Stash magnitude in the real array and angle in the imaginary array, then convert in place.
+	float* mag = out.m_real.GetCpuPointer();
+	float* ang = out.m_imag.GetCpuPointer();
+	auto& first = m_points[0];
+	auto& last = m_points[len-1];
+	size_t lo = 0;
+	for(size_t i=0; i<npoints; i++)
+	{
+		float freq = freqAt(i);
+
+		//Below the lowest point: use insertion loss of the lowest point, but interpolate phase to zero at DC
+		if(freq < first.m_frequency)
+		{
+			mag[i] = first.m_amplitude;
+			ang[i] = InterpolatePhase(0, first.m_phase, freq / first.m_frequency);
+			continue;
+		}
+
+		//Above the highest point: zero
+		else if(freq > last.m_frequency)
+		{
+			mag[i] = 0;
+			ang[i] = 0;
+			continue;
+		}
+
+		//Move forward until the next point is above us
+		while( (lo+2 < len) && (m_points[lo+1].m_frequency <= freq) )
+			lo ++;
+		size_t hi = min(lo+1, len-1);
+
+		auto& plo = m_points[lo];
+		auto& phi = m_points[hi];
+		float dfreq = phi.m_frequency - plo.m_frequency;
+		float frac;
+		if(dfreq > FLT_EPSILON)
+			frac = (freq - plo.m_frequency) / dfreq;
+		else
+			frac = 0;
+
+		mag[i] = plo.m_amplitude + (phi.m_amplitude - plo.m_amplitude)*frac;
+		ang[i] = InterpolatePhase(plo.m_phase, phi.m_phase, frac);
+	}
+
+	//Second pass: convert to rectangular
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		PolarToRectangularAVX2(out);
+	else
+	#endif
+		PolarToRectangular(out);
+
+	out.m_real.MarkModifiedFromCpu();
+	out.m_imag.MarkModifiedFromCpu();
+}
+
+/**
+	@brief Converts resampled data from (magnitude, angle) to (real, imaginary) in place
+ */
+void SParameterVector::PolarToRectangular(SParameterResampledVector& out) const
+{
+	size_t len = out.size();
+	float* re = out.m_real.GetCpuPointer();
+	float* im = out.m_imag.GetCpuPointer();
+	for(size_t i=0; i<len; i++)
+	{
+		float mag = re[i];
+		float ang = im[i];
+		re[i] = mag * cos(ang);
+		im[i] = mag * sin(ang);
+	}
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+void SParameterVector::PolarToRectangularAVX2(SParameterResampledVector& out) const
+{
+	size_t len = out.size();
+	size_t end = len - (len % 8);
+	float* re = out.m_real.GetCpuPointer();
+	float* im = out.m_imag.GetCpuPointer();
+
+	//Vectorized loop doing 8 elements at once
+	for(size_t i=0; i<end; i += 8)
+	{
+		__m256 mag = _mm256_loadu_ps(re + i);
+		__m256 ang = _mm256_loadu_ps(im + i);
+
+		__m256 sinval;
+		__m256 cosval;
+		_mm256_sincos_ps(ang, &sinval, &cosval);
+
+		_mm256_storeu_ps(re + i, _mm256_mul_ps(mag, cosval));
+		_mm256_storeu_ps(im + i, _mm256_mul_ps(mag, sinval));
+	}
+
+	//Catch any stragglers
+	for(size_t i=end; i<len; i++)
+	{
+		float mag = re[i];
+		float ang = im[i];
+		re[i] = mag * cos(ang);
+		im[i] = mag * sin(ang);
+	}
+}
+#endif
+
 /**
 	@brief Gets the group delay at a given bin
  */
@@ -252,6 +449,57 @@ void SParameters::Allocate(int nports)
 	m_nports = nports;
 }
 
+/**
+	@brief Serializes the S-parameters to a compact binary blob (for caching parsed files)
+ */
+void SParameters::SerializeBinary(vector<uint8_t>& blob)
+{
+	BinaryBlobWriter writer(blob);
+	writer.Write<uint32_t>(m_nports);
+
+	//Map is sorted by (to, from) so we don't need to save the indexes
+	for(auto it : m_params)
+	{
+		auto& points = it.second->m_points;
+		points.PrepareForCpuAccess();
+		writer.WriteArray(points.GetCpuPointer(), points.size());
+	}
+}
+
+/**
+	@brief Loads S-parameters from a blob created by SerializeBinary()
+
+	@return True on success, false if the blob was malformed (in which case we're left empty)
+ */
+bool SParameters::DeserializeBinary(const vector<uint8_t>& blob)
+{
+	Clear();
+
+	BinaryBlobReader reader(blob);
+	auto nports = reader.Read<uint32_t>();
+	if(!reader.IsOK() || (nports == 0) || (nports > 1024) )
+		return false;
+	Allocate(nports);
+
+	for(auto it : m_params)
+	{
+		auto vec = it.second;
+		size_t len = reader.ReadArrayLength<SParameterPoint>();
+		vec->m_points.resize(len);
+		vec->m_points.PrepareForCpuAccess();
+		reader.ReadRaw(vec->m_points.GetCpuPointer(), len * sizeof(SParameterPoint));
+		vec->m_points.MarkModifiedFromCpu();
+		vec->MarkModified();
+	}
+
+	if(!reader.IsOK() || !reader.AtEnd())
+	{
+		Clear();
+		return false;
+	}
+	return true;
+}
+
 /**
 	@brief Serializes a S-parameter model to a Touchstone file
 
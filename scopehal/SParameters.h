@@ -36,6 +36,7 @@
 #define SParameters_h
 
 #include <complex>
+#include <atomic>
 
 /**
 	@brief A single point in an S-parameter dataset
@@ -68,6 +69,67 @@ public:
 	{ return std::polar(m_amplitude, m_phase); }
 };
 
+class SParameterVector;
+
+/**
+	@brief A single S-parameter array resampled onto a new frequency grid, in rectangular form
+
+	Real and imaginary parts are stored as separate planar arrays so they can be consumed directly by vectorized
+	code (or shaders) without any per-point trig.
+
+	The object remembers which source vector and which grid it was generated from, so repeated resampling requests
+	with unchanged inputs are free.
+ */
+class SParameterResampledVector
+{
+public:
+	SParameterResampledVector()
+	: m_srcSerial(0)
+	, m_gridSerial(0)
+	, m_gridStart(0)
+	, m_gridStep(0)
+	{
+		m_real.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+		m_imag.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
+	}
+
+	size_t size() const
+	{ return m_real.size(); }
+
+	std::complex<float> GetComplex(size_t i)
+	{ return std::complex<float>(m_real[i], m_imag[i]); }
+
+	/**
+		@brief Forces the next resampling request to recompute everything
+	 */
+	void Invalidate()
+	{
+		m_srcSerial = 0;
+		m_gridSerial = 0;
+	}
+
+	///@brief Real part of each point
+	AcceleratorBuffer<float> m_real;
+
+	///@brief Imaginary part of each point
+	AcceleratorBuffer<float> m_imag;
+
+protected:
+	friend class SParameterVector;
+
+	///@brief Serial number of the vector we were resampled from
+	uint64_t m_srcSerial;
+
+	///@brief Serial number of the vector whose frequency points we were resampled to (0 for a uniform grid)
+	uint64_t m_gridSerial;
+
+	///@brief Start of the uniform grid we were resampled to
+	float m_gridStart;
+
+	///@brief Bin size of the uniform grid we were resampled to
+	float m_gridStep;
+};
+
 /**
 	@brief A single S-parameter array
  */
@@ -75,29 +137,23 @@ class SParameterVector
 {
 public:
 	SParameterVector()
+	: m_serial(AllocateSerial())
 	{}
 
 	/**
 		@brief Creates an S-parameter vector from analog waveforms in dB / degree format
 	 */
 	SParameterVector(const WaveformBase* wmag, const WaveformBase* wang)
+	: m_serial(AllocateSerial())
 	{
-		auto umag = dynamic_cast<const UniformAnalogWaveform*>(wmag);
-		auto smag = dynamic_cast<const SparseAnalogWaveform*>(wmag);
-
-		auto uang = dynamic_cast<const UniformAnalogWaveform*>(wang);
-		auto sang = dynamic_cast<const SparseAnalogWaveform*>(wang);
-
-		if(umag && uang)
-			ConvertFromWaveforms(umag, uang);
-		else
-			ConvertFromWaveforms(smag, sang);
+		LoadFromWaveforms(wmag, wang);
 	}
 
 	/**
 		@brief Creates an S-parameter vector from analog waveforms in dB / degree format
 	 */
 	SParameterVector(const SparseAnalogWaveform* wmag, const SparseAnalogWaveform* wang)
+	: m_serial(AllocateSerial())
 	{
 		ConvertFromWaveforms(wmag, wang);
 	}
@@ -106,10 +162,28 @@ public:
 		@brief Creates an S-parameter vector from analog waveforms in dB / degree format
 	 */
 	SParameterVector(const UniformAnalogWaveform* wmag, const UniformAnalogWaveform* wang)
+	: m_serial(AllocateSerial())
 	{
 		ConvertFromWaveforms(wmag, wang);
 	}
 
+	/**
+		@brief Loads the vector from a pair of waveforms in dB / degree format, which may be sparse or uniform
+	 */
+	void LoadFromWaveforms(const WaveformBase* wmag, const WaveformBase* wang)
+	{
+		auto umag = dynamic_cast<const UniformAnalogWaveform*>(wmag);
+		auto smag = dynamic_cast<const SparseAnalogWaveform*>(wmag);
+
+		auto uang = dynamic_cast<const UniformAnalogWaveform*>(wang);
+		auto sang = dynamic_cast<const SparseAnalogWaveform*>(wang);
+
+		if(umag && uang)
+			ConvertFromWaveforms(umag, uang);
+		else
+			ConvertFromWaveforms(smag, sang);
+	}
+
 	/**
 		@brief Loads the vector from a pair of waveforms in mag/angle format.
 
@@ -139,6 +213,7 @@ public:
 		}
 
 		m_points.MarkModifiedFromCpu();
+		MarkModified();
 	}
 
 	void ConvertToWaveforms(SparseAnalogWaveform* wmag, SparseAnalogWaveform* wang);
@@ -147,10 +222,30 @@ public:
 	float InterpolateMagnitude(float frequency) const;
 	float InterpolateAngle(float frequency) const;
 
+	void Resample(const SParameterVector& grid, SParameterResampledVector& out) const;
+	void ResampleUniform(float start, float step, size_t npoints, SParameterResampledVector& out) const;
+
 	AcceleratorBuffer<SParameterPoint> m_points;
 
 	void resize(size_t nsize)
-	{ m_points.resize(nsize); }
+	{
+		m_points.resize(nsize);
+		MarkModified();
+	}
+
+	/**
+		@brief Indicates that m_points has been changed, invalidating any resampled copies of it.
+
+		Must be called by anything which writes to m_points directly.
+	 */
+	void MarkModified()
+	{ m_serial = AllocateSerial(); }
+
+	/**
+		@brief Returns a globally unique serial number identifying the current contents of this vector
+	 */
+	uint64_t GetSerial() const
+	{ return m_serial; }
 
 	float GetGroupDelay(size_t bin) const;
 
@@ -162,6 +257,22 @@ public:
 
 protected:
 	float InterpolatePhase(float phase_lo, float phase_hi, float frac) const;
+
+	template<class F>
+	void DoResample(F freqAt, size_t npoints, SParameterResampledVector& out) const;
+
+	void PolarToRectangular(SParameterResampledVector& out) const;
+#ifdef __x86_64__
+	void PolarToRectangularAVX2(SParameterResampledVector& out) const;
+#endif
+
+	static uint64_t AllocateSerial()
+	{ return ++m_nextSerial; }
+
+	///@brief Serial number of the current contents of m_points
+	uint64_t m_serial;
+
+	static std::atomic<uint64_t> m_nextSerial;
 };
 
 typedef std::pair<int, int> SPair;
@@ -215,6 +326,9 @@ public:
 	size_t GetNumPorts() const
 	{ return m_nports; }
 
+	void SerializeBinary(std::vector<uint8_t>& blob);
+	bool DeserializeBinary(const std::vector<uint8_t>& blob);
+
 protected:
 	std::map< SPair , SParameterVector*> m_params;
 
@@ -32,6 +32,7 @@
 using namespace std;
 
 Statistic::CreateMapType Statistic::m_createprocs;
+map<StreamDescriptor, weak_ptr<RunningStatistics> > Statistic::m_sharedRunningStats;
 
 Statistic::Statistic()
 {
@@ -41,6 +42,36 @@ Statistic::~Statistic()
 {
 }
 
+/**
+	@brief Gets the running statistics for a stream, shared with every other Statistic calculated on it
+ */
+RunningStatistics* Statistic::GetRunningStatistics(StreamDescriptor stream)
+{
+	auto it = m_runningStats.find(stream);
+	if(it != m_runningStats.end())
+		return it->second.get();
+
+	auto stats = m_sharedRunningStats[stream].lock();
+	if(!stats)
+	{
+		stats = make_shared<RunningStatistics>();
+		m_sharedRunningStats[stream] = stats;
+	}
+	m_runningStats[stream] = stats;
+	return stats.get();
+}
+
+/**
+	@brief Clears the running statistics of every stream we've been calculated on
+
+	Since these are shared, this also clears other statistics displayed for the same streams.
+ */
+void Statistic::ClearRunningStatistics()
+{
+	for(auto it : m_runningStats)
+		it.second->Clear();
+}
+
 void Statistic::DoAddStatisticClass(string name, CreateProcType proc)
 {
 	m_createprocs[name] = proc;
@@ -36,6 +36,8 @@
 #ifndef Statistic_h
 #define Statistic_h
 
+class RunningStatistics;
+
 class Statistic
 {
 public:
@@ -48,6 +50,16 @@ public:
 	virtual std::string GetStatisticDisplayName() =0;
 	virtual bool Calculate(StreamDescriptor stream, double& value) =0;
 
+protected:
+	RunningStatistics* GetRunningStatistics(StreamDescriptor stream);
+	void ClearRunningStatistics();
+
+	///@brief Running statistics for each stream we've been calculated on
+	std::map<StreamDescriptor, std::shared_ptr<RunningStatistics> > m_runningStats;
+
+	///@brief Running statistics shared by all Statistic instances, by stream
+	static std::map<StreamDescriptor, std::weak_ptr<RunningStatistics> > m_sharedRunningStats;
+
 	//Enumeration / factory
 public:
 	typedef Statistic* (*CreateProcType)();
@@ -33,10 +33,14 @@
 	@brief Implementation of TouchstoneParser
  */
 #include "scopehal.h"
+#include "PipelineCacheManager.h"
 #include <math.h>
 
 using namespace std;
 
+///@brief Version number of the SParameters binary format stored in the parsed file cache
+static const uint32_t g_touchstoneCacheVersion = 1;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // TouchstoneParser
 
@@ -56,6 +60,17 @@ bool TouchstoneParser::Load(string fname, SParameters& params)
 {
 	params.Clear();
 
+	//If we've parsed this exact file before, use the cached copy
+	if(g_pipelineCacheMgr)
+	{
+		auto blob = g_pipelineCacheMgr->LookupParsedFile(fname, "touchstone", g_touchstoneCacheVersion);
+		if(blob && params.DeserializeBinary(*blob))
+		{
+			LogTrace("Loaded S-parameter file %s from cache\n", fname.c_str());
+			return true;
+		}
+	}
+
 	//If file doesn't exist, bail early
 	//Open in binary mode because we ignore \r characters for files with Windows line endings,
 	//but we need files with Unix line endings to open correctly on Windows even if no \r is present.
@@ -229,10 +244,22 @@ bool TouchstoneParser::Load(string fname, SParameters& params)
 		}
 	}
 
-
 	delete[] buf;
+
+	//Invalidate any resampled copies of the old data
+	for(auto it : params.m_params)
+		it.second->MarkModified();
+
 	LogTrace("Loaded %zu S-parameter points\n", params.m_params[SPair(1,1)]->m_points.size());
 
+	//Save the parsed data so we don't have to do this again
+	if(ok && g_pipelineCacheMgr)
+	{
+		auto blob = make_shared< vector<uint8_t> >();
+		params.SerializeBinary(*blob);
+		g_pipelineCacheMgr->StoreParsedFile(fname, "touchstone", g_touchstoneCacheVersion, blob);
+	}
+
 	return ok;
 }
 
@@ -60,6 +60,9 @@ public:
 		, m_triggerPhase(0)
 		, m_flags(0)
 		, m_revision(0)
+		, m_appendRevision(0)
+		, m_rewriteRevision(0)
+		, m_textRevision(0)
 	{
 	}
 
@@ -70,6 +73,9 @@ public:
 		, m_triggerPhase(rhs.m_triggerPhase)
 		, m_flags(rhs.m_flags)
 		, m_revision(rhs.m_revision)
+		, m_appendRevision(rhs.m_appendRevision)
+		, m_rewriteRevision(rhs.m_rewriteRevision)
+		, m_textRevision(rhs.m_revision)
 	{}
 
 	//empty virtual destructor in case any derived classes need one
@@ -117,6 +123,37 @@ public:
 	 */
 	uint64_t m_revision;
 
+	/**
+		@brief Bumps m_revision to indicate that samples were added to the end of the waveform, and nothing else changed
+
+		Sources which only ever append (streaming captures etc) should call this instead of incrementing m_revision
+		directly, so that downstream filters can decode just the new samples. The duration of the previous last
+		sample may be extended, but no other existing sample or the timebase may change.
+	 */
+	void MarkSamplesAppended()
+	{
+		//If anything else happened since the last append, the samples we have now are a new baseline
+		if(m_appendRevision != m_revision)
+			m_rewriteRevision = m_revision;
+
+		m_revision ++;
+		m_appendRevision = m_revision;
+	}
+
+	/**
+		@brief Returns true if the only changes since revision rev were appended samples
+
+		Any modification other than MarkSamplesAppended() (including a direct m_revision increment) returns false, as
+		does a waveform whose source has never called MarkSamplesAppended().
+	 */
+	bool IsAppendOf(uint64_t rev) const
+	{
+		return (m_appendRevision != 0) &&
+			(m_appendRevision == m_revision) &&
+			(m_rewriteRevision <= rev) &&
+			(rev <= m_revision);
+	}
+
 	enum
 	{
 		WAVEFORM_CLIPPING = 1
@@ -140,6 +177,53 @@ public:
 		return StandardColors::colors[StandardColors::COLOR_ERROR];
 	}
 
+	/**
+		@brief Gets the text of a sample, rendering and caching it (and its neighbors) if needed
+
+		Every distinct string is stored once per waveform, so repeated calls don't allocate. The cache is discarded
+		when m_revision changes.
+	 */
+	const std::string& GetCachedText(size_t i)
+	{
+		ValidateTextCache();
+		if(m_textIds[i] == TEXT_NOT_RENDERED)
+			RenderTextRange(i, std::min(i + (size_t)TEXT_RENDER_BLOCK, m_textIds.size()));
+		return m_textStrings[m_textIds[i]];
+	}
+
+	/**
+		@brief Renders text for all samples in [start, end) that aren't already cached
+
+		Exporters should call this once up front, then use GetCachedText() for each sample.
+	 */
+	void RenderTextRange(size_t start, size_t end)
+	{
+		ValidateTextCache();
+		end = std::min(end, m_textIds.size());
+		while(start < end)
+		{
+			//Find the next run of unrendered samples
+			while( (start < end) && (m_textIds[start] != TEXT_NOT_RENDERED) )
+				start ++;
+			size_t runEnd = start;
+			while( (runEnd < end) && (m_textIds[runEnd] == TEXT_NOT_RENDERED) )
+				runEnd ++;
+
+			if(runEnd > start)
+				RenderText(start, runEnd);
+			start = runEnd;
+		}
+	}
+
+	///@brief Discards cached text (for when the text depends on something other than the sample data)
+	void InvalidateTextCache()
+	{
+		m_textIds.clear();
+		m_textStrings.clear();
+		m_textIndex.clear();
+		m_textKeyIds.clear();
+	}
+
 	virtual void PrepareForCpuAccess() =0;
 	virtual void PrepareForGpuAccess() =0;
 	virtual void MarkSamplesModifiedFromCpu() =0;
@@ -147,6 +231,102 @@ public:
 
 	virtual void MarkModifiedFromCpu() =0;
 	virtual void MarkModifiedFromGpu() =0;
+
+protected:
+
+	/**
+		@brief Renders the text of samples [start, end) into the text cache
+
+		The default implementation calls GetText() for each sample. Derived classes can override this to fill a
+		whole range at once without a virtual call (and string formatting) per sample, see RenderTextByKey().
+	 */
+	virtual void RenderText(size_t start, size_t end)
+	{
+		for(size_t i=start; i<end; i++)
+			m_textIds[i] = InternText(GetText(i));
+	}
+
+	/**
+		@brief Renders text for samples [start, end) whose text depends only on a small integer key
+
+		GetText() is only called for the first sample seen with each key, all others reuse its string.
+
+		@param start	First sample to render
+		@param end		One past the last sample to render
+		@param nkeys	Number of possible key values
+		@param key		Function returning the key, in [0, nkeys), of a sample
+	 */
+	template<class KeyFunc>
+	void RenderTextByKey(size_t start, size_t end, size_t nkeys, KeyFunc key)
+	{
+		if(m_textKeyIds.size() != nkeys)
+			m_textKeyIds.assign(nkeys, (uint32_t)TEXT_NOT_RENDERED);
+
+		for(size_t i=start; i<end; i++)
+		{
+			uint32_t& id = m_textKeyIds[key(i)];
+			if(id == TEXT_NOT_RENDERED)
+				id = InternText(GetText(i));
+			m_textIds[i] = id;
+		}
+	}
+
+	///@brief Returns the cache index of a string, adding it if it's not already there
+	uint32_t InternText(const std::string& text)
+	{
+		auto it = m_textIndex.find(text);
+		if(it != m_textIndex.end())
+			return it->second;
+
+		uint32_t id = m_textStrings.size();
+		m_textStrings.push_back(text);
+		m_textIndex[text] = id;
+		return id;
+	}
+
+	///@brief Resets the text cache if the waveform has been modified, and resizes it to match the waveform
+	void ValidateTextCache()
+	{
+		if(m_textRevision != m_revision)
+		{
+			InvalidateTextCache();
+			m_textRevision = m_revision;
+		}
+
+		size_t len = size();
+		if(m_textIds.size() != len)
+			m_textIds.resize(len, (uint32_t)TEXT_NOT_RENDERED);
+	}
+
+	enum
+	{
+		///@brief Marker for samples whose text hasn't been rendered yet
+		TEXT_NOT_RENDERED = 0xffffffff,
+
+		///@brief Number of samples GetCachedText() renders at a time
+		TEXT_RENDER_BLOCK = 1024
+	};
+
+	///@brief Index into m_textStrings of each sample's text, or TEXT_NOT_RENDERED
+	std::vector<uint32_t> m_textIds;
+
+	///@brief Every distinct string used by this waveform
+	std::vector<std::string> m_textStrings;
+
+	///@brief Map of strings to their index in m_textStrings
+	std::map<std::string, uint32_t> m_textIndex;
+
+	///@brief RenderTextByKey() cache of key to string index
+	std::vector<uint32_t> m_textKeyIds;
+
+	///@brief Value of m_revision after the most recent MarkSamplesAppended() call
+	uint64_t m_appendRevision;
+
+	///@brief Last value of m_revision before which existing samples may have been changed, not just appended to
+	uint64_t m_rewriteRevision;
+
+	///@brief Value of m_revision when the text cache was filled
+	uint64_t m_textRevision;
 };
 
 template<class S> class SparseWaveform;
@@ -415,12 +595,206 @@ public:
 	}
 };
 
+/**
+	@brief Byte storage for the variable-length payloads of the symbols in one waveform
+
+	Payloads are stored back to back in a single buffer and referenced by offset, so building a waveform costs a
+	handful of reallocations rather than one per symbol, and clear() is O(1) and keeps the buffer for reuse.
+ */
+class SymbolArena
+{
+public:
+
+	///@brief Copies bytes into the arena and returns the offset of the first one
+	uint32_t Add(const uint8_t* data, size_t len)
+	{
+		uint32_t off = m_data.size();
+		m_data.insert(m_data.end(), data, data + len);
+		return off;
+	}
+
+	///@brief Appends one byte to the end of the arena
+	void push_back(uint8_t b)
+	{ m_data.push_back(b); }
+
+	uint8_t* GetData(uint32_t off)
+	{ return m_data.data() + off; }
+
+	const uint8_t* GetData(uint32_t off) const
+	{ return m_data.data() + off; }
+
+	size_t size() const
+	{ return m_data.size(); }
+
+	void clear()
+	{ m_data.clear(); }
+
+protected:
+	std::vector<uint8_t> m_data;
+};
+
+/**
+	@brief Base class for symbols whose variable-length payload lives in an ArenaSparseWaveform's SymbolArena
+
+	The symbol itself only holds a reference to its bytes, so it's trivially copyable and cheap to store in an
+	AcceleratorBuffer. Use ArenaSparseWaveform::GetSymbolData() to read the payload.
+ */
+class ArenaSymbol
+{
+public:
+	ArenaSymbol()
+		: m_dataOffset(0)
+		, m_dataLen(0)
+	{}
+
+	///@brief Offset of the payload within the arena
+	uint32_t m_dataOffset;
+
+	///@brief Length of the payload, in bytes
+	uint32_t m_dataLen;
+};
+
+/**
+	@brief A sparse waveform of ArenaSymbol-derived symbols, plus the arena holding their payloads
+ */
+template<class S>
+class ArenaSparseWaveform : public SparseWaveform<S>
+{
+public:
+	ArenaSparseWaveform(const std::string& name = "")
+		: SparseWaveform<S>(name)
+	{}
+
+	virtual ~ArenaSparseWaveform()
+	{}
+
+	///@brief Payload bytes of all symbols
+	SymbolArena m_arena;
+
+	virtual void clear() override
+	{
+		SparseWaveform<S>::clear();
+		m_arena.clear();
+	}
+
+	const uint8_t* GetSymbolData(size_t i) const
+	{ return m_arena.GetData(this->m_samples[i].m_dataOffset); }
+
+	size_t GetSymbolDataLength(size_t i) const
+	{ return this->m_samples[i].m_dataLen; }
+
+	const uint8_t* GetSymbolData(const S& s) const
+	{ return m_arena.GetData(s.m_dataOffset); }
+
+	///@brief Sets the payload of a symbol (not yet, or already, in m_samples)
+	void SetSymbolData(S& s, const uint8_t* data, size_t len)
+	{
+		s.m_dataOffset = m_arena.Add(data, len);
+		s.m_dataLen = len;
+	}
+
+	/**
+		@brief Appends one byte to the payload of a symbol
+
+		This is O(1) when the symbol's payload is the most recent one in the arena, which is always the case when
+		symbols are built one at a time. Otherwise the existing payload is first moved to the end of the arena.
+	 */
+	void AppendSymbolData(S& s, uint8_t b)
+	{
+		if( (s.m_dataLen != 0) && (s.m_dataOffset + s.m_dataLen != m_arena.size()) )
+		{
+			std::vector<uint8_t> tmp(m_arena.GetData(s.m_dataOffset), m_arena.GetData(s.m_dataOffset) + s.m_dataLen);
+			s.m_dataOffset = m_arena.Add(tmp.data(), tmp.size());
+		}
+		else if(s.m_dataLen == 0)
+			s.m_dataOffset = m_arena.size();
+
+		m_arena.push_back(b);
+		s.m_dataLen ++;
+	}
+
+	///@brief Appends a symbol with a one-byte payload to m_samples (timestamps must be added separately)
+	void PushSymbol(S s, uint8_t b)
+	{
+		AppendSymbolData(s, b);
+		this->m_samples.push_back(s);
+	}
+};
+
 typedef SparseWaveform<bool> 					SparseDigitalWaveform;
 typedef UniformWaveform<bool>					UniformDigitalWaveform;
 typedef SparseWaveform<float>					SparseAnalogWaveform;
 typedef UniformWaveform<float>					UniformAnalogWaveform;
 typedef SparseWaveform< std::vector<bool> > 	SparseDigitalBusWaveform;
 
+/**
+	@brief All segments of a sequence (fast trigger) acquisition, handed to the filter graph in one go
+
+	The waveform itself is the first segment: its samples, timebase and start time are that segment's, so filters
+	that don't know about segments process it exactly as if the scope had only captured one. Segment-aware
+	measurements (see Filter::RefreshSegmentBatch()) process every segment in one refresh instead of the graph running
+	once per segment.
+
+	The other segments are separate waveforms owned by this one. All segments share the same timescale.
+ */
+class SegmentedAnalogWaveform : public UniformAnalogWaveform
+{
+public:
+	SegmentedAnalogWaveform(const std::string& name = "")
+		: UniformAnalogWaveform(name)
+	{}
+
+	//Segments are owned, don't copy them
+	SegmentedAnalogWaveform(const SegmentedAnalogWaveform& rhs) = delete;
+	SegmentedAnalogWaveform& operator=(const SegmentedAnalogWaveform& rhs) = delete;
+
+	virtual ~SegmentedAnalogWaveform()
+	{
+		for(auto w : m_segments)
+			delete w;
+	}
+
+	size_t GetSegmentCount() const
+	{ return m_segments.size() + 1; }
+
+	///@brief Gets a segment (segment 0 is this waveform)
+	UniformAnalogWaveform* GetSegment(size_t i)
+	{
+		if(i == 0)
+			return this;
+		return m_segments[i-1];
+	}
+
+	///@brief Gets the trigger time of a segment, in femtoseconds since the first segment's trigger
+	int64_t GetSegmentOffset(size_t i)
+	{
+		//FS_PER_SECOND isn't defined yet when this header is included
+		auto seg = GetSegment(i);
+		return (seg->m_startTimestamp - m_startTimestamp) * 1000000000000000LL +
+			(seg->m_startFemtoseconds - m_startFemtoseconds);
+	}
+
+	/**
+		@brief Appends a segment, taking ownership of it
+
+		The segment must have the same timescale as this waveform.
+	 */
+	void AddSegment(UniformAnalogWaveform* seg)
+	{ m_segments.push_back(seg); }
+
+	virtual void clear()
+	{
+		UniformAnalogWaveform::clear();
+		for(auto w : m_segments)
+			delete w;
+		m_segments.clear();
+	}
+
+protected:
+	///@brief Segments after the first
+	std::vector<UniformAnalogWaveform*> m_segments;
+};
+
 //Make sure inline helpers aren't warned about if unused
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-function"
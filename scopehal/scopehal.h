@@ -74,6 +74,7 @@ extern bool g_hasAvx2;
 
 #include "Unit.h"
 #include "Bijection.h"
+#include "BinaryBlob.h"
 #include "IDTable.h"
 
 #include "AcceleratorBuffer.h"
@@ -117,6 +118,7 @@ extern bool g_hasAvx2;
 #include "Statistic.h"
 #include "FilterParameter.h"
 #include "Filter.h"
+#include "RunningStatistics.h"
 #include "ImportFilter.h"
 #include "PeakDetectionFilter.h"
 #include "SpectrumChannel.h"
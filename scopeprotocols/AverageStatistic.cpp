@@ -33,8 +33,7 @@ using namespace std;
 
 void AverageStatistic::Clear()
 {
-	m_pastSums.clear();
-	m_pastCounts.clear();
+	ClearRunningStatistics();
 }
 
 string AverageStatistic::GetStatisticName()
@@ -44,38 +43,13 @@ string AverageStatistic::GetStatisticName()
 
 bool AverageStatistic::Calculate(StreamDescriptor stream, double& value)
 {
-	//Start integrating from the past value, if we have one
-	value = 0;
-	size_t count = 0;
-	if(m_pastSums.find(stream) != m_pastSums.end())
-	{
-		value = m_pastSums[stream];
-		count = m_pastCounts[stream];
-	}
-
-	//Get input data
-	auto w = stream.GetData();
-	auto udata = dynamic_cast<UniformAnalogWaveform*>(w);
-	auto sdata = dynamic_cast<SparseAnalogWaveform*>(w);
-
 	//Add new sample data
-	if(udata)
-	{
-		for(auto sample : udata->m_samples)
-			value += sample;
-	}
-	else if(sdata)
-	{
-		for(auto sample : sdata->m_samples)
-			value += sample;
-	}
-	count += w->size();
-
-	//Average and save
-	m_pastCounts[stream] = count;
-	m_pastSums[stream] = value;
-
-	value /= count;
+	auto stats = GetRunningStatistics(stream);
+	if(!stats->Integrate(stream.GetData(), false))
+		return false;
+	if(stats->GetCount() == 0)
+		return false;
 
+	value = stats->GetMean();
 	return true;
 }
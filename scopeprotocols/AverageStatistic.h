@@ -44,10 +44,6 @@ public:
 	virtual bool Calculate(StreamDescriptor stream, double& value);
 
 	STATISTIC_INITPROC(AverageStatistic)
-
-protected:
-	std::map<StreamDescriptor, double> m_pastSums;
-	std::map<StreamDescriptor, size_t> m_pastCounts;
 };
 
 #endif
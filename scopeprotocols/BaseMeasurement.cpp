@@ -82,10 +82,11 @@ void BaseMeasurement::Refresh()
 	PrepareForCpuAccess(sin, uin);
 
 	//Make a histogram of the waveform
-	float vmin = GetMinVoltage(sin, uin);
-	float vmax = GetMaxVoltage(sin, uin);
+	auto summary = GetWaveformSummary(in);
+	float vmin = summary->m_min;
+	float vmax = summary->m_max;
 	size_t nbins = 64;
-	vector<size_t> hist = MakeHistogram(sin, uin, vmin, vmax, nbins);
+	vector<size_t> hist = summary->GetCoarseHistogram(nbins);
 
 	//Set temporary midpoint and range
 	float range = (vmax - vmin);
@@ -0,0 +1,355 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of BathtubEngine
+ */
+
+#include "scopeprotocols.h"
+
+using namespace std;
+
+mutex BathtubEngine::m_enginesMutex;
+map<StreamDescriptor, weak_ptr<BathtubEngine> > BathtubEngine::m_engines;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+BathtubEngine::BathtubEngine()
+	: m_lastUIs(0)
+	, m_width(0)
+	, m_height(0)
+{
+}
+
+/**
+	@brief Gets the engine for an eye stream, creating it if nobody else is using it yet
+ */
+shared_ptr<BathtubEngine> BathtubEngine::GetEngine(StreamDescriptor eye)
+{
+	lock_guard<mutex> lock(m_enginesMutex);
+
+	auto engine = m_engines[eye].lock();
+	if(!engine)
+	{
+		engine = make_shared<BathtubEngine>();
+		m_engines[eye] = engine;
+	}
+	return engine;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Table generation
+
+/**
+	@brief Rebuilds the summed-area table if the eye has changed since the last call
+ */
+void BathtubEngine::Update(EyeWaveform* eye)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	size_t width = eye->GetWidth();
+	size_t height = eye->GetHeight();
+	if( (m_lastEye == eye) && (m_lastUIs == eye->GetTotalUIs()) && (m_width == width) && (m_height == height) )
+		return;
+	m_lastEye = WaveformCacheKey(eye);
+	m_lastUIs = eye->GetTotalUIs();
+	m_width = width;
+	m_height = height;
+	m_curves.clear();
+
+	size_t stride = width + 1;
+	m_sums.resize(stride * (height + 1));
+
+	//Running sum along each row
+	int64_t* data = eye->GetAccumData();
+	int64_t* sums = m_sums.data();
+	memset(sums, 0, stride * sizeof(int64_t));
+	#pragma omp parallel for if(width*height > 1000000)
+	for(size_t y=0; y<height; y++)
+	{
+		int64_t* row = sums + (y+1)*stride;
+		int64_t* src = data + y*width;
+		int64_t total = 0;
+		row[0] = 0;
+		for(size_t x=0; x<width; x++)
+		{
+			total += src[x];
+			row[x+1] = total;
+		}
+	}
+
+	//then down each column
+	for(size_t y=1; y<height; y++)
+	{
+		int64_t* prev = sums + y*stride;
+		int64_t* row = sums + (y+1)*stride;
+		for(size_t x=1; x<stride; x++)
+			row[x] += prev[x];
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Bathtubs
+
+/**
+	@brief Calculates a horizontal bathtub, moving outward from the center column
+
+	@param y0	First row of the band to integrate
+	@param y1	Last row of the band to integrate (inclusive)
+	@param ber	Output array, GetWidth() points
+
+	@return Number of hits the curve was normalized to (zero if there's no data)
+ */
+uint64_t BathtubEngine::GetHorizontalBathtub(size_t y0, size_t y1, float* ber)
+{
+	lock_guard<mutex> lock(m_mutex);
+	return DoGetHorizontalBathtub(y0, y1, ber);
+}
+
+uint64_t BathtubEngine::DoGetHorizontalBathtub(size_t y0, size_t y1, float* ber)
+{
+	size_t len = m_width;
+	if(len == 0)
+		return 0;
+	size_t mid = len / 2;
+
+	//Normalize to the larger side
+	int64_t nmax = max(GetHits(0, y0, mid, y1), GetHits(mid, y0, len-1, y1));
+	if(nmax <= 0)
+	{
+		for(size_t i=0; i<len; i++)
+			ber[i] = 0;
+		return 0;
+	}
+
+	float scale = 1.0f / nmax;
+	for(size_t i=0; i<=mid; i++)
+		ber[i] = GetHits(i, y0, mid, y1) * scale;
+	for(size_t i=mid; i<len; i++)
+		ber[i] = GetHits(mid, y0, i, y1) * scale;
+	return nmax;
+}
+
+/**
+	@brief Calculates a vertical bathtub, moving outward from the center row
+
+	@param x0	First column of the band to integrate
+	@param x1	Last column of the band to integrate (inclusive)
+	@param ber	Output array, GetHeight() points
+
+	@return Number of hits the curve was normalized to (zero if there's no data)
+ */
+uint64_t BathtubEngine::GetVerticalBathtub(size_t x0, size_t x1, float* ber)
+{
+	lock_guard<mutex> lock(m_mutex);
+	return DoGetVerticalBathtub(x0, x1, ber);
+}
+
+uint64_t BathtubEngine::DoGetVerticalBathtub(size_t x0, size_t x1, float* ber)
+{
+	size_t len = m_height;
+	if(len == 0)
+		return 0;
+	size_t mid = len / 2;
+
+	int64_t nmax = max(GetHits(x0, 0, x1, mid), GetHits(x0, mid, x1, len-1));
+	if(nmax <= 0)
+	{
+		for(size_t i=0; i<len; i++)
+			ber[i] = 0;
+		return 0;
+	}
+
+	float scale = 1.0f / nmax;
+	for(size_t i=0; i<=mid; i++)
+		ber[i] = GetHits(x0, i, x1, mid) * scale;
+	for(size_t i=mid; i<len; i++)
+		ber[i] = GetHits(x0, mid, x1, i) * scale;
+	return nmax;
+}
+
+/**
+	@brief Gets a finished horizontal bathtub: log10 of BER, floored at -14
+
+	@param y0			First row of the band to integrate
+	@param y1			Last row of the band to integrate (inclusive)
+	@param extrapolate	True to extend the curve with ExtrapolateDualDirac()
+	@param logber		Output array, GetWidth() points
+ */
+void BathtubEngine::GetLogHorizontalBathtub(size_t y0, size_t y1, bool extrapolate, float* logber)
+{
+	GetLogBathtub(false, y0, y1, extrapolate, logber);
+}
+
+/**
+	@brief Gets a finished vertical bathtub: log10 of BER, floored at -14
+
+	@param x0			First column of the band to integrate
+	@param x1			Last column of the band to integrate (inclusive)
+	@param extrapolate	True to extend the curve with ExtrapolateDualDirac()
+	@param logber		Output array, GetHeight() points
+ */
+void BathtubEngine::GetLogVerticalBathtub(size_t x0, size_t x1, bool extrapolate, float* logber)
+{
+	GetLogBathtub(true, x0, x1, extrapolate, logber);
+}
+
+/**
+	@brief Builds a finished bathtub, or copies it out of the cache if this eye already has one for the same band
+
+	Every bathtub view on the same eye, band and settings gets the same curve, so it's only built once per eye.
+ */
+void BathtubEngine::GetLogBathtub(bool vertical, size_t lo, size_t hi, bool extrapolate, float* logber)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	size_t len = vertical ? m_height : m_width;
+	for(auto& c : m_curves)
+	{
+		if( (c.m_vertical == vertical) && (c.m_lo == lo) && (c.m_hi == hi) && (c.m_extrapolate == extrapolate) )
+		{
+			memcpy(logber, c.m_logber.data(), len * sizeof(float));
+			return;
+		}
+	}
+
+	CachedCurve curve;
+	curve.m_vertical = vertical;
+	curve.m_lo = lo;
+	curve.m_hi = hi;
+	curve.m_extrapolate = extrapolate;
+	curve.m_logber.resize(len);
+	float* samples = curve.m_logber.data();
+
+	//Integrate BER from the center out
+	uint64_t nmax;
+	if(vertical)
+		nmax = DoGetVerticalBathtub(lo, hi, samples);
+	else
+		nmax = DoGetHorizontalBathtub(lo, hi, samples);
+
+	//Extend the curve below what we've measured, trusting anything with at least 10 hits
+	if(nmax && extrapolate)
+		ExtrapolateDualDirac(samples, len, 10.0 / nmax);
+
+	//Log post-scaling
+	for(size_t i=0; i<len; i++)
+	{
+		float& samp = samples[i];
+		if(samp < 1e-14)
+			samp = -14;	//cap ber if we don't have enough data
+		else
+			samp = log10(samp);
+	}
+
+	memcpy(logber, samples, len * sizeof(float));
+	m_curves.push_back(curve);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Extrapolation
+
+/**
+	@brief Fills in the low-BER center of a bathtub using the dual-Dirac model
+
+	Each side of the bathtub is fitted separately. Points between minBER and 0.25 are converted to Q scale, where a
+	Gaussian tail is a straight line, and a least squares line through them is used in place of any point below
+	minBER. This gets a curve down to 1e-12 without having to integrate trillions of UIs.
+
+	@param ber		Bathtub curve, with the center at len/2
+	@param len		Number of points
+	@param minBER	Smallest BER that's measured with enough hits to trust
+ */
+void BathtubEngine::ExtrapolateDualDirac(float* ber, size_t len, double minBER)
+{
+	if(len < 2)
+		return;
+	size_t mid = len / 2;
+	FitTail(ber, 0, mid, minBER);
+	FitTail(ber, len-1, mid, minBER);
+}
+
+/**
+	@brief Fits and extrapolates one side of a bathtub
+
+	@param ber		Bathtub curve
+	@param start	Outer end of this side
+	@param end		Center of the curve
+	@param minBER	Smallest BER that's measured with enough hits to trust
+ */
+void BathtubEngine::FitTail(float* ber, size_t start, size_t end, double minBER)
+{
+	const double maxBER = 0.25;
+	ssize_t step = (end > start) ? 1 : -1;
+	ssize_t last = end + step;
+
+	//Least squares fit of Q against position
+	double n = 0;
+	double sx = 0;
+	double sy = 0;
+	double sxx = 0;
+	double sxy = 0;
+	for(ssize_t i=start; i != last; i += step)
+	{
+		if( (ber[i] < minBER) || (ber[i] > maxBER) )
+			continue;
+
+		double q = JitterAnalysisEngine::GetQ(ber[i]);
+		n ++;
+		sx += i;
+		sy += q;
+		sxx += (double)i*i;
+		sxy += i*q;
+	}
+	if(n < 3)
+		return;
+	double denom = n*sxx - sx*sx;
+	if(fabs(denom) < 1e-9)
+		return;
+	double slope = (n*sxy - sx*sy) / denom;
+	double intercept = (sy - slope*sx) / n;
+
+	//Q has to increase moving toward the center, or this isn't a tail we can extrapolate
+	if(slope * step <= 0)
+		return;
+
+	for(ssize_t i=start; i != last; i += step)
+	{
+		if(ber[i] >= minBER)
+			continue;
+
+		double q = intercept + slope*i;
+		if(q > 0)
+			ber[i] = 0.5 * erfc(q / M_SQRT2);
+	}
+}
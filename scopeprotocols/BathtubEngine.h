@@ -0,0 +1,121 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of BathtubEngine
+ */
+#ifndef BathtubEngine_h
+#define BathtubEngine_h
+
+class EyeWaveform;
+
+/**
+	@brief BER queries against the integer accumulator of an eye pattern
+
+	Keeps a summed-area table of the eye's hit counts, so the number of hits in any rectangle of the eye is O(1).
+	The table is only rebuilt (in O(width * height)) when the eye changes, and every bathtub filter on the same eye
+	shares one engine (see GetEngine()). Filters may refresh in parallel, so everything is behind m_mutex.
+
+	A bathtub point is the fraction of hits between it and the center of the eye, over a band of rows or columns.
+ */
+class BathtubEngine
+{
+public:
+	BathtubEngine();
+
+	static std::shared_ptr<BathtubEngine> GetEngine(StreamDescriptor eye);
+
+	void Update(EyeWaveform* eye);
+
+	size_t GetWidth()
+	{ return m_width; }
+
+	size_t GetHeight()
+	{ return m_height; }
+
+	uint64_t GetHorizontalBathtub(size_t y0, size_t y1, float* ber);
+	uint64_t GetVerticalBathtub(size_t x0, size_t x1, float* ber);
+
+	void GetLogHorizontalBathtub(size_t y0, size_t y1, bool extrapolate, float* logber);
+	void GetLogVerticalBathtub(size_t x0, size_t x1, bool extrapolate, float* logber);
+
+	static void ExtrapolateDualDirac(float* ber, size_t len, double minBER);
+
+protected:
+
+	/**
+		@brief Gets the total hits in the rectangle [x0, x1] * [y0, y1] (inclusive)
+	 */
+	int64_t GetHits(size_t x0, size_t y0, size_t x1, size_t y1)
+	{
+		size_t stride = m_width + 1;
+		return m_sums[(y1+1)*stride + (x1+1)] - m_sums[y0*stride + (x1+1)]
+			- m_sums[(y1+1)*stride + x0] + m_sums[y0*stride + x0];
+	}
+
+	uint64_t DoGetHorizontalBathtub(size_t y0, size_t y1, float* ber);
+	uint64_t DoGetVerticalBathtub(size_t x0, size_t x1, float* ber);
+	void GetLogBathtub(bool vertical, size_t lo, size_t hi, bool extrapolate, float* logber);
+
+	static void FitTail(float* ber, size_t start, size_t end, double minBER);
+
+	///@brief A finished (log scale, optionally extrapolated) bathtub, kept until the eye changes
+	class CachedCurve
+	{
+	public:
+		bool m_vertical;
+		size_t m_lo;
+		size_t m_hi;
+		bool m_extrapolate;
+		std::vector<float> m_logber;
+	};
+
+	std::mutex m_mutex;
+
+	//The eye the table was built from
+	WaveformCacheKey m_lastEye;
+	size_t m_lastUIs;
+
+	size_t m_width;
+	size_t m_height;
+
+	///@brief Summed-area table, (m_width+1) * (m_height+1) with a row and column of zeroes at the start
+	std::vector<int64_t> m_sums;
+
+	///@brief Curves already requested for the current eye
+	std::vector<CachedCurve> m_curves;
+
+	static std::mutex m_enginesMutex;
+	static std::map<StreamDescriptor, std::weak_ptr<BathtubEngine> > m_engines;
+};
+
+#endif
@@ -50,6 +50,7 @@ CANDecoder::CANDecoder(const string& color)
 
 	m_parameters[m_baudrateName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_BITRATE));
 	m_parameters[m_baudrateName].SetIntVal(250000);
+	m_parameters[m_baudrateName].signal_changed().connect(sigc::mem_fun(*this, &CANDecoder::ResetIncrementalState));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -74,13 +75,20 @@ string CANDecoder::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+/**
+	@brief Decodes the input
+
+	If the input is a streaming capture which has only had samples appended since the last refresh, decoding resumes
+	from the start of the last idle period. Symbols and packets of a frame which was still in progress are discarded
+	and decoded again, and new ones are appended to the existing output and packets.
+ */
 void CANDecoder::Refresh()
 {
-	ClearPackets();
-
 	//Make sure we've got valid inputs
 	if(!VerifyAllInputsOK())
 	{
+		ClearPackets();
+		ResetIncrementalState();
 		SetData(NULL, 0);
 		return;
 	}
@@ -91,13 +99,38 @@ void CANDecoder::Refresh()
 	auto udiff = dynamic_cast<UniformDigitalWaveform*>(din);
 	auto sdiff = dynamic_cast<SparseDigitalWaveform*>(din);
 
-	//Create the capture
-	auto cap = new CANWaveform;
-	cap->m_timescale = din->m_timescale;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
-	cap->m_triggerPhase = din->m_triggerPhase;
-	cap->PrepareForCpuAccess();
+	//Pick up where we left off if we can, otherwise start over
+	auto cap = dynamic_cast<CANWaveform*>(GetData(0));
+	bool rewound = false;
+	if( (GetFirstNewSample(0) > 0) && (cap != NULL) )
+	{
+		cap->PrepareForCpuAccess();
+		m_index.Clear();
+
+		//Discard the frame in progress, if any
+		size_t nsym = m_resume.m_symbols;
+		rewound = (cap->m_samples.size() > nsym);
+		cap->m_offsets.resize(nsym);
+		cap->m_durations.resize(nsym);
+		cap->m_samples.resize(nsym);
+
+		for(size_t i=m_resume.m_packets; i<m_packets.size(); i++)
+			delete m_packets[i];
+		m_packets.resize(m_resume.m_packets);
+	}
+	else
+	{
+		ClearPackets();
+		m_resume = ResumePoint();
+
+		cap = new CANWaveform;
+		cap->m_timescale = din->m_timescale;
+		cap->m_startTimestamp = din->m_startTimestamp;
+		cap->m_startFemtoseconds = din->m_startFemtoseconds;
+		cap->m_triggerPhase = din->m_triggerPhase;
+		cap->PrepareForCpuAccess();
+		SetData(cap, 0);
+	}
 
 	//Calculate some time scale values
 	//Sample point is 3/4 of the way through the UI
@@ -105,55 +138,63 @@ void CANDecoder::Refresh()
 	int64_t fs_per_ui = FS_PER_SECOND / bitrate;
 	int64_t samples_per_ui = fs_per_ui / din->m_timescale;
 
-	enum
-	{
-		STATE_WAIT_FOR_IDLE,
-		STATE_IDLE,
-		STATE_SOF,
-		STATE_ID,
-		STATE_EXT_ID,
-		STATE_RTR,
-		STATE_IDE,
-		STATE_FD,
-		STATE_R0,
-		STATE_DLC,
-		STATE_DATA,
-		STATE_CRC,
-
-		STATE_CRC_DELIM,
-		STATE_ACK,
-		STATE_ACK_DELIM,
-		STATE_EOF
-	} state = STATE_WAIT_FOR_IDLE;
-
 	//LogDebug("Starting CAN decode\n");
 	//LogIndenter li;
 
 	Packet* pack = NULL;
 
 	size_t len = din->size();
-	int64_t tbitstart = 0;
-	int64_t tblockstart = 0;
-	bool vlast = true;
-	int nbit = 0;
-	bool sampled = false;
-	bool sampled_value = false;
-	bool last_sampled_value = false;
-	int bits_since_toggle = 0;
-	uint32_t current_field = 0;
-	bool frame_is_rtr = false;
-	bool extended_id = false;
-	bool fd_mode = false;
-	int frame_bytes_left = 0;
-	int32_t frame_id = 0;
+	State state = m_resume.m_state;
+	int64_t tbitstart = m_resume.m_tbitstart;
+	int64_t tblockstart = m_resume.m_tblockstart;
+	bool vlast = m_resume.m_vlast;
+	int nbit = m_resume.m_nbit;
+	bool sampled = m_resume.m_sampled;
+	bool sampled_value = m_resume.m_sampledValue;
+	bool last_sampled_value = m_resume.m_lastSampledValue;
+	int bits_since_toggle = m_resume.m_bitsSinceToggle;
+	uint32_t current_field = m_resume.m_currentField;
+	bool frame_is_rtr = m_resume.m_frameIsRtr;
+	bool extended_id = m_resume.m_extendedId;
+	bool fd_mode = m_resume.m_fdMode;
+	int frame_bytes_left = m_resume.m_frameBytesLeft;
+	int32_t frame_id = m_resume.m_frameId;
 	char tmp[128];
 
 	// CRC (http://esd.cs.ucr.edu/webres/can20.pdf page 13)
 	const uint16_t crc_poly = 0x4599;
-	uint16_t crc = 0;
+	uint16_t crc = m_resume.m_crc;
+
+	//We resume either at the start of the input or at the start of an idle period, so it's saved already
+	bool idle_saved = true;
 
-	for(size_t i = 0; i < len; i++)
+	for(size_t i = m_resume.m_sample; i < len; i++)
 	{
+		//Save our state at the first sample of each idle period
+		if( (state == STATE_IDLE) && !idle_saved)
+		{
+			m_resume.m_sample = i;
+			m_resume.m_symbols = cap->m_samples.size();
+			m_resume.m_packets = m_packets.size();
+			m_resume.m_state = state;
+			m_resume.m_tbitstart = tbitstart;
+			m_resume.m_tblockstart = tblockstart;
+			m_resume.m_vlast = vlast;
+			m_resume.m_nbit = nbit;
+			m_resume.m_sampled = sampled;
+			m_resume.m_sampledValue = sampled_value;
+			m_resume.m_lastSampledValue = last_sampled_value;
+			m_resume.m_bitsSinceToggle = bits_since_toggle;
+			m_resume.m_currentField = current_field;
+			m_resume.m_frameIsRtr = frame_is_rtr;
+			m_resume.m_extendedId = extended_id;
+			m_resume.m_fdMode = fd_mode;
+			m_resume.m_frameBytesLeft = frame_bytes_left;
+			m_resume.m_frameId = frame_id;
+			m_resume.m_crc = crc;
+			idle_saved = true;
+		}
+
 		bool v = GetValue(sdiff, udiff, i);
 		bool toggle = (v != vlast);
 		vlast = v;
@@ -185,6 +226,7 @@ void CANDecoder::Refresh()
 				nbit = 0;
 				bits_since_toggle = 0;
 				state = STATE_SOF;
+				idle_saved = false;
 			}
 			continue;
 		}
@@ -531,9 +573,15 @@ void CANDecoder::Refresh()
 		}
 	}
 
-	SetData(cap, 0);
+	//If the input is still growing, hold back a frame in progress from export until it ends
+	m_lastPacketOpen = (m_packets.size() > m_resume.m_packets) && din->IsAppendOf(din->m_revision);
 
+	//Symbols of a discarded frame were removed, so this is only an append if there weren't any
 	cap->MarkModifiedFromCpu();
+	if(rewound)
+		cap->m_revision ++;
+	else
+		cap->MarkSamplesAppended();
 }
 
 Gdk::Color CANWaveform::GetColor(size_t i)
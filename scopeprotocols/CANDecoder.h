@@ -101,6 +101,82 @@ public:
 
 protected:
 	std::string m_baudrateName;
+
+	enum State
+	{
+		STATE_WAIT_FOR_IDLE,
+		STATE_IDLE,
+		STATE_SOF,
+		STATE_ID,
+		STATE_EXT_ID,
+		STATE_RTR,
+		STATE_IDE,
+		STATE_FD,
+		STATE_R0,
+		STATE_DLC,
+		STATE_DATA,
+		STATE_CRC,
+
+		STATE_CRC_DELIM,
+		STATE_ACK,
+		STATE_ACK_DELIM,
+		STATE_EOF
+	};
+
+	/**
+		@brief Decoder state at the start of the most recent idle period, where an incremental refresh resumes
+
+		A frame still in progress at the end of the input is decoded again from here once more samples arrive, since
+		its last symbol may end at the last input sample (whose duration can grow when samples are appended).
+	 */
+	struct ResumePoint
+	{
+		///@brief Initial state, at the start of the input
+		ResumePoint()
+			: m_sample(0)
+			, m_symbols(0)
+			, m_packets(0)
+			, m_state(STATE_WAIT_FOR_IDLE)
+			, m_tbitstart(0)
+			, m_tblockstart(0)
+			, m_vlast(true)
+			, m_nbit(0)
+			, m_sampled(false)
+			, m_sampledValue(false)
+			, m_lastSampledValue(false)
+			, m_bitsSinceToggle(0)
+			, m_currentField(0)
+			, m_frameIsRtr(false)
+			, m_extendedId(false)
+			, m_fdMode(false)
+			, m_frameBytesLeft(0)
+			, m_frameId(0)
+			, m_crc(0)
+		{}
+
+		size_t m_sample;
+		size_t m_symbols;
+		size_t m_packets;
+
+		State m_state;
+		int64_t m_tbitstart;
+		int64_t m_tblockstart;
+		bool m_vlast;
+		int m_nbit;
+		bool m_sampled;
+		bool m_sampledValue;
+		bool m_lastSampledValue;
+		int m_bitsSinceToggle;
+		uint32_t m_currentField;
+		bool m_frameIsRtr;
+		bool m_extendedId;
+		bool m_fdMode;
+		int m_frameBytesLeft;
+		int32_t m_frameId;
+		uint16_t m_crc;
+	};
+
+	ResumePoint m_resume;
 };
 
 #endif
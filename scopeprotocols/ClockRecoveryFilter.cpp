@@ -32,6 +32,62 @@
 
 using namespace std;
 
+/**
+	@brief Bang-bang loop filter: constant phase and frequency steps regardless of error magnitude
+ */
+class BangBangLoopFilter
+{
+public:
+	void Update(int64_t delta, int64_t& edgepos, int64_t& period)
+	{
+		int64_t cperiod = period;
+		if(delta > 0)
+		{
+			period  -= cperiod / 40000;
+			edgepos -= cperiod / 400;
+		}
+		else
+		{
+			period  += cperiod / 40000;
+			edgepos += cperiod / 400;
+		}
+	}
+};
+
+/**
+	@brief Linear proportional-integral loop filter
+
+	Phase and period are tracked in floating point so that corrections smaller than 1 fs per edge aren't lost.
+	A first order loop is just this with ki = 0.
+ */
+class PILoopFilter
+{
+public:
+	PILoopFilter(double kp, double ki, int64_t period)
+	: m_kp(kp)
+	, m_ki(ki)
+	, m_period(period)
+	, m_phase(0)
+	{}
+
+	void Update(int64_t delta, int64_t& edgepos, int64_t& period)
+	{
+		m_period -= m_ki * delta;
+		m_phase -= m_kp * delta;
+
+		int64_t step = m_phase;
+		m_phase -= step;
+		edgepos += step;
+		period = llround(m_period);
+	}
+
+protected:
+	double m_kp;
+	double m_ki;
+	double m_period;
+	double m_phase;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -49,6 +105,22 @@ ClockRecoveryFilter::ClockRecoveryFilter(const string& color)
 	m_threshname = "Threshold";
 	m_parameters[m_threshname] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_VOLTS));
 	m_parameters[m_threshname].SetFloatVal(0);
+
+	m_modelname = "Loop Model";
+	m_parameters[m_modelname] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_modelname].AddEnumValue("Bang-bang", MODEL_BANG_BANG);
+	m_parameters[m_modelname].AddEnumValue("2nd order PI", MODEL_PI);
+	m_parameters[m_modelname].AddEnumValue("Golden PLL (FC)", MODEL_GOLDEN_FC);
+	m_parameters[m_modelname].AddEnumValue("Golden PLL (PCIe)", MODEL_GOLDEN_PCIE);
+	m_parameters[m_modelname].SetIntVal(MODEL_BANG_BANG);
+
+	m_bandwidthname = "Loop Bandwidth";
+	m_parameters[m_bandwidthname] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_HZ));
+	m_parameters[m_bandwidthname].SetFloatVal(4000000);	//4 MHz
+
+	m_dampingname = "Damping";
+	m_parameters[m_dampingname] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_dampingname].SetFloatVal(0.707);
 }
 
 ClockRecoveryFilter::~ClockRecoveryFilter()
@@ -148,18 +220,150 @@ void ClockRecoveryFilter::Refresh()
 	else
 		tend = GetOffsetScaled(sddin, uddin, din->size()-1);
 
-	//The actual PLL NCO
-	//TODO: use the real fibre channel PLL.
-	size_t nedge = 1;
-	//LogDebug("n, delta, period, freq_ghz, cycles_open_loop\n");
-	int64_t edgepos = edges[0];
-	bool value = false;
+	double start = GetTime();
+	double uis = (tend - edges[0]) * 1.0 / period;
+	double transitionDensity = edges.size() / max(uis, 1.0);
+	auto model = static_cast<LoopModel>(m_parameters[m_modelname].GetIntVal());
+
+	//Split long captures into overlapping segments that lock independently.
+	//Segment boundaries only depend on the data and loop settings (not the host's core count), so the output is
+	//the same everywhere. Each segment starts early by enough edges for the loop to settle, and segments are at
+	//least 4x that long so the overlap never dominates. Captures shorter than one segment lock in one piece.
+	const size_t segmentEdges = 1000000;
+	size_t overlapEdges = GetSettlingEdges(model, transitionDensity, period);
+	size_t segsize = max(segmentEdges, 4*overlapEdges);
+	size_t nsegments = (edges.size() + segsize - 1) / segsize;
+	segsize = edges.size() / nsegments;
+
+	vector<Segment> segments(nsegments);
+	for(size_t i=0; i<nsegments; i++)
+	{
+		auto& seg = segments[i];
+		size_t firstOut = i * segsize;
+		if(i == 0)
+		{
+			seg.m_firstEdge = 0;
+			seg.m_tstart = INT64_MIN;
+		}
+		else
+		{
+			seg.m_firstEdge = (firstOut > overlapEdges) ? (firstOut - overlapEdges) : 0;
+			seg.m_tstart = edges[firstOut];
+		}
+		if(i == nsegments-1)
+			seg.m_tend = tend;
+		else
+			seg.m_tend = edges[firstOut + segsize];
+
+		//Preallocate output for the nominal number of UIs, plus some margin for frequency error
+		int64_t tfirst = (i == 0) ? edges[0] : seg.m_tstart;
+		size_t nominal = max(seg.m_tend - tfirst, (int64_t)0) / period;
+		seg.m_offsets.resize(nominal + nominal/64 + 16);
+		seg.m_durations.resize(seg.m_offsets.size());
+	}
+
+	//Run the PLL
+	double kp = 0;
+	double ki = 0;
+	if(model != MODEL_BANG_BANG)
+		GetLoopGains(model, transitionDensity, period, kp, ki);
+
+	#pragma omp parallel for if(nsegments > 1)
+	for(size_t i=0; i<nsegments; i++)
+	{
+		if(model == MODEL_BANG_BANG)
+			RunSegment(segments[i], BangBangLoopFilter(), edges, gate, period, fnyquist);
+		else
+			RunSegment(segments[i], PILoopFilter(kp, ki, period), edges, gate, period, fnyquist);
+	}
+
+	//Stitch the segments together
+	size_t total = 0;
 	int64_t total_error = 0;
-	cap->m_samples.reserve(edges.size());
+	size_t num_errors = 0;
+	vector<size_t> bases(nsegments);
+	for(size_t i=0; i<nsegments; i++)
+	{
+		bases[i] = total;
+		total += segments[i].m_count;
+		total_error += segments[i].m_totalError;
+		num_errors += segments[i].m_numErrors;
+		if(segments[i].m_nyquistFail)
+			LogWarning("PLL attempted to lock to frequency near or above Nyquist - invalid config or undersampled data?\n");
+	}
+
+	cap->Resize(total);
+	#pragma omp parallel for if(nsegments > 1)
+	for(size_t i=0; i<nsegments; i++)
+	{
+		auto& seg = segments[i];
+		if(seg.m_count == 0)
+			continue;
+		memcpy(&cap->m_offsets[bases[i]], &seg.m_offsets[0], seg.m_count * sizeof(int64_t));
+		memcpy(&cap->m_durations[bases[i]], &seg.m_durations[0], seg.m_count * sizeof(int64_t));
+	}
+
+	//Recovered clock toggles on every output edge
+	for(size_t i=0; i<total; i++)
+		cap->m_samples[i] = !(i & 1);
+
+	if(num_errors)
+		total_error /= (int64_t)num_errors;
+	double dt = GetTime() - start;
+	LogTrace("Recovered %zu edges in %.3f ms (%.2f M edges/sec), average phase error %ld fs (%.4f UI)\n",
+		edges.size(),
+		dt * 1000,
+		edges.size() * 1e-6 / max(dt, 1e-9),
+		total_error,
+		total_error * 1.0 / period);
+
+	SetData(cap, 0);
+
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Runs the NCO and loop filter over one segment of the input
+
+	@param seg		Segment to process. Output is written to its preallocated buffers.
+	@param filter	Loop filter (copied, so each segment locks independently)
+	@param edges	Timestamps of all data edges
+	@param gate		Optional gating signal (clock is suppressed while it's low)
+	@param period	Nominal UI width
+	@param fnyquist	Shortest period the NCO may run at before we give up
+ */
+template<class LoopFilter>
+void ClockRecoveryFilter::RunSegment(
+	Segment& seg,
+	LoopFilter filter,
+	const vector<int64_t>& edges,
+	SparseDigitalWaveform* gate,
+	int64_t period,
+	int64_t fnyquist)
+{
+	size_t nedge = seg.m_firstEdge + 1;
+	int64_t edgepos = edges[seg.m_firstEdge];
+	size_t nedges = edges.size();
+	size_t capacity = seg.m_offsets.size();
+	size_t count = 0;
+	int64_t* offsets = &seg.m_offsets[0];
+	int64_t* durations = &seg.m_durations[0];
+
+	//Skip ahead to the first gate sample that might contain our start point
 	size_t igate = 0;
+	size_t gatelen = 0;
+	if(gate != NULL)
+	{
+		gatelen = gate->size();
+		int64_t gstart = edgepos / gate->m_timescale;
+		auto gbegin = &gate->m_offsets[0];
+		igate = upper_bound(gbegin, gbegin + gatelen, gstart) - gbegin;
+		if(igate > 0)
+			igate --;
+	}
 	bool gating = false;
 
-	for(; (edgepos < tend) && (nedge < edges.size()-1); edgepos += period)
+	for(; (edgepos < seg.m_tend) && (nedge < nedges-1); edgepos += period)
 	{
 		float center = period/2;
 
@@ -167,7 +371,7 @@ void ClockRecoveryFilter::Refresh()
 		bool was_gating = gating;
 		if(gate != NULL)
 		{
-			while(igate < edges.size()-1)
+			while(igate < gatelen)
 			{
 				//See if this edge is within the region
 				int64_t a = gate->m_offsets[igate];
@@ -196,57 +400,138 @@ void ClockRecoveryFilter::Refresh()
 		//If not, just run the NCO open loop.
 		//Allow multiple edges in the UI if the frequency is way off.
 		int64_t tnext = edges[nedge];
-		while( (tnext + center < edgepos) && (nedge+1 < edges.size()) )
+		while( (tnext + center < edgepos) && (nedge+1 < nedges) )
 		{
 			//Find phase error
 			int64_t delta = (edgepos - tnext) - period;
-			total_error += fabs(delta);
+			if(edgepos >= seg.m_tstart)
+			{
+				seg.m_totalError += llabs(delta);
+				seg.m_numErrors ++;
+			}
 
 			//If the clock is currently gated, re-sync to the edge
 			if(was_gating && !gating)
 				edgepos = tnext + period;
 
-			//Check sign of phase and do bang-bang feedback (constant shift regardless of error magnitude)
+			//Otherwise, feed the error to the loop filter
 			else
-			{
-				int64_t cperiod = period;
-				if(delta > 0)
-				{
-					period  -= cperiod / 40000;
-					edgepos -= cperiod / 400;
-				}
-				else
-				{
-					period  += cperiod / 40000;
-					edgepos += cperiod / 400;
-				}
-			}
+				filter.Update(delta, edgepos, period);
 
 			tnext = edges[++nedge];
 
 			if(period < fnyquist)
 			{
-				LogWarning("PLL attempted to lock to frequency near or above Nyquist - invalid config or undersampled data?\n");
-				nedge = edges.size();
+				seg.m_nyquistFail = true;
+				nedge = nedges;
 				break;
 			}
 		}
 
-		//Add the sample
-		if(!gating)
+		//Add the sample, if it's in our output region
+		if(!gating && (edgepos >= seg.m_tstart) )
 		{
-			value = !value;
+			if(count >= capacity)
+			{
+				capacity *= 2;
+				seg.m_offsets.resize(capacity);
+				seg.m_durations.resize(capacity);
+				offsets = &seg.m_offsets[0];
+				durations = &seg.m_durations[0];
+			}
 
-			cap->m_offsets.push_back(edgepos + period/2);
-			cap->m_durations.push_back(period);
-			cap->m_samples.push_back(value);
+			offsets[count] = edgepos + period/2;
+			durations[count] = period;
+			count ++;
 		}
 	}
 
-	total_error /= edges.size();
-	LogTrace("average phase error %zu\n", total_error);
+	seg.m_count = count;
+}
+
+/**
+	@brief Gets the -3 dB bandwidth of a linear loop model, in Hz
 
-	SetData(cap, 0);
+	@param model	Loop model (not bang-bang)
+	@param period	Nominal UI width, in fs
+ */
+double ClockRecoveryFilter::GetLoopBandwidth(LoopModel model, int64_t period)
+{
+	double baud = FS_PER_SECOND * 1.0 / period;
+	if(model == MODEL_PI)
+		return m_parameters[m_bandwidthname].GetFloatVal();
 
-	cap->MarkModifiedFromCpu();
+	//Both golden PLLs have their corner at fbaud/1667
+	return baud / 1667;
+}
+
+/**
+	@brief Estimates how many data edges the loop needs to settle from a cold start
+
+	Linear loops are given several time constants, i.e. several 1/(BW * UI) UIs. The bang-bang loop slews at a fixed
+	rate (UI/400 of phase and UI/40000 of period per edge) rather than having a bandwidth, so it gets a fixed count
+	that covers a full UI of phase error and a few hundred ppm of frequency error many times over.
+
+	@param model				Loop model
+	@param transitionDensity	Average number of data edges per UI
+	@param period				Nominal UI width, in fs
+ */
+size_t ClockRecoveryFilter::GetSettlingEdges(LoopModel model, double transitionDensity, int64_t period)
+{
+	if(model == MODEL_BANG_BANG)
+		return 20000;
+
+	//Number of UIs in one 1/(BW * UI) time constant
+	double bw = max(GetLoopBandwidth(model, period), 1.0);
+	double tauUIs = FS_PER_SECOND * 1.0 / (bw * period);
+
+	const double timeConstants = 5;
+	return ceil(timeConstants * tauUIs * max(transitionDensity, 0.01));
+}
+
+/**
+	@brief Calculates proportional and integral gains for the linear loop models
+
+	Gains are per data edge rather than per UI, so they're scaled by the transition density to keep the loop
+	bandwidth close to what was asked for.
+
+	@param model				Loop model
+	@param transitionDensity	Average number of data edges per UI
+	@param period				Nominal UI width, in fs
+	@param kp					Proportional gain (output)
+	@param ki					Integral gain (output)
+ */
+void ClockRecoveryFilter::GetLoopGains(
+	LoopModel model, double transitionDensity, int64_t period, double& kp, double& ki)
+{
+	double ui = period * 1.0 / FS_PER_SECOND;
+	double density = max(transitionDensity, 0.01);
+
+	switch(model)
+	{
+		//FC-MJSQ golden PLL: first order, corner at fbaud/1667
+		case MODEL_GOLDEN_FC:
+			kp = 2 * M_PI * GetLoopBandwidth(model, period) * ui / density;
+			ki = 0;
+			return;
+
+		//PCIe reference CDR: second order, same corner, critically damped
+		case MODEL_GOLDEN_PCIE:
+		case MODEL_PI:
+		default:
+			{
+				double bw = GetLoopBandwidth(model, period);
+				double zeta = 0.707;
+				if(model == MODEL_PI)
+					zeta = m_parameters[m_dampingname].GetFloatVal();
+
+				//Convert -3 dB bandwidth to natural frequency for a type II loop
+				double z2 = 1 + 2*zeta*zeta;
+				double wn = 2 * M_PI * bw / sqrt(z2 + sqrt(z2*z2 + 1));
+
+				kp = 2 * zeta * wn * ui / density;
+				ki = (wn * ui) * (wn * ui) / density;
+			}
+			return;
+	}
 }
@@ -47,11 +47,71 @@ public:
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream);
 
+	enum LoopModel
+	{
+		MODEL_BANG_BANG,
+		MODEL_PI,
+		MODEL_GOLDEN_FC,
+		MODEL_GOLDEN_PCIE
+	};
+
 	PROTOCOL_DECODER_INITPROC(ClockRecoveryFilter)
 
 protected:
+
+	/**
+		@brief One independently locked span of a long capture
+
+		The NCO starts locking at m_firstEdge, but only emits clock edges between m_tstart and m_tend. Neighboring
+		segments overlap by enough UIs for the loop to settle before it reaches its own output region.
+	 */
+	class Segment
+	{
+	public:
+		Segment()
+		: m_firstEdge(0)
+		, m_tstart(0)
+		, m_tend(0)
+		, m_count(0)
+		, m_totalError(0)
+		, m_numErrors(0)
+		, m_nyquistFail(false)
+		{}
+
+		size_t m_firstEdge;
+		int64_t m_tstart;
+		int64_t m_tend;
+
+		//Output, preallocated and grown by doubling
+		std::vector<int64_t> m_offsets;
+		std::vector<int64_t> m_durations;
+		size_t m_count;
+
+		//Phase error statistics, within the output region only
+		int64_t m_totalError;
+		size_t m_numErrors;
+
+		bool m_nyquistFail;
+	};
+
+	template<class LoopFilter>
+	void RunSegment(
+		Segment& seg,
+		LoopFilter filter,
+		const std::vector<int64_t>& edges,
+		SparseDigitalWaveform* gate,
+		int64_t period,
+		int64_t fnyquist);
+
+	void GetLoopGains(LoopModel model, double transitionDensity, int64_t period, double& kp, double& ki);
+	double GetLoopBandwidth(LoopModel model, int64_t period);
+	size_t GetSettlingEdges(LoopModel model, double transitionDensity, int64_t period);
+
 	std::string m_baudname;
 	std::string m_threshname;
+	std::string m_modelname;
+	std::string m_bandwidthname;
+	std::string m_dampingname;
 };
 
 #endif
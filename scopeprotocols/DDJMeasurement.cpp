@@ -82,6 +82,14 @@ bool DDJMeasurement::IsScalarOutput()
 	return true;
 }
 
+void DDJMeasurement::ClearSweeps()
+{
+	if(m_engine)
+		m_engine->Clear();
+	for(int i=0; i<256; i++)
+		m_table[i] = 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -93,96 +101,15 @@ void DDJMeasurement::Refresh()
 		return;
 	}
 
-	//Get the input data
+	//Add the new data to the running jitter tables for these inputs
 	auto tie = dynamic_cast<SparseAnalogWaveform*>(GetInputWaveform(0));
-	tie->PrepareForCpuAccess();
-
-	//Sample the input data
-	SparseDigitalWaveform samples;
-	SampleOnAnyEdgesBase(GetInputWaveform(1), GetInputWaveform(2), samples);
-
-	//DDJ history (8 UIs)
-	uint8_t window = 0;
-
-	//Table of jitter indexed by history
-	vector<size_t> num_table;
-	vector<float> sum_table;
-	size_t num_bins = 256;
-	num_table.resize(num_bins);
-	sum_table.resize(num_bins);
-	for(size_t i=0; i<num_bins; i++)
-	{
-		num_table[i] = 0;
-		sum_table[i] = 0;
-	}
-
-	size_t tielen = tie->m_samples.size();
-	size_t samplen = samples.m_samples.size();
-
-	size_t itie = 0;
-
-	//Loop over the TIE and threshold waveform and assign jitter to bins
-	size_t nbits = 0;
-	int64_t tfirst = GetOffsetScaled(tie, 0);
-	for(size_t idata=0; idata < samplen; idata ++)
-	{
-		//Sample the next bit in the thresholded waveform
-		window = (window >> 1);
-		if(samples.m_samples[idata])
-			window |= 0x80;
-		nbits ++;
-
-		//need 8 in last_window, plus one more for the current bit
-		if(nbits < 9)
-			continue;
-
-		//If we're still before the first TIE sample, nothing to do
-		int64_t tstart = samples.m_offsets[idata];
-		if(tstart < tfirst)
-			continue;
-
-		//Advance TIE samples if needed
-		int64_t target = 0;
-		while( (target < tfirst) && (itie < tielen) )
-		{
-			target = GetOffsetScaled(tie, itie);
-
-			if(target < tstart)
-				itie ++;
-		}
-		if(itie >= tielen)
-			break;
-
-		//If the TIE sample is after this bit, don't do anything.
-		//We need edges within this UI.
-		int64_t tend = tstart + samples.m_durations[idata];
-		if(target > tend)
-			continue;
-
-		//Save the info in the DDJ table
-		num_table[window] ++;
-		sum_table[window] += tie->m_samples[itie];
-	}
-
-	//Calculate DDJ
-	float ddjmin =  FLT_MAX;
-	float ddjmax = 0;
-	for(size_t i=0; i<num_bins; i++)
-	{
-		if(num_table[i] != 0)
-		{
-			float jitter = sum_table[i] * 1.0 / num_table[i];
-			m_table[i] = jitter;
-			ddjmin = min(ddjmin, jitter);
-			ddjmax = max(ddjmax, jitter);
-		}
-		else
-			m_table[i] = 0;
-	}
+	m_engine = JitterAnalysisEngine::GetEngine(GetInput(0), GetInput(1), GetInput(2));
+	m_engine->Integrate(tie, GetInputWaveform(1), GetInputWaveform(2));
+	m_engine->GetDDJTable(m_table);
 
 	auto cap = SetupEmptyUniformAnalogOutputWaveform(tie, 0, true);
 	cap->PrepareForCpuAccess();
-	cap->m_samples.push_back(ddjmax - ddjmin);
+	cap->m_samples.push_back(m_engine->GetDDJPeakToPeak());
 	cap->m_timescale = 1;
 	cap->m_startTimestamp = tie->m_startTimestamp;
 	cap->m_startFemtoseconds = tie->m_startFemtoseconds;
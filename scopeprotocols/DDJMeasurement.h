@@ -35,6 +35,11 @@
 #ifndef DDJMeasurement_h
 #define DDJMeasurement_h
 
+/**
+	@brief Data-dependent jitter, averaged over every waveform since the last ClearSweeps()
+
+	This is a view over the JitterAnalysisEngine for the TIE, threshold and clock inputs.
+ */
 class DDJMeasurement : public Filter
 {
 public:
@@ -43,6 +48,7 @@ public:
 	virtual void Refresh();
 
 	virtual bool IsScalarOutput();
+	virtual void ClearSweeps();
 
 	static std::string GetProtocolName();
 
@@ -55,6 +61,8 @@ public:
 
 protected:
 	float m_table[256];
+
+	std::shared_ptr<JitterAnalysisEngine> m_engine;
 };
 
 #endif
@@ -91,87 +91,55 @@ void DDR1Decoder::Refresh()
 		caps[i]->PrepareForCpuAccess();
 	}
 
-	//Sample all of the inputs
-	auto cclk = caps[0];
-	SparseDigitalWaveform we;
-	SparseDigitalWaveform ras;
-	SparseDigitalWaveform cas;
-	SparseDigitalWaveform cs;
-	SparseDigitalWaveform a10;
-	SampleOnRisingEdgesBase(caps[1], cclk, we);
-	SampleOnRisingEdgesBase(caps[2], cclk, ras);
-	SampleOnRisingEdgesBase(caps[3], cclk, cas);
-	SampleOnRisingEdgesBase(caps[4], cclk, cs);
-	SampleOnRisingEdgesBase(caps[5], cclk, a10);
-
-	//Create the capture
-	auto cap = new SDRAMWaveform;
-	cap->m_timescale = 1;
-	cap->m_startTimestamp = cclk->m_startTimestamp;
-	cap->m_startFemtoseconds = 0;
-	cap->PrepareForCpuAccess();
-
-	//Loop over the data and look for events on clock edges
-	size_t len = we.size();
-	len = min(len, ras.size());
-	len = min(len, cas.size());
-	len = min(len, cs.size());
-	len = min(len, a10.size());
-	for(size_t i=0; i<len; i++)
+	WaveformBase* pins[PIN_COUNT] = {0};
+	pins[PIN_WE] = caps[1];
+	pins[PIN_RAS] = caps[2];
+	pins[PIN_CAS] = caps[3];
+	pins[PIN_CS] = caps[4];
+	pins[PIN_A10] = caps[5];
+	DecodeCommands(caps[0], pins);
+}
+
+int DDR1Decoder::ClassifyCommand(uint8_t pins)
+{
+	bool swe = (pins >> PIN_WE) & 1;
+	bool sras = (pins >> PIN_RAS) & 1;
+	bool scas = (pins >> PIN_CAS) & 1;
+	bool scs = (pins >> PIN_CS) & 1;
+	bool sa10 = (pins >> PIN_A10) & 1;
+
+	//Deselect or NOP
+	if(scs || (sras && scas && swe) )
+		return COMMAND_NONE;
+
+	if(!sras && scas && swe)
+		return SDRAMSymbol::TYPE_ACT;
+	else if(!sras && scas && !swe && !sa10)
+		return SDRAMSymbol::TYPE_PRE;
+	else if(!sras && scas && !swe && sa10)
+		return SDRAMSymbol::TYPE_PREA;
+	else if(sras && !scas && !swe)
 	{
-		bool swe = we.m_samples[i];
-		bool sras = ras.m_samples[i];
-		bool scas = cas.m_samples[i];
-		bool scs = cs.m_samples[i];
-		bool sa10 = a10.m_samples[i];
-
-		if(!scs)
-		{
-			//NOP
-			if(sras && scas && swe)
-				continue;
-
-			SDRAMSymbol sym(SDRAMSymbol::TYPE_ERROR);
-
-			if(!sras && scas && swe)
-				sym.m_stype = SDRAMSymbol::TYPE_ACT;
-			else if(!sras && scas && !swe && !sa10)
-				sym.m_stype = SDRAMSymbol::TYPE_PRE;
-			else if(!sras && scas && !swe && sa10)
-				sym.m_stype = SDRAMSymbol::TYPE_PREA;
-			else if(sras && !scas && !swe)
-			{
-				if(!sa10)
-					sym.m_stype = SDRAMSymbol::TYPE_WR;
-				else
-					sym.m_stype = SDRAMSymbol::TYPE_WRA;
-			}
-			else if(sras && !scas && swe)
-			{
-				if(!sa10)
-					sym.m_stype = SDRAMSymbol::TYPE_RD;
-				else
-					sym.m_stype = SDRAMSymbol::TYPE_RDA;
-			}
-			else if(!sras && !scas && !swe)
-				sym.m_stype = SDRAMSymbol::TYPE_MRS;		//TODO: MRS / EMRS depending on BA0
-			else if(sras && scas && !swe)
-				sym.m_stype = SDRAMSymbol::TYPE_STOP;
-			else if(!sras && !scas && swe)
-				sym.m_stype = SDRAMSymbol::TYPE_REF;
-
-			//Unknown
-			//TODO: self refresh entry/exit (we don't have CKE in the current test data source so can't use it)
-			else
-				LogDebug("[%zu] Unknown command (RAS=%d, CAS=%d, WE=%d, A10=%d)\n", i, sras, scas, swe, sa10);
-
-			//Create the symbol
-			cap->m_offsets.push_back(we.m_offsets[i]);
-			cap->m_durations.push_back(we.m_durations[i]);
-			cap->m_samples.push_back(sym);
-		}
+		if(!sa10)
+			return SDRAMSymbol::TYPE_WR;
+		else
+			return SDRAMSymbol::TYPE_WRA;
 	}
-	SetData(cap, 0);
-
-	cap->MarkModifiedFromCpu();
+	else if(sras && !scas && swe)
+	{
+		if(!sa10)
+			return SDRAMSymbol::TYPE_RD;
+		else
+			return SDRAMSymbol::TYPE_RDA;
+	}
+	else if(!sras && !scas && !swe)
+		return SDRAMSymbol::TYPE_MRS;		//TODO: MRS / EMRS depending on BA0
+	else if(sras && scas && !swe)
+		return SDRAMSymbol::TYPE_STOP;
+	else if(!sras && !scas && swe)
+		return SDRAMSymbol::TYPE_REF;
+
+	//Unknown
+	//TODO: self refresh entry/exit (we don't have CKE in the current test data source so can't use it)
+	return SDRAMSymbol::TYPE_ERROR;
 }
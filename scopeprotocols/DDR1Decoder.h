@@ -52,6 +52,7 @@ public:
 	PROTOCOL_DECODER_INITPROC(DDR1Decoder)
 
 protected:
+	virtual int ClassifyCommand(uint8_t pins);
 };
 
 #endif
@@ -52,6 +52,7 @@ public:
 	PROTOCOL_DECODER_INITPROC(DDR3Decoder)
 
 protected:
+	virtual int ClassifyCommand(uint8_t pins);
 };
 
 #endif
@@ -55,6 +55,9 @@ DVIDecoder::DVIDecoder(const string& color)
 	CreateInput("D0 (blue)");
 	CreateInput("D1 (green)");
 	CreateInput("D2 (red)");
+
+	m_store.DeclareEnum("Type", { "Video", "VSYNC" });
+	m_store.DeclareColumn("Width", PacketStore::COLUMN_DECIMAL);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -89,6 +92,13 @@ bool DVIDecoder::GetShowImageColumn()
 	return true;
 }
 
+Packet* DVIDecoder::CreatePacketView(size_t row)
+{
+	if(m_store.GetValue(row, COL_TYPE) == TYPE_VIDEO)
+		return new VideoScanlinePacket;
+	return new Packet;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -124,7 +134,9 @@ void DVIDecoder::Refresh()
 
 	TMDSSymbol::TMDSType last_type = TMDSSymbol::TMDS_TYPE_ERROR;
 
-	VideoScanlinePacket* current_packet = NULL;
+	//Row of the packet store for the scanline being decoded, if any
+	bool in_packet = false;
+	size_t current_packet = 0;
 	int current_pixels = 0;
 
 	//Decode the actual data
@@ -139,16 +151,14 @@ void DVIDecoder::Refresh()
 		if(sblue.m_type == TMDSSymbol::TMDS_TYPE_CONTROL)
 		{
 			//If the last sample was data, save the packet for the scanline or data island
-			if( (last_type == TMDSSymbol::TMDS_TYPE_DATA) && (current_packet != NULL) )
+			if( (last_type == TMDSSymbol::TMDS_TYPE_DATA) && in_packet )
 			{
-				current_packet->m_len = dblue->m_offsets[iblue] + dblue->m_durations[iblue] - current_packet->m_offset;
-				char tmp[32];
-				snprintf(tmp, sizeof(tmp), "%d", current_pixels);
-				current_packet->m_headers["Width"] = tmp;
-				m_packets.push_back(current_packet);
+				m_store.SetLength(current_packet,
+					dblue->m_offsets[iblue] + dblue->m_durations[iblue] - m_store.GetOffset(current_packet));
+				m_store.SetValue(current_packet, COL_WIDTH, current_pixels);
 
 				current_pixels = 0;
-				current_packet = NULL;
+				in_packet = false;
 			}
 
 			//Extract synchronization signals from blue channel
@@ -164,10 +174,15 @@ void DVIDecoder::Refresh()
 
 			else if(vsync)
 			{
-				auto pack = new Packet;
-				pack->m_offset = dblue->m_offsets[iblue];
-				pack->m_headers["Type"] = "VSYNC";
-				m_packets.push_back(pack);
+				//Pixel data is appended to the last row, so drop any unterminated scanline first
+				if(in_packet)
+				{
+					m_store.RemoveLastPacket();
+					in_packet = false;
+				}
+
+				auto pack = AddPacket(dblue->m_offsets[iblue]);
+				m_store.SetValue(pack, COL_TYPE, TYPE_VSYNC);
 
 				cap->m_offsets.push_back(dblue->m_offsets[iblue]);
 				cap->m_durations.push_back(dblue->m_durations[iblue]);
@@ -232,10 +247,12 @@ void DVIDecoder::Refresh()
 					break;
 				}
 
-				//Start a new packet
-				current_packet = new VideoScanlinePacket;
-				current_packet->m_offset = dblue->m_offsets[iblue];
-				current_packet->m_headers["Type"] = "Video";
+				//Start a new packet, discarding any unterminated one
+				if(in_packet)
+					m_store.RemoveLastPacket();
+				current_packet = AddPacket(dblue->m_offsets[iblue]);
+				m_store.SetValue(current_packet, COL_TYPE, TYPE_VIDEO);
+				in_packet = true;
 				current_pixels = 0;
 			}
 
@@ -251,11 +268,10 @@ void DVIDecoder::Refresh()
 
 			//In-memory packet data is RGB order for compatibility with Gdk::Pixbuf
 			//may be null if waveform starts halfway through a scan line. Don't make a packet for that.
-			if(current_packet != NULL)
+			if(in_packet)
 			{
-				current_packet->m_data.push_back(sred.m_data);
-				current_packet->m_data.push_back(sgreen.m_data);
-				current_packet->m_data.push_back(sblue.m_data);
+				uint8_t rgb[3] = {sred.m_data, sgreen.m_data, sblue.m_data};
+				m_store.AppendData(rgb, 3);
 				current_pixels ++;
 			}
 		}
@@ -269,8 +285,8 @@ void DVIDecoder::Refresh()
 		ired ++;
 	}
 
-	if(current_packet)
-		delete current_packet;
+	if(in_packet)
+		m_store.RemoveLastPacket();
 
 	SetData(cap, 0);
 
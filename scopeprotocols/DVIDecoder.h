@@ -104,6 +104,21 @@ public:
 	PROTOCOL_DECODER_INITPROC(DVIDecoder)
 
 protected:
+	virtual Packet* CreatePacketView(size_t row);
+
+	///@brief Column indexes in the packet store, in GetHeaders() order
+	enum
+	{
+		COL_TYPE,
+		COL_WIDTH
+	};
+
+	///@brief Values of the type column
+	enum
+	{
+		TYPE_VIDEO,
+		TYPE_VSYNC
+	};
 };
 
 #endif
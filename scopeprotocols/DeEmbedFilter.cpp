@@ -408,7 +408,8 @@ int64_t DeEmbedFilter::GetGroupDelay()
 /**
 	@brief Recalculate the cached S-parameters (and clamp gain if requested)
 
-	Since there's no AVX sin/cos instructions, precompute sin(phase) and cos(phase)
+	The resampled rectangular form is cached by SParameterVector::ResampleUniform() so only the gain clamping is
+	redone unless the FFT size or the input S-parameters change.
  */
 void DeEmbedFilter::InterpolateSparameters(float bin_hz, bool invert, size_t nouts)
 {
@@ -416,64 +417,59 @@ void DeEmbedFilter::InterpolateSparameters(float bin_hz, bool invert, size_t nou
 
 	float maxGain = pow(10, m_parameters[m_maxGainName].GetFloatVal()/20);
 
-	//Extract the S-parameters
-	auto wmag = GetInputWaveform(1);
-	auto wang = GetInputWaveform(2);
-	wmag->PrepareForCpuAccess();
-	wang->PrepareForCpuAccess();
-
 	m_resampledSparamSines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_resampledSparamSines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 
 	m_resampledSparamCosines.SetCpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 	m_resampledSparamCosines.SetGpuAccessHint(AcceleratorBuffer<float>::HINT_LIKELY);
 
-	auto smag = dynamic_cast<SparseAnalogWaveform*>(wmag);
-	auto sang = dynamic_cast<SparseAnalogWaveform*>(wang);
-	auto umag = dynamic_cast<UniformAnalogWaveform*>(wmag);
-	auto uang = dynamic_cast<UniformAnalogWaveform*>(wang);
+	//Extract the S-parameters, but only if they actually changed since last time
+	auto wmag = GetInputWaveform(1);
+	auto wang = GetInputWaveform(2);
+	if( (m_loadedMagKey != wmag) || (m_loadedAngleKey != wang) )
+	{
+		wmag->PrepareForCpuAccess();
+		wang->PrepareForCpuAccess();
+		m_cachedSparams.LoadFromWaveforms(wmag, wang);
 
-	if(smag && sang)
-		m_cachedSparams.ConvertFromWaveforms(smag, sang);
-	else
-		m_cachedSparams.ConvertFromWaveforms(umag, uang);
+		m_loadedMagKey = wmag;
+		m_loadedAngleKey = wang;
+	}
+
+	//Resample to our FFT bins (no-op if neither the grid nor the S-parameters changed)
+	m_cachedSparams.ResampleUniform(0, bin_hz, nouts, m_resampledSparams);
+	m_resampledSparams.m_real.PrepareForCpuAccess();
+	m_resampledSparams.m_imag.PrepareForCpuAccess();
 
 	m_resampledSparamSines.resize(nouts);
 	m_resampledSparamCosines.resize(nouts);
+	m_resampledSparamSines.PrepareForCpuAccess();
+	m_resampledSparamCosines.PrepareForCpuAccess();
 
-	//De-embedding
+	//De-embedding: multiply by the reciprocal, clamping gain as requested
 	if(invert)
 	{
 		for(size_t i=0; i<nouts; i++)
 		{
-			float freq = bin_hz * i;
-			auto pt = m_cachedSparams.InterpolatePoint(freq);
-			float mag = pt.m_amplitude;
-			float ang = pt.m_phase;
-
-			float amp = 0;
-			if(fabs(mag) > FLT_EPSILON)
-				amp = 1.0f / mag;
-			amp = min(amp, maxGain);
-
-			m_resampledSparamSines[i] = sin(-ang) * amp;
-			m_resampledSparamCosines[i] = cos(-ang) * amp;
+			float re = m_resampledSparams.m_real[i];
+			float im = m_resampledSparams.m_imag[i];
+			float mag = sqrtf(re*re + im*im);
+
+			//1/(re + j*im) = (re - j*im) / mag^2
+			float scale = 0;
+			if(mag > FLT_EPSILON)
+				scale = min(1.0f / mag, maxGain) / mag;
+
+			m_resampledSparamSines[i] = -im * scale;
+			m_resampledSparamCosines[i] = re * scale;
 		}
 	}
 
 	//Channel emulation
 	else
 	{
-		for(size_t i=0; i<nouts; i++)
-		{
-			float freq = bin_hz * i;
-			auto pt = m_cachedSparams.InterpolatePoint(freq);
-			float mag = pt.m_amplitude;
-			float ang = pt.m_phase;
-
-			m_resampledSparamSines[i] = sin(ang) * mag;
-			m_resampledSparamCosines[i] = cos(ang) * mag;
-		}
+		memcpy(m_resampledSparamSines.GetCpuPointer(), m_resampledSparams.m_imag.GetCpuPointer(), nouts*sizeof(float));
+		memcpy(m_resampledSparamCosines.GetCpuPointer(), m_resampledSparams.m_real.GetCpuPointer(), nouts*sizeof(float));
 	}
 
 	m_resampledSparamSines.MarkModifiedFromCpu();
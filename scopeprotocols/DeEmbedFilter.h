@@ -98,6 +98,9 @@ protected:
 	WaveformCacheKey m_angleKey;
 
 	SParameterVector m_cachedSparams;
+	SParameterResampledVector m_resampledSparams;
+	WaveformCacheKey m_loadedMagKey;
+	WaveformCacheKey m_loadedAngleKey;
 
 	ComputePipeline m_rectangularComputePipeline;
 	ComputePipeline m_deEmbedComputePipeline;
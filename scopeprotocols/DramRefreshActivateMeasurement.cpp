@@ -79,58 +79,29 @@ void DramRefreshActivateMeasurement::Refresh()
 	auto din = dynamic_cast<SDRAMWaveform*>(GetInputWaveform(0));
 	din->PrepareForCpuAccess();
 
+	//The decoder measured the delay from refreshing each bank until the next activation to it
+	auto& events = din->m_refreshToActivate;
+	size_t len = events.size();
+	if(len == 0)
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
 	//Create the output
 	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0, true);
 	cap->PrepareForCpuAccess();
-
-	//Measure delay from refreshing a bank until an activation to the same bank
-	int64_t lastRef[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+	cap->Resize(len);
 
 	int64_t tlast = 0;
-	size_t len = din->m_samples.size();
 	for(size_t i=0; i<len; i++)
 	{
-		int64_t tnow = din->m_offsets[i] * din->m_timescale;
-
-		//Discard invalid bank IDs
-		auto sample = din->m_samples[i];
-		if( (sample.m_bank < 0) || (sample.m_bank > 8) )
-			continue;
-
-		//If it's a refresh, update the last refresh time
-		if(sample.m_stype == SDRAMSymbol::TYPE_REF)
-			lastRef[sample.m_bank] = din->m_offsets[i] * din->m_timescale;
-
-		//If it's an activate, measure the latency
-		else if(sample.m_stype == SDRAMSymbol::TYPE_ACT)
-		{
-			int64_t tact = din->m_offsets[i] * din->m_timescale;
-
-			//If the refresh command is before the start of the capture, ignore this event
-			int64_t tref= lastRef[sample.m_bank];
-			if(tref == 0)
-				continue;
-
-			//Valid access, measure the latency
-			cap->m_offsets.push_back(tlast);
-			cap->m_durations.push_back(tnow - tlast);
-			cap->m_samples.push_back(tact - tref);
-			tlast = tnow;
-
-			//Purge the last-refresh timestamp so we don't report false times for the next activate
-			lastRef[sample.m_bank] = 0;
-		}
+		cap->m_offsets[i] = tlast;
+		cap->m_durations[i] = events[i].m_time - tlast;
+		cap->m_samples[i] = events[i].m_latency;
+		tlast = events[i].m_time;
 	}
 
-	if(cap->m_samples.empty())
-	{
-		delete cap;
-		SetData(NULL, 0);
-		return;
-	}
-
-	SetData(cap, 0);
-
 	//Copy start time etc from the input. Timestamps are in femtoseconds.
 	cap->m_timescale = 1;
 	cap->m_startTimestamp = din->m_startTimestamp;
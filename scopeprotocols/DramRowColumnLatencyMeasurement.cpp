@@ -79,61 +79,29 @@ void DramRowColumnLatencyMeasurement::Refresh()
 	auto din = dynamic_cast<SDRAMWaveform*>(GetInputWaveform(0));
 	din->PrepareForCpuAccess();
 
+	//The decoder measured the delay from activating a row in each bank until the next read or write to it
+	auto& events = din->m_activateToColumn;
+	size_t len = events.size();
+	if(len == 0)
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
 	//Create the output
 	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0, true);
 	cap->PrepareForCpuAccess();
 	cap->m_timescale = 1;
-
-	//Measure delay from activating a row in a bank until a read or write to the same bank
-	int64_t lastAct[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+	cap->Resize(len);
 
 	int64_t tlast = 0;
-	size_t len = din->m_samples.size();
 	for(size_t i=0; i<len; i++)
 	{
-		int64_t tnow = din->m_offsets[i] * din->m_timescale;
-
-		//Discard invalid bank IDs
-		auto sample = din->m_samples[i];
-		if( (sample.m_bank < 0) || (sample.m_bank > 8) )
-			continue;
-
-		//If it's an activate, update the last activation time
-		if(sample.m_stype == SDRAMSymbol::TYPE_ACT)
-			lastAct[sample.m_bank] = tnow;
-
-		//If it's a read or write, measure the latency
-		else if( (sample.m_stype == SDRAMSymbol::TYPE_WR) |
-			(sample.m_stype == SDRAMSymbol::TYPE_WRA) |
-			(sample.m_stype == SDRAMSymbol::TYPE_RD) |
-			(sample.m_stype == SDRAMSymbol::TYPE_RDA) )
-		{
-			int64_t tcol = tnow;
-
-			//If the activate command is before the start of the capture, ignore this event
-			int64_t tact = lastAct[sample.m_bank];
-			if(tact == 0)
-				continue;
-
-			//Valid access, measure the latency
-			cap->m_offsets.push_back(tlast);
-			cap->m_durations.push_back(tnow - tlast);
-			cap->m_samples.push_back(tcol - tact);
-			tlast = tnow;
-
-			//Purge the last-refresh activate so we don't report false times for the next read or write
-			lastAct[sample.m_bank] = 0;
-		}
+		cap->m_offsets[i] = tlast;
+		cap->m_durations[i] = events[i].m_time - tlast;
+		cap->m_samples[i] = events[i].m_latency;
+		tlast = events[i].m_time;
 	}
 
-	if(cap->m_samples.empty())
-	{
-		delete cap;
-		SetData(NULL, 0);
-		return;
-	}
-
-	SetData(cap, 0);
-
 	cap->MarkModifiedFromCpu();
 }
@@ -77,10 +77,37 @@ void DutyCycleMeasurement::Refresh()
 		SetData(NULL, 0);
 		return;
 	}
+
 	auto din = GetInputWaveform(0);
+	din->PrepareForCpuAccess();
+
+	//Sequence acquisitions get one point per segment
+	if(RefreshSegmentBatch(din, [this](WaveformBase* seg, SparseAnalogWaveform* out) { return Measure(seg, out); }))
+		return;
+
+	//Create the output
+	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0, true);
+	cap->m_timescale = 1;
+	cap->PrepareForCpuAccess();
+	if(!Measure(din, cap))
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Measures one waveform into an empty, CPU-side output
+
+	@return False if there was nothing to measure
+ */
+bool DutyCycleMeasurement::Measure(WaveformBase* din, SparseAnalogWaveform* cap)
+{
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
-	din->PrepareForCpuAccess();
 
 	//Find average voltage of the waveform and use that as the zero crossing
 	float midpoint = GetAvgVoltage(sdin, udin);
@@ -92,15 +119,7 @@ void DutyCycleMeasurement::Refresh()
 	else
 		FindZeroCrossings(udin, midpoint, edges);
 	if(edges.size() < 2)
-	{
-		SetData(NULL, 0);
-		return;
-	}
-
-	//Create the output
-	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0, true);
-	cap->m_timescale = 1;
-	cap->PrepareForCpuAccess();
+		return false;
 
 	//Figure out edge polarity
 	bool initial_polarity = (GetValue(sdin, udin, 0) > midpoint);
@@ -130,7 +149,5 @@ void DutyCycleMeasurement::Refresh()
 		cap->m_samples.push_back(duty);
 	}
 
-	SetData(cap, 0);
-
-	cap->MarkModifiedFromCpu();
+	return true;
 }
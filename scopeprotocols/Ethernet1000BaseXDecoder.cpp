@@ -82,7 +82,7 @@ void Ethernet1000BaseXDecoder::Refresh()
 	data->PrepareForCpuAccess();
 
 	//Create the output capture
-	auto cap = new EthernetWaveform;
+	auto cap = SetupEmptyOutputWaveform<EthernetWaveform>(data, 0);
 	cap->m_timescale = data->m_timescale;
 	cap->m_startTimestamp = data->m_startTimestamp;
 	cap->m_startFemtoseconds = data->m_startFemtoseconds;
@@ -88,9 +88,8 @@ void Ethernet100BaseTXDecoder::Refresh()
 	clk->PrepareForCpuAccess();
 
 	//Sample the input on the edges of the recovered clock
-	SparseAnalogWaveform samples;
-	samples.PrepareForCpuAccess();
-	SampleOnAnyEdgesBase(din, clk, samples);
+	auto psamples = GetSampledOnAnyEdges<float>(din, clk);
+	auto& samples = *psamples;
 	size_t ilen = samples.size();
 
 	//MLT-3 decode
@@ -139,7 +138,7 @@ void Ethernet100BaseTXDecoder::Refresh()
 	}
 
 	//Copy our timestamps from the input. Output has femtosecond resolution since we sampled on clock edges
-	auto cap = new EthernetWaveform;
+	auto cap = SetupEmptyOutputWaveform<EthernetWaveform>(din, 0);
 	cap->m_timescale = 1;
 	cap->m_startTimestamp = din->m_startTimestamp;
 	cap->m_startFemtoseconds = din->m_startFemtoseconds;
@@ -72,7 +72,7 @@ void Ethernet10BaseTDecoder::Refresh()
 	din->PrepareForCpuAccess();
 
 	//Copy our time scales from the input
-	auto cap = new EthernetWaveform;
+	auto cap = SetupEmptyOutputWaveform<EthernetWaveform>(din, 0);
 	cap->m_timescale = din->m_timescale;
 	cap->m_startTimestamp = din->m_startTimestamp;
 	cap->m_startFemtoseconds = din->m_startFemtoseconds;
@@ -83,7 +83,7 @@ void Ethernet10GBaseRDecoder::Refresh()
 	data->PrepareForCpuAccess();
 
 	//Create the output capture
-	auto cap = new EthernetWaveform;
+	auto cap = SetupEmptyOutputWaveform<EthernetWaveform>(data, 0);
 	cap->m_timescale = data->m_timescale;
 	cap->m_startTimestamp = data->m_startTimestamp;
 	cap->m_startFemtoseconds = data->m_startFemtoseconds;
@@ -139,7 +139,7 @@ void Ethernet10GBaseRDecoder::Refresh()
 					{
 						cap->m_offsets.push_back(offsets[4]);
 						cap->m_durations.push_back(durations[4]);
-						cap->m_samples.push_back(EthernetFrameSegment(EthernetFrameSegment::TYPE_INVALID, 0));
+						cap->PushSymbol(EthernetFrameSegment(EthernetFrameSegment::TYPE_INVALID), 0);
 						continue;
 					}
 
@@ -148,7 +148,7 @@ void Ethernet10GBaseRDecoder::Refresh()
 					{
 						cap->m_offsets.push_back(offsets[4]);
 						cap->m_durations.push_back(durations[4]);
-						cap->m_samples.push_back(EthernetFrameSegment(EthernetFrameSegment::TYPE_INVALID, 0));
+						cap->PushSymbol(EthernetFrameSegment(EthernetFrameSegment::TYPE_INVALID), 0);
 						continue;
 					}
 
@@ -194,7 +194,7 @@ void Ethernet10GBaseRDecoder::Refresh()
 					//Add sample
 					cap->m_offsets.push_back(offsets[0]);
 					cap->m_durations.push_back(offsets[7] + durations[7] - offsets[0]);
-					cap->m_samples.push_back(EthernetFrameSegment(vtype, 0));
+					cap->PushSymbol(EthernetFrameSegment(vtype), 0);
 				}
 				break;
 
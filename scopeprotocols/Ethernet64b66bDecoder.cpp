@@ -34,6 +34,7 @@
  */
 
 #include "../scopehal/scopehal.h"
+#include "../scopehal/LineCoding.h"
 #include "Ethernet64b66bDecoder.h"
 
 using namespace std;
@@ -92,76 +93,41 @@ void Ethernet64b66bDecoder::Refresh()
 	cap->PrepareForCpuAccess();
 
 	//Record the value of the data stream at each clock edge
-	SparseDigitalWaveform data;
-	SampleOnAnyEdgesBase(din, clkin, data);
+	auto pdata = GetSampledOnAnyEdges<bool>(din, clkin);
+	auto& data = *pdata;
+
+	//Pack the sampled bits so we can work on 64 UIs at a time
+	size_t len = data.m_samples.size();
+	PackedBitstream bits;
+	if(len)
+		bits.Pack(&data.m_samples[0], len);
 
 	//Look at each phase and figure out block alignment
-	size_t end = data.size() - 66;
-	size_t best_offset = 0;
-	size_t best_errors = end;
-	for(size_t offset=0; offset < 66; offset ++)
-	{
-		size_t errors = 0;
-		for(size_t i=offset; i<end; i+= 66)
-		{
-			if(data.m_samples[i] == data.m_samples[i+1])
-				errors ++;
-		}
+	size_t end = (len > 66) ? len - 66 : 0;
+	size_t best_offset = LineCoding::FindBlockAlignment(bits, 66);
 
-		if(errors < best_errors)
-		{
-			best_offset = offset;
-			best_errors = errors;
-		}
+	//Decode the actual data
+	if(end > best_offset)
+	{
+		size_t nblocks = (end - best_offset + 65) / 66;
+		cap->m_offsets.reserve(nblocks);
+		cap->m_durations.reserve(nblocks);
+		cap->m_samples.reserve(nblocks);
 	}
 
-
-	//Decode the actual data
 	bool first		= true;
-	uint64_t lfsr	= 0;
-
+	uint64_t prev	= 0;
 	for(size_t i=best_offset; i<end; i += 66)
 	{
-		//Extract the header bits
-		uint8_t header =
-			(data.m_samples[i] ? 2 : 0) |
-			(data.m_samples[i+1] ? 1 : 0);
+		//Extract the header bits (first bit on the wire is the MSB)
+		uint8_t h = bits.Extract(i, 2);
+		uint8_t header = ( (h & 1) << 1) | (h >> 1);
 
 		//Extract the data bits and descramble them.
-		uint64_t codeword = 0;
-		for(size_t j=0; j<64; j++)
-		{
-			bool b = data.m_samples[i + 2 + j];
-
-			codeword >>= 1;
-			if(b ^ ( (lfsr >> 38) & 1) ^ ( (lfsr >> 57) & 1) )
-				codeword |= 0x8000000000000000L;
-
-			lfsr = (lfsr << 1) | b;
-		}
-
-		//Need to swap bit/byte ordering around a bunch.
-		uint64_t bytes[8] =
-		{
-			(codeword >> 56) & 0xff,
-			(codeword >> 48) & 0xff,
-			(codeword >> 40) & 0xff,
-			(codeword >> 32) & 0xff,
-			(codeword >> 24) & 0xff,
-			(codeword >> 16) & 0xff,
-			(codeword >> 8) & 0xff,
-			(codeword >> 0) & 0xff,
-		};
-
-		codeword =
-			(bytes[7] << 56) |
-			(bytes[6] << 48) |
-			(bytes[5] << 40) |
-			(bytes[4] << 32) |
-			(bytes[3] << 24) |
-			(bytes[2] << 16) |
-			(bytes[1] << 8) |
-			bytes[0];
+		//First bit on the wire ends up as the LSB, so swap byte ordering to put the first byte in the MSB.
+		uint64_t scrambled = bits.GetWindow(i + 2);
+		uint64_t codeword = __builtin_bswap64(LineCoding::Descramble64b66b(scrambled, prev));
+		prev = scrambled;
 
 		//Just prime the scrambler, we can't decode yet
 		if(first)
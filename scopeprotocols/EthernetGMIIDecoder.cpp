@@ -109,7 +109,7 @@ void EthernetGMIIDecoder::Refresh()
 	SampleOnRisingEdgesBase(data, clk, ddata);
 
 	//Create the output capture
-	auto cap = new EthernetWaveform;
+	auto cap = SetupEmptyOutputWaveform<EthernetWaveform>(data, 0);
 	cap->m_timescale = 1;
 	cap->m_startTimestamp = data->m_startTimestamp;
 	cap->m_startFemtoseconds = data->m_startFemtoseconds;
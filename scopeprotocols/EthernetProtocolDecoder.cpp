@@ -48,16 +48,18 @@ EthernetProtocolDecoder::EthernetProtocolDecoder(const string& color)
 	m_parameters[m_outfile].m_fileFilterName = "PCAP files (*.pcap)";
 	m_parameters[m_outfile].m_fileIsOutput = true;
 
-	m_fpOut = NULL;
+	m_pcapOut = NULL;
+
+	m_store.DeclareColumn("Dest MAC", PacketStore::COLUMN_MAC);
+	m_store.DeclareColumn("Src MAC", PacketStore::COLUMN_MAC);
+	m_store.DeclareColumn("VLAN", PacketStore::COLUMN_DECIMAL);
+	m_store.DeclareColumn("Ethertype", PacketStore::COLUMN_CUSTOM);
 }
 
 EthernetProtocolDecoder::~EthernetProtocolDecoder()
 {
-	if(m_fpOut)
-	{
-		fclose(m_fpOut);
-		m_fpOut = NULL;
-	}
+	PacketExporter::Close(m_pcapOut);
+	m_pcapOut = NULL;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -87,6 +89,56 @@ vector<string> EthernetProtocolDecoder::GetHeaders()
 	return ret;
 }
 
+/**
+	@brief Complete frames are exported as they're decoded, so just push them out to disk
+ */
+void EthernetProtocolDecoder::ExportPackets()
+{
+	if(m_pcapOut)
+		m_pcapOut->Commit();
+	if(m_exporter)
+		m_exporter->Commit();
+}
+
+uint16_t EthernetProtocolDecoder::GetExportLinkType()
+{
+	return PacketExporter::LINKTYPE_ETHERNET;
+}
+
+string EthernetProtocolDecoder::FormatHeader(size_t row, size_t col, uint64_t value)
+{
+	if(col != COL_ETHERTYPE)
+		return PacketDecoder::FormatHeader(row, col, value);
+
+	switch(value)
+	{
+		case ETHERTYPE_LLC:
+			return "LLC";
+
+		case ETHERTYPE_STP:
+			return "STP";
+
+		case 0x0800:
+			return "IPv4";
+
+		case 0x0806:
+			return "ARP";
+
+		case 0x8100:
+			return "802.1q";
+
+		case 0x86DD:
+			return "IPv6";
+
+		default:
+			{
+				char tmp[16];
+				snprintf(tmp, sizeof(tmp), "%04x", (unsigned int)value);
+				return tmp;
+			}
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual protocol decoding
 
@@ -96,39 +148,20 @@ void EthernetProtocolDecoder::BytesToFrames(
 		vector<uint64_t>& ends,
 		EthernetWaveform* cap)
 {
-	//Look up the file name, if any
+	//Look up the file names, if any
 	auto fname = m_parameters[m_outfile].GetFileName();
-	if(m_cachedOutputFname != fname)
+	if(fname != m_pcapName)
 	{
-		m_cachedOutputFname = fname;
-		if(m_fpOut)
-			fclose(m_fpOut);
-		m_fpOut = fopen(fname.c_str(), "wb");
-
-		//TODO: error logging if valid filename we can't open
-		//TODO: pull in libpcap headers and just write a pcap_hdr_s instead?
-		if(m_fpOut)
-		{
-			uint32_t magic = 0xa1b2c3d4;				//timestamps in sec+us
-			fwrite(&magic, sizeof(magic), 1, m_fpOut);
-			uint16_t major = 2;
-			uint16_t minor = 4;
-			fwrite(&major, sizeof(major), 1, m_fpOut);
-			fwrite(&minor, sizeof(minor), 1, m_fpOut);
-
-			int32_t reserved = 0;
-			fwrite(&reserved, sizeof(reserved), 1, m_fpOut);
-			fwrite(&reserved, sizeof(reserved), 1, m_fpOut);
-
-			uint32_t max_packet = 65535;
-			fwrite(&max_packet, sizeof(max_packet), 1, m_fpOut);
-
-			uint32_t network_type = 1;
-			fwrite(&network_type, sizeof(network_type), 1, m_fpOut);
-		}
+		PacketExporter::Close(m_pcapOut);
+		m_pcapOut = NULL;
+		m_pcapName = fname;
+		if(!fname.empty())
+			m_pcapOut = PacketExporter::Open(fname, PacketExporter::FORMAT_PCAP, GetExportLinkType());
 	}
+	auto exporter = GetExporter();
 
-	Packet* pack = new Packet;
+	//Headers are stored raw and only formatted if the packet is displayed (see FormatHeader())
+	size_t pack = AddPacket(0);
 
 	EthernetFrameSegment segment;
 	segment.m_type = EthernetFrameSegment::TYPE_INVALID;
@@ -154,11 +187,11 @@ void EthernetProtocolDecoder::BytesToFrames(
 				{
 					start = starts[i];
 					segment.m_type = EthernetFrameSegment::TYPE_PREAMBLE;
-					segment.m_data.clear();
-					segment.m_data.push_back(0x55);
+					segment.m_dataLen = 0;
+					cap->AppendSymbolData(segment, 0x55);
 
 					//Start a new packet
-					pack->m_offset = starts[i];
+					m_store.SetOffset(pack, starts[i]);
 				}
 				break;
 
@@ -177,49 +210,28 @@ void EthernetProtocolDecoder::BytesToFrames(
 					cap->m_offsets.push_back(start / cap->m_timescale);
 					cap->m_durations.push_back( (ends[i] - starts[i]) / cap->m_timescale);
 					segment.m_type = EthernetFrameSegment::TYPE_SFD;
-					segment.m_data.clear();
-					segment.m_data.push_back(0xd5);
+					segment.m_dataLen = 0;
+					cap->AppendSymbolData(segment, 0xd5);
 					cap->m_samples.push_back(segment);
 
 					//Set up for data
 					segment.m_type = EthernetFrameSegment::TYPE_DST_MAC;
-					segment.m_data.clear();
+					segment.m_dataLen = 0;
 
 					crcstart = i+1;
 
-					//Save to the PCAP file, if open
-					if(m_fpOut)
-					{
-						//Calculate the start time of the packet
-						time_t tstart = cap->m_startTimestamp;
-						int64_t fs = cap->m_startFemtoseconds + start;
-						if(fs >= FS_PER_SECOND)
-						{
-							tstart += (fs / FS_PER_SECOND);
-							fs %= (int64_t)FS_PER_SECOND;
-						}
-
-						//Convert timestamp to PCAP format: 32-bit sec + us
-						uint32_t sec = tstart;
-						uint32_t us = fs / 1000000000;
-						fwrite(&sec, sizeof(sec), 1, m_fpOut);
-						fwrite(&us, sizeof(us), 1, m_fpOut);
-
-						//Length of the packet (not including preamble or SFD, which we truncate)
-						//Write twice: captured length and actual length
-						uint32_t packet_len = bytes.size() - (i+1);
-						fwrite(&packet_len, sizeof(packet_len), 1, m_fpOut);
-						fwrite(&packet_len, sizeof(packet_len), 1, m_fpOut);
-
-						//Write the actual packet data
-						fwrite(&bytes[i+1], packet_len, 1, m_fpOut);
-						fflush(m_fpOut);
-					}
+					//Save the frame (not including preamble or SFD, which we truncate) to the capture files, if open
+					size_t packet_len = bytes.size() - (i+1);
+					int64_t fs = cap->m_startFemtoseconds + start;
+					if(m_pcapOut)
+						m_pcapOut->WritePacket(0, cap->m_startTimestamp, fs, &bytes[i+1], packet_len);
+					if(exporter)
+						exporter->WritePacket(m_exportInterface, cap->m_startTimestamp, fs, &bytes[i+1], packet_len);
 				}
 
 				//No SFD, just add the preamble byte
 				else if(bytes[i] == 0x55)
-					segment.m_data.push_back(0x55);
+					cap->AppendSymbolData(segment, 0x55);
 
 				//Garbage (TODO: handle this better)
 				else
@@ -232,35 +244,30 @@ void EthernetProtocolDecoder::BytesToFrames(
 			case EthernetFrameSegment::TYPE_DST_MAC:
 
 				//Start of MAC? Record start time
-				if(segment.m_data.empty())
+				if(segment.m_dataLen == 0)
 				{
 					start = starts[i];
 					cap->m_offsets.push_back(start / cap->m_timescale);
 				}
 
 				//Add the data
-				segment.m_data.push_back(bytes[i]);
+				cap->AppendSymbolData(segment, bytes[i]);
 
 				//Are we done? Add it
-				if(segment.m_data.size() == 6)
+				if(segment.m_dataLen == 6)
 				{
 					cap->m_durations.push_back( (ends[i] - start) / cap->m_timescale );
 					cap->m_samples.push_back(segment);
 
-					//Format the content for display
-					char tmp[64];
-					snprintf(tmp, sizeof(tmp), "%02x:%02x:%02x:%02x:%02x:%02x",
-						segment.m_data[0],
-						segment.m_data[1],
-						segment.m_data[2],
-						segment.m_data[3],
-						segment.m_data[4],
-						segment.m_data[5]);
-					pack->m_headers["Dest MAC"] = tmp;
+					uint64_t mac = 0;
+					auto sdata = cap->GetSymbolData(segment);
+					for(size_t j=0; j<6; j++)
+						mac = (mac << 8) | sdata[j];
+					m_store.SetValue(pack, COL_DEST_MAC, mac);
 
 					//Reset for next block of the frame
 					segment.m_type = EthernetFrameSegment::TYPE_SRC_MAC;
-					segment.m_data.clear();
+					segment.m_dataLen = 0;
 				}
 
 				break;
@@ -268,35 +275,30 @@ void EthernetProtocolDecoder::BytesToFrames(
 			case EthernetFrameSegment::TYPE_SRC_MAC:
 
 				//Start of MAC? Record start time
-				if(segment.m_data.empty())
+				if(segment.m_dataLen == 0)
 				{
 					start = starts[i];
 					cap->m_offsets.push_back(start / cap->m_timescale);
 				}
 
 				//Add the data
-				segment.m_data.push_back(bytes[i]);
+				cap->AppendSymbolData(segment, bytes[i]);
 
 				//Are we done? Add it
-				if(segment.m_data.size() == 6)
+				if(segment.m_dataLen == 6)
 				{
 					cap->m_durations.push_back( (ends[i] - start) / cap->m_timescale);
 					cap->m_samples.push_back(segment);
 
-					//Format the content for display
-					char tmp[64];
-					snprintf(tmp, sizeof(tmp),"%02x:%02x:%02x:%02x:%02x:%02x",
-						segment.m_data[0],
-						segment.m_data[1],
-						segment.m_data[2],
-						segment.m_data[3],
-						segment.m_data[4],
-						segment.m_data[5]);
-					pack->m_headers["Src MAC"] = tmp;
+					uint64_t mac = 0;
+					auto sdata = cap->GetSymbolData(segment);
+					for(size_t j=0; j<6; j++)
+						mac = (mac << 8) | sdata[j];
+					m_store.SetValue(pack, COL_SRC_MAC, mac);
 
 					//Reset for next block of the frame
 					segment.m_type = EthernetFrameSegment::TYPE_ETHERTYPE;
-					segment.m_data.clear();
+					segment.m_dataLen = 0;
 				}
 
 				break;
@@ -304,17 +306,17 @@ void EthernetProtocolDecoder::BytesToFrames(
 			case EthernetFrameSegment::TYPE_ETHERTYPE:
 
 				//Start of Ethertype? Record start time
-				if(segment.m_data.empty())
+				if(segment.m_dataLen == 0)
 				{
 					start = starts[i] ;
 					cap->m_offsets.push_back(start / cap->m_timescale);
 				}
 
 				//Add the data
-				segment.m_data.push_back(bytes[i]);
+				cap->AppendSymbolData(segment, bytes[i]);
 
 				//Are we done? Add it
-				if(segment.m_data.size() == 2)
+				if(segment.m_dataLen == 2)
 				{
 					cap->m_durations.push_back( (ends[i] - start) / cap->m_timescale);
 					cap->m_samples.push_back(segment);
@@ -328,69 +330,62 @@ void EthernetProtocolDecoder::BytesToFrames(
 						#cab2d6
 						#6a3d9a
 					 */
-					uint16_t ethertype = (segment.m_data[0] << 8) | segment.m_data[1];
+					auto sdata = cap->GetSymbolData(segment);
+					uint16_t ethertype = (sdata[0] << 8) | sdata[1];
 					if(ethertype < 1500)
 					{
 						//Default to unknown LLC
-						pack->m_headers["Ethertype"] = "LLC";
-						pack->m_displayBackgroundColor = Gdk::Color("#33a02c");
-						pack->m_displayForegroundColor = Gdk::Color("#000000");
+						m_store.SetValue(pack, COL_ETHERTYPE, ETHERTYPE_LLC);
+						m_store.SetBackgroundColor(pack, Gdk::Color("#33a02c"));
+						m_store.SetForegroundColor(pack, Gdk::Color("#000000"));
 
 						//Look up the LLC LSAP address to see what it is
 						if( (i+1) < bytes.size() )
 						{
 							if(bytes[i+1] == 0x42)
 							{
-								pack->m_headers["Ethertype"] = "STP";
-								pack->m_displayBackgroundColor = Gdk::Color("#fdbf6f");
-								pack->m_displayForegroundColor = Gdk::Color("#000000");
+								m_store.SetValue(pack, COL_ETHERTYPE, ETHERTYPE_STP);
+								m_store.SetBackgroundColor(pack, Gdk::Color("#fdbf6f"));
+								m_store.SetForegroundColor(pack, Gdk::Color("#000000"));
 							}
 						}
 					}
 					else
 					{
-						char tmp[64];
+						m_store.SetValue(pack, COL_ETHERTYPE, ethertype);
 						switch(ethertype)
 						{
 							case 0x0800:
-								pack->m_headers["Ethertype"] = "IPv4";
-								pack->m_displayBackgroundColor = Gdk::Color("#a6cee3");
-								pack->m_displayForegroundColor = Gdk::Color("#000000");
+								m_store.SetBackgroundColor(pack, Gdk::Color("#a6cee3"));
+								m_store.SetForegroundColor(pack, Gdk::Color("#000000"));
 								break;
 
 							case 0x0806:
-								pack->m_headers["Ethertype"] = "ARP";
-								pack->m_displayBackgroundColor = Gdk::Color("#ffff99");
-								pack->m_displayForegroundColor = Gdk::Color("#000000");
+								m_store.SetBackgroundColor(pack, Gdk::Color("#ffff99"));
+								m_store.SetForegroundColor(pack, Gdk::Color("#000000"));
 								break;
 
 							//TODO: decoder inner ethertype too?
 							case 0x8100:
-								pack->m_headers["Ethertype"] = "802.1q";
-								pack->m_displayBackgroundColor = Gdk::Color("#b2df8a");
-								pack->m_displayForegroundColor = Gdk::Color("#000000");
+								m_store.SetBackgroundColor(pack, Gdk::Color("#b2df8a"));
+								m_store.SetForegroundColor(pack, Gdk::Color("#000000"));
 								break;
 
 							case 0x86DD:
-								pack->m_headers["Ethertype"] = "IPv6";
-								pack->m_displayBackgroundColor = Gdk::Color("#1f78b4");
-								pack->m_displayForegroundColor = Gdk::Color("#ffffff");
+								m_store.SetBackgroundColor(pack, Gdk::Color("#1f78b4"));
+								m_store.SetForegroundColor(pack, Gdk::Color("#ffffff"));
 								break;
 
 							default:
-								snprintf(tmp, sizeof(tmp), "%02x%02x",
-								segment.m_data[0],
-								segment.m_data[1]);
-								pack->m_headers["Ethertype"] = tmp;
-								pack->m_displayBackgroundColor = Gdk::Color("#fb9a99");
-								pack->m_displayForegroundColor = Gdk::Color("#000000");
+								m_store.SetBackgroundColor(pack, Gdk::Color("#fb9a99"));
+								m_store.SetForegroundColor(pack, Gdk::Color("#000000"));
 								break;
 						}
 					}
 
 					//Reset for next block of the frame
 					segment.m_type = EthernetFrameSegment::TYPE_PAYLOAD;
-					segment.m_data.clear();
+					segment.m_dataLen = 0;
 
 					//It's an 802.1q tag, decode the VLAN header
 					if(ethertype == 0x8100)
@@ -402,31 +397,29 @@ void EthernetProtocolDecoder::BytesToFrames(
 			case EthernetFrameSegment::TYPE_VLAN_TAG:
 
 				//Start of tag? Record start time
-				if(segment.m_data.empty())
+				if(segment.m_dataLen == 0)
 				{
 					start = starts[i];
 					cap->m_offsets.push_back(start / cap->m_timescale);
 				}
 
 				//Add the data
-				segment.m_data.push_back(bytes[i]);
+				cap->AppendSymbolData(segment, bytes[i]);
 
 				//Are we done? Add it
-				if(segment.m_data.size() == 2)
+				if(segment.m_dataLen == 2)
 				{
 					cap->m_durations.push_back( (ends[i] - start) / cap->m_timescale);
 					cap->m_samples.push_back(segment);
 
-					uint16_t tag = (segment.m_data[0] << 8) | segment.m_data[1];
+					auto sdata = cap->GetSymbolData(segment);
+					uint16_t tag = (sdata[0] << 8) | sdata[1];
 
 					//Reset for the internal ethertype
 					segment.m_type = EthernetFrameSegment::TYPE_ETHERTYPE;
-					segment.m_data.clear();
+					segment.m_dataLen = 0;
 
-					//Format the content for display
-					char tmp[64];
-					snprintf(tmp, sizeof(tmp),"%d", tag & 0xfff);
-					pack->m_headers["VLAN"] = tmp;
+					m_store.SetValue(pack, COL_VLAN, tag & 0xfff);
 				}
 
 				break;
@@ -439,16 +432,16 @@ void EthernetProtocolDecoder::BytesToFrames(
 				cap->m_offsets.push_back(start / cap->m_timescale);
 				cap->m_durations.push_back( (ends[i] - start) / cap->m_timescale);
 				segment.m_type = EthernetFrameSegment::TYPE_PAYLOAD;
-				segment.m_data.clear();
-				segment.m_data.push_back(bytes[i]);
+				segment.m_dataLen = 0;
+				cap->AppendSymbolData(segment, bytes[i]);
 				cap->m_samples.push_back(segment);
 
-				pack->m_data.push_back(bytes[i]);
+				m_store.AppendData(bytes[i]);
 
 				//If almost at end of packet, next 4 bytes are FCS
 				if(i == bytes.size() - 5)
 				{
-					segment.m_data.clear();
+					segment.m_dataLen = 0;
 					segment.m_type = EthernetFrameSegment::TYPE_FCS_GOOD;
 				}
 				break;
@@ -456,7 +449,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 			case EthernetFrameSegment::TYPE_FCS_GOOD:
 
 				//Start of FCS? Record start time
-				if(segment.m_data.empty())
+				if(segment.m_dataLen == 0)
 				{
 					crc_expected = CRC32(&bytes[0], crcstart, i-1);
 
@@ -465,25 +458,24 @@ void EthernetProtocolDecoder::BytesToFrames(
 				}
 
 				//Add the data
-				segment.m_data.push_back(bytes[i]);
+				cap->AppendSymbolData(segment, bytes[i]);
 				crc_actual = (crc_actual << 8) | bytes[i];
 
 				//Are we done? Add it
-				if(segment.m_data.size() == 4)
+				if(segment.m_dataLen == 4)
 				{
 					//Validate CRC
 					if(crc_actual != crc_expected)
 					{
 						segment.m_type = EthernetFrameSegment::TYPE_FCS_BAD;
-						pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
-						pack->m_displayForegroundColor = Gdk::Color("#ffffff");
+						m_store.SetBackgroundColor(pack, m_backgroundColors[PROTO_COLOR_ERROR]);
+						m_store.SetForegroundColor(pack, Gdk::Color("#ffffff"));
 					}
 
 					cap->m_durations.push_back( (ends[i] - start)/ cap->m_timescale);
 					cap->m_samples.push_back(segment);
 
-					pack->m_len = ends[i] - pack->m_offset;
-					m_packets.push_back(pack);
+					m_store.SetLength(pack, ends[i] - m_store.GetOffset(pack));
 					return;
 				}
 
@@ -495,7 +487,7 @@ void EthernetProtocolDecoder::BytesToFrames(
 	}
 
 	//If we get here it wasn't a valid frame
-	delete pack;
+	m_store.RemoveLastPacket();
 }
 
 Gdk::Color EthernetWaveform::GetColor(size_t i)
@@ -541,6 +533,7 @@ string EthernetWaveform::GetText(size_t i)
 	char tmp[128];
 
 	auto sample = m_samples[i];
+	auto data = GetSymbolData(i);
 	switch(sample.m_type)
 	{
 		case EthernetFrameSegment::TYPE_PREAMBLE:
@@ -554,37 +547,37 @@ string EthernetWaveform::GetText(size_t i)
 
 		case EthernetFrameSegment::TYPE_DST_MAC:
 			{
-				if(sample.m_data.size() != 6)
+				if(sample.m_dataLen != 6)
 					return "[invalid dest MAC length]";
 
 				snprintf(tmp, sizeof(tmp), "To %02x:%02x:%02x:%02x:%02x:%02x",
-					sample.m_data[0],
-					sample.m_data[1],
-					sample.m_data[2],
-					sample.m_data[3],
-					sample.m_data[4],
-					sample.m_data[5]);
+					data[0],
+					data[1],
+					data[2],
+					data[3],
+					data[4],
+					data[5]);
 				return tmp;
 			}
 
 		case EthernetFrameSegment::TYPE_SRC_MAC:
 			{
-				if(sample.m_data.size() != 6)
+				if(sample.m_dataLen != 6)
 					return "[invalid src MAC length]";
 
 				snprintf(tmp, sizeof(tmp), "From %02x:%02x:%02x:%02x:%02x:%02x",
-					sample.m_data[0],
-					sample.m_data[1],
-					sample.m_data[2],
-					sample.m_data[3],
-					sample.m_data[4],
-					sample.m_data[5]);
+					data[0],
+					data[1],
+					data[2],
+					data[3],
+					data[4],
+					data[5]);
 				return tmp;
 			}
 
 		case EthernetFrameSegment::TYPE_VLAN_TAG:
 			{
-				uint16_t tag = (sample.m_data[0] << 8) | sample.m_data[1];
+				uint16_t tag = (data[0] << 8) | data[1];
 
 				snprintf(tmp, sizeof(tmp), "VLAN %d, PCP %d",
 					tag & 0xfff, tag >> 13);
@@ -598,12 +591,12 @@ string EthernetWaveform::GetText(size_t i)
 
 		case EthernetFrameSegment::TYPE_ETHERTYPE:
 			{
-				if(sample.m_data.size() != 2)
+				if(sample.m_dataLen != 2)
 					return "[invalid Ethertype length]";
 
 				string type = "Type: ";
 
-				uint16_t ethertype = (sample.m_data[0] << 8) | sample.m_data[1];
+				uint16_t ethertype = (data[0] << 8) | data[1];
 
 				//It's not actually an ethertype, it's a LLC frame.
 				if(ethertype < 1500)
@@ -611,8 +604,7 @@ string EthernetWaveform::GetText(size_t i)
 					//Look at the next segment to get the payload
 					if((size_t)i+1 < m_samples.size())
 					{
-						auto& next = m_samples[i+1];
-						if(next.m_data[0] == 0x42)
+						if(GetSymbolData(i+1)[0] == 0x42)
 							type += "STP";
 						else
 							type += "LLC";
@@ -662,9 +654,9 @@ string EthernetWaveform::GetText(size_t i)
 		case EthernetFrameSegment::TYPE_PAYLOAD:
 			{
 				string ret;
-				for(auto b : sample.m_data)
+				for(size_t j=0; j<sample.m_dataLen; j++)
 				{
-					snprintf(tmp, sizeof(tmp), "%02x ", b);
+					snprintf(tmp, sizeof(tmp), "%02x ", data[j]);
 					ret += tmp;
 				}
 				return ret;
@@ -672,7 +664,7 @@ string EthernetWaveform::GetText(size_t i)
 
 		case EthernetFrameSegment::TYPE_INBAND_STATUS:
 			{
-				int status = sample.m_data[0];
+				int status = data[0];
 
 				int up = status & 1;
 				int rawspeed = (status >> 1) & 3;
@@ -695,14 +687,14 @@ string EthernetWaveform::GetText(size_t i)
 		case EthernetFrameSegment::TYPE_FCS_GOOD:
 		case EthernetFrameSegment::TYPE_FCS_BAD:
 			{
-				if(sample.m_data.size() != 4)
+				if(sample.m_dataLen != 4)
 					return "[invalid FCS length]";
 
 				snprintf(tmp, sizeof(tmp), "CRC: %02x%02x%02x%02x",
-					sample.m_data[0],
-					sample.m_data[1],
-					sample.m_data[2],
-					sample.m_data[3]);
+					data[0],
+					data[1],
+					data[2],
+					data[3]);
 				return tmp;
 			}
 
@@ -39,8 +39,10 @@
 
 /**
 	@brief Part of an Ethernet frame (speed doesn't matter)
+
+	Segment bytes live in the EthernetWaveform's arena (see EthernetWaveform::GetSymbolData()).
  */
-class EthernetFrameSegment
+class EthernetFrameSegment : public ArenaSymbol
 {
 public:
 	enum SegmentType
@@ -62,25 +64,18 @@ public:
 		TYPE_LINK_INTERRUPTION
 	} m_type;
 
-	std::vector<uint8_t> m_data;
-
 	EthernetFrameSegment()
 	{}
 
-	EthernetFrameSegment(SegmentType type, uint8_t value)
+	EthernetFrameSegment(SegmentType type)
 		: m_type(type)
-	{ m_data.push_back(value); }
-
-	bool operator==(const EthernetFrameSegment& rhs) const
-	{
-		return (m_data == rhs.m_data) && (m_type == rhs.m_type);
-	}
+	{}
 };
 
-class EthernetWaveform : public SparseWaveform<EthernetFrameSegment>
+class EthernetWaveform : public ArenaSparseWaveform<EthernetFrameSegment>
 {
 public:
-	EthernetWaveform () : SparseWaveform<EthernetFrameSegment>() {};
+	EthernetWaveform () : ArenaSparseWaveform<EthernetFrameSegment>() {};
 	virtual std::string GetText(size_t) override;
 	virtual Gdk::Color GetColor(size_t) override;
 };
@@ -96,6 +91,26 @@ public:
 	virtual std::vector<std::string> GetHeaders();
 
 protected:
+	virtual std::string FormatHeader(size_t row, size_t col, uint64_t value);
+	virtual void ExportPackets();
+	virtual uint16_t GetExportLinkType();
+
+	///@brief Column indexes in the packet store, in GetHeaders() order
+	enum
+	{
+		COL_DEST_MAC,
+		COL_SRC_MAC,
+		COL_VLAN,
+		COL_ETHERTYPE
+	};
+
+	///@brief Ethertype column values for frames with a length field rather than an ethertype
+	enum
+	{
+		ETHERTYPE_LLC = 0x10000,
+		ETHERTYPE_STP = 0x10042
+	};
+
 	void BytesToFrames(
 		std::vector<uint8_t>& bytes,
 		std::vector<uint64_t>& starts,
@@ -103,8 +118,12 @@ protected:
 		EthernetWaveform* cap);
 
 	std::string m_outfile;
-	std::string m_cachedOutputFname;
-	FILE* m_fpOut;
+
+	///@brief Legacy PCAP output (complete frames, written as they're decoded)
+	PacketExporter* m_pcapOut;
+
+	///@brief File name m_pcapOut was last opened for
+	std::string m_pcapName;
 };
 
 #endif
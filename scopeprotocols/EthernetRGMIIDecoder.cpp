@@ -117,7 +117,7 @@ void EthernetRGMIIDecoder::Refresh()
 	len -= 4;
 
 	//Create the output capture
-	auto cap = new EthernetWaveform;
+	auto cap = SetupEmptyOutputWaveform<EthernetWaveform>(data, 0);
 	cap->m_timescale = 1;
 	cap->m_startTimestamp = data->m_startTimestamp;
 	cap->m_startFemtoseconds = data->m_startFemtoseconds;
@@ -144,7 +144,7 @@ void EthernetRGMIIDecoder::Refresh()
 			{
 				auto& sample = cap->m_samples[last];
 				if( (sample.m_type == EthernetFrameSegment::TYPE_INBAND_STATUS) &&
-					(sample.m_data[0] == status) )
+					(cap->GetSymbolData(sample)[0] == status) )
 				{
 					extend = true;
 				}
@@ -157,7 +157,7 @@ void EthernetRGMIIDecoder::Refresh()
 			{
 				cap->m_offsets.push_back(ddata.m_offsets[i]);
 				cap->m_durations.push_back(ddata.m_durations[i]);
-				cap->m_samples.push_back(EthernetFrameSegment(EthernetFrameSegment::TYPE_INBAND_STATUS, status));
+				cap->PushSymbol(EthernetFrameSegment(EthernetFrameSegment::TYPE_INBAND_STATUS), status);
 			}
 
 			continue;
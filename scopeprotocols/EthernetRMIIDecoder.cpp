@@ -110,7 +110,7 @@ void EthernetRMIIDecoder::Refresh()
 	len -= 4;	//we read past current position to get a full byte
 
 	//Create the output capture
-	auto cap = new EthernetWaveform;
+	auto cap = SetupEmptyOutputWaveform<EthernetWaveform>(clk, 0);
 	cap->m_timescale = 1;
 	cap->m_startTimestamp = clk->m_startTimestamp;
 	cap->m_startFemtoseconds = clk->m_startFemtoseconds;
@@ -193,6 +193,51 @@ void EyeMask::RenderForAnalysis(
 	RenderInternal(cr, waveform, xscale, xoff, yscale, yoff, height);
 }
 
+/**
+	@brief Rasterizes the mask into a packed bitmap, one bit per eye pattern pixel
+
+	Uses the same geometry as RenderForAnalysis(). Each row is GetBitmapStride(width) words long, and bit (x % 64)
+	of word (x / 64) is set if pixel x lies inside the mask.
+ */
+void EyeMask::Rasterize(
+	vector<uint64_t>& bits,
+	size_t width,
+	size_t height,
+	EyeWaveform* waveform,
+	float xscale,
+	float xoff,
+	float yscale) const
+{
+	//Render with Cairo, then pack
+	Cairo::RefPtr< Cairo::ImageSurface > surface =
+		Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+	Cairo::RefPtr< Cairo::Context > cr = Cairo::Context::create(surface);
+
+	cr->set_source_rgba(0, 0, 0, 1);
+	cr->rectangle(0, 0, width, height);
+	cr->fill();
+
+	RenderForAnalysis(cr, waveform, xscale, xoff, yscale, 0, height);
+	surface->flush();
+
+	size_t wordsPerRow = GetBitmapStride(width);
+	bits.assign(wordsPerRow * height, 0);
+
+	uint32_t* data = reinterpret_cast<uint32_t*>(surface->get_data());
+	int stride = surface->get_stride() / sizeof(uint32_t);
+	for(size_t y=0; y<height; y++)
+	{
+		auto row = data + (y*stride);
+		auto bitrow = &bits[y*wordsPerRow];
+		for(size_t x=0; x<width; x++)
+		{
+			//If mask pixel isn't black, it's part of the mask
+			if( (row[x] & 0xff) != 0)
+				bitrow[x / 64] |= (1ULL << (x % 64));
+		}
+	}
+}
+
 void EyeMask::RenderInternal(
 		Cairo::RefPtr<Cairo::Context> cr,
 		EyeWaveform* waveform,
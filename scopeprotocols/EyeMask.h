@@ -104,6 +104,21 @@ public:
 		float yoff,
 		float height) const;
 
+	void Rasterize(
+		std::vector<uint64_t>& bits,
+		size_t width,
+		size_t height,
+		EyeWaveform* waveform,
+		float xscale,
+		float xoff,
+		float yscale) const;
+
+	/**
+		@brief Number of 64-bit words in each row of a bitmap from Rasterize()
+	 */
+	static size_t GetBitmapStride(size_t width)
+	{ return (width + 63) / 64; }
+
 protected:
 	void RenderInternal(
 		Cairo::RefPtr<Cairo::Context> cr,
@@ -30,12 +30,33 @@
 #include "../scopehal/scopehal.h"
 #include "EyePattern.h"
 #include <algorithm>
+#include <omp.h>
 #ifdef __x86_64__
 #include <immintrin.h>
 #endif
 
 using namespace std;
 
+/**
+	@brief Cleans up rounding artifacts in the rightmost columns of the eye
+
+	Shared by the accumulator and the integration tiles, since mask hit counting on a tile has to see exactly what
+	the tile will look like once it's merged.
+ */
+template<class T>
+static void FixupRightColumns(T* data, size_t width, size_t height, size_t delta)
+{
+	size_t xmax = width - 1;
+	size_t xstart = xmax - delta;
+	size_t xend = xmax;
+	for(size_t y=0; y<height; y++)
+	{
+		T* row = data + y*width;
+		for(size_t x=xstart; x<=xend; x++)
+			row[x] = row[x-delta];
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -47,6 +68,9 @@ EyeWaveform::EyeWaveform(size_t width, size_t height, float center)
 	, m_totalUIs(0)
 	, m_centerVoltage(center)
 	, m_maskHitRate(0)
+	, m_maskGeneration(0)
+	, m_maskHits(0)
+	, m_maskTotal(0)
 {
 	size_t npix = width*height;
 	m_accumdata = new int64_t[npix];
@@ -77,8 +101,12 @@ void EyeWaveform::Normalize()
 		int64_t* row = m_accumdata + y*m_width;
 
 		//Find peak amplitude
-		for(size_t x=halfwidth; x<m_width; x++)
-			nmax = max(row[x], nmax);
+		#ifdef __x86_64__
+		if(g_hasAvx2)
+			nmax = max(FindPeakAVX2(row + halfwidth, m_width - halfwidth), nmax);
+		else
+		#endif
+			nmax = max(FindPeakGeneric(row + halfwidth, m_width - halfwidth), nmax);
 
 		//Copy right half to left half
 		memcpy(row, row+halfwidth, blocksize);
@@ -93,11 +121,93 @@ void EyeWaveform::Normalize()
 		2.0 means mapping values to [0, 2] and saturating anything above 1.
 	 */
 	norm *= m_saturationLevel;
+	#ifdef __x86_64__
+	if(g_hasAvx2)
+		ScaleOutputAVX2(norm);
+	else
+	#endif
+		ScaleOutputGeneric(norm);
+}
+
+int64_t EyeWaveform::FindPeakGeneric(const int64_t* row, size_t len)
+{
+	int64_t nmax = 0;
+	for(size_t x=0; x<len; x++)
+		nmax = max(row[x], nmax);
+	return nmax;
+}
+
+void EyeWaveform::ScaleOutputGeneric(float norm)
+{
 	size_t len = m_width * m_height;
 	for(size_t i=0; i<len; i++)
 		m_outdata[i] = min(1.0f, m_accumdata[i] * norm);
 }
 
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+int64_t EyeWaveform::FindPeakAVX2(const int64_t* row, size_t len)
+{
+	size_t len_rounded = len - (len % 4);
+
+	//AVX2 has no 64-bit max, so do it with a compare and blend
+	__m256i vmax = _mm256_setzero_si256();
+	size_t x = 0;
+	for(; x<len_rounded; x += 4)
+	{
+		__m256i v		= _mm256_loadu_si256((const __m256i*)(row + x));
+		__m256i gt		= _mm256_cmpgt_epi64(v, vmax);
+		vmax			= _mm256_blendv_epi8(vmax, v, gt);
+	}
+
+	int64_t lanes[4] __attribute__((aligned(32)));
+	_mm256_store_si256((__m256i*)lanes, vmax);
+	int64_t nmax = max(max(lanes[0], lanes[1]), max(lanes[2], lanes[3]));
+
+	//Catch any stragglers
+	for(; x<len; x++)
+		nmax = max(row[x], nmax);
+	return nmax;
+}
+
+__attribute__((target("avx2")))
+void EyeWaveform::ScaleOutputAVX2(float norm)
+{
+	size_t len = m_width * m_height;
+	size_t len_rounded = len - (len % 8);
+
+	/*
+		There's no 64-bit integer to float conversion in AVX2. Bin counts are non-negative and way under 2^52,
+		so OR them into the mantissa of 2^52 and subtract 2^52 to get an exact double.
+	 */
+	__m256i vmagici		= _mm256_set1_epi64x(0x4330000000000000LL);
+	__m256d vmagicd		= _mm256_set1_pd(4503599627370496.0);
+	__m256d vnorm		= _mm256_set1_pd(norm);
+	__m256 vone			= _mm256_set1_ps(1);
+
+	size_t i = 0;
+	for(; i<len_rounded; i += 8)
+	{
+		__m256i vlo		= _mm256_loadu_si256((const __m256i*)(m_accumdata + i));
+		__m256i vhi		= _mm256_loadu_si256((const __m256i*)(m_accumdata + i + 4));
+
+		__m256d dlo		= _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(vlo, vmagici)), vmagicd);
+		__m256d dhi		= _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(vhi, vmagici)), vmagicd);
+		dlo				= _mm256_mul_pd(dlo, vnorm);
+		dhi				= _mm256_mul_pd(dhi, vnorm);
+
+		__m256 out		= _mm256_castps128_ps256(_mm256_cvtpd_ps(dlo));
+		out				= _mm256_insertf128_ps(out, _mm256_cvtpd_ps(dhi), 1);
+		out				= _mm256_min_ps(out, vone);
+		_mm256_storeu_ps(m_outdata + i, out);
+	}
+
+	//Catch any stragglers
+	for(; i<len; i++)
+		m_outdata[i] = min(1.0f, m_accumdata[i] * norm);
+}
+#endif /* __x86_64__ */
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -117,6 +227,13 @@ EyePattern::EyePattern(const string& color)
 	, m_clockAlignName("Clock Alignment")
 	, m_rateModeName("Bit Rate Mode")
 	, m_rateName("Bit Rate")
+	, m_maskGeneration(0)
+	, m_maskBitsWidth(0)
+	, m_maskBitsHeight(0)
+	, m_maskBitsXScale(0)
+	, m_maskBitsXOff(0)
+	, m_maskBitsYScale(0)
+	, m_maskBitsUIWidth(0)
 {
 	AddStream(Unit(Unit::UNIT_COUNTS), "data", Stream::STREAM_TYPE_EYE);
 	CreateInput("din");
@@ -456,51 +573,25 @@ void EyePattern::Refresh()
 	float yoff = -center*yscale + ymid;
 	float xtimescale = waveform->m_timescale * m_xscale;
 
+	//If we have an eye mask, prepare it for processing
+	bool maskTest = false;
+	if(m_mask.GetFileName() != "")
+		maskTest = PrepareMaskTest(cap);
+
 	//Process the eye
-	size_t cend = clock_edges.size() - 1;
-	size_t wend = waveform->size()-1;
 	int32_t ymax = m_height - 1;
 	int32_t xmax = m_width - 1;
-	auto swfm = dynamic_cast<SparseAnalogWaveform*>(waveform);
-	auto uwfm = dynamic_cast<UniformAnalogWaveform*>(waveform);
 	if(m_xscale > FLT_EPSILON)
-	{
-		//Optimized inner loop for dense packed waveforms
-		//We can assume m_offsets[i] = i and m_durations[i] = 0 for all input
-		if(uwfm)
-		{
-			#ifdef __x86_64__
-			if(g_hasAvx2)
-				DensePackedInnerLoopAVX2(uwfm, clock_edges, data, wend, cend, xmax, ymax, xtimescale, yscale, yoff);
-			else
-			#endif
-				DensePackedInnerLoop(uwfm, clock_edges, data, wend, cend, xmax, ymax, xtimescale, yscale, yoff);
-		}
-
-		//Normal main loop
-		else
-			SparsePackedInnerLoop(swfm, clock_edges, data, wend, cend, xmax, ymax, xtimescale, yscale, yoff);
-	}
+		Integrate(waveform, clock_edges, data, xmax, ymax, xtimescale, yscale, yoff, maskTest);
 
 	//Rightmost column of the eye has some rounding artifacts.
 	//For now, just replace it with the value from 1 column to its left.
-	size_t delta = ceil(m_xscale);
-	size_t xstart = xmax - delta;
-	size_t xend = xmax;
-	for(size_t y=0; y<m_height; y++)
-	{
-		int64_t* row = data + y*m_width;
-		for(size_t x=xstart; x<=xend; x++)
-			row[x] = row[x-delta];
-	}
+	FixupRightColumns(data, m_width, m_height, ceil(m_xscale));
 
 	//Count total number of UIs we've integrated
 	cap->IntegrateUIs(clock_edges.size());
 	cap->Normalize();
-
-	//If we have an eye mask, prepare it for processing
-	if(m_mask.GetFileName() != "")
-		DoMaskTest(cap);
+	cap->m_revision ++;
 
 	double dt = GetTime() - start;
 	total_frames ++;
@@ -508,13 +599,180 @@ void EyePattern::Refresh()
 	LogTrace("Refresh took %.3f ms (avg %.3f)\n", dt * 1000, (total_time * 1000) / total_frames);
 }
 
+/**
+	@brief Integrates one waveform into the eye
+
+	The input is split into blocks of samples, each starting at the UI containing its first sample. Blocks are
+	integrated in parallel into 32-bit tiles, which are then widened and added to the 64-bit accumulator.
+
+	A sample adds at most 64 counts to any one pixel, so blocks are capped at 2^25 samples to make sure a tile can
+	never saturate. Bigger waveforms are integrated in several passes.
+
+	If maskTest is set, each tile is cleaned up and mirrored the same way the accumulator will be, then counted
+	against the mask bitmap. This lets the running hit counts be updated from only the newly integrated UIs.
+ */
+void EyePattern::Integrate(
+	WaveformBase* waveform,
+	vector<int64_t>& clock_edges,
+	int64_t* data,
+	int32_t xmax,
+	int32_t ymax,
+	float xtimescale,
+	float yscale,
+	float yoff,
+	bool maskTest
+	)
+{
+	auto swfm = dynamic_cast<SparseAnalogWaveform*>(waveform);
+	auto uwfm = dynamic_cast<UniformAnalogWaveform*>(waveform);
+	auto cap = dynamic_cast<EyeWaveform*>(GetData(0));
+
+	if( (clock_edges.size() < 2) || (waveform->size() < 2) )
+		return;
+	size_t cend = clock_edges.size() - 1;
+	size_t wend = waveform->size() - 1;
+
+	//Divide large waveforms into blocks and multithread them
+	//TODO: tune split
+	const size_t maxBlockSamples = 1 << 25;
+	size_t nthreads = 1;
+	if(wend > 1000000)
+		nthreads = omp_get_max_threads();
+	size_t numblocks = max(nthreads, (wend + maxBlockSamples - 1) / maxBlockSamples);
+	size_t blocksize = (wend + numblocks - 1) / numblocks;
+
+	//Round blocks to multiples of 8 samples for clean vectorization
+	blocksize += (8 - (blocksize % 8)) % 8;
+	numblocks = (wend + blocksize - 1) / blocksize;
+	nthreads = min(nthreads, numblocks);
+
+	size_t npix = m_width * m_height;
+	if(m_accumTiles.size() < nthreads)
+		m_accumTiles.resize(nthreads);
+	for(size_t i=0; i<nthreads; i++)
+		m_accumTiles[i].resize(npix);
+
+	size_t delta = ceil(m_xscale);
+	size_t halfwidth = m_width/2;
+	vector<uint64_t> hits(numblocks, 0);
+	vector<uint64_t> totals(numblocks, 0);
+
+	for(size_t first=0; first<numblocks; first += nthreads)
+	{
+		size_t last = min(numblocks, first + nthreads);
+
+		#pragma omp parallel for if(last - first > 1)
+		for(size_t block=first; block<last; block++)
+		{
+			uint32_t* tile = &m_accumTiles[block - first][0];
+			memset(tile, 0, npix * sizeof(uint32_t));
+
+			size_t istart = block * blocksize;
+			size_t iend = min(wend, istart + blocksize);
+
+			//Start at the last clock edge before our first sample
+			int64_t tstart;
+			if(uwfm)
+				tstart = istart * waveform->m_timescale + waveform->m_triggerPhase;
+			else
+				tstart = swfm->m_offsets[istart] * waveform->m_timescale + waveform->m_triggerPhase;
+			size_t cstart = upper_bound(clock_edges.begin(), clock_edges.end(), tstart) - clock_edges.begin();
+			if(cstart > 0)
+				cstart --;
+			if(cstart >= cend)
+				continue;
+
+			//Optimized inner loop for dense packed waveforms
+			//We can assume m_offsets[i] = i and m_durations[i] = 0 for all input
+			if(uwfm)
+			{
+				#ifdef __x86_64__
+				if(g_hasAvx2)
+				{
+					DensePackedInnerLoopAVX2(
+						uwfm, clock_edges, tile, istart, iend, cstart, cend, xmax, ymax, xtimescale, yscale, yoff);
+				}
+				else
+				#endif
+				{
+					DensePackedInnerLoop(
+						uwfm, clock_edges, tile, istart, iend, cstart, cend, xmax, ymax, xtimescale, yscale, yoff);
+				}
+			}
+
+			//Normal main loop
+			else
+			{
+				#ifdef __x86_64__
+				if(g_hasAvx2)
+				{
+					SparsePackedInnerLoopAVX2(
+						swfm, clock_edges, tile, istart, iend, cstart, cend, xmax, ymax, xtimescale, yscale, yoff);
+				}
+				else
+				#endif
+				{
+					SparsePackedInnerLoop(
+						swfm, clock_edges, tile, istart, iend, cstart, cend, xmax, ymax, xtimescale, yscale, yoff);
+				}
+			}
+
+			//Count mask hits in the new data, as it will look once merged and normalized
+			if(maskTest)
+			{
+				FixupRightColumns(tile, m_width, m_height, delta);
+				for(size_t y=0; y<m_height; y++)
+				{
+					uint32_t* row = tile + y*m_width;
+					memcpy(row, row+halfwidth, halfwidth * sizeof(uint32_t));
+				}
+
+				#ifdef __x86_64__
+				if(g_hasAvx2)
+					CountMaskHitsAVX2(tile, hits[block], totals[block]);
+				else
+				#endif
+					CountMaskHitsGeneric(tile, hits[block], totals[block]);
+			}
+		}
+
+		//Widen the tiles and merge them into the accumulator
+		size_t ntiles = last - first;
+		#pragma omp parallel for if(ntiles > 1)
+		for(size_t y=0; y<m_height; y++)
+		{
+			int64_t* row = data + y*m_width;
+			for(size_t i=0; i<ntiles; i++)
+			{
+				const uint32_t* tilerow = &m_accumTiles[i][y*m_width];
+				for(size_t x=0; x<m_width; x++)
+					row[x] += tilerow[x];
+			}
+		}
+	}
+
+	if(maskTest)
+	{
+		uint64_t newhits = 0;
+		uint64_t newtotal = 0;
+		for(size_t i=0; i<numblocks; i++)
+		{
+			newhits += hits[i];
+			newtotal += totals[i];
+		}
+		cap->AddMaskHits(newhits, newtotal);
+	}
+}
+
 #ifdef __x86_64__
 __attribute__((target("avx2")))
 void EyePattern::DensePackedInnerLoopAVX2(
 	UniformAnalogWaveform* waveform,
 	vector<int64_t>& clock_edges,
-	int64_t* data,
-	size_t wend,
+	uint32_t* data,
+	size_t istart,
+	size_t iend,
+	size_t cstart,
 	size_t cend,
 	int32_t xmax,
 	int32_t ymax,
@@ -527,9 +785,9 @@ void EyePattern::DensePackedInnerLoopAVX2(
 	int64_t width = cap->GetUIWidth();
 	int64_t halfwidth = width/2;
 
-	size_t iclock = 0;
+	size_t iclock = cstart;
 
-	size_t wend_rounded = wend - (wend % 8);
+	size_t iend_rounded = iend - ((iend - istart) % 8);
 
 	//Splat some constants into vector regs
 	__m256i vxoff 		= _mm256_set1_epi32((int)m_xoff);
@@ -543,9 +801,9 @@ void EyePattern::DensePackedInnerLoopAVX2(
 	float* samples = (float*)&waveform->m_samples[0];
 
 	//Main unrolled loop, 8 samples per iteration
-	size_t i = 0;
+	size_t i = istart;
 	uint32_t bufmax = m_width * (m_height - 1);
-	for(; i<wend_rounded && iclock < cend; i+= 8)
+	for(; i<iend_rounded && iclock < cend; i+= 8)
 	{
 		//Figure out timestamp of this sample within the UI.
 		//This doesn't vectorize well, but it's pretty fast.
@@ -635,7 +893,7 @@ void EyePattern::DensePackedInnerLoopAVX2(
 	}
 
 	//Catch any stragglers
-	for(; i<wend && iclock < cend; i++)
+	for(; i<iend && iclock < cend; i++)
 	{
 		//Find time of this sample.
 		//If it's past the end of the current UI, move to the next clock edge
@@ -683,20 +941,157 @@ void EyePattern::DensePackedInnerLoopAVX2(
 		//Calculate how much of the pixel's intensity to put in each row
 		float yfrac = nominal_pixel_y - floor(nominal_pixel_y);
 		int32_t bin2 = yfrac * 64;
-		int64_t* pix = data + y1*m_width + pixel_x_round;
+		uint32_t* pix = data + y1*m_width + pixel_x_round;
 
 		//Plot each point (this only draws the right half of the eye, we copy to the left later)
 		pix[0] 		 += 64 - bin2;
 		pix[m_width] += bin2;
 	}
 }
+
+__attribute__((target("avx2")))
+void EyePattern::SparsePackedInnerLoopAVX2(
+	SparseAnalogWaveform* waveform,
+	vector<int64_t>& clock_edges,
+	uint32_t* data,
+	size_t istart,
+	size_t iend,
+	size_t cstart,
+	size_t cend,
+	int32_t xmax,
+	int32_t ymax,
+	float xtimescale,
+	float yscale,
+	float yoff
+	)
+{
+	auto cap = dynamic_cast<EyeWaveform*>(GetData(0));
+	int64_t width = cap->GetUIWidth();
+	int64_t halfwidth = width/2;
+
+	size_t iclock = cstart;
+
+	size_t iend_rounded = iend - ((iend - istart) % 8);
+
+	//Splat some constants into vector regs
+	__m256i vxoff 		= _mm256_set1_epi32((int)m_xoff);
+	__m256 vxscale 		= _mm256_set1_ps(m_xscale);
+	__m256 vxtimescale	= _mm256_set1_ps(xtimescale);
+	__m256 vyoff 		= _mm256_set1_ps(yoff);
+	__m256 vyscale 		= _mm256_set1_ps(yscale);
+	__m256 v64			= _mm256_set1_ps(64);
+
+	float* samples = (float*)&waveform->m_samples[0];
+	int64_t* offsets = (int64_t*)&waveform->m_offsets[0];
+
+	//Main unrolled loop, 8 samples per iteration
+	size_t i = istart;
+	for(; i<iend_rounded && iclock < cend; i+= 8)
+	{
+		//Figure out timestamp of each sample within the UI, and the time to the next sample.
+		//Same as the scalar loop, but we have to keep track of which lanes got dropped.
+		int32_t offset[8]	__attribute__((aligned(32))) = {0};
+		float dt[8]			__attribute__((aligned(32))) = {1, 1, 1, 1, 1, 1, 1, 1};
+		bool valid[8] = {false};
+		for(size_t j=0; j<8; j++)
+		{
+			size_t k = i+j;
+
+			//Find time of this sample.
+			//If it's past the end of the current UI, move to the next clock edge
+			int64_t tstart = offsets[k] * waveform->m_timescale + waveform->m_triggerPhase;
+			int64_t off = tstart - clock_edges[iclock];
+			if(off < 0)
+				continue;
+			size_t nextclk = iclock + 1;
+			int64_t tnext = clock_edges[nextclk];
+			if(tstart >= tnext)
+			{
+				//Move to the next clock edge
+				iclock ++;
+				if(iclock >= cend)
+					break;
+
+				//Figure out the offset to the next edge
+				off = tstart - tnext;
+			}
+
+			//Drop anything past half a UI if the next clock edge is a long ways out
+			//(this is needed for irregularly sampled data like DDR RAM)
+			int64_t ttnext = tnext - tstart;
+			if( (off > halfwidth) && (ttnext > width) )
+				continue;
+
+			offset[j] = off;
+			dt[j] = offsets[k+1] - offsets[k];
+			valid[j] = true;
+		}
+
+		//Interpolate X position
+		__m256i voffset		= _mm256_load_si256((__m256i*)offset);
+		voffset 			= _mm256_sub_epi32(voffset, vxoff);
+		__m256 foffset		= _mm256_cvtepi32_ps(voffset);
+		foffset				= _mm256_mul_ps(foffset, vxscale);
+		__m256 vxfloor		= _mm256_floor_ps(foffset);
+		__m256 vdt			= _mm256_load_ps(dt);
+		vdt					= _mm256_mul_ps(vdt, vxtimescale);
+		__m256 fdx			= _mm256_sub_ps(foffset, vxfloor);
+		fdx					= _mm256_div_ps(fdx, vdt);
+		__m256i vxfloori	= _mm256_cvtps_epi32(vxfloor);
+
+		//Load waveform data
+		__m256 vcur			= _mm256_loadu_ps(samples + i);
+		__m256 vnext		= _mm256_loadu_ps(samples + i + 1);
+
+		//Interpolate voltage
+		__m256 vdv			= _mm256_sub_ps(vnext, vcur);
+		__m256 ynom			= _mm256_mul_ps(vdv, fdx);
+		ynom				= _mm256_add_ps(vcur, ynom);
+		ynom				= _mm256_mul_ps(ynom, vyscale);
+		ynom				= _mm256_add_ps(ynom, vyoff);
+		__m256 vyfloor		= _mm256_floor_ps(ynom);
+		__m256 vyfrac		= _mm256_sub_ps(ynom, vyfloor);
+		__m256i vyfloori	= _mm256_cvtps_epi32(vyfloor);
+
+		//Calculate how much of the pixel's intensity to put in each row
+		__m256 vbin2f		= _mm256_mul_ps(vyfrac, v64);
+		__m256i vbin2i		= _mm256_cvtps_epi32(vbin2f);
+
+		//Save stuff for output loop
+		int32_t pixel_x_round[8]	__attribute__((aligned(32)));
+		int32_t pixel_y[8]			__attribute__((aligned(32)));
+		int32_t bin2[8]				__attribute__((aligned(32)));
+		_mm256_store_si256((__m256i*)pixel_x_round, vxfloori);
+		_mm256_store_si256((__m256i*)pixel_y, vyfloori);
+		_mm256_store_si256((__m256i*)bin2, vbin2i);
+
+		//Final output loop. Doesn't vectorize well
+		for(size_t j=0; j<8; j++)
+		{
+			//Abort if this pixel is out of bounds
+			if(!valid[j] || (pixel_x_round[j] > xmax) || (pixel_y[j] >= ymax) || (pixel_y[j] < 0) )
+				continue;
+
+			//Plot each point (this only draws the right half of the eye, we copy to the left later)
+			uint32_t* pix = data + pixel_y[j]*m_width + pixel_x_round[j];
+			pix[0] 		 += 64 - bin2[j];
+			pix[m_width] += bin2[j];
+		}
+	}
+
+	//Catch any stragglers
+	if(i < iend)
+		SparsePackedInnerLoop(waveform, clock_edges, data, i, iend, iclock, cend, xmax, ymax, xtimescale, yscale, yoff);
+}
 #endif /* __x86_64__ */
 
 void EyePattern::DensePackedInnerLoop(
 	UniformAnalogWaveform* waveform,
 	vector<int64_t>& clock_edges,
-	int64_t* data,
-	size_t wend,
+	uint32_t* data,
+	size_t istart,
+	size_t iend,
+	size_t cstart,
 	size_t cend,
 	int32_t xmax,
 	int32_t ymax,
@@ -709,8 +1104,8 @@ void EyePattern::DensePackedInnerLoop(
 	int64_t width = cap->GetUIWidth();
 	int64_t halfwidth = width/2;
 
-	size_t iclock = 0;
-	for(size_t i=0; i<wend && iclock < cend; i++)
+	size_t iclock = cstart;
+	for(size_t i=istart; i<iend && iclock < cend; i++)
 	{
 		//Find time of this sample.
 		//If it's past the end of the current UI, move to the next clock edge
@@ -758,7 +1153,7 @@ void EyePattern::DensePackedInnerLoop(
 		//Calculate how much of the pixel's intensity to put in each row
 		float yfrac = nominal_pixel_y - floor(nominal_pixel_y);
 		int32_t bin2 = yfrac * 64;
-		int64_t* pix = data + y1*m_width + pixel_x_round;
+		uint32_t* pix = data + y1*m_width + pixel_x_round;
 
 		//Plot each point (this only draws the right half of the eye, we copy to the left later)
 		pix[0] 		 += 64 - bin2;
@@ -769,8 +1164,10 @@ void EyePattern::DensePackedInnerLoop(
 void EyePattern::SparsePackedInnerLoop(
 	SparseAnalogWaveform* waveform,
 	vector<int64_t>& clock_edges,
-	int64_t* data,
-	size_t wend,
+	uint32_t* data,
+	size_t istart,
+	size_t iend,
+	size_t cstart,
 	size_t cend,
 	int32_t xmax,
 	int32_t ymax,
@@ -783,8 +1180,8 @@ void EyePattern::SparsePackedInnerLoop(
 	int64_t width = cap->GetUIWidth();
 	int64_t halfwidth = width/2;
 
-	size_t iclock = 0;
-	for(size_t i=0; i<wend && iclock < cend; i++)
+	size_t iclock = cstart;
+	for(size_t i=istart; i<iend && iclock < cend; i++)
 	{
 		//Find time of this sample.
 		//If it's past the end of the current UI, move to the next clock edge
@@ -833,7 +1230,7 @@ void EyePattern::SparsePackedInnerLoop(
 		//Calculate how much of the pixel's intensity to put in each row
 		float yfrac = nominal_pixel_y - floor(nominal_pixel_y);
 		int32_t bin2 = yfrac * 64;
-		int64_t* pix = data + y1*m_width + pixel_x_round;
+		uint32_t* pix = data + y1*m_width + pixel_x_round;
 
 		//Plot each point (this only draws the right half of the eye, we copy to the left later)
 		pix[0] 		 += 64 - bin2;
@@ -913,60 +1310,140 @@ void EyePattern::RecalculateUIWidth()
 }
 
 /**
-	@brief Checks the current capture against the eye mask
+	@brief Gets the eye mask ready for testing the next batch of UIs
+
+	The mask is only rasterized when the mask file or the eye geometry changes. Whenever that happens, or the
+	running hit counts in the capture were made against an older rasterization, the whole accumulator is recounted.
+	Otherwise Integrate() just adds the hits from the new UIs.
+
+	@return True if mask testing can proceed
+ */
+bool EyePattern::PrepareMaskTest(EyeWaveform* cap)
+{
+	float yscale = m_height / GetVoltageRange(0);
+
+	if( (m_maskBits.empty()) ||
+		(m_maskBitsFile != m_mask.GetFileName()) ||
+		(m_maskBitsWidth != m_width) ||
+		(m_maskBitsHeight != m_height) ||
+		(m_maskBitsXScale != m_xscale) ||
+		(m_maskBitsXOff != m_xoff) ||
+		(m_maskBitsYScale != yscale) ||
+		(m_maskBitsUIWidth != cap->GetUIWidth()) )
+	{
+		m_mask.Rasterize(m_maskBits, m_width, m_height, cap, m_xscale, m_xoff, yscale);
+
+		m_maskBitsFile = m_mask.GetFileName();
+		m_maskBitsWidth = m_width;
+		m_maskBitsHeight = m_height;
+		m_maskBitsXScale = m_xscale;
+		m_maskBitsXOff = m_xoff;
+		m_maskBitsYScale = yscale;
+		m_maskBitsUIWidth = cap->GetUIWidth();
+		m_maskGeneration ++;
+	}
+
+	if(cap->GetMaskGeneration() != m_maskGeneration)
+	{
+		uint64_t hits;
+		uint64_t total;
+		CountMaskHits(cap->GetAccumData(), hits, total);
+		cap->SetMaskHits(m_maskGeneration, hits, total);
+	}
+
+	return !m_maskBits.empty();
+}
+
+/**
+	@brief Counts total and masked bin values over a full eye, using the packed mask bitmap
  */
-void EyePattern::DoMaskTest(EyeWaveform* cap)
+template<class T>
+static void CountMaskHitsInternal(
+	const T* data, const uint64_t* mask, size_t width, size_t height, uint64_t& hits, uint64_t& total)
 {
-	//TODO: performance optimization, don't re-render mask every waveform, only when we resize
+	size_t stride = EyeMask::GetBitmapStride(width);
 
-	//Create the Cairo surface we're drawing on
-	Cairo::RefPtr< Cairo::ImageSurface > surface =
-		Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, m_width, m_height);
-	Cairo::RefPtr< Cairo::Context > cr = Cairo::Context::create(surface);
+	hits = 0;
+	total = 0;
+	for(size_t y=0; y<height; y++)
+	{
+		auto row = data + y*width;
+		auto maskrow = mask + y*stride;
+		for(size_t x=0; x<width; x++)
+		{
+			total += row[x];
+			if(maskrow[x / 64] & (1ULL << (x % 64)))
+				hits += row[x];
+		}
+	}
+}
 
-	//Set up transformation to match GL's bottom-left origin
-	//cr->translate(0, m_height);
-	//cr->scale(1, -1);
+void EyePattern::CountMaskHits(const int64_t* data, uint64_t& hits, uint64_t& total)
+{
+	CountMaskHitsInternal(data, &m_maskBits[0], m_width, m_height, hits, total);
+}
 
-	//Clear to a blank background
-	cr->set_source_rgba(0, 0, 0, 1);
-	cr->rectangle(0, 0, m_width, m_height);
-	cr->fill();
+void EyePattern::CountMaskHitsGeneric(const uint32_t* data, uint64_t& hits, uint64_t& total)
+{
+	CountMaskHitsInternal(data, &m_maskBits[0], m_width, m_height, hits, total);
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2")))
+void EyePattern::CountMaskHitsAVX2(const uint32_t* data, uint64_t& hits, uint64_t& total)
+{
+	size_t stride = EyeMask::GetBitmapStride(m_width);
+	size_t fullwords = m_width / 64;
+	const uint64_t* mask = &m_maskBits[0];
+
+	//One bit per lane, for expanding a mask byte into a lane mask
+	__m256i vlanebits	= _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1);
+
+	__m256i vtotal		= _mm256_setzero_si256();
+	__m256i vhits		= _mm256_setzero_si256();
+	uint64_t tailhits	= 0;
+	uint64_t tailtotal	= 0;
 
-	//Software rendering
-	float yscale = m_height / GetVoltageRange(0);
-	m_mask.RenderForAnalysis(
-		cr,
-		cap,
-		m_xscale,
-		m_xoff,
-		yscale,
-		0,
-		m_height);
-
-	auto accum = cap->GetAccumData();
-
-	//Test each pixel of the eye pattern against the mask
-	uint32_t* data = reinterpret_cast<uint32_t*>(surface->get_data());
-	int stride = surface->get_stride() / sizeof(uint32_t);
-	size_t total = 0;
-	size_t hits = 0;
 	for(size_t y=0; y<m_height; y++)
 	{
-		auto row = data + (y*stride);
-		auto eyerow = accum + (y*m_width);
-		for(size_t x=0; x<m_width; x++)
+		auto row = data + y*m_width;
+		auto maskrow = mask + y*stride;
+
+		//64 pixels per mask word
+		for(size_t w=0; w<fullwords; w++)
+		{
+			uint64_t bits = maskrow[w];
+			auto block = row + w*64;
+			for(size_t j=0; j<8; j++)
+			{
+				__m256i v		= _mm256_loadu_si256((const __m256i*)(block + j*8));
+
+				//Select the lanes that are inside the mask
+				__m256i vbyte	= _mm256_set1_epi32( (bits >> (j*8)) & 0xff);
+				__m256i vsel	= _mm256_cmpeq_epi32(_mm256_and_si256(vbyte, vlanebits), vlanebits);
+				__m256i vmasked	= _mm256_and_si256(v, vsel);
+
+				//Widen to 64 bits and accumulate
+				vtotal = _mm256_add_epi64(vtotal, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+				vtotal = _mm256_add_epi64(vtotal, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+				vhits = _mm256_add_epi64(vhits, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(vmasked)));
+				vhits = _mm256_add_epi64(vhits, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(vmasked, 1)));
+			}
+		}
+
+		//Catch any stragglers
+		for(size_t x=fullwords*64; x<m_width; x++)
 		{
-			//Look up the eye pattern pixel
-			auto bin = eyerow[x];
-			total += bin;
-
-			//If mask pixel isn't black, count violations
-			uint32_t pix = row[x];
-			if( (pix & 0xff) != 0)
-				hits += bin;
+			tailtotal += row[x];
+			if(maskrow[x / 64] & (1ULL << (x % 64)))
+				tailhits += row[x];
 		}
 	}
 
-	cap->SetMaskHitRate(hits * 1.0f / total);
+	uint64_t lanes[4] __attribute__((aligned(32)));
+	_mm256_store_si256((__m256i*)lanes, vtotal);
+	total = lanes[0] + lanes[1] + lanes[2] + lanes[3] + tailtotal;
+	_mm256_store_si256((__m256i*)lanes, vhits);
+	hits = lanes[0] + lanes[1] + lanes[2] + lanes[3] + tailhits;
 }
+#endif /* __x86_64__ */
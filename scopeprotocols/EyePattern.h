@@ -84,6 +84,35 @@ public:
 	void SetMaskHitRate(float rate)
 	{ m_maskHitRate = rate; }
 
+	/**
+		@brief Gets the mask rasterization that the running hit counts were made against
+
+		See EyePattern::PrepareMaskTest().
+	 */
+	uint64_t GetMaskGeneration()
+	{ return m_maskGeneration; }
+
+	/**
+		@brief Replaces the running mask hit counts, after a full recount against a new mask rasterization
+	 */
+	void SetMaskHits(uint64_t generation, uint64_t hits, uint64_t total)
+	{
+		m_maskGeneration = generation;
+		m_maskHits = hits;
+		m_maskTotal = total;
+		UpdateMaskHitRate();
+	}
+
+	/**
+		@brief Adds hits from newly integrated UIs to the running mask hit counts
+	 */
+	void AddMaskHits(uint64_t hits, uint64_t total)
+	{
+		m_maskHits += hits;
+		m_maskTotal += total;
+		UpdateMaskHitRate();
+	}
+
 	//Unused virtual methods from WaveformBase that we have to override
 	virtual void clear()
 	{}
@@ -113,6 +142,21 @@ public:
 	{ return 0; }
 
 protected:
+	void UpdateMaskHitRate()
+	{
+		if(m_maskTotal)
+			m_maskHitRate = m_maskHits * 1.0f / m_maskTotal;
+		else
+			m_maskHitRate = 0;
+	}
+
+	static int64_t FindPeakGeneric(const int64_t* row, size_t len);
+	void ScaleOutputGeneric(float norm);
+#ifdef __x86_64__
+	static int64_t FindPeakAVX2(const int64_t* row, size_t len);
+	void ScaleOutputAVX2(float norm);
+#endif
+
 	size_t m_width;
 	size_t m_height;
 
@@ -123,6 +167,10 @@ protected:
 	float m_centerVoltage;
 
 	float m_maskHitRate;
+
+	uint64_t m_maskGeneration;
+	uint64_t m_maskHits;
+	uint64_t m_maskTotal;
 };
 
 class EyePattern : public Filter
@@ -205,13 +253,33 @@ public:
 	PROTOCOL_DECODER_INITPROC(EyePattern)
 
 protected:
-	void DoMaskTest(EyeWaveform* cap);
+	bool PrepareMaskTest(EyeWaveform* cap);
+
+	void CountMaskHits(const int64_t* data, uint64_t& hits, uint64_t& total);
+	void CountMaskHitsGeneric(const uint32_t* data, uint64_t& hits, uint64_t& total);
+#ifdef __x86_64__
+	void CountMaskHitsAVX2(const uint32_t* data, uint64_t& hits, uint64_t& total);
+#endif
+
+	void Integrate(
+		WaveformBase* waveform,
+		std::vector<int64_t>& clock_edges,
+		int64_t* data,
+		int32_t xmax,
+		int32_t ymax,
+		float xtimescale,
+		float yscale,
+		float yoff,
+		bool maskTest
+		);
 
 	void SparsePackedInnerLoop(
 		SparseAnalogWaveform* waveform,
 		std::vector<int64_t>& clock_edges,
-		int64_t* data,
-		size_t wend,
+		uint32_t* data,
+		size_t istart,
+		size_t iend,
+		size_t cstart,
 		size_t cend,
 		int32_t xmax,
 		int32_t ymax,
@@ -223,8 +291,10 @@ protected:
 	void DensePackedInnerLoop(
 		UniformAnalogWaveform* waveform,
 		std::vector<int64_t>& clock_edges,
-		int64_t* data,
-		size_t wend,
+		uint32_t* data,
+		size_t istart,
+		size_t iend,
+		size_t cstart,
 		size_t cend,
 		int32_t xmax,
 		int32_t ymax,
@@ -237,8 +307,25 @@ protected:
 	void DensePackedInnerLoopAVX2(
 		UniformAnalogWaveform* waveform,
 		std::vector<int64_t>& clock_edges,
-		int64_t* data,
-		size_t wend,
+		uint32_t* data,
+		size_t istart,
+		size_t iend,
+		size_t cstart,
+		size_t cend,
+		int32_t xmax,
+		int32_t ymax,
+		float xtimescale,
+		float yscale,
+		float yoff
+		);
+
+	void SparsePackedInnerLoopAVX2(
+		SparseAnalogWaveform* waveform,
+		std::vector<int64_t>& clock_edges,
+		uint32_t* data,
+		size_t istart,
+		size_t iend,
+		size_t cstart,
 		size_t cend,
 		int32_t xmax,
 		int32_t ymax,
@@ -266,6 +353,24 @@ protected:
 	std::string m_rateName;
 
 	EyeMask m_mask;
+
+	///@brief m_mask rasterized at the current eye geometry (see EyeMask::Rasterize)
+	std::vector<uint64_t> m_maskBits;
+
+	///@brief Incremented every time m_maskBits is rasterized
+	uint64_t m_maskGeneration;
+
+	//Geometry m_maskBits was rasterized at
+	std::string m_maskBitsFile;
+	size_t m_maskBitsWidth;
+	size_t m_maskBitsHeight;
+	float m_maskBitsXScale;
+	int64_t m_maskBitsXOff;
+	float m_maskBitsYScale;
+	float m_maskBitsUIWidth;
+
+	///@brief Per-block 32-bit integration tiles, kept around between refreshes to avoid reallocating
+	std::vector< std::vector<uint32_t> > m_accumTiles;
 };
 
 #endif
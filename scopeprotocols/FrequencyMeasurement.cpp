@@ -86,6 +86,32 @@ void FrequencyMeasurement::Refresh()
 
 	auto din = GetInputWaveform(0);
 	din->PrepareForCpuAccess();
+
+	//Sequence acquisitions get one point per segment
+	if(RefreshSegmentBatch(din, [this](WaveformBase* seg, SparseAnalogWaveform* out) { return Measure(seg, out); }))
+		return;
+
+	//Create the output
+	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0, true);
+	cap->m_timescale = 1;
+	cap->PrepareForCpuAccess();
+	if(!Measure(din, cap))
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Measures one waveform into an empty, CPU-side output
+
+	@return False if there was nothing to measure
+ */
+bool FrequencyMeasurement::Measure(WaveformBase* din, SparseAnalogWaveform* cap)
+{
 	auto uadin = dynamic_cast<UniformAnalogWaveform*>(din);
 	auto sadin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto uddin = dynamic_cast<UniformDigitalWaveform*>(din);
@@ -106,15 +132,7 @@ void FrequencyMeasurement::Refresh()
 
 	//We need at least one full cycle of the waveform to have a meaningful frequency
 	if(edges.size() < 2)
-	{
-		SetData(NULL, 0);
-		return;
-	}
-
-	//Create the output
-	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0, true);
-	cap->m_timescale = 1;
-	cap->PrepareForCpuAccess();
+		return false;
 
 	size_t elen = edges.size();
 	for(size_t i=0; i < (elen - 2); i+= 2)
@@ -131,7 +149,5 @@ void FrequencyMeasurement::Refresh()
 		cap->m_samples.push_back(freq);
 	}
 
-	SetData(cap, 0);
-
-	cap->MarkModifiedFromCpu();
+	return true;
 }
@@ -47,6 +47,9 @@ public:
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream);
 
 	PROTOCOL_DECODER_INITPROC(FrequencyMeasurement)
+
+protected:
+	bool Measure(WaveformBase* din, SparseAnalogWaveform* cap);
 };
 
 #endif
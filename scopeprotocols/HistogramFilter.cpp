@@ -145,7 +145,7 @@ void HistogramFilter::Refresh()
 	//Calculate histogram for our incoming data
 	//For now, 100fs per bin target
 	size_t bins = ceil(range) / 100;
-	auto data = MakeHistogram(sdin, udin, m_min, m_max, bins);
+	MakeHistogram(sdin, udin, m_min, m_max, bins, m_newCounts);
 
 	//Calculate bin configuration.
 	float binsize = range / bins;
@@ -173,7 +173,7 @@ void HistogramFilter::Refresh()
 	size_t vmax = 0;
 	for(size_t i=0; i<bins; i++)
 	{
-		m_histogram[i] += data[i];
+		m_histogram[i] += m_newCounts[i];
 		vmax = max(vmax, m_histogram[i]);
 	}
 
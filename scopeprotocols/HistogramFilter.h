@@ -62,6 +62,9 @@ protected:
 	float m_max;
 
 	std::vector<size_t> m_histogram;
+
+	///@brief Histogram of the current waveform only, kept around so the bins aren't reallocated every refresh
+	std::vector<size_t> m_newCounts;
 };
 
 #endif
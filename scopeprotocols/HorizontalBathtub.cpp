@@ -46,6 +46,14 @@ HorizontalBathtub::HorizontalBathtub(const string& color)
 	m_voltageName = "Voltage";
 	m_parameters[m_voltageName] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_VOLTS));
 	m_parameters[m_voltageName].SetFloatVal(0);
+
+	m_rangeName = "Voltage Range";
+	m_parameters[m_rangeName] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_VOLTS));
+	m_parameters[m_rangeName].SetFloatVal(0);
+
+	m_extrapolateName = "Dual-Dirac Extrapolation";
+	m_parameters[m_extrapolateName] = FilterParameter(FilterParameter::TYPE_BOOL, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_extrapolateName].SetBoolVal(true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -85,16 +93,21 @@ void HorizontalBathtub::Refresh()
 	auto din = dynamic_cast<EyeWaveform*>(GetInputWaveform(0));
 	din->PrepareForCpuAccess();
 	float threshold = m_parameters[m_voltageName].GetFloatVal();
+	float range = m_parameters[m_rangeName].GetFloatVal();
 
-	//Find the eye bin for this height
+	//Find the eye bins for this band of voltages
 	float yscale = din->GetHeight() / m_inputs[0].GetVoltageRange();
 	float ymid = din->GetHeight()/2;
 	float center = din->GetCenterVoltage();
+	ssize_t ybin0 = round( (threshold - range/2 - center)*yscale + ymid);
+	ssize_t ybin1 = round( (threshold + range/2 - center)*yscale + ymid);
 
 	//Sanity check we're not off the eye
-	size_t ybin = round( (threshold-center)*yscale + ymid);
-	if(ybin >= din->GetHeight())
+	ssize_t height = din->GetHeight();
+	if( (ybin1 < 0) || (ybin0 >= height) )
 		return;
+	ybin0 = max(ybin0, (ssize_t)0);
+	ybin1 = min(ybin1, height-1);
 
 	//Horizontal scale: one eye is two UIs wide
 	double fs_per_width = 2*din->m_uiWidth;
@@ -106,47 +119,13 @@ void HorizontalBathtub::Refresh()
 	cap->m_triggerPhase = -din->m_uiWidth;
 	cap->m_timescale = fs_per_pixel;
 
-	//Extract the single scanline we're interested in
-	//TODO: support a range of voltages
-	int64_t* row = din->GetAccumData() + ybin*din->GetWidth();
+	//The curve itself comes from the shared engine for this eye, which only builds it once per eye and band
+	m_engine = BathtubEngine::GetEngine(GetInput(0));
+	m_engine->Update(din);
 	size_t len = din->GetWidth();
 	cap->Resize(len);
-	for(size_t i=0; i<len; i++)
-		cap->m_samples[i] = row[i];
-
-	//Move from the center out and integrate BER
-	float sumleft = 0;
-	float sumright = 0;
-	ssize_t mid = len/2;
-	for(ssize_t i=mid; i>=0; i--)
-	{
-		float& samp = cap->m_samples[i];
-		sumleft += samp;
-		samp = sumleft;
-	}
-	for(size_t i=mid; i<len; i++)
-	{
-		float& samp = cap->m_samples[i];
-		sumright += samp;
-		samp = sumright;
-	}
-
-	//Normalize to max amplitude
-	float nmax = sumleft;
-	if(sumright > sumleft)
-		nmax = sumright;
-	for(size_t i=0; i<len; i++)
-		cap->m_samples[i] /= nmax;
-
-	//Log post-scaling
-	for(size_t i=0; i<len; i++)
-	{
-		float& samp = cap->m_samples[i];
-		if(samp < 1e-12)
-			samp = -14;	//cap ber if we don't have enough data
-		else
-			samp = log10(samp);
-	}
+	m_engine->GetLogHorizontalBathtub(ybin0, ybin1, m_parameters[m_extrapolateName].GetBoolVal(),
+		cap->m_samples.GetCpuPointer());
 
 	SetData(cap, 0);
 	cap->MarkModifiedFromCpu();
@@ -50,6 +50,10 @@ public:
 
 protected:
 	std::string m_voltageName;
+	std::string m_rangeName;
+	std::string m_extrapolateName;
+
+	std::shared_ptr<BathtubEngine> m_engine;
 };
 
 #endif
@@ -72,24 +72,46 @@ string I2CDecoder::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+/**
+	@brief Decodes transactions from the position and state in st, and updates it to the end of the input
+ */
 template<class T, class U>
-void I2CDecoderInnerLoop(T* sda, U* scl, I2CWaveform* cap)
+void I2CDecoder::InnerLoop(T* sda, U* scl, I2CWaveform* cap, LoopState& st)
 {
-	//Loop over the data and look for transactions
-	bool				last_scl = true;
-	bool 				last_sda = true;
-	int64_t				tstart	= 0;
-	I2CSymbol::stype	current_type = I2CSymbol::TYPE_ERROR;
-	uint8_t				current_byte = 0;
-	uint8_t				bitcount = 0;
-	bool				last_was_start	= 0;
 	size_t				sdalen = sda->size();
 	size_t 				scllen = scl->size();
-	size_t 				isda = 0;
-	size_t 				iscl = 0;
-	int64_t 			timestamp	= 0;
+	if( (sdalen == 0) || (scllen == 0) )
+		return;
+
+	//Loop over the data and look for transactions
+	bool				last_scl = st.m_lastScl;
+	bool 				last_sda = st.m_lastSda;
+	int64_t				tstart	= st.m_tstart;
+	I2CSymbol::stype	current_type = st.m_currentType;
+	uint8_t				current_byte = st.m_currentByte;
+	uint8_t				bitcount = st.m_bitcount;
+	bool				last_was_start	= st.m_lastWasStart;
+	size_t 				isda = st.m_isda;
+	size_t 				iscl = st.m_iscl;
+	int64_t 			timestamp	= st.m_timestamp;
+
+	//Move on to the next event on either line, if there is one
+	auto advance = [&]()
+	{
+		int64_t next_sda = Filter::GetNextEventTimestampScaled(sda, isda, sdalen, timestamp);
+		int64_t next_scl = Filter::GetNextEventTimestampScaled(scl, iscl, scllen, timestamp);
+		int64_t next_timestamp = min(next_sda, next_scl);
+		if(next_timestamp == timestamp)
+			return false;
+		timestamp = next_timestamp;
+		Filter::AdvanceToTimestampScaled(sda, isda, sdalen, timestamp);
+		Filter::AdvanceToTimestampScaled(scl, iscl, scllen, timestamp);
+		return true;
+	};
 
-	while(true)
+	//If we're resuming, the event at the saved timestamp was already processed by the previous refresh
+	bool more = !st.m_started || advance();
+	while(more)
 	{
 		bool cur_sda = sda->m_samples[isda];
 		bool cur_scl = scl->m_samples[iscl];
@@ -189,21 +211,33 @@ void I2CDecoderInnerLoop(T* sda, U* scl, I2CWaveform* cap)
 		last_scl = cur_scl;
 
 		//Move on
-		int64_t next_sda = Filter::GetNextEventTimestampScaled(sda, isda, sdalen, timestamp);
-		int64_t next_scl = Filter::GetNextEventTimestampScaled(scl, iscl, scllen, timestamp);
-		int64_t next_timestamp = min(next_sda, next_scl);
-		if(next_timestamp == timestamp)
-			break;
-		timestamp = next_timestamp;
-		Filter::AdvanceToTimestampScaled(sda, isda, sdalen, timestamp);
-		Filter::AdvanceToTimestampScaled(scl, iscl, scllen, timestamp);
+		more = advance();
 	}
+
+	st.m_started = true;
+	st.m_lastScl = last_scl;
+	st.m_lastSda = last_sda;
+	st.m_tstart = tstart;
+	st.m_currentType = current_type;
+	st.m_currentByte = current_byte;
+	st.m_bitcount = bitcount;
+	st.m_lastWasStart = last_was_start;
+	st.m_isda = isda;
+	st.m_iscl = iscl;
+	st.m_timestamp = timestamp;
 }
 
+/**
+	@brief Decodes the input
+
+	If both inputs are streaming captures which have only had samples appended since the last refresh, decoding
+	resumes from the last event processed and new symbols are appended to the existing output.
+ */
 void I2CDecoder::Refresh()
 {
 	if(!VerifyAllInputsOK())
 	{
+		ResetIncrementalState();
 		SetData(NULL, 0);
 		return;
 	}
@@ -220,25 +254,37 @@ void I2CDecoder::Refresh()
 	auto ssda = dynamic_cast<SparseDigitalWaveform*>(sda);
 	auto sscl = dynamic_cast<SparseDigitalWaveform*>(scl);
 
-	//Create the capture
-	auto cap = new I2CWaveform;
-	cap->m_timescale = 1;
-	cap->m_startTimestamp = sda->m_startTimestamp;
-	cap->m_startFemtoseconds = sda->m_startFemtoseconds;
-	cap->m_triggerPhase = 0;
-	cap->PrepareForCpuAccess();
+	//Pick up where we left off if we can, otherwise start over
+	//(check both inputs every time, so each one's incremental state stays current)
+	bool sda_appended = (GetFirstNewSample(0) > 0);
+	bool scl_appended = (GetFirstNewSample(1) > 0);
+	auto cap = dynamic_cast<I2CWaveform*>(GetData(0));
+	if(sda_appended && scl_appended && (cap != NULL) )
+		cap->PrepareForCpuAccess();
+	else
+	{
+		m_state = LoopState();
+
+		cap = new I2CWaveform;
+		cap->m_timescale = 1;
+		cap->m_startTimestamp = sda->m_startTimestamp;
+		cap->m_startFemtoseconds = sda->m_startFemtoseconds;
+		cap->m_triggerPhase = 0;
+		cap->PrepareForCpuAccess();
+		SetData(cap, 0);
+	}
 
 	if(usda && uscl)
-		I2CDecoderInnerLoop(usda, uscl, cap);
+		InnerLoop(usda, uscl, cap, m_state);
 	else if(usda && sscl)
-		I2CDecoderInnerLoop(usda, sscl, cap);
+		InnerLoop(usda, sscl, cap, m_state);
 	else if(ssda && sscl)
-		I2CDecoderInnerLoop(ssda, sscl, cap);
+		InnerLoop(ssda, sscl, cap, m_state);
 	else /*if(ssda && uscl)*/
-		I2CDecoderInnerLoop(ssda, uscl, cap);
+		InnerLoop(ssda, uscl, cap, m_state);
 
-	SetData(cap, 0);
 	cap->MarkModifiedFromCpu();
+	cap->MarkSamplesAppended();
 }
 
 Gdk::Color I2CWaveform::GetColor(size_t i)
@@ -90,6 +90,44 @@ public:
 	PROTOCOL_DECODER_INITPROC(I2CDecoder)
 
 protected:
+
+	///@brief Decoder state as of the end of the input, so appended samples can be decoded incrementally
+	struct LoopState
+	{
+		///@brief Initial state, at the start of the input
+		LoopState()
+			: m_started(false)
+			, m_lastScl(true)
+			, m_lastSda(true)
+			, m_tstart(0)
+			, m_currentType(I2CSymbol::TYPE_ERROR)
+			, m_currentByte(0)
+			, m_bitcount(0)
+			, m_lastWasStart(false)
+			, m_isda(0)
+			, m_iscl(0)
+			, m_timestamp(0)
+		{}
+
+		///@brief True if the event at m_timestamp has been processed
+		bool m_started;
+
+		bool m_lastScl;
+		bool m_lastSda;
+		int64_t m_tstart;
+		I2CSymbol::stype m_currentType;
+		uint8_t m_currentByte;
+		uint8_t m_bitcount;
+		bool m_lastWasStart;
+		size_t m_isda;
+		size_t m_iscl;
+		int64_t m_timestamp;
+	};
+
+	template<class T, class U>
+	static void InnerLoop(T* sda, U* scl, I2CWaveform* cap, LoopState& st);
+
+	LoopState m_state;
 };
 
 #endif
@@ -61,6 +61,7 @@ I2CEepromDecoder::I2CEepromDecoder(const string& color)
 	m_parameters[m_memtypename].AddEnumValue("16+1 (24CM01)", 17);
 	m_parameters[m_memtypename].AddEnumValue("16+2 (24CM02)", 18);
 	m_parameters[m_memtypename].SetIntVal(04);
+	m_parameters[m_memtypename].signal_changed().connect(sigc::mem_fun(*this, &Filter::InvalidateOutputText));
 
 	m_baseaddrname = "Base Address";
 	m_parameters[m_baseaddrname] = FilterParameter(FilterParameter::TYPE_ENUM, Unit(Unit::UNIT_COUNTS));
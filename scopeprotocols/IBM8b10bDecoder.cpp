@@ -34,6 +34,7 @@
  */
 
 #include "../scopehal/scopehal.h"
+#include "../scopehal/LineCoding.h"
 #include "IBM8b10bDecoder.h"
 
 using namespace std;
@@ -50,6 +51,7 @@ IBM8b10bDecoder::IBM8b10bDecoder(const string& color)
 
 	m_displayformat = "Display Format";
 	m_parameters[m_displayformat] = MakeIBM8b10bDisplayFormatParameter();
+	m_parameters[m_displayformat].signal_changed().connect(sigc::mem_fun(*this, &Filter::InvalidateOutputText));
 }
 
 FilterParameter IBM8b10bDecoder::MakeIBM8b10bDisplayFormatParameter()
@@ -110,207 +112,67 @@ void IBM8b10bDecoder::Refresh()
 
 	//Record the value of the data stream at each clock edge
 	//TODO: allow single rate clocks too?
-	SparseDigitalWaveform data;
-	SampleOnAnyEdgesBase(din, clkin, data);
-	data.PrepareForCpuAccess();
-
-	//Look for commas in the data stream
-	//TODO: make this more efficient?
+	auto pdata = GetSampledOnAnyEdges<bool>(din, clkin);
+	auto& data = *pdata;
+
+	//Pack the sampled bits so we can work on 64 UIs at a time
+	size_t len = data.m_samples.size();
+	PackedBitstream bits;
+	if(len)
+		bits.Pack(&data.m_samples[0], len);
+
+	//Look for commas in the data stream, at all ten possible alignments at once.
+	//Comma is always exactly five identical bits at positions 2...6 within the symbol (left-right bit ordering).
+	//Every valid symbol should have equal numbers of 0s and 1s (5/5) or two more of one (4/6 or 6/4).
 	size_t max_commas = 0;
 	size_t max_offset = 0;
-	for(size_t offset=0; offset < 10; offset ++)
+	if(len > 20)
 	{
-		size_t num_commas = 0;
-		size_t dlen = data.m_samples.size() - 20;
-		size_t num_errors = 0;
-
-		//Only check the first 100K UIs (10K symbols) for alignment
-		//to avoid wasting a ton of time repeatedly decoding a huge capture
-		dlen = min(dlen, (size_t)100000);
-
-		for(size_t i=0; i<dlen; i += 10)
+		PackedBitstream commas;
+		PackedBitstream errors;
+		LineCoding::FindCommas(bits, commas);
+		LineCoding::FindDisparityErrors(bits, errors);
+
+		size_t nsymbols = len/10 - 1;
+		vector<size_t> num_commas;
+		vector<size_t> num_errors;
+		LineCoding::CountPerPhase(commas, 10, nsymbols, num_commas);
+		LineCoding::CountPerPhase(errors, 10, nsymbols, num_errors);
+
+		for(size_t offset=0; offset < 10; offset ++)
 		{
-			//Check if we have a comma (five identical bits) anywhere in the data stream
-			//Commas are always at positions 2...6 within the symbol (left-right bit ordering)
-			bool comma = true;
-			for(int j=3; j<=6; j++)
+			//Allow a *few* errors, but discard any potential alignment with more errors than commas
+			if(num_errors[offset] > num_commas[offset])
+			{}
+
+			else if(num_commas[offset] > max_commas)
 			{
-				if(data.m_samples[i+offset+j] != data.m_samples[i+offset+2])
-				{
-					comma = false;
-					break;
-				}
+				max_commas = num_commas[offset];
+				max_offset = offset;
 			}
-
-			//Comma is always exactly five identical bits (so 1 and 7 must be different)
-			if(data.m_samples[i+offset+1] == data.m_samples[i+offset+2])
-				comma = false;
-			if(data.m_samples[i+offset+7] == data.m_samples[i+offset+2])
-				comma = false;
-
-			//Count number of 0s and 1s in the symbol
-			//Should always be equal (5/5) or two greater (4/6 or 6/4)
-			int nones = 0;
-			for(int j=0; j<10; j++)
-				nones += data.m_samples[i+offset+j];
-			if( (nones != 4) && (nones != 5) && (nones != 6) )
-				num_errors ++;
-
-			if(comma)
-				num_commas ++;
+			LogTrace("Found %zu commas and %zu errors at offset %zu\n",
+				num_commas[offset], num_errors[offset], offset);
 		}
-
-		//Allow a *few* errors, but discard any potential alignment with more errors than commas
-		if(num_errors > num_commas)
-		{}
-
-		else if(num_commas > max_commas)
-		{
-			max_commas = num_commas;
-			max_offset = offset;
-		}
-		LogTrace("Found %zu commas and %zu errors at offset %zu\n", num_commas, num_errors, offset);
 	}
 
 	//Decode the actual data
+	auto table = LineCoding::Get8b10bTable();
 	bool first = true;
 	int last_disp = -1;
-	size_t dlen = data.m_samples.size() - 11;
+	size_t dlen = (len > 11) ? len - 11 : 0;
+	if(dlen > max_offset)
+	{
+		size_t nsymbols = (dlen - max_offset + 9) / 10;
+		cap->m_offsets.reserve(nsymbols);
+		cap->m_durations.reserve(nsymbols);
+		cap->m_samples.reserve(nsymbols);
+	}
 	for(size_t i=max_offset; i<dlen; i+= 10)
 	{
-		//5b/6b decode
-
-		uint8_t code6 =
-			(data.m_samples[i+0] ? 32 : 0) |
-			(data.m_samples[i+1] ? 16 : 0) |
-			(data.m_samples[i+2] ? 8 : 0) |
-			(data.m_samples[i+3] ? 4 : 0) |
-			(data.m_samples[i+4] ? 2 : 0) |
-			(data.m_samples[i+5] ? 1 : 0);
-
-		static const int code5_table[64] =
-		{
-			 0,  0,  0,  0,  0, 23,  8,  7,	//00-07
-			 0, 27,  4, 20, 24, 12, 28, 28, //08-0f
-			 0, 29,  2, 18, 31, 10, 26, 15, //10-17
-			 0,  6, 22, 16, 14,  1, 30,  0,	//18-1f
-			 0, 30, 1,  17, 16,  9, 25,  0,	//20-27
-			15,  5, 21, 31, 13,  2, 29,  0,	//28-2f
-			28,  3, 19, 24, 11,  4, 27,  0,	//30-37
-			 7,  8, 23,  0,  0,  0,  0,  0  //38-3f
-		};
-
-		static const int disp5_table[64] =
-		{
-			 0,  0,  0, 0,  0, -2, -2, 0,	//00-07
-			 0, -2, -2, 0, -2,  0,  0, 2,	//08-0f
-			 0, -2, -2, 0, -2,  0,  0, 2,	//10-17
-			-2,  0,  0, 2,  0,  2,  2, 0,	//18-1f
-			 0, -2, -2, 0, -2,  0,  0, 2,	//20-27
-			-2,  0,  0, 2,  0,  2,  2, 0,	//28-2f
-			-2,  0,  0, 2,  0,  2,  2, 0,	//30-37
-			 0,  2,  2, 0,  0,  0,  0, 0 	//38-3f
-		};
-
-		static const bool err5_table[64] =
-		{
-			 true,  true,  true,  true,  true, false, false, false,	//00-07
-			 true, false, false, false, false, false, false, false, //08-0f
-			 true, false, false, false, false, false, false, false, //10-17
-			false, false, false, false, false, false, false,  true,	//18-1f
-			 true, false, false, false, false, false, false, false,	//20-27
-			false, false, false, false, false, false, false,  true,	//28-2f
-			false, false, false, false, false, false, false,  true,	//30-37
-			false, false, false,  true,  true,  true,  true,  true  //38-3f
-		};
-
-		static const bool ctl5_table[64] =
-		{
-			false, false, false, false, false, false, false, false,	//00-07
-			false, false, false, false, false, false, false, true,  //08-0f
-			false, false, false, false, false, false, false, false, //10-17
-			false, false, false, false, false, false, false, false,	//18-1f
-			false, false, false, false, false, false, false, false,	//20-27
-			false, false, false, false, false, false, false, false,	//28-2f
-			true,  false, false, false, false, false, false, false,	//30-37
-			false, false, false, false, false, false, false, false  //38-3f
-		};
-
-		int code5 = code5_table[code6];
-		int disp5 = disp5_table[code6];
-		bool err5 = err5_table[code6];
-		bool ctl5 = ctl5_table[code6];
-
-		//3b/4b decode
-		uint8_t code4 =
-			(data.m_samples[i+6] ? 8 : 0) |
-			(data.m_samples[i+7] ? 4 : 0) |
-			(data.m_samples[i+8] ? 2 : 0) |
-			(data.m_samples[i+9] ? 1 : 0);
-
-		static const bool err3_ctl_table[16] =
-		{
-			 true,  true, false, false, false, false, false, false,
-			false, false, false, false, false, false,  true,  true
-		};
-
-		static const int code3_pos_ctl_table[16] =	//if disp5 positive
-		{
-			0, 0, 4, 3, 0, 2, 6, 7,
-			7, 1, 5, 0, 3, 4, 0, 0,
-		};
-
-		static const int code3_neg_ctl_table[16] =	//if disp5 negative
-		{
-			0, 0, 4, 3, 0, 5, 1, 7,
-			7, 6, 2, 0, 3, 4, 0, 0
-		};
-
-		static const bool err3_table[16] =
-		{
-			 true,  false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false,  true
-		};
-
-		static const int code3_table[16] =
-		{
-			0, 7, 4, 3, 0, 2, 6, 7,
-			7, 1, 5, 0, 3, 4, 7, 0
-		};
-
-		static const int disp3_table[16] =
-		{
-			 0, -2, -2, 0, -2, 0, 0, 2,
-			-2, 0,  0, 2,  0, 2, 2, 0
-		};
-
-		//true only for Dx.A7
-		const bool alt3_table[16] =
-		{
-			0, 0, 0, 0, 0, 0, 0, 1,
-			1, 0, 0, 0, 0, 0, 0, 0
-		};
-
-		int code3 = false;
-		int disp3 = 0;
-		int err3 = false;
-		if(ctl5)
-		{
-			if(disp5 >= 0)
-				code3 = code3_pos_ctl_table[code4];
-			else
-				code3 = code3_neg_ctl_table[code4];
-			err3 = err3_ctl_table[code4];
-		}
-		else
-		{
-			code3 = code3_table[code4];
-			err3 = err3_table[code4];
-		}
-		disp3 = disp3_table[code4];
+		auto& code = table[bits.Extract(i, 10)];
 
 		//Disparity tracking
-		int total_disp = disp3 + disp5;
+		int total_disp = code.m_disparity;
 		if(first)
 		{
 			if(total_disp < 0)
@@ -321,7 +183,6 @@ void IBM8b10bDecoder::Refresh()
 		}
 
 		bool disperr = false;
-		//int old_disp = last_disp;
 		if(total_disp > 0 && last_disp > 0)
 		{
 			disperr = true;
@@ -335,41 +196,13 @@ void IBM8b10bDecoder::Refresh()
 		else
 			last_disp += total_disp;
 
-		//Special processing for a few control codes that use the .A7 format
-		bool alt = alt3_table[code4];
-		if(alt)
-		{
-			if( (code5 == 23) || (code5 == 27) || (code5 == 29) || (code5 == 30) )
-				ctl5 = true;
-		}
-
 		//Horizontally shift the decoded symbol back by half a UI
 		//since the recovered clock edge is in the middle of the UI.
 		//We want the decoded signal boundaries to line up with the data edge, not the middle of the UI.
 		cap->m_offsets.push_back(data.m_offsets[i] - data.m_durations[i]/2);
 
 		cap->m_durations.push_back(data.m_offsets[i+10] - data.m_offsets[i]);
-		cap->m_samples.push_back(IBM8b10bSymbol(ctl5, err5 || err3 || disperr, (code3 << 5) | code5, last_disp));
-
-		if(err5 || err3 || disperr)
-		{
-			/*LogDebug(
-				"Symbol %zu (ctl5 = %d, err5 = %d, err3=%d, disperr=%d, code3=%d, code5=%d, "
-					"old_disp = %d, total_disp = %d, disp3 = %d, disp5 = %d)\n",
-				i,
-				ctl5, err5, err3, disperr, code3, code5, old_disp, total_disp, disp3, disp5);*/
-		}
-		/*
-		else
-		{
-			if(ctl5)
-				LogDebug("K%d.%d, disp=%d (old_disp = %d, disp3=%d, disp5=%d)\n",
-					code5, code3, last_disp, old_disp, disp3, disp5);
-			else
-				LogDebug("D%d.%d, disp=%d (old_disp = %d, disp3=%d, disp5=%d)\n",
-					code5, code3, last_disp, old_disp,disp3, disp5);
-		}
-		*/
+		cap->m_samples.push_back(IBM8b10bSymbol(code.m_control, code.m_error || disperr, code.m_data, last_disp));
 	}
 
 	SetData(cap, 0);
@@ -430,3 +263,13 @@ string IBM8b10bWaveform::GetText(size_t i)
 	return "";
 }
 
+void IBM8b10bWaveform::RenderText(size_t start, size_t end)
+{
+	//Text depends on the data, control/error flags, and sign of the running disparity
+	RenderTextByKey(start, end, 8*256, [this](size_t i)
+	{
+		const IBM8b10bSymbol& s = m_samples[i];
+		return (s.m_error << 10) | (s.m_control << 9) | ( (s.m_disparity < 0) << 8) | s.m_data;
+	});
+}
+
@@ -71,6 +71,9 @@ public:
 	virtual Gdk::Color GetColor(size_t) override;
 
 	FilterParameter& m_displayformat;
+
+protected:
+	virtual void RenderText(size_t start, size_t end) override;
 };
 
 class IBM8b10bDecoder : public Filter
@@ -82,17 +82,15 @@ void IPv4Decoder::Refresh()
 	size_t len = din->m_samples.size();
 
 	//Loop over the events and process stuff
-	auto cap = new IPv4Waveform;
+	auto cap = SetupEmptyOutputWaveform<IPv4Waveform>(din, 0);
 	cap->PrepareForCpuAccess();
-	cap->m_timescale = din->m_timescale;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
 
 	int state = 0;
 	int header_len = 0;
 	for(size_t i=0; i<len; i++)
 	{
 		auto s = din->m_samples[i];
+		auto sdata = din->GetSymbolData(i);
 		int64_t halfdur = din->m_durations[i]/2;
 
 		switch(state)
@@ -123,7 +121,7 @@ void IPv4Decoder::Refresh()
 			case 3:
 				if(s.m_type == EthernetFrameSegment::TYPE_ETHERTYPE)
 				{
-					uint16_t ethertype = (s.m_data[0] << 8) | s.m_data[1];
+					uint16_t ethertype = (sdata[0] << 8) | sdata[1];
 
 					//802.1q tag
 					if(ethertype == 0x8100)
@@ -154,14 +152,14 @@ void IPv4Decoder::Refresh()
 			case 5:
 				if(s.m_type == EthernetFrameSegment::TYPE_PAYLOAD)
 				{
-					uint8_t data = s.m_data[0];
+					uint8_t data = sdata[0];
 
 					//Expect 0x4-something for IP version
 					if( (data >> 4) == 4)
 					{
 						cap->m_offsets.push_back(din->m_offsets[i]);
 						cap->m_durations.push_back(halfdur);
-						cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_VERSION, 4));
+						cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_VERSION), 4);
 					}
 					else
 					{
@@ -174,7 +172,7 @@ void IPv4Decoder::Refresh()
 
 					cap->m_offsets.push_back(din->m_offsets[i] + halfdur);
 					cap->m_durations.push_back(halfdur);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_HEADER_LEN, header_len));
+					cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_HEADER_LEN), header_len);
 
 					state = 6;
 				}
@@ -189,7 +187,7 @@ void IPv4Decoder::Refresh()
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_DIFFSERV, s.m_data[0]));
+					cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_DIFFSERV), sdata[0]);
 					state = 7;
 				}
 				else
@@ -202,7 +200,7 @@ void IPv4Decoder::Refresh()
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_LENGTH, s.m_data[0]));
+					cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_LENGTH), sdata[0]);
 					state = 8;
 				}
 				else
@@ -214,7 +212,7 @@ void IPv4Decoder::Refresh()
 					//Append to the previous sample
 					size_t n = cap->m_offsets.size() - 1;
 					cap->m_durations[n] = din->m_offsets[i] + din->m_durations[i] - cap->m_offsets[n];
-					cap->m_samples[n].m_data.push_back(s.m_data[0]);
+					cap->AppendSymbolData(cap->m_samples[n], sdata[0]);
 					state = 9;
 				}
 				else
@@ -227,7 +225,7 @@ void IPv4Decoder::Refresh()
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_ID, s.m_data[0]));
+					cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_ID), sdata[0]);
 					state = 10;
 				}
 				else
@@ -239,7 +237,7 @@ void IPv4Decoder::Refresh()
 					//Append to the previous sample
 					size_t n = cap->m_offsets.size() - 1;
 					cap->m_durations[n] = din->m_offsets[i] + din->m_durations[i] - cap->m_offsets[n];
-					cap->m_samples[n].m_data.push_back(s.m_data[0]);
+					cap->AppendSymbolData(cap->m_samples[n], sdata[0]);
 					state = 11;
 				}
 				else
@@ -253,12 +251,12 @@ void IPv4Decoder::Refresh()
 					//Flags
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(halfdur);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_FLAGS, s.m_data[0] >> 5));
+					cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_FLAGS), sdata[0] >> 5);
 
 					//Frag offset, high 5 bits
 					cap->m_offsets.push_back(din->m_offsets[i] + halfdur);
 					cap->m_durations.push_back(halfdur);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_FRAG_OFFSET, s.m_data[0] & 0x1f));
+					cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_FRAG_OFFSET), sdata[0] & 0x1f);
 					state = 12;
 				}
 				else
@@ -270,7 +268,7 @@ void IPv4Decoder::Refresh()
 					//Append to the previous sample
 					size_t n = cap->m_offsets.size() - 1;
 					cap->m_durations[n] = din->m_offsets[i] + din->m_durations[i] - cap->m_offsets[n];
-					cap->m_samples[n].m_data.push_back(s.m_data[0]);
+					cap->AppendSymbolData(cap->m_samples[n], sdata[0]);
 					state = 13;
 				}
 				else
@@ -283,7 +281,7 @@ void IPv4Decoder::Refresh()
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_TTL, s.m_data[0]));
+					cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_TTL), sdata[0]);
 					state = 14;
 				}
 				else
@@ -296,7 +294,7 @@ void IPv4Decoder::Refresh()
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_PROTOCOL, s.m_data[0]));
+					cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_PROTOCOL), sdata[0]);
 					state = 15;
 				}
 				else
@@ -309,7 +307,7 @@ void IPv4Decoder::Refresh()
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_HEADER_CHECKSUM, s.m_data[0]));
+					cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_HEADER_CHECKSUM), sdata[0]);
 					state = 16;
 				}
 				else
@@ -321,7 +319,7 @@ void IPv4Decoder::Refresh()
 					//Append to the previous sample
 					size_t n = cap->m_offsets.size() - 1;
 					cap->m_durations[n] = din->m_offsets[i] + din->m_durations[i] - cap->m_offsets[n];
-					cap->m_samples[n].m_data.push_back(s.m_data[0]);
+					cap->AppendSymbolData(cap->m_samples[n], sdata[0]);
 					state = 17;
 				}
 				else
@@ -334,7 +332,7 @@ void IPv4Decoder::Refresh()
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_SOURCE_IP, s.m_data[0]));
+					cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_SOURCE_IP), sdata[0]);
 					state = 18;
 				}
 				else
@@ -348,7 +346,7 @@ void IPv4Decoder::Refresh()
 					//Append to the previous sample
 					size_t n = cap->m_offsets.size() - 1;
 					cap->m_durations[n] = din->m_offsets[i] + din->m_durations[i] - cap->m_offsets[n];
-					cap->m_samples[n].m_data.push_back(s.m_data[0]);
+					cap->AppendSymbolData(cap->m_samples[n], sdata[0]);
 					state++;
 				}
 				else
@@ -361,7 +359,7 @@ void IPv4Decoder::Refresh()
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_DEST_IP, s.m_data[0]));
+					cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_DEST_IP), sdata[0]);
 					state = 22;
 				}
 				else
@@ -375,7 +373,7 @@ void IPv4Decoder::Refresh()
 					//Append to the previous sample
 					size_t n = cap->m_offsets.size() - 1;
 					cap->m_durations[n] = din->m_offsets[i] + din->m_durations[i] - cap->m_offsets[n];
-					cap->m_samples[n].m_data.push_back(s.m_data[0]);
+					cap->AppendSymbolData(cap->m_samples[n], sdata[0]);
 					state++;
 				}
 				else
@@ -388,7 +386,7 @@ void IPv4Decoder::Refresh()
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(IPv4Symbol(IPv4Symbol::TYPE_DATA, s.m_data[0]));
+					cap->PushSymbol(IPv4Symbol(IPv4Symbol::TYPE_DATA), sdata[0]);
 				}
 
 				//terminate the packet on FCS or error
@@ -445,26 +443,27 @@ string IPv4Waveform::GetText(size_t i)
 	char tmp[128];
 
 	auto sample = m_samples[i];
+	auto data = GetSymbolData(i);
 	switch(sample.m_type)
 	{
 		case IPv4Symbol::TYPE_VERSION:
-			snprintf(tmp, sizeof(tmp), "V%d", sample.m_data[0]);
+			snprintf(tmp, sizeof(tmp), "V%d", data[0]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_HEADER_LEN:
-			if(sample.m_data[0] == 5)
+			if(data[0] == 5)
 				return "No opts";
 			else
 			{
-				snprintf(tmp, sizeof(tmp), "%d header words", sample.m_data[0]);
+				snprintf(tmp, sizeof(tmp), "%d header words", data[0]);
 				return string(tmp);
 			}
 
 		case IPv4Symbol::TYPE_DIFFSERV:
 			{
-				snprintf(tmp, sizeof(tmp), "DSCP: %d", sample.m_data[0] >> 2);
+				snprintf(tmp, sizeof(tmp), "DSCP: %d", data[0] >> 2);
 				string ret = tmp;
-				switch(sample.m_data[0] & 0x3)
+				switch(data[0] & 0x3)
 				{
 					case 0:
 						ret += ", Non-ECT";
@@ -486,21 +485,21 @@ string IPv4Waveform::GetText(size_t i)
 			}
 
 		case IPv4Symbol::TYPE_LENGTH:
-			snprintf(tmp, sizeof(tmp), "Length: %d", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "Length: %d", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_ID:
-			snprintf(tmp, sizeof(tmp), "ID: 0x%04x", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "ID: 0x%04x", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_FLAGS:
 			{
 				string ret;
-				if(sample.m_data[0] & 4)
+				if(data[0] & 4)
 					ret = "Evil ";
-				if(sample.m_data[0] & 2)
+				if(data[0] & 2)
 					ret += "DF ";
-				if(sample.m_data[0] & 1)
+				if(data[0] & 1)
 					ret += "MF ";
 				if(ret == "")
 					ret = "No flag";
@@ -508,15 +507,15 @@ string IPv4Waveform::GetText(size_t i)
 			}
 
 		case IPv4Symbol::TYPE_FRAG_OFFSET:
-			snprintf(tmp, sizeof(tmp), "Offset: 0x%04x", 8*( (sample.m_data[0] << 8) | sample.m_data[1]));
+			snprintf(tmp, sizeof(tmp), "Offset: 0x%04x", 8*( (data[0] << 8) | data[1]));
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_TTL:
-			snprintf(tmp, sizeof(tmp), "TTL: %d", sample.m_data[0]);
+			snprintf(tmp, sizeof(tmp), "TTL: %d", data[0]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_PROTOCOL:
-			switch(sample.m_data[0])
+			switch(data[0])
 			{
 				case 0x01:
 					return "ICMP";
@@ -538,28 +537,28 @@ string IPv4Waveform::GetText(size_t i)
 					return "FCoIP";
 
 				default:
-					snprintf(tmp, sizeof(tmp), "Protocol: 0x%02x", sample.m_data[0]);
+					snprintf(tmp, sizeof(tmp), "Protocol: 0x%02x", data[0]);
 					return string(tmp);
 			}
 			break;
 
 		case IPv4Symbol::TYPE_HEADER_CHECKSUM:
-			snprintf(tmp, sizeof(tmp), "Checksum: 0x%04x", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "Checksum: 0x%04x", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_SOURCE_IP:
 			snprintf(tmp, sizeof(tmp), "Source: %d.%d.%d.%d",
-				sample.m_data[0], sample.m_data[1], sample.m_data[2], sample.m_data[3]);
+				data[0], data[1], data[2], data[3]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_DEST_IP:
 			snprintf(tmp, sizeof(tmp), "Dest: %d.%d.%d.%d",
-				sample.m_data[0], sample.m_data[1], sample.m_data[2], sample.m_data[3]);
+				data[0], data[1], data[2], data[3]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_DATA:
 		case IPv4Symbol::TYPE_OPTIONS:
-			snprintf(tmp, sizeof(tmp), "%02x", sample.m_data[0]);
+			snprintf(tmp, sizeof(tmp), "%02x", data[0]);
 			return string(tmp);
 
 		case IPv4Symbol::TYPE_ERROR:
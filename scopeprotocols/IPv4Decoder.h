@@ -35,7 +35,12 @@
 #ifndef IPv4Decoder_h
 #define IPv4Decoder_h
 
-class IPv4Symbol
+/**
+	@brief One field of an IPv4 header
+
+	Field bytes live in the IPv4Waveform's arena (see IPv4Waveform::GetSymbolData()).
+ */
+class IPv4Symbol : public ArenaSymbol
 {
 public:
 
@@ -58,25 +63,18 @@ public:
 		TYPE_DATA
 	} m_type;
 
-	std::vector<uint8_t> m_data;
-
 	IPv4Symbol()
 	{}
 
-	IPv4Symbol(SegmentType type, uint8_t value)
+	IPv4Symbol(SegmentType type)
 		: m_type(type)
-	{ m_data.push_back(value); }
-
-	bool operator==(const IPv4Symbol& rhs) const
-	{
-		return (m_data == rhs.m_data) && (m_type == rhs.m_type);
-	}
+	{}
 };
 
-class IPv4Waveform : public SparseWaveform<IPv4Symbol>
+class IPv4Waveform : public ArenaSparseWaveform<IPv4Symbol>
 {
 public:
-	IPv4Waveform () : SparseWaveform<IPv4Symbol>() {};
+	IPv4Waveform () : ArenaSparseWaveform<IPv4Symbol>() {};
 	virtual std::string GetText(size_t) override;
 	virtual Gdk::Color GetColor(size_t) override;
 };
@@ -0,0 +1,492 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Implementation of JitterAnalysisEngine
+ */
+
+#include "scopeprotocols.h"
+
+using namespace std;
+
+mutex JitterAnalysisEngine::m_enginesMutex;
+map<JitterAnalysisEngine::EngineKey, weak_ptr<JitterAnalysisEngine> > JitterAnalysisEngine::m_engines;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+JitterAnalysisEngine::JitterAnalysisEngine()
+{
+	Clear();
+}
+
+/**
+	@brief Gets the engine for a set of source streams, creating it if nobody else is using it yet
+
+	The DDJ tables depend on which data and clock the TIE was sampled against, so filters only share an engine if all
+	three inputs match. Filters that only look at the TIE itself (like the spectrum) leave data and clock empty.
+
+	@param tie		TIE stream
+	@param data		Thresholded data stream, if any
+	@param clock	Recovered clock stream, if any
+ */
+shared_ptr<JitterAnalysisEngine> JitterAnalysisEngine::GetEngine(
+	StreamDescriptor tie,
+	StreamDescriptor data,
+	StreamDescriptor clock)
+{
+	lock_guard<mutex> lock(m_enginesMutex);
+
+	EngineKey key(tie, data, clock);
+	auto engine = m_engines[key].lock();
+	if(!engine)
+	{
+		engine = make_shared<JitterAnalysisEngine>();
+		m_engines[key] = engine;
+	}
+	return engine;
+}
+
+/**
+	@brief Discards all accumulated jitter data
+ */
+void JitterAnalysisEngine::Clear()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	m_lastTIE = WaveformCacheKey();
+	m_lastData = WaveformCacheKey();
+	m_lastClock = WaveformCacheKey();
+
+	for(int i=0; i<256; i++)
+	{
+		m_ddjCounts[i] = 0;
+		m_ddjSums[i] = 0;
+		m_ddjTable[i] = 0;
+	}
+	m_ddjPeakToPeak = 0;
+	m_lastIndexes.clear();
+	m_lastWindows.clear();
+
+	m_residualCount = 0;
+	m_residualMean = 0;
+	m_residualM2 = 0;
+
+	m_tieStats.Clear();
+
+	m_spectrumSum.clear();
+	m_spectrumBinWidth = 0;
+	m_spectrumCount = 0;
+	m_lastSpectrumTIE = WaveformCacheKey();
+}
+
+/**
+	@brief Discards the averaged spectrum only
+ */
+void JitterAnalysisEngine::ClearSpectrum()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	m_spectrumSum.clear();
+	m_spectrumBinWidth = 0;
+	m_spectrumCount = 0;
+	m_lastSpectrumTIE = WaveformCacheKey();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Integration
+
+/**
+	@brief Adds a new TIE waveform, and the data it was measured on, to the running tables
+
+	Does nothing if these exact input revisions were already integrated.
+
+	@param tie		TIE waveform
+	@param data		Thresholded data signal
+	@param clock	Recovered clock for sampling data
+ */
+void JitterAnalysisEngine::Integrate(SparseAnalogWaveform* tie, WaveformBase* data, WaveformBase* clock)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if( (m_lastTIE == tie) && (m_lastData == data) && (m_lastClock == clock) )
+		return;
+	m_lastTIE = WaveformCacheKey(tie);
+	m_lastData = WaveformCacheKey(data);
+	m_lastClock = WaveformCacheKey(clock);
+	m_lastIndexes.clear();
+	m_lastWindows.clear();
+
+	m_tieStats.Integrate(tie, true);
+
+	tie->PrepareForCpuAccess();
+	auto psamples = Filter::GetSampledOnAnyEdges<bool>(data, clock);
+	auto& samples = *psamples;
+
+	//DDJ history (8 UIs)
+	uint8_t window = 0;
+
+	size_t tielen = tie->size();
+	size_t samplen = samples.size();
+	if( (tielen == 0) || (samplen == 0) )
+		return;
+
+	//Matched (history, TIE) pairs from this waveform, for the residual pass
+	auto& windows = m_lastWindows;
+	vector<float> ties;
+	windows.reserve(tielen);
+	ties.reserve(tielen);
+	m_lastIndexes.reserve(tielen);
+
+	size_t itie = 0;
+
+	//Loop over the TIE and threshold waveform and assign jitter to bins
+	size_t nbits = 0;
+	int64_t tfirst = GetOffsetScaled(tie, 0);
+	for(size_t idata=0; idata < samplen; idata ++)
+	{
+		//Sample the next bit in the thresholded waveform
+		window = (window >> 1);
+		if(samples.m_samples[idata])
+			window |= 0x80;
+		nbits ++;
+
+		//need 8 in last_window, plus one more for the current bit
+		if(nbits < 9)
+			continue;
+
+		//If we're still before the first TIE sample, nothing to do
+		int64_t tstart = samples.m_offsets[idata];
+		if(tstart < tfirst)
+			continue;
+
+		//Advance TIE samples if needed
+		int64_t target = 0;
+		while( (target < tfirst) && (itie < tielen) )
+		{
+			target = GetOffsetScaled(tie, itie);
+
+			if(target < tstart)
+				itie ++;
+		}
+		if(itie >= tielen)
+			break;
+
+		//If the TIE sample is after this bit, don't do anything.
+		//We need edges within this UI.
+		int64_t tend = tstart + samples.m_durations[idata];
+		if(target > tend)
+			continue;
+
+		//Save the info in the DDJ table
+		float t = tie->m_samples[itie];
+		m_ddjCounts[window] ++;
+		m_ddjSums[window] += t;
+		windows.push_back(window);
+		ties.push_back(t);
+		m_lastIndexes.push_back(itie);
+	}
+
+	UpdateDDJTable();
+
+	//Subtract the averaged DDJ to get the uncorrelated jitter, then merge its deviations into the running total
+	size_t n = ties.size();
+	if(n)
+	{
+		double sum = 0;
+		for(size_t i=0; i<n; i++)
+			sum += ties[i] - m_ddjTable[windows[i]];
+		double mean = sum / n;
+
+		double m2 = 0;
+		for(size_t i=0; i<n; i++)
+		{
+			double d = (ties[i] - m_ddjTable[windows[i]]) - mean;
+			m2 += d*d;
+		}
+
+		if(m_residualCount == 0)
+		{
+			m_residualMean = mean;
+			m_residualM2 = m2;
+		}
+		else
+		{
+			double total = m_residualCount + n;
+			double delta = mean - m_residualMean;
+			m_residualMean += delta * n / total;
+			m_residualM2 += m2 + delta*delta * m_residualCount * n / total;
+		}
+		m_residualCount += n;
+	}
+}
+
+/**
+	@brief Adds a new TIE waveform to the running histogram only, for views with no data or clock to sample against
+
+	Does nothing if this revision was already integrated.
+ */
+void JitterAnalysisEngine::IntegrateTIE(SparseAnalogWaveform* tie)
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_tieStats.Integrate(tie, true);
+}
+
+/**
+	@brief Recalculates the average jitter for each data history, and the DDJ peak-to-peak
+ */
+void JitterAnalysisEngine::UpdateDDJTable()
+{
+	float ddjmin =  FLT_MAX;
+	float ddjmax = 0;
+	for(size_t i=0; i<256; i++)
+	{
+		if(m_ddjCounts[i] != 0)
+		{
+			float jitter = m_ddjSums[i] / m_ddjCounts[i];
+			m_ddjTable[i] = jitter;
+			ddjmin = min(ddjmin, jitter);
+			ddjmax = max(ddjmax, jitter);
+		}
+		else
+			m_ddjTable[i] = 0;
+	}
+
+	if(ddjmin > ddjmax)
+		m_ddjPeakToPeak = 0;
+	else
+		m_ddjPeakToPeak = ddjmax - ddjmin;
+}
+
+/**
+	@brief Adds a new magnitude spectrum to the running average, and replaces it with the average
+
+	The average restarts if the bin count or spacing changes. If the spectrum of this TIE waveform was already added
+	(by another spectrum filter on the same stream), it's only overwritten with the current average.
+
+	@param tie			The TIE waveform the spectrum was calculated from
+	@param magnitudes	Spectrum to add, overwritten with the average
+	@param len			Number of bins
+	@param binwidth		Bin spacing, in Hz
+ */
+void JitterAnalysisEngine::AverageSpectrum(WaveformBase* tie, float* magnitudes, size_t len, double binwidth)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if( (m_spectrumSum.size() != len) || (fabs(m_spectrumBinWidth - binwidth) > 1e-6 * binwidth) )
+	{
+		m_spectrumSum.assign(len, 0);
+		m_spectrumBinWidth = binwidth;
+		m_spectrumCount = 0;
+		m_lastSpectrumTIE = WaveformCacheKey();
+	}
+
+	if(m_lastSpectrumTIE != tie)
+	{
+		m_lastSpectrumTIE = WaveformCacheKey(tie);
+		m_spectrumCount ++;
+		for(size_t i=0; i<len; i++)
+			m_spectrumSum[i] += magnitudes[i];
+	}
+
+	double scale = 1.0 / m_spectrumCount;
+	for(size_t i=0; i<len; i++)
+		magnitudes[i] = m_spectrumSum[i] * scale;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+/**
+	@brief Copies out the average TIE for each 8-bit data history (oldest bit in the LSB)
+ */
+void JitterAnalysisEngine::GetDDJTable(float* table)
+{
+	lock_guard<mutex> lock(m_mutex);
+	memcpy(table, m_ddjTable, sizeof(m_ddjTable));
+}
+
+float JitterAnalysisEngine::GetDDJPeakToPeak()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_ddjPeakToPeak;
+}
+
+/**
+	@brief Gets the RMS of the uncorrelated (Rj + BUj) jitter
+ */
+double JitterAnalysisEngine::GetUncorrelatedJitter()
+{
+	lock_guard<mutex> lock(m_mutex);
+	if(m_residualCount == 0)
+		return 0;
+	return sqrt(m_residualM2 / m_residualCount);
+}
+
+/**
+	@brief Extrapolates total jitter at a given bit error rate with the dual-Dirac model
+
+	TJ = DDJ + PJ + 2 * Q(BER) * RJ, with DDJ taken as the DDJ peak-to-peak and RJ as the RMS uncorrelated jitter.
+
+	If an engine with an averaged TIE spectrum is given (see GetPeriodicJitter()), the tones found in it are counted
+	as PJ at their peak-to-peak amplitude and their power is removed from RJ. Otherwise PJ is lumped into RJ, which
+	overstates TJ when there's a lot of it.
+
+	@param ber		Target bit error rate
+	@param spectrum	Engine holding the averaged spectrum of the same TIE stream, may be this engine or NULL
+ */
+double JitterAnalysisEngine::GetTotalJitter(double ber, JitterAnalysisEngine* spectrum)
+{
+	double rj = GetUncorrelatedJitter();
+
+	double pjRMS = 0;
+	double pjPeakToPeak = 0;
+	if(spectrum && spectrum->GetPeriodicJitter(pjRMS, pjPeakToPeak))
+		rj = sqrt(max(0.0, rj*rj - pjRMS*pjRMS));
+
+	return GetDDJPeakToPeak() + pjPeakToPeak + 2 * GetQ(ber) * rj;
+}
+
+/**
+	@brief Finds periodic jitter tones in the averaged TIE spectrum
+
+	The random floor is taken as the median bin, and runs of adjacent bins more than 20 dB above it are one tone each
+	(so window leakage doesn't count a tone twice). The spectrum bins are RMS amplitudes, so each tone's RMS is the
+	square root of its power above the floor, and its peak-to-peak is 2 * sqrt(2) times that. Window leakage makes
+	the power a little high, which errs on the safe side for TJ.
+
+	Since the spectrum is of the raw TIE, DDJ on a short repeating pattern also shows up as tones and is counted twice.
+
+	@param rms			Total RMS of all tones
+	@param peakToPeak	Sum of the peak-to-peak amplitudes of all tones
+
+	@return False if no spectrum has been averaged yet
+ */
+bool JitterAnalysisEngine::GetPeriodicJitter(double& rms, double& peakToPeak)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	rms = 0;
+	peakToPeak = 0;
+	if( (m_spectrumCount == 0) || (m_spectrumSum.size() < 3) )
+		return false;
+
+	//Skip the DC bin
+	size_t len = m_spectrumSum.size();
+	vector<double> bins(m_spectrumSum.begin() + 1, m_spectrumSum.end());
+	for(auto& b : bins)
+		b /= m_spectrumCount;
+
+	vector<double> sorted = bins;
+	nth_element(sorted.begin(), sorted.begin() + sorted.size()/2, sorted.end());
+	double noise = sorted[sorted.size()/2];
+	double threshold = 10 * noise;
+	double noisePower = noise * noise;
+
+	double totalPower = 0;
+	double tonePower = 0;
+	for(size_t i=0; i<len; i++)
+	{
+		bool tone = (i < bins.size()) && (bins[i] > threshold);
+		if(tone)
+			tonePower += bins[i]*bins[i] - noisePower;
+
+		//End of a run of tone bins
+		else if(tonePower > 0)
+		{
+			totalPower += tonePower;
+			peakToPeak += 2 * M_SQRT2 * sqrt(tonePower);
+			tonePower = 0;
+		}
+	}
+
+	rms = sqrt(totalPower);
+	return true;
+}
+
+/**
+	@brief Calculates the uncorrelated (Rj + BUj) jitter of the last integrated TIE waveform
+
+	Every UI matched to a data history gets its TIE minus the current DDJ table entry. Other samples are left alone.
+
+	@param tie	The TIE waveform, which must be the one last passed to Integrate()
+	@param out	Output waveform, with the same sample count as tie
+
+	@return False if tie isn't the last waveform integrated
+ */
+bool JitterAnalysisEngine::GetResiduals(SparseAnalogWaveform* tie, SparseAnalogWaveform* out)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if(m_lastTIE != tie)
+		return false;
+
+	for(size_t i=0; i<m_lastIndexes.size(); i++)
+	{
+		size_t itie = m_lastIndexes[i];
+		out->m_samples[itie] = tie->m_samples[itie] - m_ddjTable[m_lastWindows[i]];
+	}
+	return true;
+}
+
+/**
+	@brief Gets a copy of the TIE statistics and histogram, accumulated since the last Clear()
+ */
+RunningStatistics JitterAnalysisEngine::GetTIEStatistics()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_tieStats;
+}
+
+/**
+	@brief Finds Q such that the Gaussian tail probability 0.5 * erfc(Q / sqrt(2)) equals the given BER
+ */
+double JitterAnalysisEngine::GetQ(double ber)
+{
+	if(ber <= 0)
+		return 0;
+	if(ber >= 0.5)
+		return 0;
+
+	//Tail probability is monotonic in Q, so bisect
+	double lo = 0;
+	double hi = 40;
+	for(int i=0; i<100; i++)
+	{
+		double mid = (lo + hi) / 2;
+		if(0.5 * erfc(mid / M_SQRT2) > ber)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return (lo + hi) / 2;
+}
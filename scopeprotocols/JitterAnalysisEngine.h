@@ -0,0 +1,122 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of JitterAnalysisEngine
+ */
+#ifndef JitterAnalysisEngine_h
+#define JitterAnalysisEngine_h
+
+#include <tuple>
+
+/**
+	@brief Running jitter decomposition for one TIE stream, accumulated across triggers
+
+	Every jitter filter with the same TIE, data and clock inputs shares one engine (see GetEngine()), and each new
+	waveform is only integrated once no matter how many of them are displayed. Work per refresh is proportional to the new data only:
+
+	* DDJ: average TIE for each 8-bit data history, as running sums and counts
+	* Uncorrelated jitter (Rj + BUj): running mean and variance of TIE with the DDJ table subtracted
+	* TIE histogram and statistics, as RunningStatistics
+	* TIE spectrum: running average of the magnitude spectrum, per bin
+
+	Filters may refresh in parallel, so everything is behind m_mutex.
+ */
+class JitterAnalysisEngine
+{
+public:
+	JitterAnalysisEngine();
+
+	static std::shared_ptr<JitterAnalysisEngine> GetEngine(
+		StreamDescriptor tie,
+		StreamDescriptor data = StreamDescriptor(),
+		StreamDescriptor clock = StreamDescriptor());
+
+	void Clear();
+	void ClearSpectrum();
+
+	void Integrate(SparseAnalogWaveform* tie, WaveformBase* data, WaveformBase* clock);
+	void IntegrateTIE(SparseAnalogWaveform* tie);
+
+	void GetDDJTable(float* table);
+	float GetDDJPeakToPeak();
+	double GetUncorrelatedJitter();
+	double GetTotalJitter(double ber, JitterAnalysisEngine* spectrum = NULL);
+	bool GetPeriodicJitter(double& rms, double& peakToPeak);
+	bool GetResiduals(SparseAnalogWaveform* tie, SparseAnalogWaveform* out);
+	RunningStatistics GetTIEStatistics();
+
+	void AverageSpectrum(WaveformBase* tie, float* magnitudes, size_t len, double binwidth);
+
+	static double GetQ(double ber);
+
+protected:
+	void UpdateDDJTable();
+
+	std::mutex m_mutex;
+
+	//Input revisions we last integrated, so filters sharing the engine don't integrate the same data twice
+	WaveformCacheKey m_lastTIE;
+	WaveformCacheKey m_lastData;
+	WaveformCacheKey m_lastClock;
+
+	//DDJ history
+	uint64_t m_ddjCounts[256];
+	double m_ddjSums[256];
+	float m_ddjTable[256];
+	float m_ddjPeakToPeak;
+
+	//TIE sample index and data history of every matched UI in the last TIE waveform, for GetResiduals()
+	std::vector<size_t> m_lastIndexes;
+	std::vector<uint8_t> m_lastWindows;
+
+	//Residual (TIE minus DDJ), merged with the parallel form of Welford's algorithm
+	uint64_t m_residualCount;
+	double m_residualMean;
+	double m_residualM2;
+
+	RunningStatistics m_tieStats;
+
+	//Spectrum average
+	WaveformCacheKey m_lastSpectrumTIE;
+	std::vector<double> m_spectrumSum;
+	double m_spectrumBinWidth;
+	size_t m_spectrumCount;
+
+	///@brief Source streams an engine was created for: TIE, data and clock
+	typedef std::tuple<StreamDescriptor, StreamDescriptor, StreamDescriptor> EngineKey;
+
+	static std::mutex m_enginesMutex;
+	static std::map<EngineKey, std::weak_ptr<JitterAnalysisEngine> > m_engines;
+};
+
+#endif
@@ -29,6 +29,7 @@
 
 #include "../scopehal/scopehal.h"
 #include "../scopehal/AlignedAllocator.h"
+#include "JitterAnalysisEngine.h"
 #include "JitterSpectrumFilter.h"
 
 using namespace std;
@@ -38,10 +39,14 @@ using namespace std;
 
 JitterSpectrumFilter::JitterSpectrumFilter(const string& color)
 	: FFTFilter(color)
+	, m_averageName("Average Across Triggers")
 {
 	m_xAxisUnit = Unit(Unit::UNIT_HZ);
 	SetYAxisUnits(Unit(Unit::UNIT_FS), 0);
 	m_category = CAT_ANALYSIS;
+
+	m_parameters[m_averageName] = FilterParameter(FilterParameter::TYPE_BOOL, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_averageName].SetBoolVal(false);
 }
 
 JitterSpectrumFilter::~JitterSpectrumFilter()
@@ -76,6 +81,12 @@ string JitterSpectrumFilter::GetProtocolName()
 	return "Jitter Spectrum";
 }
 
+void JitterSpectrumFilter::ClearSweeps()
+{
+	if(m_engine)
+		m_engine->ClearSpectrum();
+}
+
 Filter::DataLocation JitterSpectrumFilter::GetInputLocation()
 {
 	//We explicitly manage our input memory and don't care where it is when Refresh() is called
@@ -213,4 +224,20 @@ void JitterSpectrumFilter::Refresh(vk::raii::CommandBuffer& cmdBuf, vk::raii::Qu
 
 	//and do the actual FFT processing
 	DoRefresh(din, extended_samples, ui_width_final, npoints, nouts, false, cmdBuf, queue);
+
+	//Average magnitudes across triggers, so periodic jitter stands out of the random floor.
+	//Only the new spectrum is added each time; the average restarts if the length or bin spacing changes.
+	if(m_parameters[m_averageName].GetBoolVal())
+	{
+		m_engine = JitterAnalysisEngine::GetEngine(GetInput(0));
+
+		auto cap = dynamic_cast<UniformAnalogWaveform*>(GetData(0));
+		cap->PrepareForCpuAccess();
+		m_engine->AverageSpectrum(din, cap->m_samples.GetCpuPointer(), cap->size(), cap->m_timescale);
+		cap->MarkModifiedFromCpu();
+
+		FindPeaks(cap);
+	}
+	else
+		m_engine = nullptr;
 }
@@ -37,6 +37,8 @@
 
 #include "FFTFilter.h"
 
+class JitterAnalysisEngine;
+
 class JitterSpectrumFilter : public FFTFilter
 {
 public:
@@ -45,6 +47,7 @@ public:
 
 	virtual void Refresh(vk::raii::CommandBuffer& cmdBuf, vk::raii::Queue& queue);
 	virtual DataLocation GetInputLocation();
+	virtual void ClearSweeps();
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream);
 
@@ -54,6 +57,10 @@ public:
 
 protected:
 	size_t EstimateUIWidth(SparseAnalogWaveform* din);
+
+	std::string m_averageName;
+
+	std::shared_ptr<JitterAnalysisEngine> m_engine;
 };
 
 #endif
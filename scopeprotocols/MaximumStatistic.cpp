@@ -33,7 +33,7 @@ using namespace std;
 
 void MaximumStatistic::Clear()
 {
-	m_pastMaximums.clear();
+	ClearRunningStatistics();
 }
 
 string MaximumStatistic::GetStatisticName()
@@ -43,29 +43,12 @@ string MaximumStatistic::GetStatisticName()
 
 bool MaximumStatistic::Calculate(StreamDescriptor stream, double& value)
 {
-	//Starting value is previous maximum, if we have one
-	value = -1e20;
-	if(m_pastMaximums.find(stream) != m_pastMaximums.end())
-		value = m_pastMaximums[stream];
-
-	//Get input data
-	auto w = stream.GetData();
-	auto udata = dynamic_cast<UniformAnalogWaveform*>(w);
-	auto sdata = dynamic_cast<SparseAnalogWaveform*>(w);
-
 	//Add new sample data
-	if(udata)
-	{
-		for(auto sample : udata->m_samples)
-			value = max(value, (double)sample);
-	}
-	else if(sdata)
-	{
-		for(auto sample : sdata->m_samples)
-			value = max(value, (double)sample);
-	}
-
-	m_pastMaximums[stream] = value;
+	auto stats = GetRunningStatistics(stream);
+	stats->Integrate(stream.GetData(), false);
 
+	value = -1e20;
+	if(stats->GetCount())
+		value = stats->GetMaximum();
 	return true;
 }
@@ -44,9 +44,6 @@ public:
 	virtual bool Calculate(StreamDescriptor stream, double& value);
 
 	STATISTIC_INITPROC(MaximumStatistic)
-
-protected:
-	std::map<StreamDescriptor, double> m_pastMaximums;
 };
 
 #endif
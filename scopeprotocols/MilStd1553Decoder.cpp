@@ -38,6 +38,17 @@ using namespace std;
 
 MilStd1553Decoder::MilStd1553Decoder(const string& color)
 	: PacketDecoder(color, CAT_BUS)
+	, m_resumeSample(0)
+	, m_state(STATE_IDLE)
+	, m_frameState(FRAME_STATE_IDLE)
+	, m_lastBit(false)
+	, m_tbitstart(0)
+	, m_bitcount(0)
+	, m_word(0)
+	, m_dataWordCount(0)
+	, m_dataWordsExpected(0)
+	, m_ctrlDirection(false)
+	, m_pack(NULL)
 {
 	CreateInput("in");
 }
@@ -79,13 +90,20 @@ vector<string> MilStd1553Decoder::GetHeaders()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+/**
+	@brief Decodes the input
+
+	If the input is a streaming capture which has only had samples appended since the last refresh, decoding resumes
+	with the state machines as they were at the end of the previous input, and new symbols and packets are appended
+	to the existing ones.
+ */
 void MilStd1553Decoder::Refresh()
 {
-	ClearPackets();
-
 	//Get the input data
 	if(!VerifyAllInputsOK())
 	{
+		ClearPackets();
+		ResetIncrementalState();
 		SetData(NULL, 0);
 		return;
 	}
@@ -97,38 +115,38 @@ void MilStd1553Decoder::Refresh()
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
 
-	//Copy our time scales from the input
-	auto cap = new MilStd1553Waveform;
-	cap->m_timescale = din->m_timescale;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
-	cap->m_triggerPhase = din->m_triggerPhase;
-	SetData(cap, 0);
-	cap->PrepareForCpuAccess();
-
-	enum
+	//Pick up where we left off if we can, otherwise start over
+	auto cap = dynamic_cast<MilStd1553Waveform*>(GetData(0));
+	if( (GetFirstNewSample(0) > 0) && (cap != NULL) )
 	{
-		STATE_IDLE,
-		STATE_SYNC_COMMAND_HIGH,
-		STATE_SYNC_COMMAND_LOW,
-		STATE_SYNC_DATA_LOW,
-		STATE_SYNC_DATA_HIGH,
-
-		STATE_DATA_0_LOW,
-		STATE_DATA_0_HIGH,
-
-		STATE_DATA_1_HIGH,
-		STATE_DATA_1_LOW,
-
-		STATE_TURNAROUND
-	} state = STATE_IDLE;
-
-	enum
+		cap->PrepareForCpuAccess();
+		m_index.Clear();
+	}
+	else
 	{
-		FRAME_STATE_IDLE,
-		FRAME_STATE_STATUS,
-		FRAME_STATE_DATA
-	} frame_state = FRAME_STATE_IDLE;
+		ClearPackets();
+		m_resumeSample = 0;
+		m_state = STATE_IDLE;
+		m_frameState = FRAME_STATE_IDLE;
+		m_lastBit = false;
+		m_tbitstart = 0;
+		m_bitstarts.clear();
+		m_bitcount = 0;
+		m_word = 0;
+		m_dataWordCount = 0;
+		m_dataWordsExpected = 0;
+		m_ctrlDirection = false;
+		m_pack = NULL;
+
+		//Copy our time scales from the input
+		cap = new MilStd1553Waveform;
+		cap->m_timescale = din->m_timescale;
+		cap->m_startTimestamp = din->m_startTimestamp;
+		cap->m_startFemtoseconds = din->m_startFemtoseconds;
+		cap->m_triggerPhase = din->m_triggerPhase;
+		SetData(cap, 0);
+		cap->PrepareForCpuAccess();
+	}
 
 	//Logic high/low thresholds (anything between is considered undefined)
 	const float high = 2;
@@ -145,16 +163,18 @@ void MilStd1553Decoder::Refresh()
 	int64_t data_len_samples	= data_len_fs / din->m_timescale;
 	int64_t ifg_len_samples		= ifg_len_fs / din->m_timescale;
 
-	bool last_bit = false;
-	int64_t tbitstart = 0;
-	vector<int64_t> bitstarts;
-	int bitcount = 0;
-	uint16_t word = 0;
-	int data_word_count = 0;
-	int data_words_expected = 0;
-	bool ctrl_direction = false;
-	Packet* pack = NULL;
-	for(size_t i=0; i<len; i++)
+	auto state = m_state;
+	auto frame_state = m_frameState;
+	bool last_bit = m_lastBit;
+	int64_t tbitstart = m_tbitstart;
+	vector<int64_t> bitstarts = m_bitstarts;
+	int bitcount = m_bitcount;
+	uint16_t word = m_word;
+	int data_word_count = m_dataWordCount;
+	int data_words_expected = m_dataWordsExpected;
+	bool ctrl_direction = m_ctrlDirection;
+	Packet* pack = m_pack;
+	for(size_t i=m_resumeSample; i<len; i++)
 	{
 		int64_t timestamp = ::GetOffset(sdin, udin, i);
 		int64_t duration = timestamp - tbitstart;
@@ -677,7 +697,24 @@ void MilStd1553Decoder::Refresh()
 		last_bit = current_bit;
 	}
 
+	m_resumeSample = len;
+	m_state = state;
+	m_frameState = frame_state;
+	m_lastBit = last_bit;
+	m_tbitstart = tbitstart;
+	m_bitstarts = bitstarts;
+	m_bitcount = bitcount;
+	m_word = word;
+	m_dataWordCount = data_word_count;
+	m_dataWordsExpected = data_words_expected;
+	m_ctrlDirection = ctrl_direction;
+	m_pack = pack;
+
+	//If the input is still growing, hold back a transaction in progress from export until it ends
+	m_lastPacketOpen = (frame_state != FRAME_STATE_IDLE) && din->IsAppendOf(din->m_revision);
+
 	cap->MarkModifiedFromCpu();
+	cap->MarkSamplesAppended();
 }
 
 Gdk::Color MilStd1553Waveform::GetColor(size_t i)
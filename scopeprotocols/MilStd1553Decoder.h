@@ -114,6 +114,47 @@ public:
 	std::vector<std::string> GetHeaders();
 
 	PROTOCOL_DECODER_INITPROC(MilStd1553Decoder)
+
+protected:
+	///@brief Low level state machine (turns line levels into bits and words)
+	enum LineState
+	{
+		STATE_IDLE,
+		STATE_SYNC_COMMAND_HIGH,
+		STATE_SYNC_COMMAND_LOW,
+		STATE_SYNC_DATA_LOW,
+		STATE_SYNC_DATA_HIGH,
+
+		STATE_DATA_0_LOW,
+		STATE_DATA_0_HIGH,
+
+		STATE_DATA_1_HIGH,
+		STATE_DATA_1_LOW,
+
+		STATE_TURNAROUND
+	};
+
+	///@brief Upper level state machine (turns words into transactions)
+	enum FrameState
+	{
+		FRAME_STATE_IDLE,
+		FRAME_STATE_STATUS,
+		FRAME_STATE_DATA
+	};
+
+	//Decoder state as of the end of the input, so appended samples can be decoded incrementally
+	size_t m_resumeSample;
+	LineState m_state;
+	FrameState m_frameState;
+	bool m_lastBit;
+	int64_t m_tbitstart;
+	std::vector<int64_t> m_bitstarts;
+	int m_bitcount;
+	uint16_t m_word;
+	int m_dataWordCount;
+	int m_dataWordsExpected;
+	bool m_ctrlDirection;
+	Packet* m_pack;
 };
 
 #endif
@@ -33,7 +33,7 @@ using namespace std;
 
 void MinimumStatistic::Clear()
 {
-	m_pastMinimums.clear();
+	ClearRunningStatistics();
 }
 
 string MinimumStatistic::GetStatisticName()
@@ -43,29 +43,12 @@ string MinimumStatistic::GetStatisticName()
 
 bool MinimumStatistic::Calculate(StreamDescriptor stream, double& value)
 {
-	//Starting value is previous minimum, if we have one
-	value = 1e20;
-	if(m_pastMinimums.find(stream) != m_pastMinimums.end())
-		value = m_pastMinimums[stream];
-
-	//Get input data
-	auto w = stream.GetData();
-	auto udata = dynamic_cast<UniformAnalogWaveform*>(w);
-	auto sdata = dynamic_cast<SparseAnalogWaveform*>(w);
-
 	//Add new sample data
-	if(udata)
-	{
-		for(auto sample : udata->m_samples)
-			value = min(value, (double)sample);
-	}
-	else if(sdata)
-	{
-		for(auto sample : sdata->m_samples)
-			value = min(value, (double)sample);
-	}
-
-	m_pastMinimums[stream] = value;
+	auto stats = GetRunningStatistics(stream);
+	stats->Integrate(stream.GetData(), false);
 
+	value = 1e20;
+	if(stats->GetCount())
+		value = stats->GetMinimum();
 	return true;
 }
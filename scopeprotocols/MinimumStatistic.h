@@ -44,9 +44,6 @@ public:
 	virtual bool Calculate(StreamDescriptor stream, double& value);
 
 	STATISTIC_INITPROC(MinimumStatistic)
-
-protected:
-	std::map<StreamDescriptor, double> m_pastMinimums;
 };
 
 #endif
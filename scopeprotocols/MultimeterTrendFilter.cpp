@@ -164,5 +164,8 @@ void MultimeterTrendFilter::AddSample(SparseAnalogWaveform* wfm, double value, d
 	for(size_t i=0; i<len; i++)
 		wfm->m_offsets[i] -= dt;
 
+	//This is a rolling window (old samples are dropped and everything shifts in time) rather than an append,
+	//so downstream filters have to process it from scratch
 	wfm->MarkModifiedFromCpu();
+	wfm->m_revision ++;
 }
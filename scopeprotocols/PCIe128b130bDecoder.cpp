@@ -34,6 +34,7 @@
  */
 
 #include "../scopehal/scopehal.h"
+#include "../scopehal/LineCoding.h"
 #include "PCIe128b130bDecoder.h"
 
 using namespace std;
@@ -92,28 +93,18 @@ void PCIe128b130bDecoder::Refresh()
 	cap->PrepareForCpuAccess();
 
 	//Record the value of the data stream at each clock edge
-	SparseDigitalWaveform data;
-	SampleOnAnyEdgesBase(din, clkin, data);
+	auto pdata = GetSampledOnAnyEdges<bool>(din, clkin);
+	auto& data = *pdata;
 
-	//Look at each phase and figure out block alignment
-	size_t end = data.size() - 130;
-	size_t best_offset = 0;
-	size_t best_errors = end;
-	for(size_t offset=0; offset < 130; offset ++)
-	{
-		size_t errors = 0;
-		for(size_t i=offset; i<end; i+= 130)
-		{
-			if(data.m_samples[i] == data.m_samples[i+1])
-				errors ++;
-		}
+	//Pack the sampled bits so we can work on 64 UIs at a time
+	size_t nbits = data.m_samples.size();
+	PackedBitstream bits;
+	if(nbits)
+		bits.Pack(&data.m_samples[0], nbits);
 
-		if(errors < best_errors)
-		{
-			best_offset = offset;
-			best_errors = errors;
-		}
-	}
+	//Look at each phase and figure out block alignment
+	size_t end = (nbits > 130) ? nbits - 130 : 0;
+	size_t best_offset = LineCoding::FindBlockAlignment(bits, 130);
 
 	//Decode the actual data
 	uint8_t symbols[32] = {0};
@@ -121,10 +112,9 @@ void PCIe128b130bDecoder::Refresh()
 	uint32_t scrambler = 0;
 	for(size_t i=best_offset; i<end; i += 130)
 	{
-		//Extract the header bits
-		uint8_t header =
-			(data.m_samples[i] ? 2 : 0) |
-			(data.m_samples[i+1] ? 1 : 0);
+		//Extract the header bits (first bit on the wire is the MSB)
+		uint8_t h = bits.Extract(i, 2);
+		uint8_t header = ( (h & 1) << 1) | (h >> 1);
 
 		//Figure out type
 		PCIe128b130bSymbol::type_t type;
@@ -140,14 +130,15 @@ void PCIe128b130bDecoder::Refresh()
 		else
 			type = PCIe128b130bSymbol::TYPE_ORDERED_SET;
 
-		//Extract the data bytes, but don't descramble yet
+		//Extract the data bytes, but don't descramble yet.
+		//Bytes are sent LSB first so they come out of the packed stream in the right bit order.
 		size_t len = 16;
-		for(size_t j=0; j<16; j++)
+		uint64_t lo = bits.GetWindow(i + 2);
+		uint64_t hi = bits.GetWindow(i + 66);
+		for(size_t j=0; j<8; j++)
 		{
-			uint8_t tmp = 0;
-			for(size_t k=0; k<8; k++)
-				tmp |= (data.m_samples[i + j*8 + k + 2] << ( /* 7- */ k) );
-			symbols[j] = tmp;
+			symbols[j] = lo >> (j*8);
+			symbols[j+8] = hi >> (j*8);
 		}
 
 		//TODO: If this is a skip ordered set (SOS) it can vary in length if bridging is used
@@ -182,14 +173,14 @@ void PCIe128b130bDecoder::Refresh()
 			if(type == PCIe128b130bSymbol::TYPE_ORDERED_SET)
 			{
 				for(size_t j=0; j<len; j++)
-					RunScrambler(scrambler);
+					LineCoding::RunPCIeGen3Scrambler(scrambler);
 			}
 
 			//Descramble data
 			else
 			{
 				for(size_t j=0; j<len; j++)
-					symbols[j] ^= RunScrambler(scrambler);
+					symbols[j] ^= LineCoding::RunPCIeGen3Scrambler(scrambler);
 			}
 		}
 
@@ -262,21 +253,3 @@ string PCIe128b130bWaveform::GetText(size_t i)
 
 	return ret;
 }
-
-uint8_t PCIe128b130bDecoder::RunScrambler(uint32_t& state)
-{
-	uint8_t ret = 0;
-
-	for(int j=0; j<8; j++)
-	{
-		bool b22 = (state & 0x400000);
-		state <<= 1;
-		if(b22)
-		{
-			state ^= 0x210125;
-			ret |= (1 << j);
-		}
-	}
-
-	return ret;
-}
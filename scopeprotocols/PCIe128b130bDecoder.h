@@ -88,9 +88,6 @@ public:
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream);
 
 	PROTOCOL_DECODER_INITPROC(PCIe128b130bDecoder)
-
-protected:
-	uint8_t RunScrambler(uint32_t& state);
 };
 
 #endif
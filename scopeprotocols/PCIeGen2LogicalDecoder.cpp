@@ -412,3 +412,9 @@ string PCIeLogicalWaveform::GetText(size_t i)
 			return "ERROR";
 	}
 }
+
+void PCIeLogicalWaveform::RenderText(size_t start, size_t end)
+{
+	RenderTextByKey(start, end, (PCIeLogicalSymbol::TYPE_ERROR + 1) * 256, [this](size_t i)
+		{ return (m_samples[i].m_type << 8) | m_samples[i].m_data; });
+}
@@ -77,6 +77,9 @@ public:
 	PCIeLogicalWaveform () : SparseWaveform<PCIeLogicalSymbol>() {};
 	virtual std::string GetText(size_t) override;
 	virtual Gdk::Color GetColor(size_t) override;
+
+protected:
+	virtual void RenderText(size_t start, size_t end) override;
 };
 
 /**
@@ -36,6 +36,7 @@
 #include "../scopehal/Filter.h"
 #include "PCIe128b130bDecoder.h"
 #include "PCIeGen3LogicalDecoder.h"
+#include <omp.h>
 
 
 using namespace std;
@@ -131,52 +132,206 @@ void PCIeGen3LogicalDecoder::Refresh()
 		indexes.push_back(j);
 	}
 
+	//Figure out how many blocks are present on every lane after deskew
+	size_t nblocks = SIZE_MAX;
+	for(ssize_t i=0; i<nports; i++)
+	{
+		size_t len = inputs[i]->m_samples.size();
+		nblocks = min(nblocks, len - min(len, indexes[i]));
+	}
+
+	//No skip ordered set on some lane? We can't synchronize, so everything is scrambled
+	if(nblocks == 0)
+	{
+		size_t len = in0->m_offsets.size();
+		if(len)
+		{
+			cap->m_offsets.push_back(0);
+			cap->m_durations.push_back( (in0->m_offsets[len-1] + in0->m_durations[len-1]) * in0->m_timescale);
+			cap->m_samples.push_back(PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_NO_SCRAMBLER));
+		}
+
+		SetData(cap, 0);
+		cap->MarkModifiedFromCpu();
+		return;
+	}
+
+	//De-stripe all of the lanes in parallel
+	StripedStream stream;
+	stream.m_nports = nports;
+	stream.m_blocks.resize(nblocks);
+	stream.m_bytes.resize(nblocks * 16 * nports);
+	stream.m_errors.resize(nblocks * 16 * nports);
+
+	#pragma omp parallel for if(nports > 1)
+	for(ssize_t j=0; j<nports; j++)
+	{
+		auto in = inputs[j];
+		size_t base = indexes[j];
+		uint8_t* bytes = &stream.m_bytes[j];
+		uint8_t* errors = &stream.m_errors[j];
+
+		for(size_t b=0; b<nblocks; b++)
+		{
+			auto& sym = in->m_samples[base + b];
+			uint8_t error = (sym.m_type == PCIe128b130bSymbol::TYPE_ERROR);
+			size_t off = b*16*nports;
+			for(size_t k=0; k<16; k++)
+			{
+				bytes[off + k*nports] = sym.m_data[k];
+				errors[off + k*nports] = error;
+			}
+
+			//Framing of the logical stream follows lane 0
+			if(j == 0)
+			{
+				auto& block = stream.m_blocks[b];
+				block.m_start = (in->m_offsets[base + b] * in->m_timescale) + in->m_triggerPhase;
+				block.m_len = in->m_durations[base + b] * in->m_timescale;
+				block.m_orderedSet = (sym.m_type == PCIe128b130bSymbol::TYPE_ORDERED_SET);
+				block.m_orderedSetType = sym.m_data[0];
+			}
+		}
+	}
+
 	//Add "scrambler desynced" symbol from start of waveform until the first skip set in lane 0
-	int64_t symstart = (in0->m_offsets[indexes[0]] * in0->m_timescale) + in0->m_triggerPhase;
-	cap->m_offsets.push_back(0);
-	cap->m_durations.push_back(symstart);
-	cap->m_samples.push_back(PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_NO_SCRAMBLER));
+	SymbolList symbols;
+	int64_t symstart = stream.m_blocks[0].m_start;
+	symbols.push_back(0, symstart, PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_NO_SCRAMBLER));
 
 	//Pass through the skip ordered set
-	cap->m_offsets.push_back(symstart);
-	cap->m_durations.push_back(in0->m_durations[indexes[0]] * in0->m_timescale);
-	cap->m_samples.push_back(PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_SKIP));
+	symbols.push_back(symstart, stream.m_blocks[0].m_len, PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_SKIP));
 
-	//Process the input, one striped symbol at a time
-	enum
+	//Process the logical stream
+	DecodeStream(stream, symbols);
+
+	//Copy to the output
+	size_t nsyms = symbols.m_offsets.size();
+	cap->m_offsets.reserve(nsyms);
+	cap->m_durations.reserve(nsyms);
+	cap->m_samples.reserve(nsyms);
+	for(size_t i=0; i<nsyms; i++)
 	{
-		PACKET_STATE_IDLE,
-		PACKET_STATE_START_DLLP,
-		PACKET_STATE_DLLP,
-		PACKET_STATE_EDS_1,
-		PACKET_STATE_EDS_2,
-		PACKET_STATE_EDS_3,
-		PACKET_STATE_STP_1,
-		PACKET_STATE_TLP_DATA,
-		PACKET_STATE_EDB
-	} packet_state = PACKET_STATE_IDLE;
-	int64_t count = 0;
-	int64_t packet_len = 0;
-	while(true)
+		cap->m_offsets.push_back(symbols.m_offsets[i]);
+		cap->m_durations.push_back(symbols.m_durations[i]);
+		cap->m_samples.push_back(symbols.m_samples[i]);
+	}
+
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Decodes a de-striped stream, appending the symbols to cap
+
+	Framing state only carries across a block boundary in the middle of a packet, and ordered sets (which we split
+	the stream at) are normally only sent between packets. So we decode chunks of the stream in parallel assuming
+	each starts out idle, then stitch them together in order. If a chunk turns out to have started mid-packet
+	(protocol error, or an ordered set we don't understand) it's decoded again with the correct starting state,
+	so the result is always identical to decoding the whole stream serially.
+ */
+void PCIeGen3LogicalDecoder::DecodeStream(const StripedStream& stream, SymbolList& cap)
+{
+	//Split the stream into chunks, each starting with an ordered set.
+	//With only one thread there's nothing to gain, so decode the whole stream as a single chunk.
+	size_t nblocks = stream.m_blocks.size();
+	size_t nthreads = omp_get_max_threads();
+	size_t target = nblocks;
+	if(nthreads > 1)
+		target = max(nblocks / (nthreads * 4), (size_t)1024);
+	vector<size_t> chunkStarts;
+	chunkStarts.push_back(0);
+	for(size_t b=1; b<nblocks; b++)
+	{
+		if(stream.m_blocks[b].m_orderedSet && (b - chunkStarts.back() >= target) )
+			chunkStarts.push_back(b);
+	}
+	chunkStarts.push_back(nblocks);
+	size_t nchunks = chunkStarts.size() - 1;
+
+	vector<SymbolList> chunkSymbols(nchunks);
+	vector<DecodeState> chunkStates(nchunks);
+
+	#pragma omp parallel for if(nchunks > 1)
+	for(size_t c=0; c<nchunks; c++)
+		DecodeBlocks(stream, chunkStarts[c], chunkStarts[c+1], chunkStates[c], chunkSymbols[c]);
+
+	DecodeState state;
+	for(size_t c=0; c<nchunks; c++)
+	{
+		if(state.m_state == PACKET_STATE_IDLE)
+		{
+			AppendChunk(cap, chunkSymbols[c]);
+			state = chunkStates[c];
+		}
+		else
+			DecodeBlocks(stream, chunkStarts[c], chunkStarts[c+1], state, cap);
+	}
+}
+
+/**
+	@brief Appends symbols decoded from an idle starting state, merging logical idles across the boundary
+ */
+void PCIeGen3LogicalDecoder::AppendChunk(SymbolList& cap, const SymbolList& chunk)
+{
+	size_t len = chunk.m_offsets.size();
+	if(len == 0)
+		return;
+
+	size_t i = 0;
+	size_t caplen = cap.m_offsets.size();
+	if( (caplen > 0) &&
+		(cap.m_samples[caplen-1].m_type == PCIeLogicalSymbol::TYPE_LOGICAL_IDLE) &&
+		(chunk.m_samples[0].m_type == PCIeLogicalSymbol::TYPE_LOGICAL_IDLE) )
+	{
+		cap.m_durations[caplen-1] = chunk.m_offsets[0] + chunk.m_durations[0] - cap.m_offsets[caplen-1];
+		i = 1;
+	}
+
+	cap.m_offsets.insert(cap.m_offsets.end(), chunk.m_offsets.begin() + i, chunk.m_offsets.end());
+	cap.m_durations.insert(cap.m_durations.end(), chunk.m_durations.begin() + i, chunk.m_durations.end());
+	cap.m_samples.insert(cap.m_samples.end(), chunk.m_samples.begin() + i, chunk.m_samples.end());
+}
+
+/**
+	@brief Decodes blocks [first, last) of a de-striped stream
+
+	@param stream	The stream to decode
+	@param first	First block to decode
+	@param last		One past the last block to decode
+	@param state	Framing state before the first block, updated to the state after the last block on return
+	@param cap		Symbol list to append to
+ */
+void PCIeGen3LogicalDecoder::DecodeBlocks(
+	const StripedStream& stream,
+	size_t first,
+	size_t last,
+	DecodeState& state,
+	SymbolList& cap)
+{
+	ssize_t nports = stream.m_nports;
+	PacketState packet_state = state.m_state;
+	int64_t count = state.m_count;
+	int64_t packet_len = state.m_packetLen;
+
+	for(size_t b=first; b<last; b++)
 	{
 		//Get bounds of each logical byte within the stream
-		size_t i0 = indexes[0];
-		symstart = (in0->m_offsets[i0] * in0->m_timescale) + in0->m_triggerPhase;
-		int64_t symlen = (in0->m_durations[i0] * in0->m_timescale);
+		auto& block = stream.m_blocks[b];
+		int64_t symstart = block.m_start;
+		int64_t symlen = block.m_len;
 		int64_t sublen = symlen / (nports * 16);
 
 		//Process ordered sets (on all lanes at once)
 		//For now, assume we're synced across all lanes.
 		//TODO: better handling of protocol errors where ordered sets desync
-		if(inputs[0]->m_samples[i0].m_type == PCIe128b130bSymbol::TYPE_ORDERED_SET)
+		if(block.m_orderedSet)
 		{
-			switch(inputs[0]->m_samples[i0].m_data[0])
+			switch(block.m_orderedSetType)
 			{
 				//SOS
 				case 0xaa:
-					cap->m_offsets.push_back(symstart);
-					cap->m_durations.push_back(symlen);
-					cap->m_samples.push_back(PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_SKIP));
+					cap.push_back(symstart, symlen, PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_SKIP));
 					break;
 
 				//Electrical Idle Exit EIEOS
@@ -206,9 +361,7 @@ void PCIeGen3LogicalDecoder::Refresh()
 
 				//TODO: other ordered sets
 				default:
-					cap->m_offsets.push_back(symstart);
-					cap->m_durations.push_back(symlen);
-					cap->m_samples.push_back(PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_ERROR));
+					cap.push_back(symstart, symlen, PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_ERROR));
 					break;
 			}
 		}
@@ -216,18 +369,17 @@ void PCIeGen3LogicalDecoder::Refresh()
 		else
 		{
 			//Process data
-			//Bytes are striped across lanes *within* 128/130 blocks!
+			//Bytes are striped across lanes *within* 128/130 blocks, but the stream is already in logical order
+			const uint8_t* bytes = &stream.m_bytes[b*16*nports];
+			const uint8_t* errors = &stream.m_errors[b*16*nports];
 			for(ssize_t k=0; k<16; k++)
 			{
 				for(ssize_t j=0; j<nports; j++)
 				{
-					auto data = inputs[j];
-					auto i = indexes[j];
-
-					size_t len = cap->m_offsets.size();
+					size_t len = cap.m_offsets.size();
 
 					//Figure out bounds of byte within the physical layer symbols
-					auto sym = data->m_samples[i];
+					uint8_t data = bytes[k*nports + j];
 					int64_t off = symstart + (k*nports + j)*sublen;
 					int64_t dur = sublen;
 					int64_t end = off + sublen;
@@ -240,7 +392,7 @@ void PCIeGen3LogicalDecoder::Refresh()
 					bool error = false;
 
 					//Pass through errors
-					if(data->m_samples[i].m_type == PCIe128b130bSymbol::TYPE_ERROR)
+					if(errors[k*nports + j])
 						error = true;
 
 					else
@@ -251,7 +403,7 @@ void PCIeGen3LogicalDecoder::Refresh()
 							case PACKET_STATE_IDLE:
 								{
 									bool found = true;
-									switch(sym.m_data[k])
+									switch(data)
 									{
 										//IDL 00
 										case 0x00:
@@ -260,27 +412,21 @@ void PCIeGen3LogicalDecoder::Refresh()
 
 										//SDP F0 AC
 										case 0xf0:
-											cap->m_offsets.push_back(off);
-											cap->m_durations.push_back(dur);
-											cap->m_samples.push_back(PCIeLogicalSymbol(
+											cap.push_back(off, dur, PCIeLogicalSymbol(
 												PCIeLogicalSymbol::TYPE_START_DLLP));
 											packet_state = PACKET_STATE_START_DLLP;
 											break;
 
 										//EDS 1F 80 90 00
 										case 0x1f:
-											cap->m_offsets.push_back(off);
-											cap->m_durations.push_back(dur);
-											cap->m_samples.push_back(PCIeLogicalSymbol(
+											cap.push_back(off, dur, PCIeLogicalSymbol(
 												PCIeLogicalSymbol::TYPE_END_DATA_STREAM));
 											packet_state = PACKET_STATE_EDS_1;
 											break;
 
 										//EDB 0xc0 c0 c0 c0
 										case 0xc0:
-											cap->m_offsets.push_back(off);
-											cap->m_durations.push_back(dur);
-											cap->m_samples.push_back(PCIeLogicalSymbol(
+											cap.push_back(off, dur, PCIeLogicalSymbol(
 												PCIeLogicalSymbol::TYPE_END_BAD));
 											packet_state = PACKET_STATE_EDB;
 											count = 0;
@@ -295,15 +441,13 @@ void PCIeGen3LogicalDecoder::Refresh()
 									if(found)
 									{}
 
-									else if( (sym.m_data[k] & 0x0f) == 0x0f)
+									else if( (data & 0x0f) == 0x0f)
 									{
 										count = 0;
-										packet_len = sym.m_data[k] >> 4;
+										packet_len = data >> 4;
 										packet_state = PACKET_STATE_STP_1;
 
-										cap->m_offsets.push_back(off);
-										cap->m_durations.push_back(dur);
-										cap->m_samples.push_back(PCIeLogicalSymbol(
+										cap.push_back(off, dur, PCIeLogicalSymbol(
 											PCIeLogicalSymbol::TYPE_START_TLP));
 									}
 
@@ -317,9 +461,9 @@ void PCIeGen3LogicalDecoder::Refresh()
 
 							//Expect second word of SDP token
 							case PACKET_STATE_START_DLLP:
-								if(sym.m_data[k] == 0xac)
+								if(data == 0xac)
 								{
-									cap->m_durations[len-1] = end - cap->m_offsets[len-1];
+									cap.m_durations[len-1] = end - cap.m_offsets[len-1];
 									count = 0;
 									packet_state = PACKET_STATE_DLLP;
 								}
@@ -331,10 +475,8 @@ void PCIeGen3LogicalDecoder::Refresh()
 
 							//DLLP content (6 bytes)
 							case PACKET_STATE_DLLP:
-								cap->m_offsets.push_back(off);
-								cap->m_durations.push_back(dur);
-								cap->m_samples.push_back(PCIeLogicalSymbol(
-									PCIeLogicalSymbol::TYPE_PAYLOAD_DATA, sym.m_data[k]));
+								cap.push_back(off, dur, PCIeLogicalSymbol(
+									PCIeLogicalSymbol::TYPE_PAYLOAD_DATA, data));
 
 								count++;
 								if(count == 6)
@@ -349,8 +491,8 @@ void PCIeGen3LogicalDecoder::Refresh()
 							case PACKET_STATE_STP_1:
 
 								//Extend previous symbol
-								cap->m_durations[len-1] = end - cap->m_offsets[len-1];
-								packet_len |= ((sym.m_data[k] & 0x7f) << 4);
+								cap.m_durations[len-1] = end - cap.m_offsets[len-1];
+								packet_len |= ((data & 0x7f) << 4);
 
 								//packet length in header is dwords, convert to bytes
 								packet_len *= 4;
@@ -371,14 +513,10 @@ void PCIeGen3LogicalDecoder::Refresh()
 									//Add an end symbol so the data link layer knows the frame ended
 									//(even though there's not an explicit one in the gen3 line coding)
 									auto halflen = dur/2;
-									cap->m_offsets.push_back(off);
-									cap->m_durations.push_back(halflen);
-									cap->m_samples.push_back(PCIeLogicalSymbol(
-										PCIeLogicalSymbol::TYPE_PAYLOAD_DATA, sym.m_data[k]));
-
-									cap->m_offsets.push_back(off + halflen);
-									cap->m_durations.push_back(dur - halflen);
-									cap->m_samples.push_back(PCIeLogicalSymbol(
+									cap.push_back(off, halflen, PCIeLogicalSymbol(
+										PCIeLogicalSymbol::TYPE_PAYLOAD_DATA, data));
+
+									cap.push_back(off + halflen, dur - halflen, PCIeLogicalSymbol(
 										PCIeLogicalSymbol::TYPE_END));
 
 									packet_state = PACKET_STATE_IDLE;
@@ -386,10 +524,8 @@ void PCIeGen3LogicalDecoder::Refresh()
 
 								else
 								{
-									cap->m_offsets.push_back(off);
-									cap->m_durations.push_back(dur);
-									cap->m_samples.push_back(PCIeLogicalSymbol(
-										PCIeLogicalSymbol::TYPE_PAYLOAD_DATA, sym.m_data[k]));
+									cap.push_back(off, dur, PCIeLogicalSymbol(
+										PCIeLogicalSymbol::TYPE_PAYLOAD_DATA, data));
 								}
 								break;
 
@@ -398,9 +534,9 @@ void PCIeGen3LogicalDecoder::Refresh()
 
 							//Expect second word of EDS token
 							case PACKET_STATE_EDS_1:
-								if(sym.m_data[k] == 0x80)
+								if(data == 0x80)
 								{
-									cap->m_durations[len-1] = end - cap->m_offsets[len-1];
+									cap.m_durations[len-1] = end - cap.m_offsets[len-1];
 									packet_state = PACKET_STATE_EDS_2;
 								}
 
@@ -411,9 +547,9 @@ void PCIeGen3LogicalDecoder::Refresh()
 
 							//Expect third word of EDS token
 							case PACKET_STATE_EDS_2:
-								if(sym.m_data[k] == 0x90)
+								if(data == 0x90)
 								{
-									cap->m_durations[len-1] = end - cap->m_offsets[len-1];
+									cap.m_durations[len-1] = end - cap.m_offsets[len-1];
 									packet_state = PACKET_STATE_EDS_3;
 								}
 
@@ -424,9 +560,9 @@ void PCIeGen3LogicalDecoder::Refresh()
 
 							//Expect fourth word of EDS token
 							case PACKET_STATE_EDS_3:
-								if(sym.m_data[k] == 0x00)
+								if(data == 0x00)
 								{
-									cap->m_durations[len-1] = end - cap->m_offsets[len-1];
+									cap.m_durations[len-1] = end - cap.m_offsets[len-1];
 									packet_state = PACKET_STATE_IDLE;
 								}
 
@@ -439,9 +575,9 @@ void PCIeGen3LogicalDecoder::Refresh()
 							// EDB token path
 
 							case PACKET_STATE_EDB:
-								if(sym.m_data[k] == 0xc0)
+								if(data == 0xc0)
 								{
-									cap->m_durations[len-1] = end - cap->m_offsets[len-1];
+									cap.m_durations[len-1] = end - cap.m_offsets[len-1];
 									count ++;
 
 									if(count == 3)
@@ -457,49 +593,34 @@ void PCIeGen3LogicalDecoder::Refresh()
 
 					if(error)
 					{
-						cap->m_offsets.push_back(off);
-						cap->m_durations.push_back(dur);
-						cap->m_samples.push_back(PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_ERROR));
+						cap.push_back(off, dur, PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_ERROR));
 						packet_state = PACKET_STATE_IDLE;
 					}
 				}
 			}
 		}
-
-		//Increment indexes and check if we went off the end of any of the input streams
-		bool done = false;
-		for(ssize_t j=0; j<nports; j++)
-		{
-			indexes[j] ++;
-
-			if(indexes[j] >= inputs[j]->m_samples.size())
-				done = true;
-		}
-		if(done)
-			break;
 	}
 
-	SetData(cap, 0);
-	cap->MarkModifiedFromCpu();
+	state.m_state = packet_state;
+	state.m_count = count;
+	state.m_packetLen = packet_len;
 }
 
 /**
 	@brief Adds a logical idle symbol, or extends an existing one
  */
-void PCIeGen3LogicalDecoder::AddLogicalIdle(PCIeLogicalWaveform* cap, int64_t off, int64_t tend)
+void PCIeGen3LogicalDecoder::AddLogicalIdle(SymbolList& cap, int64_t off, int64_t tend)
 {
-	size_t len = cap->m_offsets.size();
+	size_t len = cap.m_offsets.size();
 
 	if(len > 0)
 	{
-		if(cap->m_samples[len-1].m_type == PCIeLogicalSymbol::TYPE_LOGICAL_IDLE)
+		if(cap.m_samples[len-1].m_type == PCIeLogicalSymbol::TYPE_LOGICAL_IDLE)
 		{
-			cap->m_durations[len-1] = tend - cap->m_offsets[len-1];
+			cap.m_durations[len-1] = tend - cap.m_offsets[len-1];
 			return;
 		}
 	}
 
-	cap->m_offsets.push_back(off);
-	cap->m_durations.push_back(tend - off);
-	cap->m_samples.push_back(PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_LOGICAL_IDLE));
+	cap.push_back(off, tend - off, PCIeLogicalSymbol(PCIeLogicalSymbol::TYPE_LOGICAL_IDLE));
 }
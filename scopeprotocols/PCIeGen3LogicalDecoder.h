@@ -56,7 +56,90 @@ public:
 	PROTOCOL_DECODER_INITPROC(PCIeGen3LogicalDecoder)
 
 protected:
-	void AddLogicalIdle(PCIeLogicalWaveform* cap, int64_t off, int64_t tend);
+
+	/**
+		@brief Lane 0 view of one 128b/130b block, after deskew
+	 */
+	class StripedBlock
+	{
+	public:
+		int64_t m_start;
+		int64_t m_len;
+		bool m_orderedSet;
+		uint8_t m_orderedSetType;
+	};
+
+	/**
+		@brief All lanes of a link, deskewed and de-striped into logical byte order
+
+		Byte k of block b on lane j is at index (b*16 + k)*nports + j of m_bytes.
+	 */
+	class StripedStream
+	{
+	public:
+		size_t m_nports;
+		std::vector<StripedBlock> m_blocks;
+		std::vector<uint8_t> m_bytes;
+		std::vector<uint8_t> m_errors;
+	};
+
+	enum PacketState
+	{
+		PACKET_STATE_IDLE,
+		PACKET_STATE_START_DLLP,
+		PACKET_STATE_DLLP,
+		PACKET_STATE_EDS_1,
+		PACKET_STATE_EDS_2,
+		PACKET_STATE_EDS_3,
+		PACKET_STATE_STP_1,
+		PACKET_STATE_TLP_DATA,
+		PACKET_STATE_EDB
+	};
+
+	/**
+		@brief Framing state carried from one block to the next
+	 */
+	class DecodeState
+	{
+	public:
+		DecodeState()
+		: m_state(PACKET_STATE_IDLE)
+		, m_count(0)
+		, m_packetLen(0)
+		{}
+
+		PacketState m_state;
+		int64_t m_count;
+		int64_t m_packetLen;
+	};
+
+	/**
+		@brief Decoded symbols, before they're copied to the output waveform
+	 */
+	class SymbolList
+	{
+	public:
+		void push_back(int64_t off, int64_t dur, PCIeLogicalSymbol sym)
+		{
+			m_offsets.push_back(off);
+			m_durations.push_back(dur);
+			m_samples.push_back(sym);
+		}
+
+		std::vector<int64_t> m_offsets;
+		std::vector<int64_t> m_durations;
+		std::vector<PCIeLogicalSymbol> m_samples;
+	};
+
+	static void DecodeStream(const StripedStream& stream, SymbolList& cap);
+	static void DecodeBlocks(
+		const StripedStream& stream,
+		size_t first,
+		size_t last,
+		DecodeState& state,
+		SymbolList& cap);
+	static void AppendChunk(SymbolList& cap, const SymbolList& chunk);
+	static void AddLogicalIdle(SymbolList& cap, int64_t off, int64_t tend);
 };
 
 #endif
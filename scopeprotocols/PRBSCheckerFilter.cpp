@@ -132,9 +132,8 @@ void PRBSCheckerFilter::Refresh()
 	din->PrepareForCpuAccess();
 	clkin->PrepareForCpuAccess();
 
-	SparseDigitalWaveform data;
-	data.PrepareForCpuAccess();
-	SampleOnAnyEdgesBase(din, clkin, data);
+	auto pdata = GetSampledOnAnyEdges<bool>(din, clkin);
+	auto& data = *pdata;
 
 	auto poly = static_cast<PRBSGeneratorFilter::Polynomials>(m_parameters[m_polyname].GetIntVal());
 
@@ -0,0 +1,90 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2021 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of PercentileStatistic and its subclasses
+ */
+
+#ifndef PercentileStatistic_h
+#define PercentileStatistic_h
+
+/**
+	@brief Base class for statistics that report a fixed percentile of all samples seen so far
+ */
+class PercentileStatistic : public Statistic
+{
+public:
+	virtual void Clear();
+	virtual bool Calculate(StreamDescriptor stream, double& value);
+
+protected:
+	///@brief The percentile to report, from 0 to 100
+	virtual double GetPercentile() =0;
+};
+
+class MedianStatistic : public PercentileStatistic
+{
+public:
+	static std::string GetStatisticName();
+
+	STATISTIC_INITPROC(MedianStatistic)
+
+protected:
+	virtual double GetPercentile()
+	{ return 50; }
+};
+
+class Percentile5Statistic : public PercentileStatistic
+{
+public:
+	static std::string GetStatisticName();
+
+	STATISTIC_INITPROC(Percentile5Statistic)
+
+protected:
+	virtual double GetPercentile()
+	{ return 5; }
+};
+
+class Percentile95Statistic : public PercentileStatistic
+{
+public:
+	static std::string GetStatisticName();
+
+	STATISTIC_INITPROC(Percentile95Statistic)
+
+protected:
+	virtual double GetPercentile()
+	{ return 95; }
+};
+
+#endif
@@ -78,9 +78,35 @@ void PeriodMeasurement::Refresh()
 		return;
 	}
 
-	//Find average voltage of the waveform and use that as the zero crossing
 	auto din = GetInputWaveform(0);
 	din->PrepareForCpuAccess();
+
+	//Sequence acquisitions get one point per segment
+	if(RefreshSegmentBatch(din, [this](WaveformBase* seg, SparseAnalogWaveform* out) { return Measure(seg, out); }))
+		return;
+
+	//Create the output
+	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0, true);
+	cap->m_timescale = 1;
+	cap->PrepareForCpuAccess();
+	if(!Measure(din, cap))
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Measures one waveform into an empty, CPU-side output
+
+	@return False if there was nothing to measure
+ */
+bool PeriodMeasurement::Measure(WaveformBase* din, SparseAnalogWaveform* cap)
+{
+	//Find average voltage of the waveform and use that as the zero crossing
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
 	float midpoint = GetAvgVoltage(sdin, udin);
@@ -89,15 +115,7 @@ void PeriodMeasurement::Refresh()
 	vector<int64_t> edges;
 	FindZeroCrossings(sdin, udin, midpoint, edges);
 	if(edges.size() < 2)
-	{
-		SetData(NULL, 0);
-		return;
-	}
-
-	//Create the output
-	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0, true);
-	cap->PrepareForCpuAccess();
-	cap->m_timescale = 1;
+		return false;
 
 	for(size_t i=0; i < (edges.size()-2); i+= 2)
 	{
@@ -111,5 +129,5 @@ void PeriodMeasurement::Refresh()
 		cap->m_samples.push_back(delta);
 	}
 
-	SetData(cap, 0);
+	return true;
 }
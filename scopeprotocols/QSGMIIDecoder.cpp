@@ -56,6 +56,7 @@ QSGMIIDecoder::QSGMIIDecoder(const string& color)
 
 	m_displayformat = "Display Format";
 	m_parameters[m_displayformat] = IBM8b10bDecoder::MakeIBM8b10bDisplayFormatParameter();
+	m_parameters[m_displayformat].signal_changed().connect(sigc::mem_fun(*this, &Filter::InvalidateOutputText));
 }
 
 QSGMIIDecoder::~QSGMIIDecoder()
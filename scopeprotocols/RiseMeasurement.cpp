@@ -96,10 +96,35 @@ void RiseMeasurement::Refresh()
 		return;
 	}
 
-	//Get the input data
 	auto din = GetInputWaveform(0);
-	size_t len = din->size();
 	din->PrepareForCpuAccess();
+
+	//Sequence acquisitions get one point per segment
+	if(RefreshSegmentBatch(din, [this](WaveformBase* seg, SparseAnalogWaveform* out) { return Measure(seg, out); }))
+		return;
+
+	//Create the output
+	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0, true);
+	cap->m_timescale = 1;
+	cap->PrepareForCpuAccess();
+	if(!Measure(din, cap))
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Measures one waveform into an empty, CPU-side output
+
+	@return False if there was nothing to measure
+ */
+bool RiseMeasurement::Measure(WaveformBase* din, SparseAnalogWaveform* cap)
+{
+	size_t len = din->size();
 	auto sdin = dynamic_cast<SparseAnalogWaveform*>(din);
 	auto udin = dynamic_cast<UniformAnalogWaveform*>(din);
 
@@ -112,11 +137,6 @@ void RiseMeasurement::Refresh()
 	float vstart = base + m_parameters[m_startname].GetFloatVal()*delta;
 	float vend = base + m_parameters[m_endname].GetFloatVal()*delta;
 
-	//Create the output
-	auto cap = SetupEmptySparseAnalogOutputWaveform(din, 0);
-	cap->m_timescale = 1;
-	cap->PrepareForCpuAccess();
-
 	float last = 1e20;
 	double tedge = 0;
 
@@ -158,6 +178,5 @@ void RiseMeasurement::Refresh()
 		last = cur;
 	}
 
-	SetData(cap, 0);
-	cap->MarkModifiedFromCpu();
+	return true;
 }
@@ -50,6 +50,8 @@ public:
 	PROTOCOL_DECODER_INITPROC(RiseMeasurement)
 
 protected:
+	bool Measure(WaveformBase* din, SparseAnalogWaveform* cap);
+
 	std::string m_startname;
 	std::string m_endname;
 };
@@ -72,6 +72,12 @@ string RjBUjFilter::GetProtocolName()
 	return "Rj + BUj";
 }
 
+void RjBUjFilter::ClearSweeps()
+{
+	if(m_engine)
+		m_engine->Clear();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -83,76 +89,14 @@ void RjBUjFilter::Refresh()
 		return;
 	}
 
-	//Get the input data
+	//Add the new data to the running jitter tables for these inputs (a no-op if a DDJ measurement already did)
 	auto tie = dynamic_cast<SparseAnalogWaveform*>(GetInputWaveform(0));
-	auto thresh = GetInputWaveform(1);
-	auto clk = GetInputWaveform(2);
-	auto ddj = dynamic_cast<DDJMeasurement*>(GetInput(3).m_channel);
-	float* table = ddj->GetDDJTable();
+	m_engine = JitterAnalysisEngine::GetEngine(GetInput(0), GetInput(1), GetInput(2));
+	m_engine->Integrate(tie, GetInputWaveform(1), GetInputWaveform(2));
 
-	tie->PrepareForCpuAccess();
-	thresh->PrepareForCpuAccess();
-	clk->PrepareForCpuAccess();
-
-	//Sample the input data
-	SparseDigitalWaveform samples;
-	SampleOnAnyEdgesBase(thresh, clk, samples);
-	samples.PrepareForCpuAccess();
-
-	//Set up output waveform
+	//Subtract the averaged DDJ from TIE to get the uncorrelated jitter
 	auto cap = SetupSparseOutputWaveform(tie, 0, 0, 0);
 	cap->PrepareForCpuAccess();
-
-	//DDJ history (8 UIs)
-	uint8_t window = 0;
-
-	size_t tielen = tie->size();
-	size_t samplen = samples.size();
-
-	size_t itie = 0;
-
-	//Main processing loop
-	size_t nbits = 0;
-	int64_t tfirst = tie->m_offsets[0] * tie->m_timescale + tie->m_triggerPhase;
-	for(size_t idata=0; idata < samplen; idata ++)
-	{
-		//Sample the next bit in the thresholded waveform
-		window = (window >> 1);
-		if(samples.m_samples[idata])
-			window |= 0x80;
-		nbits ++;
-
-		//need 8 in last_window, plus one more for the current bit
-		if(nbits < 9)
-			continue;
-
-		//If we're still before the first TIE sample, nothing to do
-		int64_t tstart = samples.m_offsets[idata];
-		if(tstart < tfirst)
-			continue;
-
-		//Advance TIE samples if needed
-		int64_t target = 0;
-		while( (target < tfirst) && (itie < tielen) )
-		{
-			target = tie->m_offsets[itie] * tie->m_timescale + tie->m_triggerPhase;
-
-			if(target < tstart)
-				itie ++;
-		}
-		if(itie >= tielen)
-			break;
-
-		//If the TIE sample is after this bit, don't do anything.
-		//We need edges within this UI.
-		int64_t tend = tstart + samples.m_durations[idata];
-		if(target > tend)
-			continue;
-
-		//We've got a good sample. Subtract the averaged DDJ from TIE to get the uncorrelated jitter (Rj + BUj).
-		float uj = tie->m_samples[itie] - table[window];
-		cap->m_samples[itie] = uj;
-	}
-
+	m_engine->GetResiduals(tie, cap);
 	cap->MarkModifiedFromCpu();
 }
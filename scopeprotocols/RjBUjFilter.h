@@ -35,18 +35,29 @@
 #ifndef RjBUjFilter_h
 #define RjBUjFilter_h
 
+/**
+	@brief Uncorrelated jitter (Rj + BUj): TIE with the data-dependent part subtracted
+
+	This is a view over the JitterAnalysisEngine for the TIE, threshold and clock inputs, so the DDJ table subtracted
+	is the one accumulated across triggers. The DDJ input is still required so existing setups load unchanged, and
+	shares its engine when it's wired to the same signals.
+ */
 class RjBUjFilter : public Filter
 {
 public:
 	RjBUjFilter(const std::string& color);
 
 	virtual void Refresh();
+	virtual void ClearSweeps();
 
 	static std::string GetProtocolName();
 
 	virtual bool ValidateChannel(size_t i, StreamDescriptor stream);
 
 	PROTOCOL_DECODER_INITPROC(RjBUjFilter)
+
+protected:
+	std::shared_ptr<JitterAnalysisEngine> m_engine;
 };
 
 #endif
@@ -53,6 +53,7 @@ SDCmdDecoder::SDCmdDecoder(const string& color)
 	m_parameters[m_cardtypename].AddEnumValue("SD", SD_GENERIC);
 	m_parameters[m_cardtypename].AddEnumValue("eMMC", SD_EMMC);
 	m_parameters[m_cardtypename].SetIntVal(SD_GENERIC);
+	m_parameters[m_cardtypename].signal_changed().connect(sigc::mem_fun(*this, &Filter::InvalidateOutputText));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
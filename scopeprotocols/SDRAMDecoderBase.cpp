@@ -46,6 +46,175 @@ SDRAMDecoderBase::~SDRAMDecoderBase()
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Command decoding
+
+/**
+	@brief Samples the command bus on rising clock edges, decodes the commands, and measures per-bank latencies
+
+	Pin states are packed into one byte per clock and looked up in a table built from ClassifyCommand(). Blocks of
+	clocks are processed in parallel: one pass counts the commands in each block so the output can be allocated up
+	front, then a second pass fills it in.
+
+	@param clk		The command clock
+	@param pins		Command bus signals, indexed by CommandPin. Unused pins may be NULL (and are read as low).
+ */
+void SDRAMDecoderBase::DecodeCommands(WaveformBase* clk, WaveformBase* pins[PIN_COUNT])
+{
+	//Build the command table
+	int8_t table[1 << PIN_COUNT];
+	for(int i=0; i<(1 << PIN_COUNT); i++)
+		table[i] = ClassifyCommand(i);
+
+	//Sample all of the inputs
+	SparseDigitalWaveform samples[PIN_COUNT];
+	size_t len = SIZE_MAX;
+	for(int i=0; i<PIN_COUNT; i++)
+	{
+		if(!pins[i])
+			continue;
+		SampleOnRisingEdgesBase(pins[i], clk, samples[i]);
+		len = min(len, samples[i].size());
+	}
+	if(len == SIZE_MAX)
+		len = 0;
+
+	//Create the capture
+	auto cap = new SDRAMWaveform;
+	cap->m_timescale = 1;
+	cap->m_startTimestamp = clk->m_startTimestamp;
+	cap->m_startFemtoseconds = 0;
+	cap->PrepareForCpuAccess();
+
+	//Pack the pin states for each clock, and count commands per block
+	vector<uint8_t> packed(len, 0);
+	size_t nblocks = (len + COMMAND_BLOCK - 1) / COMMAND_BLOCK;
+	vector<size_t> base(nblocks + 1, 0);
+	#pragma omp parallel for if(nblocks > 1)
+	for(size_t i=0; i<nblocks; i++)
+	{
+		size_t start = i * COMMAND_BLOCK;
+		size_t end = min(start + COMMAND_BLOCK, len);
+		uint8_t* p = &packed[0];
+
+		for(int j=0; j<PIN_COUNT; j++)
+		{
+			if(!pins[j])
+				continue;
+			const bool* s = samples[j].m_samples.GetCpuPointer();
+			for(size_t k=start; k<end; k++)
+				p[k] |= s[k] << j;
+		}
+
+		size_t count = 0;
+		for(size_t k=start; k<end; k++)
+			count += (table[p[k]] != COMMAND_NONE);
+		base[i+1] = count;
+	}
+	for(size_t i=0; i<nblocks; i++)
+		base[i+1] += base[i];
+
+	//Emit the commands
+	size_t ncmds = base[nblocks];
+	cap->Resize(ncmds);
+	vector<uint8_t> cmdpins(ncmds);
+	auto& timebase = samples[PIN_CS];
+	#pragma omp parallel for if(nblocks > 1)
+	for(size_t i=0; i<nblocks; i++)
+	{
+		size_t start = i * COMMAND_BLOCK;
+		size_t end = min(start + COMMAND_BLOCK, len);
+
+		size_t n = base[i];
+		for(size_t k=start; k<end; k++)
+		{
+			int type = table[packed[k]];
+			if(type == COMMAND_NONE)
+				continue;
+
+			cap->m_offsets[n] = timebase.m_offsets[k];
+			cap->m_durations[n] = timebase.m_durations[k];
+			cap->m_samples[n] = SDRAMSymbol(static_cast<SDRAMSymbol::stype>(type));
+			cmdpins[n] = packed[k];
+			n ++;
+		}
+	}
+
+	MeasureLatencies(cap, cmdpins.empty() ? NULL : &cmdpins[0]);
+
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
+
+/**
+	@brief Pairs up commands to each bank and records the tRFC and tRCD latencies in the output
+
+	This is inherently sequential, but only walks the decoded commands, not every clock.
+
+	@param cap		The decoded commands
+	@param cmdpins	Packed pin states of each command, for logging unknown commands
+ */
+void SDRAMDecoderBase::MeasureLatencies(SDRAMWaveform* cap, const uint8_t* cmdpins)
+{
+	//Last refresh and activate time of each bank (0 if none, or already paired with a later command)
+	int64_t lastRef[MAX_BANKS] = {0};
+	int64_t lastAct[MAX_BANKS] = {0};
+
+	size_t len = cap->size();
+	for(size_t i=0; i<len; i++)
+	{
+		auto& sample = cap->m_samples[i];
+		int64_t tnow = cap->m_offsets[i];
+
+		if(sample.m_stype == SDRAMSymbol::TYPE_ERROR)
+		{
+			uint8_t p = cmdpins[i];
+			LogDebug("[%zu] Unknown command (RAS=%d, CAS=%d, WE=%d, A12=%d, A10=%d)\n",
+				i,
+				(p >> PIN_RAS) & 1,
+				(p >> PIN_CAS) & 1,
+				(p >> PIN_WE) & 1,
+				(p >> PIN_A12) & 1,
+				(p >> PIN_A10) & 1);
+		}
+
+		//Discard invalid bank IDs
+		if( (sample.m_bank < 0) || (sample.m_bank >= MAX_BANKS) )
+			continue;
+
+		switch(sample.m_stype)
+		{
+			case SDRAMSymbol::TYPE_REF:
+				lastRef[sample.m_bank] = tnow;
+				break;
+
+			//Activate ends a refresh-to-activate interval and starts an activate-to-column one
+			case SDRAMSymbol::TYPE_ACT:
+				if(lastRef[sample.m_bank] != 0)
+				{
+					cap->m_refreshToActivate.push_back(SDRAMLatency(tnow, tnow - lastRef[sample.m_bank]));
+					lastRef[sample.m_bank] = 0;
+				}
+				lastAct[sample.m_bank] = tnow;
+				break;
+
+			case SDRAMSymbol::TYPE_WR:
+			case SDRAMSymbol::TYPE_WRA:
+			case SDRAMSymbol::TYPE_RD:
+			case SDRAMSymbol::TYPE_RDA:
+				if(lastAct[sample.m_bank] != 0)
+				{
+					cap->m_activateToColumn.push_back(SDRAMLatency(tnow, tnow - lastAct[sample.m_bank]));
+					lastAct[sample.m_bank] = 0;
+				}
+				break;
+
+			default:
+				break;
+		}
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Pretty printing
 
@@ -71,12 +71,36 @@ public:
 	}
 };
 
+/**
+	@brief Delay between two commands to the same bank, measured while decoding
+ */
+class SDRAMLatency
+{
+public:
+	SDRAMLatency(int64_t time, int64_t latency)
+	 : m_time(time)
+	 , m_latency(latency)
+	{}
+
+	///@brief Time of the second command (femtoseconds)
+	int64_t m_time;
+
+	///@brief Time from the first command to the second (femtoseconds)
+	int64_t m_latency;
+};
+
 class SDRAMWaveform : public SparseWaveform<SDRAMSymbol>
 {
 public:
 	SDRAMWaveform () : SparseWaveform<SDRAMSymbol>() {};
 	virtual std::string GetText(size_t) override;
 	virtual Gdk::Color GetColor(size_t) override;
+
+	///@brief Delays from a refresh to the next activate of the same bank (tRFC)
+	std::vector<SDRAMLatency> m_refreshToActivate;
+
+	///@brief Delays from an activate to the next read or write of the same bank (tRCD)
+	std::vector<SDRAMLatency> m_activateToColumn;
 };
 
 class SDRAMDecoderBase : public Filter
@@ -84,6 +108,47 @@ class SDRAMDecoderBase : public Filter
 public:
 	SDRAMDecoderBase(const std::string& color);
 	virtual ~SDRAMDecoderBase();
+
+protected:
+
+	/**
+		@brief Command bus signals, in bit order of the packed pin states passed to ClassifyCommand()
+	 */
+	enum CommandPin
+	{
+		PIN_WE,
+		PIN_RAS,
+		PIN_CAS,
+		PIN_CS,
+		PIN_A10,
+		PIN_A12,
+
+		PIN_COUNT
+	};
+
+	enum
+	{
+		///@brief Returned by ClassifyCommand() for a deselect or NOP
+		COMMAND_NONE = -1,
+
+		///@brief Number of banks tracked for latency measurements
+		MAX_BANKS = 8,
+
+		///@brief Number of clock cycles classified as one block
+		COMMAND_BLOCK = 65536
+	};
+
+	/**
+		@brief Decodes the command for one combination of command bus pin states
+
+		@param pins		Pin states, with bit N set if CommandPin N was high
+
+		@return The command type, or COMMAND_NONE if no command was issued
+	 */
+	virtual int ClassifyCommand(uint8_t pins) =0;
+
+	void DecodeCommands(WaveformBase* clk, WaveformBase* pins[PIN_COUNT]);
+	void MeasureLatencies(SDRAMWaveform* cap, const uint8_t* cmdpins);
 };
 
 #endif
@@ -135,22 +135,16 @@ void SParameterCascadeFilter::Refresh()
 	//Use S11a magnitude as timebase reference for our output
 	auto base = GetInputWaveform(0);
 
-	for(size_t i=0; i<16; i++)
-		GetInputWaveform(i)->PrepareForCpuAccess();
-
-	//Get all of our inputs
-	SParameterVector s11a(GetInputWaveform(0), GetInputWaveform(1));
-	SParameterVector s12a(GetInputWaveform(2), GetInputWaveform(3));
-	SParameterVector s21a(GetInputWaveform(4), GetInputWaveform(5));
-	SParameterVector s22a(GetInputWaveform(6), GetInputWaveform(7));
-
-	SParameterVector s11b(GetInputWaveform(8), GetInputWaveform(9));
-	SParameterVector s12b(GetInputWaveform(10), GetInputWaveform(11));
-	SParameterVector s21b(GetInputWaveform(12), GetInputWaveform(13));
-	SParameterVector s22b(GetInputWaveform(14), GetInputWaveform(15));
+	//Get all of our inputs (S11a S12a S21a S22a S11b S12b S21b S22b)
+	//and resample them to S11a's frequency grid in real/imaginary form.
+	//Both steps are no-ops for any inputs that haven't changed since last refresh.
+	LoadInputVectors(8);
+	auto& grid = *m_inputVectors[0];
+	for(size_t i=0; i<8; i++)
+		m_inputVectors[i]->Resample(grid, m_resampledInputs[i]);
 
 	//Vectors for output
-	size_t npoints = s11a.size();
+	size_t npoints = grid.size();
 	SParameterVector s11o;
 	SParameterVector s12o;
 	SParameterVector s21o;
@@ -160,23 +154,30 @@ void SParameterCascadeFilter::Refresh()
 	s21o.resize(npoints);
 	s22o.resize(npoints);
 
+	auto& s11a = m_resampledInputs[0];
+	auto& s12a = m_resampledInputs[1];
+	auto& s21a = m_resampledInputs[2];
+	auto& s22a = m_resampledInputs[3];
+	auto& s11b = m_resampledInputs[4];
+	auto& s12b = m_resampledInputs[5];
+	auto& s21b = m_resampledInputs[6];
+	auto& s22b = m_resampledInputs[7];
+
 	//Concatenate the S-parameters
 	//(equation 2.18, page 118 of Dunsmore 2nd edition)
 	for(size_t i=0; i<npoints;i++)
 	{
-		float freq = s11a.m_points[i].m_frequency;
-
-		//Interpolate all inputs to our current frequency bin
-		//and convert from our default mag/angle representation to real/imaginary
-		auto p11a = s11a.InterpolatePoint(freq).ToComplex();
-		auto p12a = s12a.InterpolatePoint(freq).ToComplex();
-		auto p21a = s21a.InterpolatePoint(freq).ToComplex();
-		auto p22a = s22a.InterpolatePoint(freq).ToComplex();
-
-		auto p11b = s11b.InterpolatePoint(freq).ToComplex();
-		auto p12b = s12b.InterpolatePoint(freq).ToComplex();
-		auto p21b = s21b.InterpolatePoint(freq).ToComplex();
-		auto p22b = s22b.InterpolatePoint(freq).ToComplex();
+		float freq = grid.m_points[i].m_frequency;
+
+		auto p11a = s11a.GetComplex(i);
+		auto p12a = s12a.GetComplex(i);
+		auto p21a = s21a.GetComplex(i);
+		auto p22a = s22a.GetComplex(i);
+
+		auto p11b = s11b.GetComplex(i);
+		auto p12b = s12b.GetComplex(i);
+		auto p21b = s21b.GetComplex(i);
+		auto p22b = s22b.GetComplex(i);
 
 		//Do the actual math
 		auto one = complex<float>(1, 0);
@@ -51,6 +51,9 @@ public:
 
 protected:
 	virtual void RefreshPorts();
+
+	///@brief All of our inputs, resampled to the frequency grid of the first
+	SParameterResampledVector m_resampledInputs[8];
 };
 
 #endif
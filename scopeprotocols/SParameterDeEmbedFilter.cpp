@@ -141,23 +141,16 @@ void SParameterDeEmbedFilter::Refresh()
 	//Use S11a magnitude as timebase reference for our output
 	auto base = GetInputWaveform(0);
 
-	for(size_t i=0; i<16; i++)
-		GetInputWaveform(i)->PrepareForCpuAccess();
-
-	//Combined network
-	SParameterVector s11c(GetInputWaveform(0), GetInputWaveform(1));
-	SParameterVector s12c(GetInputWaveform(2), GetInputWaveform(3));
-	SParameterVector s21c(GetInputWaveform(4), GetInputWaveform(5));
-	SParameterVector s22c(GetInputWaveform(6), GetInputWaveform(7));
-
-	//Known network
-	SParameterVector s11k(GetInputWaveform(8), GetInputWaveform(9));
-	SParameterVector s12k(GetInputWaveform(10), GetInputWaveform(11));
-	SParameterVector s21k(GetInputWaveform(12), GetInputWaveform(13));
-	SParameterVector s22k(GetInputWaveform(14), GetInputWaveform(15));
+	//Get all of our inputs (combined network S11 S12 S21 S22, then known network S11 S12 S21 S22)
+	//and resample them to the combined S11 frequency grid in real/imaginary form.
+	//Both steps are no-ops for any inputs that haven't changed since last refresh.
+	LoadInputVectors(8);
+	auto& grid = *m_inputVectors[0];
+	for(size_t i=0; i<8; i++)
+		m_inputVectors[i]->Resample(grid, m_resampledInputs[i]);
 
 	//Vectors for output
-	size_t npoints = s11c.size();
+	size_t npoints = grid.size();
 	SParameterVector s11o;
 	SParameterVector s12o;
 	SParameterVector s21o;
@@ -170,22 +163,29 @@ void SParameterDeEmbedFilter::Refresh()
 	//Figure out which network is known
 	bool knownIsA = (m_parameters[m_knownSide].GetIntVal() == SIDE_LEFT);
 
+	auto& s11c = m_resampledInputs[0];
+	auto& s12c = m_resampledInputs[1];
+	auto& s21c = m_resampledInputs[2];
+	auto& s22c = m_resampledInputs[3];
+	auto& s11k = m_resampledInputs[4];
+	auto& s12k = m_resampledInputs[5];
+	auto& s21k = m_resampledInputs[6];
+	auto& s22k = m_resampledInputs[7];
+
 	//Do the actual de-embed
 	for(size_t i=0; i<npoints;i++)
 	{
-		float freq = s11c.m_points[i].m_frequency;
-
-		//Interpolate all inputs to our current frequency bin
-		//and convert from our default mag/angle representation to real/imaginary
-		auto p11c = s11c.InterpolatePoint(freq).ToComplex();
-		auto p12c = s12c.InterpolatePoint(freq).ToComplex();
-		auto p21c = s21c.InterpolatePoint(freq).ToComplex();
-		auto p22c = s22c.InterpolatePoint(freq).ToComplex();
-
-		auto p11k = s11k.InterpolatePoint(freq).ToComplex();
-		auto p12k = s12k.InterpolatePoint(freq).ToComplex();
-		auto p21k = s21k.InterpolatePoint(freq).ToComplex();
-		auto p22k = s22k.InterpolatePoint(freq).ToComplex();
+		float freq = grid.m_points[i].m_frequency;
+
+		auto p11c = s11c.GetComplex(i);
+		auto p12c = s12c.GetComplex(i);
+		auto p21c = s21c.GetComplex(i);
+		auto p22c = s22c.GetComplex(i);
+
+		auto p11k = s11k.GetComplex(i);
+		auto p12k = s12k.GetComplex(i);
+		auto p21k = s21k.GetComplex(i);
+		auto p22k = s22k.GetComplex(i);
 
 		complex<float> p11;
 		complex<float> p12;
@@ -55,6 +55,9 @@ public:
 protected:
 	virtual void RefreshPorts();
 
+	///@brief All of our inputs, resampled to the frequency grid of the first
+	SParameterResampledVector m_resampledInputs[8];
+
 	enum Side
 	{
 		SIDE_LEFT,
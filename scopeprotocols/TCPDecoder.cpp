@@ -84,13 +84,8 @@ void TCPDecoder::Refresh()
 	size_t len = din->m_samples.size();
 
 	//Loop over the events and process stuff
-	auto cap = new TCPWaveform;
-	cap->m_timescale = din->m_timescale;
-	cap->m_triggerPhase = din->m_triggerPhase;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
+	auto cap = SetupEmptyOutputWaveform<TCPWaveform>(din, 0);
 	cap->PrepareForCpuAccess();
-	SetData(cap, 0);
 
 	int state = 0;
 	int option_len = 0;
@@ -104,8 +99,8 @@ void TCPDecoder::Refresh()
 		int64_t halfdur = dur/2;
 
 		uint8_t bin = 0;
-		if(din->m_samples[i].m_data.size())
-			bin = din->m_samples[i].m_data[0];
+		if(s.m_dataLen)
+			bin = din->GetSymbolData(i)[0];
 
 		switch(state)
 		{
@@ -133,7 +128,7 @@ void TCPDecoder::Refresh()
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_SOURCE_PORT, bin));
+					cap->PushSymbol(TCPSymbol(TCPSymbol::TYPE_SOURCE_PORT), bin);
 				}
 				break;
 
@@ -141,7 +136,7 @@ void TCPDecoder::Refresh()
 			case 3:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendSymbolData(cap->m_samples[caplen-1], bin);
 					cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 					state = 4;
 				}
@@ -157,7 +152,7 @@ void TCPDecoder::Refresh()
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_DEST_PORT, bin));
+					cap->PushSymbol(TCPSymbol(TCPSymbol::TYPE_DEST_PORT), bin);
 				}
 				else
 					state = 0;
@@ -167,7 +162,7 @@ void TCPDecoder::Refresh()
 			case 5:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendSymbolData(cap->m_samples[caplen-1], bin);
 					cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 					state = 6;
 				}
@@ -183,7 +178,7 @@ void TCPDecoder::Refresh()
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_SEQ, bin));
+					cap->PushSymbol(TCPSymbol(TCPSymbol::TYPE_SEQ), bin);
 				}
 				else
 					state = 0;
@@ -193,9 +188,9 @@ void TCPDecoder::Refresh()
 			case 7:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendSymbolData(cap->m_samples[caplen-1], bin);
 
-					if(cap->m_samples[caplen-1].m_data.size() == 4)
+					if(cap->m_samples[caplen-1].m_dataLen == 4)
 					{
 						cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 						state = 8;
@@ -213,7 +208,7 @@ void TCPDecoder::Refresh()
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_ACK, bin));
+					cap->PushSymbol(TCPSymbol(TCPSymbol::TYPE_ACK), bin);
 				}
 				else
 					state = 0;
@@ -223,9 +218,9 @@ void TCPDecoder::Refresh()
 			case 9:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendSymbolData(cap->m_samples[caplen-1], bin);
 
-					if(cap->m_samples[caplen-1].m_data.size() == 4)
+					if(cap->m_samples[caplen-1].m_dataLen == 4)
 					{
 						cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 						state = 10;
@@ -243,14 +238,14 @@ void TCPDecoder::Refresh()
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(halfdur);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_DATA_OFFSET, bin >> 4));
+					cap->PushSymbol(TCPSymbol(TCPSymbol::TYPE_DATA_OFFSET), bin >> 4);
 
 					option_len = ( (bin >> 4) * 4) - 20;
 
 					//Also push the NS bit of the flags
 					cap->m_offsets.push_back(off + halfdur);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_FLAGS, bin & 0xf));
+					cap->PushSymbol(TCPSymbol(TCPSymbol::TYPE_FLAGS), bin & 0xf);
 				}
 				else
 					state = 0;
@@ -260,7 +255,7 @@ void TCPDecoder::Refresh()
 			case 11:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendSymbolData(cap->m_samples[caplen-1], bin);
 					cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 					state = 12;
 				}
@@ -276,7 +271,7 @@ void TCPDecoder::Refresh()
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_WINDOW, bin));
+					cap->PushSymbol(TCPSymbol(TCPSymbol::TYPE_WINDOW), bin);
 				}
 				else
 					state = 0;
@@ -286,7 +281,7 @@ void TCPDecoder::Refresh()
 			case 13:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendSymbolData(cap->m_samples[caplen-1], bin);
 					cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 					state = 14;
 				}
@@ -302,7 +297,7 @@ void TCPDecoder::Refresh()
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_CHECKSUM, bin));
+					cap->PushSymbol(TCPSymbol(TCPSymbol::TYPE_CHECKSUM), bin);
 				}
 				else
 					state = 0;
@@ -312,7 +307,7 @@ void TCPDecoder::Refresh()
 			case 15:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendSymbolData(cap->m_samples[caplen-1], bin);
 					cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 					state = 16;
 				}
@@ -328,7 +323,7 @@ void TCPDecoder::Refresh()
 
 					cap->m_offsets.push_back(off);
 					cap->m_durations.push_back(0);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_URGENT, bin));
+					cap->PushSymbol(TCPSymbol(TCPSymbol::TYPE_URGENT), bin);
 				}
 				else
 					state = 0;
@@ -338,7 +333,7 @@ void TCPDecoder::Refresh()
 			case 17:
 				if(s.m_type == IPv4Symbol::TYPE_DATA)
 				{
-					cap->m_samples[caplen-1].m_data.push_back(bin);
+					cap->AppendSymbolData(cap->m_samples[caplen-1], bin);
 					cap->m_durations[caplen-1] = end - cap->m_offsets[caplen-1];
 					state = 18;
 				}
@@ -355,7 +350,7 @@ void TCPDecoder::Refresh()
 					{
 						cap->m_offsets.push_back(din->m_offsets[i]);
 						cap->m_durations.push_back(din->m_durations[i]);
-						cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_DATA, bin));
+						cap->PushSymbol(TCPSymbol(TCPSymbol::TYPE_DATA), bin);
 
 						state = 19;
 					}
@@ -365,7 +360,7 @@ void TCPDecoder::Refresh()
 					{
 						cap->m_offsets.push_back(din->m_offsets[i]);
 						cap->m_durations.push_back(din->m_durations[i]);
-						cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_OPTIONS, bin));
+						cap->PushSymbol(TCPSymbol(TCPSymbol::TYPE_OPTIONS), bin);
 
 						option_len --;
 					}
@@ -379,7 +374,7 @@ void TCPDecoder::Refresh()
 				{
 					cap->m_offsets.push_back(din->m_offsets[i]);
 					cap->m_durations.push_back(din->m_durations[i]);
-					cap->m_samples.push_back(TCPSymbol(TCPSymbol::TYPE_DATA, bin));
+					cap->PushSymbol(TCPSymbol(TCPSymbol::TYPE_DATA), bin);
 				}
 				else
 					state = 0;
@@ -429,71 +424,72 @@ string TCPWaveform::GetText(size_t i)
 {
 	char tmp[128];
 	auto sample = m_samples[i];
+	auto data = GetSymbolData(i);
 
 	switch(sample.m_type)
 	{
 		case TCPSymbol::TYPE_SEQ:
 			snprintf(tmp, sizeof(tmp), "Seq: %08x",
-				(sample.m_data[0] << 24) | (sample.m_data[1] << 16) | (sample.m_data[2] << 8) | sample.m_data[3]);
+				(data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_ACK:
 			snprintf(tmp, sizeof(tmp), "Ack: %08x",
-				(sample.m_data[0] << 24) | (sample.m_data[1] << 16) | (sample.m_data[2] << 8) | sample.m_data[3]);
+				(data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_DATA_OFFSET:
-			snprintf(tmp, sizeof(tmp), "Data off: %d", sample.m_data[0]);
+			snprintf(tmp, sizeof(tmp), "Data off: %d", data[0]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_FLAGS:
 			{
 				string s;
-				if(sample.m_data[1] & 0x01)
+				if(data[1] & 0x01)
 					s += "FIN ";
-				if(sample.m_data[1] & 0x02)
+				if(data[1] & 0x02)
 					s += "SYN ";
-				if(sample.m_data[1] & 0x04)
+				if(data[1] & 0x04)
 					s += "RST ";
-				if(sample.m_data[1] & 0x08)
+				if(data[1] & 0x08)
 					s += "PSH ";
-				if(sample.m_data[1] & 0x10)
+				if(data[1] & 0x10)
 					s += "ACK ";
-				if(sample.m_data[1] & 0x20)
+				if(data[1] & 0x20)
 					s += "URG ";
-				if(sample.m_data[1] & 0x40)
+				if(data[1] & 0x40)
 					s += "ECE ";
-				if(sample.m_data[1] & 0x80)
+				if(data[1] & 0x80)
 					s += "CWR ";
-				if(sample.m_data[0] & 1)
+				if(data[0] & 1)
 					s += "NS ";
 				return s;
 			}
 
 		case TCPSymbol::TYPE_WINDOW:
-			snprintf(tmp, sizeof(tmp), "Window: %d", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "Window: %d", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_CHECKSUM:
-			snprintf(tmp, sizeof(tmp), "Checksum: %x", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "Checksum: %x", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_URGENT:
-			snprintf(tmp, sizeof(tmp), "Urgent: %x", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "Urgent: %x", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_SOURCE_PORT:
-			snprintf(tmp, sizeof(tmp), "Source: %d", (sample.m_data[0] << 8) | sample.m_data[1]);
+			snprintf(tmp, sizeof(tmp), "Source: %d", (data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_DEST_PORT:
 			snprintf(tmp, sizeof(tmp), "Dest: %d",
-				(sample.m_data[0] << 8) | sample.m_data[1]);
+				(data[0] << 8) | data[1]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_DATA:
 		case TCPSymbol::TYPE_OPTIONS:
-			snprintf(tmp, sizeof(tmp), "%02x", sample.m_data[0]);
+			snprintf(tmp, sizeof(tmp), "%02x", data[0]);
 			return string(tmp);
 
 		case TCPSymbol::TYPE_ERROR:
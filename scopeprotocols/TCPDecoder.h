@@ -37,7 +37,12 @@
 
 #include "IPv4Decoder.h"
 
-class TCPSymbol
+/**
+	@brief One field of a TCP header
+
+	Field bytes live in the TCPWaveform's arena (see TCPWaveform::GetSymbolData()).
+ */
+class TCPSymbol : public ArenaSymbol
 {
 public:
 
@@ -57,25 +62,18 @@ public:
 		TYPE_DATA
 	} m_type;
 
-	std::vector<uint8_t> m_data;
-
 	TCPSymbol()
 	{}
 
-	TCPSymbol(SegmentType type, uint8_t value)
+	TCPSymbol(SegmentType type)
 		: m_type(type)
-	{ m_data.push_back(value); }
-
-	bool operator==(const TCPSymbol& rhs) const
-	{
-		return (m_data == rhs.m_data) && (m_type == rhs.m_type);
-	}
+	{}
 };
 
-class TCPWaveform : public SparseWaveform<TCPSymbol>
+class TCPWaveform : public ArenaSparseWaveform<TCPSymbol>
 {
 public:
-	TCPWaveform () : SparseWaveform<TCPSymbol>() {};
+	TCPWaveform () : ArenaSparseWaveform<TCPSymbol>() {};
 	virtual std::string GetText(size_t) override;
 	virtual Gdk::Color GetColor(size_t) override;
 };
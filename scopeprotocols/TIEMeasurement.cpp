@@ -40,6 +40,7 @@ TIEMeasurement::TIEMeasurement(const string& color)
 	, m_skipname("Skip Start")
 {
 	AddStream(Unit(Unit::UNIT_FS), "data", Stream::STREAM_TYPE_ANALOG);
+	AddStream(Unit(Unit::UNIT_COUNTS), "histogram", Stream::STREAM_TYPE_ANALOG);
 
 	//Set up channels
 	CreateInput("Clock");
@@ -78,6 +79,13 @@ string TIEMeasurement::GetProtocolName()
 	return "Clock Jitter (TIE)";
 }
 
+void TIEMeasurement::ClearSweeps()
+{
+	if(m_engine)
+		m_engine->Clear();
+	SetData(NULL, 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
@@ -86,6 +94,7 @@ void TIEMeasurement::Refresh()
 	if(!VerifyAllInputsOK())
 	{
 		SetData(NULL, 0);
+		SetData(NULL, 1);
 		return;
 	}
 
@@ -194,4 +203,60 @@ void TIEMeasurement::Refresh()
 	SetData(cap, 0);
 
 	cap->MarkModifiedFromCpu();
+
+	UpdateHistogram(cap);
+}
+
+/**
+	@brief Adds a new TIE waveform to the running histogram and copies the histogram to the second stream
+
+	Bins are rounded up to a whole number of femtoseconds, since that's the resolution of the output timebase.
+ */
+void TIEMeasurement::UpdateHistogram(SparseAnalogWaveform* tie)
+{
+	m_engine = JitterAnalysisEngine::GetEngine(StreamDescriptor(this, 0));
+	m_engine->IntegrateTIE(tie);
+	auto stats = m_engine->GetTIEStatistics();
+
+	//Find the occupied range of the histogram
+	auto& bins = stats.GetHistogram();
+	size_t first = bins.size();
+	size_t last = 0;
+	for(size_t i=0; i<bins.size(); i++)
+	{
+		if(bins[i] == 0)
+			continue;
+		first = min(first, i);
+		last = i;
+	}
+	if(first > last)
+	{
+		SetData(NULL, 1);
+		return;
+	}
+
+	double hmin = stats.GetHistogramMin();
+	double binwidth = stats.GetHistogramBinWidth();
+	int64_t width = max((int64_t)1, (int64_t)ceil(binwidth));
+	int64_t start = floor(hmin + first*binwidth);
+	int64_t end = ceil(hmin + (last+1)*binwidth);
+	size_t len = (end - start + width - 1) / width;
+
+	auto hist = SetupEmptyUniformAnalogOutputWaveform(tie, 1);
+	hist->m_timescale = width;
+	hist->m_triggerPhase = start;
+	hist->Resize(len);
+	hist->PrepareForCpuAccess();
+	for(size_t i=0; i<len; i++)
+		hist->m_samples[i] = 0;
+
+	//Re-bin by bin center
+	for(size_t i=first; i<=last; i++)
+	{
+		double center = hmin + (i + 0.5) * binwidth;
+		size_t bin = min((size_t)max(floor((center - start) / width), 0.0), len-1);
+		hist->m_samples[bin] += bins[i];
+	}
+
+	hist->MarkModifiedFromCpu();
 }
@@ -35,12 +35,19 @@
 #ifndef TIEMeasurement_h
 #define TIEMeasurement_h
 
+/**
+	@brief Time interval error of a clock against a golden (recovered) clock
+
+	The second stream is a histogram of every TIE sample since the last ClearSweeps(). It's a view over the
+	JitterAnalysisEngine for the TIE stream, so jitter filters on the TIE share the same accumulated histogram.
+ */
 class TIEMeasurement : public Filter
 {
 public:
 	TIEMeasurement(const std::string& color);
 
 	virtual void Refresh();
+	virtual void ClearSweeps();
 
 	static std::string GetProtocolName();
 
@@ -49,8 +56,12 @@ public:
 	PROTOCOL_DECODER_INITPROC(TIEMeasurement)
 
 protected:
+	void UpdateHistogram(SparseAnalogWaveform* tie);
+
 	std::string m_threshname;
 	std::string m_skipname;
+
+	std::shared_ptr<JitterAnalysisEngine> m_engine;
 };
 
 #endif
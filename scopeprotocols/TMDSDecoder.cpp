@@ -34,6 +34,7 @@
  */
 
 #include "../scopehal/scopehal.h"
+#include "../scopehal/LineCoding.h"
 #include "TMDSDecoder.h"
 
 using namespace std;
@@ -97,65 +98,48 @@ void TMDSDecoder::Refresh()
 	cap->PrepareForCpuAccess();
 
 	//Record the value of the data stream at each clock edge
-	SparseDigitalWaveform sampdata;
-	SampleOnAnyEdgesBase(din, clkin, sampdata);
+	auto pdata = GetSampledOnAnyEdges<bool>(din, clkin);
+	auto& sampdata = *pdata;
+
+	//Pack the sampled bits so we can work on 64 UIs at a time
+	size_t len = sampdata.m_samples.size();
+	PackedBitstream bits;
+	if(len)
+		bits.Pack(&sampdata.m_samples[0], len);
 
 	/*
 		Look for preamble data. We need this to synchronize. (HDMI 1.4 spec section 5.4.2)
 
-		TMDS sends the LSB first.
-		Since element 0 of a C++ array is leftmost, this table has bit ordering mirrored from the spec.
+		TMDS sends the LSB first, which is the same order PackedBitstream uses, so the codes are as in the spec.
+		Check all ten phases at once and pick the one with the most control period characters.
 	 */
-	static const bool control_codes[4][10] =
-	{
-		{ 0, 0, 1, 0, 1, 0, 1, 0, 1, 1 },
-		{ 1, 1, 0, 1, 0, 1, 0, 1, 0, 0 },
-		{ 0, 0, 1, 0, 1, 0, 1, 0, 1, 0 },
-		{ 1, 1, 0, 1, 0, 1, 0, 1, 0, 1 }
-	};
+	static const uint64_t control_codes[4] = { 0x354, 0x0ab, 0x154, 0x2ab };
 
-	size_t max_preambles = 0;
 	size_t max_offset = 0;
-	for(size_t offset=0; offset < 10; offset ++)
+	if(len > 20)
 	{
-		size_t num_preambles[4] = {0};
-		for(size_t i=0; i<sampdata.m_samples.size() - 20; i += 10)
-		{
-			//Look for control code "j" at phase "offset", position "i" within the data stream
-			for(size_t j=0; j<4; j++)
-			{
-				bool match = true;
-				for(size_t k=0; k<10; k++)
-				{
-					if(sampdata.m_samples[i+offset+k] != control_codes[j][k])
-						match = false;
-				}
-				if(match)
-				{
-					num_preambles[j] ++;
-					break;
-				}
-			}
-		}
+		PackedBitstream mask;
+		LineCoding::FindPatterns(bits, control_codes, 4, 10, mask);
 
-		for(size_t j=0; j<4; j++)
+		vector<size_t> num_preambles;
+		LineCoding::CountPerPhase(mask, 10, len/10 - 1, num_preambles);
+		for(size_t offset=1; offset < 10; offset ++)
 		{
-			if(num_preambles[j] > max_preambles)
-			{
-				max_preambles = num_preambles[j];
+			if(num_preambles[offset] > num_preambles[max_offset])
 				max_offset = offset;
-			}
 		}
 	}
 
 	int lane = m_parameters[m_lanename].GetIntVal();
+	if( (lane < 0) || (lane > 2) )
+		lane = 0;
 
 	//HDMI Video guard band (HDMI 1.4 spec 5.2.2.1)
-	static const bool video_guard[3][10] =
+	static const uint16_t video_guard[3] =
 	{
-		{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 1 },
-		{ 1, 1, 0, 0, 1, 1, 0, 0, 1, 0 },		//also used for data guard band, 5.2.3.3
-		{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 1 },
+		0x2cc,
+		0x133,		//also used for data guard band, 5.2.3.3
+		0x2cc
 	};
 
 	//TODO: TERC4 (5.4.3)
@@ -168,83 +152,44 @@ void TMDSDecoder::Refresh()
 	} last_symbol_type = TYPE_DATA;
 
 	//Decode the actual data
-	size_t sampmax = sampdata.m_samples.size()-11;
+	auto table = LineCoding::GetTMDSTable();
+	size_t sampmax = (len > 11) ? len - 11 : 0;
+	if(sampmax > max_offset)
+	{
+		size_t nsymbols = (sampmax - max_offset + 9) / 10;
+		cap->m_offsets.reserve(nsymbols);
+		cap->m_durations.reserve(nsymbols);
+		cap->m_samples.reserve(nsymbols);
+	}
 	for(size_t i=max_offset; i<sampmax; i+= 10)
 	{
-		bool match = true;
+		auto code = bits.Extract(i, 10);
+		auto& entry = table[code];
+
+		cap->m_offsets.push_back(sampdata.m_offsets[i]);
+		cap->m_durations.push_back(sampdata.m_offsets[i+10] - sampdata.m_offsets[i]);
 
 		//Check for control codes at any point in the sequence
-		for(size_t j=0; j<4; j++)
+		if(entry.m_control >= 0)
 		{
-			match = true;
-			for(size_t k=0; k<10; k++)
-			{
-				if(sampdata.m_samples[i+k] != control_codes[j][k])
-					match = false;
-			}
-
-			if(match)
-			{
-				cap->m_offsets.push_back(sampdata.m_offsets[i]);
-				cap->m_durations.push_back(sampdata.m_offsets[i+10] - sampdata.m_offsets[i]);
-				cap->m_samples.push_back(TMDSSymbol(TMDSSymbol::TMDS_TYPE_CONTROL, j));
-
-				last_symbol_type = TYPE_PREAMBLE;
-				break;
-			}
+			cap->m_samples.push_back(TMDSSymbol(TMDSSymbol::TMDS_TYPE_CONTROL, entry.m_control));
+			last_symbol_type = TYPE_PREAMBLE;
 		}
 
-		if(match)
-			continue;
-
 		//Check for HDMI video/control leading guard band
-		if( (last_symbol_type == TYPE_PREAMBLE) || (last_symbol_type == TYPE_GUARD) )
+		else if( ( (last_symbol_type == TYPE_PREAMBLE) || (last_symbol_type == TYPE_GUARD) ) &&
+			(code == video_guard[lane]) )
 		{
-			match = true;
-			for(size_t k=0; k<10; k++)
-			{
-				if(sampdata.m_samples[i+k] != video_guard[lane][k])
-					match = false;
-			}
-
-			if(match)
-			{
-				cap->m_offsets.push_back(sampdata.m_offsets[i]);
-				cap->m_durations.push_back(sampdata.m_offsets[i+10] - sampdata.m_offsets[i]);
-				cap->m_samples.push_back(TMDSSymbol(TMDSSymbol::TMDS_TYPE_GUARD, 0));
-				//last_symbol_type = TYPE_GUARD;
-				break;
-			}
+			cap->m_samples.push_back(TMDSSymbol(TMDSSymbol::TMDS_TYPE_GUARD, 0));
+			last_symbol_type = TYPE_GUARD;
 		}
 
-		if(match)
-			continue;
-
 		//Whatever is left is assumed to be video data
-		bool d9 = sampdata.m_samples[i+9];
-		bool d8 = sampdata.m_samples[i+8];
-
-		uint8_t d = sampdata.m_samples[i+0] |
-					(sampdata.m_samples[i+1] << 1) |
-					(sampdata.m_samples[i+2] << 2) |
-					(sampdata.m_samples[i+3] << 3) |
-					(sampdata.m_samples[i+4] << 4) |
-					(sampdata.m_samples[i+5] << 5) |
-					(sampdata.m_samples[i+6] << 6) |
-					(sampdata.m_samples[i+7] << 7);
-
-		if(d9)
-			d ^= 0xff;
-
-		if(d8)
-			d ^= (d << 1);
 		else
-			d ^= (d << 1) ^ 0xfe;
-
-		cap->m_offsets.push_back(sampdata.m_offsets[i]);
-		cap->m_durations.push_back(sampdata.m_offsets[i+10] - sampdata.m_offsets[i]);
-		cap->m_samples.push_back(TMDSSymbol(TMDSSymbol::TMDS_TYPE_DATA, d));
-		last_symbol_type = TYPE_DATA;
+		{
+			cap->m_samples.push_back(TMDSSymbol(TMDSSymbol::TMDS_TYPE_DATA, entry.m_data));
+			last_symbol_type = TYPE_DATA;
+		}
 	}
 
 	SetData(cap, 0);
@@ -297,3 +242,9 @@ string TMDSWaveform::GetText(size_t i)
 	}
 	return string(tmp);
 }
+
+void TMDSWaveform::RenderText(size_t start, size_t end)
+{
+	RenderTextByKey(start, end, 4*256, [this](size_t i)
+		{ return (m_samples[i].m_type << 8) | m_samples[i].m_data; });
+}
@@ -71,6 +71,9 @@ public:
 	TMDSWaveform () : SparseWaveform<TMDSSymbol>() {};
 	virtual std::string GetText(size_t) override;
 	virtual Gdk::Color GetColor(size_t) override;
+
+protected:
+	virtual void RenderText(size_t start, size_t end) override;
 };
 
 class TMDSDecoder : public Filter
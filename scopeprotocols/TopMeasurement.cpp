@@ -83,10 +83,11 @@ void TopMeasurement::Refresh()
 	size_t len = din->size();
 
 	//Make a histogram of the waveform
-	float min = GetMinVoltage(sdin, udin);
-	float max = GetMaxVoltage(sdin, udin);
+	auto summary = GetWaveformSummary(din);
+	float min = summary->m_min;
+	float max = summary->m_max;
 	size_t nbins = 64;
-	vector<size_t> hist = MakeHistogram(sdin, udin, min, max, nbins);
+	vector<size_t> hist = summary->GetCoarseHistogram(nbins);
 
 	//Set temporary midpoint and range
 	float range = (max - min);
@@ -0,0 +1,136 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+#include "scopeprotocols.h"
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+TotalJitterMeasurement::TotalJitterMeasurement(const string& color)
+	: Filter(color, CAT_MEASUREMENT)
+	, m_berName("Target BER")
+	, m_warnedNoSpectrum(false)
+{
+	AddStream(Unit(Unit::UNIT_FS), "data", Stream::STREAM_TYPE_ANALOG);
+
+	//Set up channels
+	CreateInput("TIE");
+	CreateInput("Threshold");
+	CreateInput("Clock");
+
+	m_parameters[m_berName] = FilterParameter(FilterParameter::TYPE_FLOAT, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_berName].SetFloatVal(1e-12);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Factory methods
+
+bool TotalJitterMeasurement::ValidateChannel(size_t i, StreamDescriptor stream)
+{
+	if(stream.m_channel == NULL)
+		return false;
+
+	if( (i == 0) &&
+		(stream.GetType() == Stream::STREAM_TYPE_ANALOG) &&
+		(stream.GetYAxisUnits() == Unit::UNIT_FS)
+		)
+	{
+		return true;
+	}
+	if( (i <= 2) && (stream.GetType() == Stream::STREAM_TYPE_DIGITAL) )
+		return true;
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Accessors
+
+string TotalJitterMeasurement::GetProtocolName()
+{
+	return "TJ@BER";
+}
+
+bool TotalJitterMeasurement::IsScalarOutput()
+{
+	return true;
+}
+
+void TotalJitterMeasurement::ClearSweeps()
+{
+	if(m_engine)
+		m_engine->Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Actual decoder logic
+
+void TotalJitterMeasurement::Refresh()
+{
+	if(!VerifyAllInputsOK())
+	{
+		SetData(NULL, 0);
+		return;
+	}
+
+	//Add the new data to the running jitter tables for these inputs
+	auto tie = dynamic_cast<SparseAnalogWaveform*>(GetInputWaveform(0));
+	m_engine = JitterAnalysisEngine::GetEngine(GetInput(0), GetInput(1), GetInput(2));
+	m_engine->Integrate(tie, GetInputWaveform(1), GetInputWaveform(2));
+
+	auto cap = SetupEmptyUniformAnalogOutputWaveform(tie, 0, true);
+	cap->PrepareForCpuAccess();
+
+	//Separate PJ using the averaged spectrum of this TIE stream, if a spectrum filter is averaging one
+	m_spectrumEngine = JitterAnalysisEngine::GetEngine(GetInput(0));
+	double pjRMS;
+	double pjPeakToPeak;
+	if(!m_spectrumEngine->GetPeriodicJitter(pjRMS, pjPeakToPeak))
+	{
+		if(!m_warnedNoSpectrum)
+		{
+			LogNotice("%s: no averaged jitter spectrum for %s, periodic jitter will be counted as random\n",
+				GetDisplayName().c_str(), GetInput(0).GetName().c_str());
+			m_warnedNoSpectrum = true;
+		}
+	}
+	else
+		m_warnedNoSpectrum = false;
+
+	float ber = m_parameters[m_berName].GetFloatVal();
+	cap->m_samples.push_back(m_engine->GetTotalJitter(ber, m_spectrumEngine.get()));
+	cap->m_timescale = 1;
+	cap->m_startTimestamp = tie->m_startTimestamp;
+	cap->m_startFemtoseconds = tie->m_startFemtoseconds;
+	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+}
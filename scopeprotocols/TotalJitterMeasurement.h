@@ -0,0 +1,76 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopeprotocols                                                                                                    *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Declaration of TotalJitterMeasurement
+ */
+#ifndef TotalJitterMeasurement_h
+#define TotalJitterMeasurement_h
+
+/**
+	@brief Total jitter extrapolated to a target bit error rate, from the dual-Dirac model
+
+	This is a view over the JitterAnalysisEngine for the TIE, threshold and clock inputs, so it accumulates across
+	triggers.
+
+	Periodic jitter is only separated from random jitter if a Jitter Spectrum filter with "Average Across Triggers"
+	is running on the same TIE stream. Without one, PJ is counted as RJ and TJ is overstated when PJ is present.
+ */
+class TotalJitterMeasurement : public Filter
+{
+public:
+	TotalJitterMeasurement(const std::string& color);
+
+	virtual void Refresh();
+
+	virtual bool IsScalarOutput();
+	virtual void ClearSweeps();
+
+	static std::string GetProtocolName();
+
+	virtual bool ValidateChannel(size_t i, StreamDescriptor stream);
+
+	PROTOCOL_DECODER_INITPROC(TotalJitterMeasurement)
+
+protected:
+	std::string m_berName;
+
+	std::shared_ptr<JitterAnalysisEngine> m_engine;
+
+	///@brief Engine for the TIE alone, which holds the averaged spectrum if there is one
+	std::shared_ptr<JitterAnalysisEngine> m_spectrumEngine;
+
+	///@brief True once we've told the user PJ can't be separated, so it's only logged once
+	bool m_warnedNoSpectrum;
+};
+
+#endif
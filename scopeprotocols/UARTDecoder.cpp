@@ -43,6 +43,9 @@ using namespace std;
 
 UARTDecoder::UARTDecoder(const string& color)
 	: PacketDecoder(color, CAT_BUS)
+	, m_resumeSample(0)
+	, m_tlast(0)
+	, m_openPacket(NULL)
 {
 	//Set up channels
 	CreateInput("din");
@@ -50,6 +53,7 @@ UARTDecoder::UARTDecoder(const string& color)
 	m_baudname = "Baud rate";
 	m_parameters[m_baudname] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_BITRATE));
 	m_parameters[m_baudname].SetIntVal(115200);
+	m_parameters[m_baudname].signal_changed().connect(sigc::mem_fun(*this, &UARTDecoder::ResetIncrementalState));
 }
 
 UARTDecoder::~UARTDecoder()
@@ -85,12 +89,19 @@ string UARTDecoder::GetProtocolName()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Actual decoder logic
 
+/**
+	@brief Decodes the input
+
+	If the input is a streaming capture which has only had samples appended since the last refresh, decoding resumes
+	from the start of the first incomplete byte and new bytes are appended to the existing output and packets.
+ */
 void UARTDecoder::Refresh()
 {
-	ClearPackets();
-
 	if(!VerifyAllInputsOK())
 	{
+		ClearPackets();
+		ResetIncrementalState();
+		m_openPacket = NULL;
 		SetData(NULL, 0);
 		return;
 	}
@@ -106,22 +117,46 @@ void UARTDecoder::Refresh()
 	int64_t ibitper = bit_period;
 	int64_t scaledbitper = ibitper / din->m_timescale;
 
-	//UART processing
-	auto cap = new ByteWaveform(m_displaycolor);
-	cap->PrepareForCpuAccess();
-	cap->m_timescale = din->m_timescale;
-	cap->m_startTimestamp = din->m_startTimestamp;
-	cap->m_startFemtoseconds = din->m_startFemtoseconds;
-	cap->m_triggerPhase = din->m_triggerPhase;
+	//Pick up where we left off if we can, otherwise start over
+	auto cap = dynamic_cast<ByteWaveform*>(GetData(0));
+	if( (GetFirstNewSample(0) > 0) && (cap != NULL) )
+	{
+		cap->PrepareForCpuAccess();
+		m_index.Clear();
+
+		//Reopen the last packet, so bytes continuing it are merged just like in a full decode
+		if(m_openPacket && !m_packets.empty() && (m_packets.back() == m_openPacket) )
+			m_packets.pop_back();
+		else
+			m_openPacket = NULL;
+	}
+	else
+	{
+		ClearPackets();
+		m_resumeSample = 0;
+		m_tlast = 0;
+		m_openPacket = NULL;
+
+		cap = new ByteWaveform(m_displaycolor);
+		cap->PrepareForCpuAccess();
+		cap->m_timescale = din->m_timescale;
+		cap->m_startTimestamp = din->m_startTimestamp;
+		cap->m_startFemtoseconds = din->m_startFemtoseconds;
+		cap->m_triggerPhase = din->m_triggerPhase;
+		SetData(cap, 0);
+	}
 
 	//Time-domain processing to reflect potentially variable sampling rate for RLE captures
 	int64_t next_value = 0;
-	size_t isample = 0;
-	int64_t tlast = 0;
-	Packet* pack = NULL;
+	size_t isample = m_resumeSample;
+	int64_t tlast = m_tlast;
+	Packet* pack = m_openPacket;
 	size_t len = din->size();
 	while(isample < len)
 	{
+		//If we run out of data partway through this byte, the next refresh resumes from here
+		m_resumeSample = isample;
+
 		//Wait for signal to go high (idle state)
 		while( (isample < len) && !GetValue(sdin, udin, isample))
 			isample ++;
@@ -197,14 +232,20 @@ void UARTDecoder::Refresh()
 		tlast = tstart;
 	}
 
-	//If we have a packet in progress, add it
+	m_tlast = tlast;
+	m_openPacket = pack;
+
+	//If we have a packet in progress, add it.
+	//If the input is still growing (its last change was an append), hold the packet back from export until it ends.
 	if(pack)
 	{
 		pack->m_len = ::GetOffsetScaled(sdin, udin, len-1) - pack->m_offset;
 		FinishPacket(pack);
 	}
+	m_lastPacketOpen = (pack != NULL) && din->IsAppendOf(din->m_revision);
 
-	SetData(cap, 0);
+	cap->MarkModifiedFromCpu();
+	cap->MarkSamplesAppended();
 }
 
 void UARTDecoder::FinishPacket(Packet* pack)
@@ -249,3 +290,8 @@ string ByteWaveform::GetText(size_t i)
 		snprintf(sbuf, sizeof(sbuf), "\\x%02x", 0xFF & c);
 	return sbuf;
 }
+
+void ByteWaveform::RenderText(size_t start, size_t end)
+{
+	RenderTextByKey(start, end, 256, [this](size_t i) { return (uint8_t)m_samples[i]; });
+}
@@ -45,6 +45,9 @@ public:
 	virtual std::string GetText(size_t) override;
 	virtual Gdk::Color GetColor(size_t) override;
 
+protected:
+	virtual void RenderText(size_t start, size_t end) override;
+
 private:
 	const std::string& m_color;
 };
@@ -68,6 +71,15 @@ public:
 protected:
 	void FinishPacket(Packet* pack);
 	std::string m_baudname;
+
+	///@brief Input sample at which to resume decoding on an incremental refresh
+	size_t m_resumeSample;
+
+	///@brief Start time of the last byte decoded
+	int64_t m_tlast;
+
+	///@brief The last packet, if more bytes could still be added to it
+	Packet* m_openPacket;
 };
 
 #endif
@@ -41,6 +41,12 @@ USB2PacketDecoder::USB2PacketDecoder(const string& color)
 {
 	//Set up channels
 	CreateInput("PCS");
+
+	m_store.DeclareEnum("Type", { "SOF", "SETUP", "IN", "OUT" });
+	m_store.DeclareColumn("Device", PacketStore::COLUMN_DECIMAL);
+	m_store.DeclareColumn("Endpoint", PacketStore::COLUMN_DECIMAL);
+	m_store.DeclareColumn("Length", PacketStore::COLUMN_DECIMAL);
+	m_store.DeclareColumn("Details", PacketStore::COLUMN_CUSTOM);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -463,18 +469,14 @@ void USB2PacketDecoder::DecodeSof(USB2PacketWaveform* cap, size_t istart, size_t
 		return;
 
 	//Make the packet
-	Packet* pack = new Packet;
-	pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
-	pack->m_headers["Type"] = "SOF";
-	char tmp[128];
-	snprintf(tmp, sizeof(tmp), "Sequence = %u", snframe.m_data);
-	pack->m_headers["Details"] = tmp;
-	pack->m_len = ((cap->m_offsets[icrc] + cap->m_durations[icrc]) * cap->m_timescale) - pack->m_offset;
-	m_packets.push_back(pack);
-
-	pack->m_headers["Device"] = "--";
-	pack->m_headers["Endpoint"] = "--";
-	pack->m_headers["Length"] = "2";
+	auto pack = AddPacket(cap->m_offsets[istart] * cap->m_timescale);
+	m_store.SetValue(pack, COL_TYPE, TYPE_SOF);
+	m_store.SetValue(pack, COL_DETAILS, snframe.m_data);
+	m_store.SetLength(pack, ((cap->m_offsets[icrc] + cap->m_durations[icrc]) * cap->m_timescale) - m_store.GetOffset(pack));
+
+	m_store.SetText(pack, COL_DEVICE, "--");
+	m_store.SetText(pack, COL_ENDPOINT, "--");
+	m_store.SetValue(pack, COL_LENGTH, 2);
 }
 
 void USB2PacketDecoder::DecodeSetup(USB2PacketWaveform* cap, size_t istart, size_t& i)
@@ -558,16 +560,12 @@ void USB2PacketDecoder::DecodeSetup(USB2PacketWaveform* cap, size_t istart, size
 	}
 
 	//Make the packet
-	Packet* pack = new Packet;
-	pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
-	pack->m_headers["Type"] = "SETUP";
-	pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_CONTROL];
-	char tmp[256];
-	snprintf(tmp, sizeof(tmp), "%d", saddr.m_data);
-	pack->m_headers["Device"] = tmp;
-	snprintf(tmp, sizeof(tmp), "%d", sendp.m_data);
-	pack->m_headers["Endpoint"] = tmp;
-	pack->m_headers["Length"] = "8";	//constant
+	auto pack = AddPacket(cap->m_offsets[istart] * cap->m_timescale);
+	m_store.SetValue(pack, COL_TYPE, TYPE_SETUP);
+	m_store.SetBackgroundColor(pack, m_backgroundColors[PROTO_COLOR_CONTROL]);
+	m_store.SetValue(pack, COL_DEVICE, saddr.m_data);
+	m_store.SetValue(pack, COL_ENDPOINT, sendp.m_data);
+	m_store.SetValue(pack, COL_LENGTH, 8);	//constant
 
 	//Decode setup details
 	uint8_t bmRequestType = data[0];
@@ -612,6 +610,7 @@ void USB2PacketDecoder::DecodeSetup(USB2PacketWaveform* cap, size_t istart, size
 			sdest = "reserved";
 			break;
 	}
+	char tmp[256];
 	snprintf(
 		tmp,
 		sizeof(tmp),
@@ -624,11 +623,10 @@ void USB2PacketDecoder::DecodeSetup(USB2PacketWaveform* cap, size_t istart, size
 		wIndex,
 		wLength,
 		ack.c_str());
-	pack->m_headers["Details"] = tmp;
+	m_store.SetText(pack, COL_DETAILS, tmp);
 
 	//Done
-	pack->m_len = ((cap->m_offsets[idcrc] + cap->m_durations[idcrc]) * cap->m_timescale) - pack->m_offset;
-	m_packets.push_back(pack);
+	m_store.SetLength(pack, ((cap->m_offsets[idcrc] + cap->m_durations[idcrc]) * cap->m_timescale) - m_store.GetOffset(pack));
 }
 
 void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_t& i)
@@ -668,8 +666,6 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		return;
 	}
 
-	char tmp[256];
-
 	//Look for the DATA packet after the IN/OUT
 	auto sdatpid = cap->m_samples[i];
 	if(sdatpid.m_type != USB2PacketSymbol::TYPE_PID)
@@ -689,26 +685,22 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		i++;
 
 		//Add a line for the aborted transaction
-		Packet* pack = new Packet;
-		pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
+		auto pack = AddPacket(cap->m_offsets[istart] * cap->m_timescale);
 		if( (cap->m_samples[istart].m_data & 0xf) == USB2PacketSymbol::PID_IN)
 		{
-			pack->m_headers["Type"] = "IN";
-			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+			m_store.SetValue(pack, COL_TYPE, TYPE_IN);
+			m_store.SetBackgroundColor(pack, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 		}
 		else
 		{
-			pack->m_headers["Type"] = "OUT";
-			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+			m_store.SetValue(pack, COL_TYPE, TYPE_OUT);
+			m_store.SetBackgroundColor(pack, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 		}
-		snprintf(tmp, sizeof(tmp), "%d", saddr.m_data);
-		pack->m_headers["Device"] = tmp;
-		snprintf(tmp, sizeof(tmp), "%d", sendp.m_data);
-		pack->m_headers["Endpoint"] = tmp;
-		pack->m_headers["Details"] = "NAK";
-		m_packets.push_back(pack);
+		m_store.SetValue(pack, COL_DEVICE, saddr.m_data);
+		m_store.SetValue(pack, COL_ENDPOINT, sendp.m_data);
+		m_store.SetText(pack, COL_DETAILS, "NAK");
 
-		pack->m_len = ((cap->m_offsets[i] + cap->m_durations[i]) * cap->m_timescale) - pack->m_offset;
+		m_store.SetLength(pack, ((cap->m_offsets[i] + cap->m_durations[i]) * cap->m_timescale) - m_store.GetOffset(pack));
 
 		return;
 	}
@@ -720,31 +712,26 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		LogError("Not data PID (%x, i=%zu)\n", sdatpid.m_data, i);
 
 		//DEBUG
-		Packet* pack = new Packet;
-		pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
-		pack->m_headers["Details"] = "ERROR";
-		pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
-		m_packets.push_back(pack);
+		auto pack = AddPacket(cap->m_offsets[istart] * cap->m_timescale);
+		m_store.SetText(pack, COL_DETAILS, "ERROR");
+		m_store.SetBackgroundColor(pack, m_backgroundColors[PROTO_COLOR_ERROR]);
 		return;
 	}
 
 	//Create the new packet
-	Packet* pack = new Packet;
-	pack->m_offset = cap->m_offsets[istart] * cap->m_timescale;
+	auto pack = AddPacket(cap->m_offsets[istart] * cap->m_timescale);
 	if( (cap->m_samples[istart].m_data & 0xf) == USB2PacketSymbol::PID_IN)
 	{
-		pack->m_headers["Type"] = "IN";
-		pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_READ];
+		m_store.SetValue(pack, COL_TYPE, TYPE_IN);
+		m_store.SetBackgroundColor(pack, m_backgroundColors[PROTO_COLOR_DATA_READ]);
 	}
 	else
 	{
-		pack->m_headers["Type"] = "OUT";
-		pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_DATA_WRITE];
+		m_store.SetValue(pack, COL_TYPE, TYPE_OUT);
+		m_store.SetBackgroundColor(pack, m_backgroundColors[PROTO_COLOR_DATA_WRITE]);
 	}
-	snprintf(tmp, sizeof(tmp), "%d", saddr.m_data);
-	pack->m_headers["Device"] = tmp;
-	snprintf(tmp, sizeof(tmp), "%d", sendp.m_data);
-	pack->m_headers["Endpoint"] = tmp;
+	m_store.SetValue(pack, COL_DEVICE, saddr.m_data);
+	m_store.SetValue(pack, COL_ENDPOINT, sendp.m_data);
 
 	//Read the data
 	while(i < cap->m_samples.size())
@@ -753,7 +740,7 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 
 		//Keep adding data
 		if(s.m_type == USB2PacketSymbol::TYPE_DATA)
-			pack->m_data.push_back(s.m_data);
+			m_store.AppendData(s.m_data);
 
 		//Next should be a CRC16
 		else if(s.m_type == USB2PacketSymbol::TYPE_CRC16_GOOD)
@@ -764,7 +751,7 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 		else if(s.m_type == USB2PacketSymbol::TYPE_CRC16_BAD)
 		{
 			i++;
-			pack->m_displayBackgroundColor = m_backgroundColors[PROTO_COLOR_ERROR];
+			m_store.SetBackgroundColor(pack, m_backgroundColors[PROTO_COLOR_ERROR]);
 			break;
 		}
 
@@ -775,44 +762,73 @@ void USB2PacketDecoder::DecodeData(USB2PacketWaveform* cap, size_t istart, size_
 	if(i >= cap->m_samples.size())
 	{
 		LogDebug("Truncated ACK\n");
+		m_store.RemoveLastPacket();
 		return;
 	}
-	string ack = "";
+	uint64_t ack = HANDSHAKE_ACK;
 	auto sack = cap->m_samples[i];
 	if(sack.m_type == USB2PacketSymbol::TYPE_PID)
 	{
 		if( (sack.m_data & 0xf) == USB2PacketSymbol::PID_ACK)
-			ack = "";
+			ack = HANDSHAKE_ACK;
 		else if( (sack.m_data & 0xf) == USB2PacketSymbol::PID_NAK)
-			ack = "NAK";
+			ack = HANDSHAKE_NAK;
 		else
-			ack = "Unknown end PID";
+			ack = HANDSHAKE_UNKNOWN_PID;
 	}
 
 	//TODO: handle errors better
 	else
 	{
 		LogDebug("DecodeData got type %x instead of ACK/NAK\n", sack.m_type);
-		ack = "Not a PID";
+		ack = HANDSHAKE_NOT_PID;
 	}
 
-	pack->m_len = ((cap->m_offsets[i] + cap->m_durations[i]) * cap->m_timescale) - pack->m_offset;
+	m_store.SetLength(pack, ((cap->m_offsets[i] + cap->m_durations[i]) * cap->m_timescale) - m_store.GetOffset(pack));
 	i++;
 
-	//Format the data
+	//The hex dump of the data is only formatted on display (see FormatHeader())
+	m_store.SetValue(pack, COL_DETAILS, ack);
+	m_store.SetValue(pack, COL_LENGTH, m_store.GetDataLength(pack));
+}
+
+string USB2PacketDecoder::FormatHeader(size_t row, size_t col, uint64_t value)
+{
+	if(col != COL_DETAILS)
+		return PacketDecoder::FormatHeader(row, col, value);
+
+	//SOF: frame number
+	if(m_store.GetValue(row, COL_TYPE) == TYPE_SOF)
+		return string("Sequence = ") + to_string(value);
+
+	//Data: payload bytes followed by the handshake, if not an ACK
 	string details = "";
-	for(auto b : pack->m_data)
+	char tmp[8];
+	auto data = m_store.GetData(row);
+	size_t len = m_store.GetDataLength(row);
+	for(size_t j=0; j<len; j++)
 	{
-		snprintf(tmp, sizeof(tmp), "%02x ", b);
+		snprintf(tmp, sizeof(tmp), "%02x ", data[j]);
 		details += tmp;
 	}
-	details += ack;
-	pack->m_headers["Details"] = details;
+	switch(value)
+	{
+		case HANDSHAKE_NAK:
+			details += "NAK";
+			break;
+
+		case HANDSHAKE_UNKNOWN_PID:
+			details += "Unknown end PID";
+			break;
 
-	snprintf(tmp, sizeof(tmp), "%zu", pack->m_data.size());
-	pack->m_headers["Length"] = tmp;
+		case HANDSHAKE_NOT_PID:
+			details += "Not a PID";
+			break;
 
-	m_packets.push_back(pack);
+		default:
+			break;
+	}
+	return details;
 }
 
 Gdk::Color USB2PacketWaveform::GetColor(size_t i)
@@ -120,6 +120,36 @@ public:
 	PROTOCOL_DECODER_INITPROC(USB2PacketDecoder)
 
 protected:
+	virtual std::string FormatHeader(size_t row, size_t col, uint64_t value);
+
+	///@brief Column indexes in the packet store, in GetHeaders() order
+	enum
+	{
+		COL_TYPE,
+		COL_DEVICE,
+		COL_ENDPOINT,
+		COL_LENGTH,
+		COL_DETAILS
+	};
+
+	///@brief Values of the type column
+	enum
+	{
+		TYPE_SOF,
+		TYPE_SETUP,
+		TYPE_IN,
+		TYPE_OUT
+	};
+
+	///@brief Values of the details column for data packets (the handshake that ended the transaction)
+	enum
+	{
+		HANDSHAKE_ACK,
+		HANDSHAKE_NAK,
+		HANDSHAKE_UNKNOWN_PID,
+		HANDSHAKE_NOT_PID
+	};
+
 	void FindPackets(USB2PacketWaveform* cap);
 	void DecodeSof(USB2PacketWaveform* cap, size_t istart, size_t& i);
 	void DecodeSetup(USB2PacketWaveform* cap, size_t istart, size_t& i);
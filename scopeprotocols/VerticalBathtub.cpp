@@ -47,6 +47,14 @@ VerticalBathtub::VerticalBathtub(const string& color)
 	m_timeName = "Time";
 	m_parameters[m_timeName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
 	m_parameters[m_timeName].SetFloatVal(0);
+
+	m_rangeName = "Time Range";
+	m_parameters[m_rangeName] = FilterParameter(FilterParameter::TYPE_INT, Unit(Unit::UNIT_FS));
+	m_parameters[m_rangeName].SetIntVal(0);
+
+	m_extrapolateName = "Dual-Dirac Extrapolation";
+	m_parameters[m_extrapolateName] = FilterParameter(FilterParameter::TYPE_BOOL, Unit(Unit::UNIT_COUNTS));
+	m_parameters[m_extrapolateName].SetBoolVal(true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -86,15 +94,20 @@ void VerticalBathtub::Refresh()
 	auto eye = dynamic_cast<EyeWaveform*>(GetInputWaveform(0));
 	eye->PrepareForCpuAccess();
 	int64_t timestamp = m_parameters[m_timeName].GetIntVal();
+	int64_t range = m_parameters[m_rangeName].GetIntVal();
 
-	//Find the eye bin for this column
+	//Find the eye bins for this band of times
 	double fs_per_width = 2*eye->m_uiWidth;
 	double fs_per_pixel = fs_per_width / eye->GetWidth();
-	size_t xbin = round( (timestamp + eye->m_uiWidth) / fs_per_pixel );
+	ssize_t xbin0 = round( (timestamp - range/2 + eye->m_uiWidth) / fs_per_pixel );
+	ssize_t xbin1 = round( (timestamp + range/2 + eye->m_uiWidth) / fs_per_pixel );
 
 	//Sanity check we're not off the eye
-	if(xbin >= eye->GetWidth())
+	ssize_t width = eye->GetWidth();
+	if( (xbin1 < 0) || (xbin0 >= width) )
 		return;
+	xbin0 = max(xbin0, (ssize_t)0);
+	xbin1 = min(xbin1, width-1);
 
 	//Create the output
 	auto cap = SetupEmptySparseAnalogOutputWaveform(eye, 0);
@@ -103,57 +116,24 @@ void VerticalBathtub::Refresh()
 	cap->PrepareForCpuAccess();
 
 	//Eye height config
-	auto range = GetInput(0).GetVoltageRange();
-	double mv_per_pixel = 1000 * range / eye->GetHeight();
-	double mv_off = 1000 * (range/2 - eye->GetCenterVoltage());
-
-	//Extract the single column we're interested in
-	//TODO: support a range of times around the midpoint
-	int64_t* data = eye->GetAccumData();
-	size_t width = eye->GetWidth();
+	auto vrange = GetInput(0).GetVoltageRange();
+	double mv_per_pixel = 1000 * vrange / eye->GetHeight();
+	double mv_off = 1000 * (vrange/2 - eye->GetCenterVoltage());
+
 	size_t len = eye->GetHeight();
 	cap->Resize(len);
 	for(size_t i=0; i<len; i++)
 	{
 		cap->m_offsets[i] = i*mv_per_pixel - mv_off;
 		cap->m_durations[i] = mv_per_pixel;
-		cap->m_samples[i] = data[i*width + xbin];
 	}
 	SetData(cap, 0);
 
-	//Move from the center out and integrate BER
-	float sumleft = 0;
-	float sumright = 0;
-	ssize_t mid = len/2;
-	for(ssize_t i=mid; i>=0; i--)
-	{
-		float& samp = cap->m_samples[i];
-		sumleft += samp;
-		samp = sumleft;
-	}
-	for(size_t i=mid; i<len; i++)
-	{
-		float& samp = cap->m_samples[i];
-		sumright += samp;
-		samp = sumright;
-	}
-
-	//Normalize to max amplitude
-	float nmax = sumleft;
-	if(sumright > sumleft)
-		nmax = sumright;
-	for(size_t i=0; i<len; i++)
-		cap->m_samples[i] /= nmax;
-
-	//Log post-scaling
-	for(size_t i=0; i<len; i++)
-	{
-		float& samp = cap->m_samples[i];
-		if(samp < 1e-12)
-			samp = -14;	//cap ber if we don't have enough data
-		else
-			samp = log10(samp);
-	}
+	//The curve itself comes from the shared engine for this eye, which only builds it once per eye and band
+	m_engine = BathtubEngine::GetEngine(GetInput(0));
+	m_engine->Update(eye);
+	m_engine->GetLogVerticalBathtub(xbin0, xbin1, m_parameters[m_extrapolateName].GetBoolVal(),
+		cap->m_samples.GetCpuPointer());
 
 	cap->MarkModifiedFromCpu();
 }
@@ -169,6 +169,7 @@ void ScopeProtocolStaticInit()
 	AddDecoderClass(TMDSDecoder);
 	AddDecoderClass(ToneGeneratorFilter);
 	AddDecoderClass(TopMeasurement);
+	AddDecoderClass(TotalJitterMeasurement);
 	AddDecoderClass(TouchstoneImportFilter);
 	AddDecoderClass(TRCImportFilter);
 	AddDecoderClass(UARTDecoder);
@@ -192,4 +193,8 @@ void ScopeProtocolStaticInit()
 	AddStatisticClass(AverageStatistic);
 	AddStatisticClass(MaximumStatistic);
 	AddStatisticClass(MinimumStatistic);
+	AddStatisticClass(MedianStatistic);
+	AddStatisticClass(Percentile5Statistic);
+	AddStatisticClass(Percentile95Statistic);
+	AddStatisticClass(StdDevStatistic);
 }
@@ -39,6 +39,9 @@
 #include "../scopehal/scopehal.h"
 #include "../scopehal/Filter.h"
 
+#include "BathtubEngine.h"
+#include "JitterAnalysisEngine.h"
+
 #include "ACCoupleFilter.h"
 #include "ACRMSMeasurement.h"
 #include "ADL5205Decoder.h"
@@ -169,6 +172,7 @@
 #include "TMDSDecoder.h"
 #include "ToneGeneratorFilter.h"
 #include "TopMeasurement.h"
+#include "TotalJitterMeasurement.h"
 #include "TouchstoneImportFilter.h"
 #include "TRCImportFilter.h"
 #include "UARTDecoder.h"
@@ -192,6 +196,8 @@
 #include "AverageStatistic.h"
 #include "MaximumStatistic.h"
 #include "MinimumStatistic.h"
+#include "PercentileStatistic.h"
+#include "StdDevStatistic.h"
 
 void ScopeProtocolStaticInit();
 
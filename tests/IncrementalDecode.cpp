@@ -0,0 +1,587 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Checks that incremental decoding of a growing waveform matches decoding it all at once
+
+	Synthesizes UART, CAN, I2C and MIL-STD-1553 traffic. Each capture is decoded once as a complete waveform, and once
+	as a streaming waveform which grows in randomly sized steps with a refresh after each one, the way a streaming
+	driver would append to it. The output symbols and packets of the two decodes must be identical.
+ */
+
+#include "../scopehal/scopehal.h"
+#include "../scopeprotocols/scopeprotocols.h"
+#include <random>
+
+using namespace std;
+
+///@brief Time scale of all synthesized waveforms (1 ns per tick)
+static const int64_t TIMESCALE = 1000000;
+
+/**
+	@brief Builds up a waveform as a series of constant levels
+
+	If step is zero, each level is one sample. Otherwise each level is sampled every step ticks, for decoders which
+	expect to see samples within a bit and not just at the edges.
+ */
+template<class W, class T>
+class LevelWriter
+{
+public:
+	LevelWriter(int64_t step = 0)
+		: m_wfm(new W)
+		, m_step(step)
+		, m_now(0)
+	{
+		m_wfm->m_timescale = TIMESCALE;
+		m_wfm->PrepareForCpuAccess();
+	}
+
+	void Level(T value, int64_t len)
+	{
+		int64_t dt = m_step ? m_step : len;
+		for(int64_t t=0; t<len; t+=dt)
+		{
+			m_wfm->m_offsets.push_back(m_now + t);
+			m_wfm->m_durations.push_back(min(dt, len - t));
+			m_wfm->m_samples.push_back(value);
+		}
+		m_now += len;
+	}
+
+	W* m_wfm;
+	int64_t m_step;
+	int64_t m_now;
+};
+
+/**
+	@brief Copies the samples of full which start before tcut to the end of live
+
+	The last sample of live is still in progress, so it lasts until tcut rather than its full duration. That gets
+	fixed up (extending it, as a streaming source would) when the next samples arrive.
+ */
+template<class W>
+void AppendUntil(W* full, W* live, int64_t tcut)
+{
+	size_t first = live->size();
+	size_t last = first;
+	while( (last < full->size()) && (full->m_offsets[last] < tcut) )
+		last ++;
+
+	if(first > 0)
+		live->m_durations[first-1] = full->m_durations[first-1];
+
+	for(size_t i=first; i<last; i++)
+	{
+		live->m_offsets.push_back(full->m_offsets[i]);
+		live->m_durations.push_back(full->m_durations[i]);
+		live->m_samples.push_back(full->m_samples[i]);
+	}
+
+	if( (last > 0) && (last < full->size()) )
+		live->m_durations[last-1] = min(full->m_durations[last-1], tcut - full->m_offsets[last-1]);
+
+	live->MarkModifiedFromCpu();
+	live->MarkSamplesAppended();
+}
+
+template<class W>
+bool CompareWaveforms(const char* name, W* full, W* inc)
+{
+	if(!full || !inc)
+	{
+		LogError("%s: missing output\n", name);
+		return false;
+	}
+	if(full->size() == 0)
+	{
+		LogError("%s: nothing was decoded\n", name);
+		return false;
+	}
+	if(full->size() != inc->size())
+	{
+		LogError("%s: %zu symbols decoded incrementally, %zu in one go\n", name, inc->size(), full->size());
+		return false;
+	}
+
+	for(size_t i=0; i<full->size(); i++)
+	{
+		if( (full->m_offsets[i] != inc->m_offsets[i]) ||
+			(full->m_durations[i] != inc->m_durations[i]) ||
+			!(full->m_samples[i] == inc->m_samples[i]) )
+		{
+			LogError("%s: symbol %zu differs\n", name, i);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ComparePackets(const char* name, PacketDecoder* full, PacketDecoder* inc)
+{
+	auto& fp = full->GetPackets();
+	auto& ip = inc->GetPackets();
+	if(fp.empty())
+	{
+		LogError("%s: no packets were decoded\n", name);
+		return false;
+	}
+	if(fp.size() != ip.size())
+	{
+		LogError("%s: %zu packets decoded incrementally, %zu in one go\n", name, ip.size(), fp.size());
+		return false;
+	}
+
+	for(size_t i=0; i<fp.size(); i++)
+	{
+		if( (fp[i]->m_offset != ip[i]->m_offset) ||
+			(fp[i]->m_len != ip[i]->m_len) ||
+			(fp[i]->m_data != ip[i]->m_data) ||
+			(fp[i]->m_headers != ip[i]->m_headers) )
+		{
+			LogError("%s: packet %zu differs\n", name, i);
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+	@brief Decodes a capture in one go and incrementally, and compares the results
+
+	@param name			Protocol name, for messages
+	@param full			Complete input waveform(s), one per decoder input
+	@param fulldec		Decoder for the complete capture
+	@param incdec		Decoder for the streaming capture
+	@param maxstep		Largest amount of time to append at once
+	@param rng			Random number generator for the step sizes
+ */
+template<class W, class S>
+bool TestDecoder(
+	const char* name,
+	vector<W*> full,
+	Filter* fulldec,
+	Filter* incdec,
+	int64_t maxstep,
+	minstd_rand& rng)
+{
+	auto stype = is_same<W, SparseAnalogWaveform>::value ? Stream::STREAM_TYPE_ANALOG : Stream::STREAM_TYPE_DIGITAL;
+	vector<OscilloscopeChannel*> chans;
+	vector<W*> live;
+	int64_t tend = 0;
+	for(size_t i=0; i<full.size(); i++)
+	{
+		auto fchan = new OscilloscopeChannel(
+			NULL, "full", "#ffffff", Unit(Unit::UNIT_FS), Unit(Unit::UNIT_VOLTS), stype, i);
+		fchan->SetData(full[i], 0);
+		fulldec->SetInput(i, StreamDescriptor(fchan, 0));
+
+		auto lchan = new OscilloscopeChannel(
+			NULL, "live", "#ffffff", Unit(Unit::UNIT_FS), Unit(Unit::UNIT_VOLTS), stype, i);
+		auto w = new W;
+		w->m_timescale = TIMESCALE;
+		w->PrepareForCpuAccess();
+		lchan->SetData(w, 0);
+		incdec->SetInput(i, StreamDescriptor(lchan, 0));
+
+		chans.push_back(fchan);
+		chans.push_back(lchan);
+		live.push_back(w);
+
+		size_t n = full[i]->size();
+		tend = max(tend, full[i]->m_offsets[n-1] + full[i]->m_durations[n-1]);
+	}
+
+	fulldec->Refresh();
+
+	//Grow the streaming capture a bit at a time.
+	//Once there's some output, every refresh should append to it rather than creating a new waveform.
+	uniform_int_distribution<int64_t> step(1, maxstep);
+	size_t refreshes = 0;
+	uint64_t rev = 0;
+	int64_t tcut = 0;
+	while(tcut < tend)
+	{
+		tcut = min(tcut + step(rng), tend);
+		if(tcut == tend)
+			tcut = INT64_MAX;
+		for(size_t i=0; i<full.size(); i++)
+			AppendUntil(full[i], live[i], tcut);
+
+		incdec->Refresh();
+		auto data = incdec->GetData(0);
+		if(data && (rev == 0) )
+			rev = data->m_revision;
+		else if(data)
+			refreshes ++;
+	}
+
+	bool ok = true;
+	auto out = incdec->GetData(0);
+	if(!out || (out->m_revision != rev + refreshes) )
+	{
+		LogError("%s: output was not updated incrementally\n", name);
+		ok = false;
+	}
+
+	ok &= CompareWaveforms(name, dynamic_cast<S*>(fulldec->GetData(0)), dynamic_cast<S*>(out));
+
+	auto fpd = dynamic_cast<PacketDecoder*>(fulldec);
+	auto ipd = dynamic_cast<PacketDecoder*>(incdec);
+	if(fpd && ipd)
+		ok &= ComparePackets(name, fpd, ipd);
+
+	LogNotice("%s: %zu symbols, %zu incremental refreshes: %s\n",
+		name,
+		fulldec->GetData(0) ? fulldec->GetData(0)->size() : (size_t)0,
+		refreshes,
+		ok ? "OK" : "FAIL");
+
+	delete fulldec;
+	delete incdec;
+	for(auto c : chans)
+		delete c;
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// UART
+
+static bool TestUART(minstd_rand& rng)
+{
+	const int64_t ui = FS_PER_SECOND / 115200 / TIMESCALE;
+
+	LevelWriter<SparseDigitalWaveform, bool> w;
+	w.Level(true, 20*ui);
+	for(int i=0; i<500; i++)
+	{
+		uint8_t b = rng();
+		w.Level(false, ui);
+		for(int j=0; j<8; j++)
+			w.Level((b >> j) & 1, ui);
+		w.Level(true, ui);
+
+		//Mostly back to back bytes, with occasional gaps long enough to end the packet
+		if(rng() % 8)
+			w.Level(true, (rng() % 3) * ui);
+		else
+			w.Level(true, (40 + rng() % 60) * ui);
+	}
+	w.Level(true, 20*ui);
+
+	return TestDecoder<SparseDigitalWaveform, ByteWaveform>(
+		"UART", {w.m_wfm}, new UARTDecoder("#ffffff"), new UARTDecoder("#ffffff"), 4*ui, rng);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CAN
+
+/**
+	@brief Adds a CAN frame, with bit stuffing and CRC
+
+	The decoder's input is true for a dominant (logic 0) bit.
+ */
+static void CANFrame(LevelWriter<SparseDigitalWaveform, bool>& w, int64_t ui, minstd_rand& rng)
+{
+	vector<bool> bits;
+	auto field = [&](uint32_t value, int nbits)
+	{
+		for(int i=nbits-1; i>=0; i--)
+			bits.push_back((value >> i) & 1);
+	};
+
+	bool ext = (rng() % 4) == 0;
+	size_t len = rng() % 9;
+	field(0, 1);				//SOF
+	field(rng() & 0x7ff, 11);	//ID
+	if(ext)
+	{
+		field(1, 1);			//SRR
+		field(1, 1);			//IDE
+		field(rng() & 0x3ffff, 18);
+		field(0, 1);			//RTR
+		field(0, 1);			//r1
+		field(0, 1);			//r0
+	}
+	else
+	{
+		field(0, 1);			//RTR
+		field(0, 1);			//IDE
+		field(0, 1);			//r0
+	}
+	field(len, 4);
+	for(size_t i=0; i<len; i++)
+		field(rng() & 0xff, 8);
+
+	uint16_t crc = 0;
+	for(auto b : bits)
+	{
+		bool next = b ^ ((crc >> 14) & 1);
+		crc = (crc << 1) & 0x7fff;
+		if(next)
+			crc ^= 0x4599;
+	}
+	field(crc, 15);
+
+	//Stuff everything up to the CRC
+	vector<bool> stuffed;
+	int run = 0;
+	for(auto b : bits)
+	{
+		if(!stuffed.empty() && (b == stuffed.back()) )
+			run ++;
+		else
+			run = 1;
+		stuffed.push_back(b);
+
+		if(run == 5)
+		{
+			stuffed.push_back(!b);
+			run = 1;
+		}
+	}
+
+	stuffed.push_back(1);		//CRC delimiter
+	stuffed.push_back(0);		//ACK
+	stuffed.push_back(1);		//ACK delimiter
+	for(int i=0; i<7; i++)		//EOF
+		stuffed.push_back(1);
+
+	for(auto b : stuffed)
+		w.Level(!b, ui);
+
+	//Interframe space
+	w.Level(false, (3 + rng() % 20) * ui);
+}
+
+static bool TestCAN(minstd_rand& rng)
+{
+	const int64_t ui = FS_PER_SECOND / 250000 / TIMESCALE;
+
+	LevelWriter<SparseDigitalWaveform, bool> w(ui / 10);
+	w.Level(false, 20*ui);
+	for(int i=0; i<40; i++)
+		CANFrame(w, ui, rng);
+
+	return TestDecoder<SparseDigitalWaveform, CANWaveform>(
+		"CAN", {w.m_wfm}, new CANDecoder("#ffffff"), new CANDecoder("#ffffff"), 5*ui, rng);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// I2C
+
+/**
+	@brief Generates SDA and SCL together, one quarter of a 100 kHz clock at a time
+ */
+class I2CWriter
+{
+public:
+	I2CWriter()
+		: m_sda(true)
+		, m_scl(true)
+	{}
+
+	void Quarter()
+	{
+		const int64_t q = 2500;
+		m_sdaw.Level(m_sda, q);
+		m_sclw.Level(m_scl, q);
+	}
+
+	void Start()
+	{
+		m_sda = true;
+		Quarter();
+		m_scl = true;
+		Quarter();
+		m_sda = false;
+		Quarter();
+		m_scl = false;
+		Quarter();
+	}
+
+	void Bit(bool b)
+	{
+		m_sda = b;
+		Quarter();
+		m_scl = true;
+		Quarter();
+		Quarter();
+		m_scl = false;
+		Quarter();
+	}
+
+	void Byte(uint8_t b, bool nak)
+	{
+		for(int i=7; i>=0; i--)
+			Bit((b >> i) & 1);
+		Bit(nak);
+	}
+
+	void Stop()
+	{
+		m_sda = false;
+		Quarter();
+		m_scl = true;
+		Quarter();
+		m_sda = true;
+		Quarter();
+		Quarter();
+	}
+
+	bool m_sda;
+	bool m_scl;
+	LevelWriter<SparseDigitalWaveform, bool> m_sdaw;
+	LevelWriter<SparseDigitalWaveform, bool> m_sclw;
+};
+
+static bool TestI2C(minstd_rand& rng)
+{
+	I2CWriter w;
+	for(int i=0; i<8; i++)
+		w.Quarter();
+	for(int i=0; i<60; i++)
+	{
+		w.Start();
+		w.Byte(rng() & 0xfe, false);
+
+		//Register address, then a repeated start to read it back
+		if(rng() % 2)
+		{
+			w.Byte(rng(), false);
+			w.Start();
+			w.Byte((rng() & 0xfe) | 1, false);
+		}
+
+		size_t len = 1 + rng() % 6;
+		for(size_t j=0; j<len; j++)
+			w.Byte(rng(), j+1 == len);
+		w.Stop();
+
+		for(int j=rng() % 20; j>0; j--)
+			w.Quarter();
+	}
+
+	return TestDecoder<SparseDigitalWaveform, I2CWaveform>(
+		"I2C", {w.m_sdaw.m_wfm, w.m_sclw.m_wfm}, new I2CDecoder("#ffffff"), new I2CDecoder("#ffffff"), 20000, rng);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MIL-STD-1553
+
+/**
+	@brief Adds one Manchester coded word: sync, 16 data bits, and odd parity
+
+	@param w		Waveform to add to
+	@param command	True for a command/status sync, false for a data sync
+	@param word		Data bits
+ */
+static void MilStd1553Word(LevelWriter<SparseAnalogWaveform, float>& w, bool command, uint16_t word)
+{
+	const float high = 5;
+	const float low = -5;
+	const int64_t half = 500;
+
+	w.Level(command ? high : low, 3*half);
+	w.Level(command ? low : high, 3*half);
+
+	bool parity = true;
+	for(int i=15; i>=0; i--)
+	{
+		bool b = (word >> i) & 1;
+		parity ^= b;
+		w.Level(b ? high : low, half);
+		w.Level(b ? low : high, half);
+	}
+	w.Level(parity ? high : low, half);
+	w.Level(parity ? low : high, half);
+}
+
+static bool TestMilStd1553(minstd_rand& rng)
+{
+	LevelWriter<SparseAnalogWaveform, float> w(50);
+	w.Level(0, 10000);
+	for(int i=0; i<40; i++)
+	{
+		uint16_t rt = rng() % 31;
+		bool transmit = rng() % 2;
+		uint16_t count = 1 + rng() % 8;
+		uint16_t status = rt << 11;
+
+		MilStd1553Word(w, true, (rt << 11) | (transmit << 10) | ((rng() % 30 + 1) << 5) | count);
+		if(transmit)
+		{
+			w.Level(0, 6000);
+			MilStd1553Word(w, true, status);
+			for(int j=0; j<count; j++)
+				MilStd1553Word(w, false, rng());
+		}
+		else
+		{
+			for(int j=0; j<count; j++)
+				MilStd1553Word(w, false, rng());
+			w.Level(0, 6000);
+			MilStd1553Word(w, true, status);
+		}
+		w.Level(0, 10000 + rng() % 20000);
+	}
+
+	return TestDecoder<SparseAnalogWaveform, MilStd1553Waveform>(
+		"MIL-STD-1553",
+		{w.m_wfm},
+		new MilStd1553Decoder("#ffffff"),
+		new MilStd1553Decoder("#ffffff"),
+		30000,
+		rng);
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+	g_log_sinks.emplace(g_log_sinks.begin(), new ColoredSTDLogSink(Severity::NOTICE));
+
+	//Waveform buffers need a compute device, skip if there isn't one
+	if(!VulkanInit(true))
+	{
+		LogNotice("No Vulkan device available, skipping\n");
+		return 77;
+	}
+
+	minstd_rand rng(1234);
+	bool ok = true;
+	ok &= TestUART(rng);
+	ok &= TestCAN(rng);
+	ok &= TestI2C(rng);
+	ok &= TestMilStd1553(rng);
+
+	ScopehalStaticCleanup();
+	return ok ? 0 : 1;
+}
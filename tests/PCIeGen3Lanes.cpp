@@ -0,0 +1,370 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Checks that the parallel PCIe gen3 logical decode matches a serial decode, and times both
+
+	Synthesizes x4 and x16 links carrying idles, TLPs, DLLPs, EDS and EDB tokens, junk bytes and lane errors, with
+	skew between the lanes and ordered sets which sometimes land in the middle of a packet. Each link is decoded with
+	a single thread (which decodes the whole stream in one go) and with several thread counts (which split it into
+	chunks decoded in parallel). The output symbols must be identical.
+ */
+
+#include "../scopehal/scopehal.h"
+#include "../scopeprotocols/scopeprotocols.h"
+#include <omp.h>
+#include <random>
+
+using namespace std;
+
+///@brief Time scale of the synthesized lanes (one UI at 8 GT/s per tick)
+static const int64_t TIMESCALE = 125000;
+
+///@brief Length of a 128b/130b block, in UIs
+static const int64_t BLOCK_LEN = 130;
+
+/**
+	@brief Builds up the lanes of a link, one 128b/130b block at a time
+ */
+class LinkWriter
+{
+public:
+	LinkWriter(size_t nports, minstd_rand& rng)
+		: m_nports(nports)
+		, m_rng(rng)
+	{
+		//Each lane starts at a different point in the stream, so it has to be deskewed
+		for(size_t j=0; j<nports; j++)
+		{
+			auto w = new PCIe128b130bWaveform;
+			w->m_timescale = TIMESCALE;
+			w->PrepareForCpuAccess();
+			m_lanes.push_back(w);
+			m_now.push_back(m_rng() % 20);
+
+			uint8_t data[16] = {0};
+			m_lead.push_back(m_rng() % 4);
+			for(size_t i=0; i<m_lead[j]; i++)
+				AddToLane(j, PCIe128b130bSymbol(PCIe128b130bSymbol::TYPE_SCRAMBLER_DESYNCED, data));
+		}
+	}
+
+	/**
+		@brief Generates nblocks blocks of traffic, starting with a skip ordered set
+	 */
+	void Generate(size_t nblocks)
+	{
+		OrderedSet(0xaa);
+
+		size_t next = 200;
+		while(m_lanes[0]->size() < m_lead[0] + nblocks)
+		{
+			if(next == 0)
+			{
+				//Usually the link finishes the packet in flight and idles before an ordered set,
+				//but sometimes one lands in the middle of a packet
+				if(m_rng() % 2)
+				{
+					while(!m_bytes.empty())
+						DataBlock(true);
+				}
+
+				//Mostly skips, sometimes other sets (including one we don't know)
+				static const uint8_t types[] = {0x00, 0x66, 0x55, 0x1e, 0x2d, 0xe1, 0x47};
+				if(m_rng() % 3)
+					OrderedSet(0xaa);
+				else
+					OrderedSet(types[m_rng() % sizeof(types)]);
+
+				next = 200 + m_rng() % 400;
+			}
+			else
+			{
+				DataBlock(false);
+				next --;
+			}
+		}
+
+		for(auto w : m_lanes)
+			w->MarkModifiedFromCpu();
+	}
+
+	vector<PCIe128b130bWaveform*> m_lanes;
+
+protected:
+
+	void AddToLane(size_t j, const PCIe128b130bSymbol& sym)
+	{
+		auto w = m_lanes[j];
+		w->m_offsets.push_back(m_now[j]);
+		w->m_durations.push_back(BLOCK_LEN);
+		w->m_samples.push_back(sym);
+		m_now[j] += BLOCK_LEN;
+	}
+
+	void OrderedSet(uint8_t type)
+	{
+		uint8_t data[16];
+		for(size_t k=0; k<16; k++)
+			data[k] = type;
+
+		for(size_t j=0; j<m_nports; j++)
+			AddToLane(j, PCIe128b130bSymbol(PCIe128b130bSymbol::TYPE_ORDERED_SET, data));
+	}
+
+	/**
+		@brief Stripes the next 16 bytes per lane of the logical byte stream across the lanes
+
+		@param drain	Pad the end of the stream with idles rather than starting new packets
+	 */
+	void DataBlock(bool drain)
+	{
+		while(m_bytes.size() < 16*m_nports)
+		{
+			if(drain)
+				m_bytes.push_back(0x00);
+			else
+				AddTraffic();
+		}
+
+		//Occasionally corrupt one lane
+		size_t badlane = SIZE_MAX;
+		if( (m_rng() % 300) == 0)
+			badlane = m_rng() % m_nports;
+
+		for(size_t j=0; j<m_nports; j++)
+		{
+			uint8_t data[16];
+			for(size_t k=0; k<16; k++)
+				data[k] = m_bytes[k*m_nports + j];
+
+			if(j == badlane)
+				AddToLane(j, PCIe128b130bSymbol(PCIe128b130bSymbol::TYPE_ERROR, data));
+			else
+				AddToLane(j, PCIe128b130bSymbol(PCIe128b130bSymbol::TYPE_DATA, data));
+		}
+
+		m_bytes.erase(m_bytes.begin(), m_bytes.begin() + 16*m_nports);
+	}
+
+	/**
+		@brief Appends a random token (and its payload, if any) to the logical byte stream
+	 */
+	void AddTraffic()
+	{
+		unsigned int r = m_rng() % 100;
+
+		//Logical idle
+		if(r < 30)
+			m_bytes.insert(m_bytes.end(), 1 + m_rng() % 32, 0x00);
+
+		//TLP, often spanning several blocks.
+		//Low nibble of the length goes in the high nibble of the STP token, so skip lengths which look like EDS.
+		else if(r < 60)
+		{
+			size_t len = 3 + m_rng() % 300;
+			if( (len & 0xf) == 1)
+				len ++;
+			m_bytes.push_back( ((len & 0xf) << 4) | 0x0f);
+			m_bytes.push_back( (len >> 4) & 0x7f);
+			for(size_t i=2; i<len*4; i++)
+				m_bytes.push_back(m_rng());
+		}
+
+		//DLLP
+		else if(r < 85)
+		{
+			m_bytes.push_back(0xf0);
+			m_bytes.push_back(0xac);
+			for(size_t i=0; i<6; i++)
+				m_bytes.push_back(m_rng());
+		}
+
+		//EDS
+		else if(r < 90)
+		{
+			static const uint8_t eds[] = {0x1f, 0x80, 0x90, 0x00};
+			m_bytes.insert(m_bytes.end(), eds, eds + sizeof(eds));
+		}
+
+		//EDB
+		else if(r < 93)
+			m_bytes.insert(m_bytes.end(), 4, 0xc0);
+
+		//Junk which isn't a valid token
+		else
+		{
+			static const uint8_t junk[] = {0x12, 0x5a, 0xe7};
+			m_bytes.push_back(junk[m_rng() % sizeof(junk)]);
+		}
+	}
+
+	size_t m_nports;
+	minstd_rand& m_rng;
+	vector<int64_t> m_now;
+	vector<size_t> m_lead;
+	deque<uint8_t> m_bytes;
+};
+
+static bool CompareWaveforms(const string& name, PCIeLogicalWaveform* serial, PCIeLogicalWaveform* parallel)
+{
+	if(!serial || !parallel)
+	{
+		LogError("%s: missing output\n", name.c_str());
+		return false;
+	}
+	if(serial->size() != parallel->size())
+	{
+		LogError("%s: %zu symbols decoded in parallel, %zu serially\n", name.c_str(), parallel->size(), serial->size());
+		return false;
+	}
+
+	for(size_t i=0; i<serial->size(); i++)
+	{
+		if( (serial->m_offsets[i] != parallel->m_offsets[i]) ||
+			(serial->m_durations[i] != parallel->m_durations[i]) ||
+			!(serial->m_samples[i] == parallel->m_samples[i]) )
+		{
+			LogError("%s: symbol %zu differs\n", name.c_str(), i);
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+	@brief Decodes a synthesized link serially and in parallel, and compares the results
+
+	@param nports	Number of lanes
+	@param nblocks	Number of 128b/130b blocks per lane
+	@param rng		Random number generator for the traffic
+ */
+static bool TestLink(size_t nports, size_t nblocks, minstd_rand& rng)
+{
+	string name = string("x") + to_string(nports);
+
+	LinkWriter link(nports, rng);
+	link.Generate(nblocks);
+
+	auto serial = new PCIeGen3LogicalDecoder("#ffffff");
+	auto parallel = new PCIeGen3LogicalDecoder("#ffffff");
+	serial->GetParameter("Lane Count").SetIntVal(nports);
+	parallel->GetParameter("Lane Count").SetIntVal(nports);
+
+	vector<OscilloscopeChannel*> chans;
+	for(size_t j=0; j<nports; j++)
+	{
+		auto chan = new OscilloscopeChannel(
+			NULL, "lane", "#ffffff", Unit(Unit::UNIT_FS), Unit(Unit::UNIT_COUNTS), Stream::STREAM_TYPE_PROTOCOL, j);
+		chan->SetData(link.m_lanes[j], 0);
+		serial->SetInput(j, StreamDescriptor(chan, 0));
+		parallel->SetInput(j, StreamDescriptor(chan, 0));
+		chans.push_back(chan);
+	}
+
+	//Reference decode, all in one chunk
+	int nthreads = omp_get_max_threads();
+	omp_set_num_threads(1);
+	double start = GetTime();
+	serial->Refresh();
+	double tserial = GetTime() - start;
+	auto ref = dynamic_cast<PCIeLogicalWaveform*>(serial->GetData(0));
+
+	//Make sure the traffic exercises everything we care about
+	bool ok = true;
+	size_t ntlps = 0;
+	size_t nskips = 0;
+	size_t nerrors = 0;
+	if(ref)
+	{
+		for(auto& s : ref->m_samples)
+		{
+			if(s.m_type == PCIeLogicalSymbol::TYPE_START_TLP)
+				ntlps ++;
+			else if(s.m_type == PCIeLogicalSymbol::TYPE_SKIP)
+				nskips ++;
+			else if(s.m_type == PCIeLogicalSymbol::TYPE_ERROR)
+				nerrors ++;
+		}
+	}
+	if( (ntlps == 0) || (nskips < 2) || (nerrors == 0) )
+	{
+		LogError("%s: serial decode is missing TLPs, skips or errors\n", name.c_str());
+		ok = false;
+	}
+
+	LogNotice("%s: %zu blocks, %zu symbols, serial decode %.2f ms\n",
+		name.c_str(), nblocks, ref ? ref->size() : (size_t)0, tserial * 1000);
+
+	//Different thread counts split the stream at different places
+	vector<int> counts = {nthreads, 2, 3, 16};
+	for(auto n : counts)
+	{
+		omp_set_num_threads(n);
+		start = GetTime();
+		parallel->Refresh();
+		double tparallel = GetTime() - start;
+
+		bool match = CompareWaveforms(name, ref, dynamic_cast<PCIeLogicalWaveform*>(parallel->GetData(0)));
+		ok &= match;
+
+		LogNotice("%s: %d threads %.2f ms (%.2fx): %s\n",
+			name.c_str(), n, tparallel * 1000, tserial / tparallel, match ? "OK" : "FAIL");
+	}
+	omp_set_num_threads(nthreads);
+
+	delete serial;
+	delete parallel;
+	for(auto c : chans)
+		delete c;
+	return ok;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+	g_log_sinks.emplace(g_log_sinks.begin(), new ColoredSTDLogSink(Severity::NOTICE));
+
+	//Waveform buffers need a compute device, skip if there isn't one
+	if(!VulkanInit(true))
+	{
+		LogNotice("No Vulkan device available, skipping\n");
+		return 77;
+	}
+
+	minstd_rand rng(1234);
+	bool ok = true;
+	ok &= TestLink(4, 60000, rng);
+	ok &= TestLink(16, 15000, rng);
+
+	ScopehalStaticCleanup();
+	return ok ? 0 : 1;
+}
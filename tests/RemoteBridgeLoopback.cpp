@@ -0,0 +1,303 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* libscopehal v0.1                                                                                                     *
+*                                                                                                                      *
+* Copyright (c) 2012-2022 Andrew D. Zonenberg and contributors                                                         *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief Streams acquisitions from a local stand-in for the Pico bridge server through PicoOscilloscope
+
+	Checks that every chunk is either converted or counted as dropped, that the sample data survives the trip intact,
+	and that Stop() returns promptly once the bridge goes idle.
+ */
+
+#include "../scopehal/scopehal.h"
+#include "../scopehal/SCPITwinLanTransport.h"
+#include "../scopehal/PicoOscilloscope.h"
+
+using namespace std;
+
+///@brief Number of chunks the fake bridge sends per START
+static const size_t CHUNK_COUNT = 256;
+
+///@brief Samples per channel in each chunk
+static const size_t CHUNK_DEPTH = 65536;
+
+///@brief Number of analog channels reported by the fake bridge
+static const size_t CHANNEL_COUNT = 4;
+
+/**
+	@brief Sample value sent for a given chunk, channel, and sample index
+
+	The first sample carries the chunk sequence number so the consumer can check ordering.
+ */
+static int16_t TestSample(size_t seq, size_t chan, size_t i)
+{
+	if(i == 0)
+		return seq;
+	return chan*1000 + (i % 997);
+}
+
+/**
+	@brief Minimal stand-in for the Pico bridge server
+ */
+class LoopbackBridge
+{
+public:
+	LoopbackBridge(uint16_t port)
+		: m_controlListener(AF_INET, SOCK_STREAM, IPPROTO_TCP)
+		, m_dataListener(AF_INET, SOCK_STREAM, IPPROTO_TCP)
+		, m_ok(false)
+	{
+		if(!m_controlListener.Bind(port) || !m_controlListener.Listen())
+			return;
+		if(!m_dataListener.Bind(port + 1) || !m_dataListener.Listen())
+			return;
+
+		m_ok = true;
+		m_thread = thread(&LoopbackBridge::ThreadProc, this);
+	}
+
+	~LoopbackBridge()
+	{
+		if(m_thread.joinable())
+			m_thread.join();
+	}
+
+	bool IsValid()
+	{ return m_ok; }
+
+protected:
+	void ThreadProc()
+	{
+		Socket control = m_controlListener.Accept();
+		Socket data = m_dataListener.Accept();
+
+		//Serve commands until the client disconnects
+		string cmd;
+		while(ReadLine(control, cmd))
+		{
+			if(cmd == "*IDN?")
+				SendLine(control, "Pico Technology,TEST0,SN0001,1.0");
+			else if(cmd == "CHANS?")
+				SendLine(control, to_string(CHANNEL_COUNT));
+			else if(cmd == "START")
+			{
+				for(size_t seq=0; seq<CHUNK_COUNT; seq++)
+				{
+					if(!SendChunk(data, seq))
+						return;
+				}
+			}
+
+			//Everything else is configuration we don't care about
+		}
+	}
+
+	bool ReadLine(Socket& sock, string& line)
+	{
+		line = "";
+		while(true)
+		{
+			unsigned char c;
+			if(!sock.RecvLooped(&c, 1))
+				return false;
+			if(c == '\n')
+				return true;
+			line += c;
+		}
+	}
+
+	void SendLine(Socket& sock, const string& line)
+	{
+		string s = line + "\n";
+		sock.SendLooped((const unsigned char*)s.c_str(), s.length());
+	}
+
+	bool SendChunk(Socket& sock, size_t seq)
+	{
+		#pragma pack(push, 1)
+		struct
+		{
+			uint16_t numChannels;
+			int64_t fs_per_sample;
+		} header;
+		#pragma pack(pop)
+		header.numChannels = CHANNEL_COUNT;
+		header.fs_per_sample = 1000;
+
+		//Build the whole chunk and send it in one go
+		vector<uint8_t> buf;
+		buf.insert(buf.end(), (uint8_t*)&header, (uint8_t*)&header + sizeof(header));
+		for(size_t chan=0; chan<CHANNEL_COUNT; chan++)
+		{
+			size_t chanhdr[2] = {chan, CHUNK_DEPTH};
+			float config[3] = {1, 0, 0};
+			buf.insert(buf.end(), (uint8_t*)chanhdr, (uint8_t*)chanhdr + sizeof(chanhdr));
+			buf.insert(buf.end(), (uint8_t*)config, (uint8_t*)config + sizeof(config));
+
+			size_t start = buf.size();
+			buf.resize(start + CHUNK_DEPTH*sizeof(int16_t));
+			int16_t* samples = (int16_t*)&buf[start];
+			for(size_t i=0; i<CHUNK_DEPTH; i++)
+				samples[i] = TestSample(seq, chan, i);
+		}
+
+		m_bytesSent += buf.size();
+		return sock.SendLooped(&buf[0], buf.size());
+	}
+
+	Socket m_controlListener;
+	Socket m_dataListener;
+	bool m_ok;
+	thread m_thread;
+
+public:
+	atomic<size_t> m_bytesSent{0};
+};
+
+/**
+	@brief Checks the waveforms most recently popped from the scope
+
+	@return Sequence number of the chunk they came from, or -1 if they didn't match what was sent
+ */
+static int64_t CheckWaveforms(Oscilloscope* scope)
+{
+	int64_t seq = -1;
+	for(size_t chan=0; chan<CHANNEL_COUNT; chan++)
+	{
+		auto wfm = dynamic_cast<UniformAnalogWaveform*>(scope->GetChannel(chan)->GetData(0));
+		if(!wfm || (wfm->size() != CHUNK_DEPTH) || (wfm->m_timescale != 1000) )
+			return -1;
+		wfm->PrepareForCpuAccess();
+
+		int64_t s = wfm->m_samples[0];
+		if(chan == 0)
+			seq = s;
+		else if(s != seq)
+			return -1;
+
+		for(size_t i=1; i<CHUNK_DEPTH; i++)
+		{
+			if(wfm->m_samples[i] != TestSample(seq, chan, i))
+				return -1;
+		}
+	}
+
+	return seq;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+	g_log_sinks.emplace(g_log_sinks.begin(), new ColoredSTDLogSink(Severity::NOTICE));
+
+	//Waveform buffers need a compute device, skip if there isn't one
+	if(!VulkanInit(true))
+	{
+		LogNotice("No Vulkan device available, skipping\n");
+		return 77;
+	}
+
+	//Pick a port pair that's unlikely to collide with another run
+	uint16_t port = 20000 + (time(NULL) % 10000) * 2;
+	int ret = 0;
+	{
+		LoopbackBridge bridge(port);
+		if(!bridge.IsValid())
+		{
+			LogError("Failed to bind loopback bridge on port %d\n", port);
+			return 1;
+		}
+
+		auto scope = new PicoOscilloscope(
+			new SCPITwinLanTransport(string("127.0.0.1:") + to_string(port) + ":" + to_string(port+1)));
+		scope->SetStreamingMode(true);
+
+		double start = GetTime();
+		scope->Start();
+
+		//Convert until every chunk has been accounted for
+		size_t converted = 0;
+		int64_t lastseq = -1;
+		while(converted + scope->GetStreamingChunksDropped() < CHUNK_COUNT)
+		{
+			if(GetTime() - start > 30)
+			{
+				LogError("Timed out after %zu chunks converted\n", converted);
+				ret = 1;
+				break;
+			}
+
+			if(!scope->AcquireData())
+				continue;
+			converted ++;
+
+			while(scope->HasPendingWaveforms())
+			{
+				scope->PopPendingWaveform();
+				int64_t seq = CheckWaveforms(scope);
+				if(seq <= lastseq)
+				{
+					LogError("Bad or out of order waveform (seq %lld after %lld)\n", (long long)seq, (long long)lastseq);
+					ret = 1;
+				}
+				lastseq = seq;
+			}
+		}
+		double dt = GetTime() - start;
+
+		LogNotice("Received %zu chunks, converted %zu, dropped %zu\n",
+			(size_t)scope->GetStreamingChunksReceived(),
+			converted,
+			(size_t)scope->GetStreamingChunksDropped());
+		LogNotice("Throughput: %.1f MB/s\n", bridge.m_bytesSent / (dt * 1e6));
+
+		if(scope->GetStreamingChunksReceived() != CHUNK_COUNT)
+		{
+			LogError("Expected %zu chunks to be received\n", CHUNK_COUNT);
+			ret = 1;
+		}
+
+		//The bridge is now idle, so the streaming thread is waiting for a chunk that will never arrive.
+		//Stopping must not wait for it.
+		double tstop = GetTime();
+		scope->Stop();
+		if(GetTime() - tstop > 1)
+		{
+			LogError("Stop() took %.3f sec\n", GetTime() - tstop);
+			ret = 1;
+		}
+
+		//Disconnects from the bridge, letting its thread exit
+		delete scope;
+	}
+
+	ScopehalStaticCleanup();
+	return ret;
+}